@@ -1,18 +1,82 @@
 #include "abstract_matrix.h"
+#include "typed_matrix.h"
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 static const char *getKlass(const Matrix *this, int *err)
 {
   return "abstractMatrix";
 }
 
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  return MATRIX_KLASS_OTHER;
+}
+
 static void freeAbstractMatrix(Matrix *this, int *err)
 {
   free(this);
 }
 
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  for (int c = 0; c < nCols; c++) {
+    row[c] = this->fns->getElement(this, rowIndex, c, err);
+    if (*err == EINVAL || *err == EDOM) return;
+  }
+}
+
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  for (int c = 0; c < nCols; c++) {
+    this->fns->setElement(this, rowIndex, c, row[c], err);
+    if (*err == EINVAL || *err == EDOM) return;
+  }
+}
+
+static MatrixBaseType *getData(const Matrix *this, int *rowStride, int *err)
+{
+  return NULL;
+}
+
+/** Return a pointer to the row-major entries of nRows x nCols matrix
+ *  this, setting *rowStride to the distance between rows.  If this
+ *  does not provide direct access to its storage, then its entries
+ *  are copied into a newly allocated buffer which is also return'd
+ *  in *copy; the caller must free(*copy).
+ */
+static const MatrixBaseType *
+getRowMajorEntries(const Matrix *this, int nRows, int nCols,
+                   int *rowStride, MatrixBaseType **copy, int *err)
+{
+  *copy = NULL;
+  const MatrixBaseType *data = this->fns->getData(this, rowStride, err);
+  if (*err == EINVAL || data) return data;
+  *copy = malloc((size_t)nRows*nCols*sizeof(MatrixBaseType));
+  if (!*copy) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, &(*copy)[(size_t)r*nCols], err);
+    if (*err == EINVAL || *err == EDOM) {
+      free(*copy);
+      *copy = NULL;
+      return NULL;
+    }
+  }
+  *rowStride = nCols;
+  return *copy;
+}
+
 static void transpose(const Matrix *this, Matrix *result, int *err)
 {
   // Check dimensions: MxN -> NxM
@@ -29,15 +93,39 @@ static void transpose(const Matrix *this, Matrix *result, int *err)
     return;
   }
 
-  // Transpose: Res[r][c] = This[c][r]
-  for (int r = 0; r < result_n; r++) {
+  MatrixBaseType *copy;
+  int ld;
+  const MatrixBaseType *src =
+    getRowMajorEntries(this, this_m, this_n, &ld, &copy, err);
+  if (!src) return;
+
+  int resultLd;
+  MatrixBaseType *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) goto done;
+  if (res) {
+    // Transpose: Res[r][c] = This[c][r], writing result directly
     for (int c = 0; c < result_m; c++) {
-      MatrixBaseType x = this->fns->getElement(this, c, r, err);
-      if (*err == EDOM || *err == EINVAL) return;
-      result->fns->setElement(result, r, c, x, err);
-      if (*err == EDOM || *err == EINVAL) return;
+      for (int r = 0; r < result_n; r++) {
+        res[(size_t)r*resultLd + c] = src[(size_t)c*ld + r];
+      }
+    }
+  }
+  else {
+    // Transpose a row at a time, gathering each column of this
+    MatrixBaseType *row = malloc(result_m*sizeof(MatrixBaseType));
+    if (!row) {
+      *err = ENOMEM;
+      goto done;
+    }
+    for (int r = 0; r < result_n; r++) {
+      for (int c = 0; c < result_m; c++) row[c] = src[(size_t)c*ld + r];
+      result->fns->setRow(result, r, row, err);
+      if (*err == EDOM || *err == EINVAL) break;
     }
+    free(row);
   }
+ done:
+  free(copy);
 }
 
 static void mul(const Matrix *this, const Matrix *multiplier,
@@ -62,29 +150,113 @@ static void mul(const Matrix *this, const Matrix *multiplier,
     return;
   }
 
+  // Get at the entries of this a row at a time and the multiplier as
+  // a whole; either directly or via a copy
+  int thisLd;
+  const MatrixBaseType *thisData = this->fns->getData(this, &thisLd, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *multiplierCopy;
+  int mulLd;
+  const MatrixBaseType *mulData =
+    getRowMajorEntries(multiplier, mul_n, mul_p, &mulLd, &multiplierCopy, err);
+  if (!mulData) return;
+  int prLd;
+  MatrixBaseType *prData = product->fns->getData(product, &prLd, err);
+  if (*err == EINVAL) goto done;
+  MatrixBaseType *buf = malloc((this_n + pr_p)*sizeof(MatrixBaseType));
+  if (!buf) {
+    *err = ENOMEM;
+    goto done;
+  }
+
   // Do the multiplication
   for (int pr_r = 0; pr_r < pr_m; pr_r++) {
+    const MatrixBaseType *thisRow;
+    if (thisData) {
+      thisRow = &thisData[(size_t)pr_r*thisLd];
+    }
+    else {
+      this->fns->getRow(this, pr_r, buf, err);
+      if (*err == EINVAL || *err == EDOM) break;
+      thisRow = buf;
+    }
+    MatrixBaseType *prRow = (prData) ? &prData[(size_t)pr_r*prLd] : &buf[this_n];
     for (int pr_c = 0; pr_c < pr_p; pr_c++) {
       // Pr[r][c] <- Sum_i This[r][i]*That[i][c]
       MatrixBaseType res = 0;
       for (int i = 0; i < this_n; i++) {
-	MatrixBaseType a = this->fns->getElement(this, pr_r, i, err);
-	if (*err == EINVAL || *err == EDOM) return;
-	MatrixBaseType b = multiplier->fns->getElement(multiplier, i, pr_c, err);
-	if (*err == EINVAL || *err == EDOM) return;
-	res += a*b;
+	res += thisRow[i]*mulData[(size_t)i*mulLd + pr_c];
       }
-      product->fns->setElement(product, pr_r, pr_c, res, err);
-      if (*err == EINVAL || *err == EDOM) return;
+      prRow[pr_c] = res;
     }
+    if (!prData) {
+      product->fns->setRow(product, pr_r, prRow, err);
+      if (*err == EINVAL || *err == EDOM) break;
+    }
+  }
+  free(buf);
+ done:
+  free(multiplierCopy);
+}
+
+/** Set result[] to this * vec[] a row of this at a time */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *row = malloc(nCols*sizeof(MatrixBaseType));
+  if (!row) {
+    *err = ENOMEM;
+    return;
   }
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, row, err);
+    if (*err == EINVAL || *err == EDOM) break;
+    MatrixBaseType res = 0;
+    for (int c = 0; c < nCols; c++) res += row[c]*vec[c];
+    result[r] = res;
+  }
+  free(row);
+}
+
+/** Set result[] to vec[] * this by accumulating the rows of this,
+ *  each scaled by the corresponding entry of vec[].
+ */
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *row = malloc(nCols*sizeof(MatrixBaseType));
+  if (!row) {
+    *err = ENOMEM;
+    return;
+  }
+  memset(result, 0, nCols*sizeof(MatrixBaseType));
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, row, err);
+    if (*err == EINVAL || *err == EDOM) break;
+    for (int c = 0; c < nCols; c++) result[c] += vec[r]*row[c];
+  }
+  free(row);
 }
 
 static MatrixFns abstractMatrixFns = {
   .getKlass = getKlass,
+  .getKlassId = getKlassId,
   .free = freeAbstractMatrix,
+  .getRow = getRow,
+  .setRow = setRow,
+  .getData = getData,
   .transpose = transpose,
   .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
 };
 
 /** Return implementation of functions for an abstract matrix; these are
@@ -96,3 +268,6 @@ getAbstractMatrixFns(void)
 {
   return &abstractMatrixFns;
 }
+
+#define TM_TEMPLATE "abstract_matrix_template.h"
+#include "typed_matrix_instances.h"
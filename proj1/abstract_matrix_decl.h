@@ -0,0 +1,11 @@
+/** Template for the abstract matrix class for a single element type;
+ *  see typed_template.h.
+ */
+
+/** Return implementation of functions for an abstract matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class. These are functions which can be implemented using only
+ *  other matrix functions, independent of the actual implementation
+ *  of the matrix.
+ */
+const TM_NAME(MatrixFns) *TM_NAME(getAbstractMatrixFns)(void);
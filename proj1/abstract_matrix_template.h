@@ -0,0 +1,279 @@
+/** Template for the implementation of the abstract matrix class for
+ *  a single element type; see typed_template.h.
+ */
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  return "abstractMatrix" TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  return MATRIX_KLASS_OTHER;
+}
+
+static void
+TM_NAME(freeAbstractMatrix)(TM_NAME(Matrix) *this, int *err)
+{
+  free(this);
+}
+
+static void
+TM_NAME(getRow)(const TM_NAME(Matrix) *this, int rowIndex, TM_TYPE row[],
+                int *err)
+{
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  for (int c = 0; c < nCols; c++) {
+    row[c] = this->fns->getElement(this, rowIndex, c, err);
+    if (*err == EINVAL || *err == EDOM) return;
+  }
+}
+
+static void
+TM_NAME(setRow)(TM_NAME(Matrix) *this, int rowIndex, const TM_TYPE row[],
+                int *err)
+{
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  for (int c = 0; c < nCols; c++) {
+    this->fns->setElement(this, rowIndex, c, row[c], err);
+    if (*err == EINVAL || *err == EDOM) return;
+  }
+}
+
+static TM_TYPE *
+TM_NAME(getData)(const TM_NAME(Matrix) *this, int *rowStride, int *err)
+{
+  return NULL;
+}
+
+/** Return a pointer to the row-major entries of nRows x nCols matrix
+ *  this, setting *rowStride to the distance between rows.  If this
+ *  does not provide direct access to its storage, then its entries
+ *  are copied into a newly allocated buffer which is also return'd
+ *  in *copy; the caller must free(*copy).
+ */
+static const TM_TYPE *
+TM_NAME(getRowMajorEntries)(const TM_NAME(Matrix) *this, int nRows, int nCols,
+                            int *rowStride, TM_TYPE **copy, int *err)
+{
+  *copy = NULL;
+  const TM_TYPE *data = this->fns->getData(this, rowStride, err);
+  if (*err == EINVAL || data) return data;
+  *copy = malloc((size_t)nRows*nCols*sizeof(TM_TYPE));
+  if (!*copy) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, &(*copy)[(size_t)r*nCols], err);
+    if (*err == EINVAL || *err == EDOM) {
+      free(*copy);
+      *copy = NULL;
+      return NULL;
+    }
+  }
+  *rowStride = nCols;
+  return *copy;
+}
+
+static void
+TM_NAME(transpose)(const TM_NAME(Matrix) *this, TM_NAME(Matrix) *result,
+                   int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == result_m && this_n == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  TM_TYPE *copy;
+  int ld;
+  const TM_TYPE *src =
+    TM_NAME(getRowMajorEntries)(this, this_m, this_n, &ld, &copy, err);
+  if (!src) return;
+
+  int resultLd;
+  TM_TYPE *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) goto done;
+  if (res) {
+    // Transpose: Res[r][c] = This[c][r], writing result directly
+    for (int c = 0; c < result_m; c++) {
+      for (int r = 0; r < result_n; r++) {
+        res[(size_t)r*resultLd + c] = src[(size_t)c*ld + r];
+      }
+    }
+  }
+  else {
+    // Transpose a row at a time, gathering each column of this
+    TM_TYPE *row = malloc(result_m*sizeof(TM_TYPE));
+    if (!row) {
+      *err = ENOMEM;
+      goto done;
+    }
+    for (int r = 0; r < result_n; r++) {
+      for (int c = 0; c < result_m; c++) row[c] = src[(size_t)c*ld + r];
+      result->fns->setRow(result, r, row, err);
+      if (*err == EDOM || *err == EINVAL) break;
+    }
+    free(row);
+  }
+ done:
+  free(copy);
+}
+
+static void
+TM_NAME(mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+             TM_NAME(Matrix) *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Get at the entries of this a row at a time and the multiplier as
+  // a whole; either directly or via a copy
+  int thisLd;
+  const TM_TYPE *thisData = this->fns->getData(this, &thisLd, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *multiplierCopy;
+  int mulLd;
+  const TM_TYPE *mulData =
+    TM_NAME(getRowMajorEntries)(multiplier, mul_n, mul_p, &mulLd,
+                                &multiplierCopy, err);
+  if (!mulData) return;
+  int prLd;
+  TM_TYPE *prData = product->fns->getData(product, &prLd, err);
+  if (*err == EINVAL) goto done;
+  TM_TYPE *buf = malloc((this_n + pr_p)*sizeof(TM_TYPE));
+  if (!buf) {
+    *err = ENOMEM;
+    goto done;
+  }
+
+  // Do the multiplication
+  for (int pr_r = 0; pr_r < pr_m; pr_r++) {
+    const TM_TYPE *thisRow;
+    if (thisData) {
+      thisRow = &thisData[(size_t)pr_r*thisLd];
+    }
+    else {
+      this->fns->getRow(this, pr_r, buf, err);
+      if (*err == EINVAL || *err == EDOM) break;
+      thisRow = buf;
+    }
+    TM_TYPE *prRow = (prData) ? &prData[(size_t)pr_r*prLd] : &buf[this_n];
+    for (int pr_c = 0; pr_c < pr_p; pr_c++) {
+      // Pr[r][c] <- Sum_i This[r][i]*That[i][c]
+      TM_TYPE res = 0;
+      for (int i = 0; i < this_n; i++) {
+	res += thisRow[i]*mulData[(size_t)i*mulLd + pr_c];
+      }
+      prRow[pr_c] = res;
+    }
+    if (!prData) {
+      product->fns->setRow(product, pr_r, prRow, err);
+      if (*err == EINVAL || *err == EDOM) break;
+    }
+  }
+  free(buf);
+ done:
+  free(multiplierCopy);
+}
+
+/** Set result[] to this * vec[] a row of this at a time */
+static void
+TM_NAME(mulVec)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *row = malloc(nCols*sizeof(TM_TYPE));
+  if (!row) {
+    *err = ENOMEM;
+    return;
+  }
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, row, err);
+    if (*err == EINVAL || *err == EDOM) break;
+    TM_TYPE res = 0;
+    for (int c = 0; c < nCols; c++) res += row[c]*vec[c];
+    result[r] = res;
+  }
+  free(row);
+}
+
+/** Set result[] to vec[] * this by accumulating the rows of this,
+ *  each scaled by the corresponding entry of vec[].
+ */
+static void
+TM_NAME(vecMul)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *row = malloc(nCols*sizeof(TM_TYPE));
+  if (!row) {
+    *err = ENOMEM;
+    return;
+  }
+  memset(result, 0, nCols*sizeof(TM_TYPE));
+  for (int r = 0; r < nRows; r++) {
+    this->fns->getRow(this, r, row, err);
+    if (*err == EINVAL || *err == EDOM) break;
+    for (int c = 0; c < nCols; c++) result[c] += vec[r]*row[c];
+  }
+  free(row);
+}
+
+static TM_NAME(MatrixFns) TM_NAME(abstractMatrixFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .free = TM_NAME(freeAbstractMatrix),
+  .getRow = TM_NAME(getRow),
+  .setRow = TM_NAME(setRow),
+  .getData = TM_NAME(getData),
+  .transpose = TM_NAME(transpose),
+  .mul = TM_NAME(mul),
+  .mulVec = TM_NAME(mulVec),
+  .vecMul = TM_NAME(vecMul),
+};
+
+/** Return implementation of functions for an abstract matrix; these are
+ *  functions which can be implemented using only other matrix functions,
+ *  independent of the actual implementation of the matrix.
+ */
+const TM_NAME(MatrixFns) *
+TM_NAME(getAbstractMatrixFns)(void)
+{
+  return &TM_NAME(abstractMatrixFns);
+}
@@ -0,0 +1,108 @@
+#include "band_matrix.h"
+#include "structured_matrix_impl.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+typedef struct {
+  StructuredMatrixImpl;
+  int nSub;
+  int nSuper;
+} BandMatrixImpl;
+
+#define KLASS "bandMatrix"
+
+/** Examines the matrix as a BandMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifyBandMatrix(const Matrix *this, int *err)
+{
+  const BandMatrixImpl *matrix = (const BandMatrixImpl *)this;
+  if (matrix->nRows <= 0 || matrix->nCols <= 0 ||
+      matrix->nSub < 0 || matrix->nSuper < 0) {
+    *err = EINVAL;
+  }
+}
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifyBandMatrix(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifyBandMatrix(this, err);
+  return MATRIX_KLASS_BAND;
+}
+
+/** Row i stores columns [i - nSub, i + nSuper] in a fixed-width slot,
+ *  of which only those within [0, nCols) are used.
+ */
+static MatrixBaseType *
+getRowEntries(const Matrix *this, int rowIndex, int *begin, int *end)
+{
+  const BandMatrixImpl *matrix = (const BandMatrixImpl *)this;
+  const int first = rowIndex - matrix->nSub;
+  const int last = rowIndex + matrix->nSuper + 1;
+  const size_t width = matrix->nSub + 1 + matrix->nSuper;
+  MatrixBaseType *row = &matrix->entries[rowIndex*width];
+  *begin = (first > 0) ? first : 0;
+  *end = (last < matrix->nCols) ? last : matrix->nCols;
+  if (*begin >= *end) {
+    *begin = *end = 0;
+    return row;
+  }
+  return &row[*begin - first];
+}
+
+static _Bool isInit = false;
+static BandMatrixFns bandMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .getRowEntries = getRowEntries,
+};
+
+static void patchBandMatrixFns(void)
+{
+  if (!isInit) {
+    const StructuredMatrixFns *fns = getStructuredMatrixFns();
+    bandMatrixFns.free = fns->free;
+    bandMatrixFns.getNRows = fns->getNRows;
+    bandMatrixFns.getNCols = fns->getNCols;
+    bandMatrixFns.getElement = fns->getElement;
+    bandMatrixFns.setElement = fns->setElement;
+    bandMatrixFns.getRow = fns->getRow;
+    bandMatrixFns.setRow = fns->setRow;
+    bandMatrixFns.getData = fns->getData;
+    bandMatrixFns.transpose = fns->transpose;
+    bandMatrixFns.mul = fns->mul;
+    bandMatrixFns.mulVec = fns->mulVec;
+    bandMatrixFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+BandMatrix *
+newBandMatrix(int nRows, int nCols, int nSub, int nSuper, int *err)
+{
+  if (nRows <= 0 || nCols <= 0 || nSub < 0 || nSuper < 0 ||
+      nSub > nRows || nSuper > nCols) {
+    *err = EINVAL;
+    return NULL;
+  }
+  BandMatrixImpl *matrix = (BandMatrixImpl *)
+    newStructuredMatrix(sizeof(BandMatrixImpl), nRows, nCols,
+                        (size_t)nRows*(nSub + 1 + nSuper),
+                        (const StructuredMatrixFns *)getBandMatrixFns(), err);
+  if (!matrix) return NULL;
+  matrix->nSub = nSub;
+  matrix->nSuper = nSuper;
+  return (BandMatrix *)matrix;
+}
+
+const BandMatrixFns *
+getBandMatrixFns(void)
+{
+  patchBandMatrixFns();
+  return &bandMatrixFns;
+}
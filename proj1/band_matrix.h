@@ -0,0 +1,34 @@
+#ifndef _BAND_MATRIX_H
+#define _BAND_MATRIX_H
+
+#include "structured_matrix.h"
+
+typedef struct BandMatrixFns {
+  StructuredMatrixFns; //-fms-extensions inserts StructuredMatrixFns fields
+} BandMatrixFns;
+
+typedef struct BandMatrix {
+  StructuredMatrix; //-fms-extensions inserts StructuredMatrix fields
+} BandMatrix;
+
+/** Return a newly allocated nRows x nCols band matrix with nSub
+ *  sub-diagonals and nSuper super-diagonals (entry [i][j] is 0 unless
+ *  i - nSub <= j <= i + nSuper), with all entries initialized to 0.
+ *  Each row stores nSub + 1 + nSuper entries, of which those falling
+ *  outside the matrix at its corners are unused; so a tridiagonal
+ *  matrix (nSub = nSuper = 1) stores 3 entries a row.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, or if nSub or nSuper is
+ *  negative or greater than nRows or nCols respectively, to ENOMEM if
+ *  not enough memory.
+ */
+BandMatrix *newBandMatrix(int nRows, int nCols, int nSub, int nSuper,
+                          int *err);
+
+/** Return implementation of functions for a band matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const BandMatrixFns *getBandMatrixFns(void);
+
+#endif //ifndef _BAND_MATRIX_H
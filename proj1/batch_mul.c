@@ -0,0 +1,182 @@
+#include "batch_mul.h"
+#include "gemm_kernel.h"
+#include "small_mul_kernel.h"
+#include "thread_pool.h"
+
+#include <errno.h>
+#include <string.h>
+
+/** BATCH_CHUNK is the # of matrices in each piece of work handed to a
+ *  thread.  Within it, matrices stored as a structure of arrays are
+ *  multiplied SOA_BLOCK at a time, which is a few SIMD registers
+ *  worth of entries.
+ */
+enum { BATCH_CHUNK = 256, SOA_BLOCK = 32 };
+
+/** Arguments for multiplying a chunk of a batch */
+typedef struct {
+  int count;
+  int m, n, p;
+  const MatrixBaseType *a;
+  const MatrixBaseType *b;
+  MatrixBaseType *c;
+} BatchArgs;
+
+/** Multiply matrices [begin, end) of a batch stored as an array of
+ *  structures, a matrix at a time, using the kernel specialized for
+ *  the shape if there is one.
+ */
+static void
+mulAosChunk(void *arg, int begin, int end)
+{
+  const BatchArgs *args = arg;
+  const int m = args->m, n = args->n, p = args->p;
+  SmallMulFn kernel = getSmallMulKernel(m, n, p);
+  if (kernel) {
+    for (int t = begin; t < end; t++) {
+      kernel(m, n, &args->a[(size_t)t*m*n], n, &args->b[(size_t)t*n*p], p,
+             &args->c[(size_t)t*m*p], p);
+    }
+    return;
+  }
+  for (int t = begin; t < end; t++) {
+    const MatrixBaseType *a = &args->a[(size_t)t*m*n];
+    const MatrixBaseType *b = &args->b[(size_t)t*n*p];
+    MatrixBaseType *restrict c = &args->c[(size_t)t*m*p];
+    for (int i = 0; i < m; i++) {
+      MatrixBaseType *restrict cRow = &c[i*p];
+      for (int j = 0; j < p; j++) cRow[j] = 0;
+      for (int k = 0; k < n; k++) {
+        const MatrixBaseType aik = a[i*n + k];
+        const MatrixBaseType *bRow = &b[k*p];
+        for (int j = 0; j < p; j++) cRow[j] += aik*bRow[j];
+      }
+    }
+  }
+}
+
+/** Set entry [i][j] of the SOA_BLOCK matrices of a batch stored as a
+ *  structure of arrays starting at matrix t0 (or only nt matrices if
+ *  fewer remain): each step of the innermost loop is a multiply-add
+ *  for the same entry of consecutive matrices, which the compiler
+ *  vectorizes, and the sums stay in registers until they are stored.
+ */
+static inline __attribute__((always_inline)) void
+mulSoaEntry(const BatchArgs *args, int i, int j, int t0, int nt)
+{
+  const int count = args->count, n = args->n, p = args->p;
+  MatrixBaseType acc[SOA_BLOCK] = { 0 };
+  for (int k = 0; k < n; k++) {
+    const MatrixBaseType *aik = &args->a[(size_t)(i*n + k)*count + t0];
+    const MatrixBaseType *bkj = &args->b[(size_t)(k*p + j)*count + t0];
+    if (nt == SOA_BLOCK) {
+      for (int t = 0; t < SOA_BLOCK; t++) acc[t] += aik[t]*bkj[t];
+    }
+    else {
+      for (int t = 0; t < nt; t++) acc[t] += aik[t]*bkj[t];
+    }
+  }
+  memcpy(&args->c[(size_t)(i*p + j)*count + t0], acc,
+         nt*sizeof(MatrixBaseType));
+}
+
+/** Multiply matrices [begin, end) of a batch stored as a structure of
+ *  arrays, SOA_BLOCK matrices at a time.  This is inlined into a
+ *  function for each instruction set below, so that the compiler
+ *  vectorizes it for that instruction set.
+ */
+static inline __attribute__((always_inline)) void
+mulSoaBlocks(const BatchArgs *args, int begin, int end)
+{
+  for (int t0 = begin; t0 < end; t0 += SOA_BLOCK) {
+    const int nt = (end - t0 < SOA_BLOCK) ? end - t0 : SOA_BLOCK;
+    for (int i = 0; i < args->m; i++) {
+      for (int j = 0; j < args->p; j++) mulSoaEntry(args, i, j, t0, nt);
+    }
+  }
+}
+
+static void
+mulSoaChunk(void *arg, int begin, int end)
+{
+  mulSoaBlocks(arg, begin, end);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+__attribute__((target("sse4.1")))
+static void
+mulSoaChunkSse41(void *arg, int begin, int end)
+{
+  mulSoaBlocks(arg, begin, end);
+}
+
+__attribute__((target("avx2")))
+static void
+mulSoaChunkAvx2(void *arg, int begin, int end)
+{
+  mulSoaBlocks(arg, begin, end);
+}
+
+__attribute__((target("avx512f")))
+static void
+mulSoaChunkAvx512(void *arg, int begin, int end)
+{
+  mulSoaBlocks(arg, begin, end);
+}
+
+//indexed by GemmKernelId
+static const ParallelForFn mulSoaChunks[N_GEMM_KERNELS] = {
+  mulSoaChunk, mulSoaChunkSse41, mulSoaChunkAvx2, mulSoaChunkAvx512,
+};
+
+#else
+
+//only the scalar variant is ever selected when not on x86
+static const ParallelForFn mulSoaChunks[N_GEMM_KERNELS] = {
+  mulSoaChunk, mulSoaChunk, mulSoaChunk, mulSoaChunk,
+};
+
+#endif
+
+void
+batchMul(BatchLayout layout, int count, int m, int n, int p,
+         const MatrixBaseType *a, const MatrixBaseType *b,
+         MatrixBaseType *c, int *err)
+{
+  if (count < 0 || m <= 0 || n <= 0 || p <= 0) {
+    *err = EINVAL;
+    return;
+  }
+  BatchArgs args = {
+    .count = count, .m = m, .n = n, .p = p, .a = a, .b = b, .c = c,
+  };
+  //the structure of arrays layout uses the instruction set selected
+  //for the gemm micro-kernels by setGemmKernel()
+  ParallelForFn fn =
+    (layout == BATCH_LAYOUT_SOA) ? mulSoaChunks[getGemmKernel()] : mulAosChunk;
+  parallelFor(count, BATCH_CHUNK, fn, &args);
+}
+
+void
+convertBatchLayout(int count, int nRows, int nCols,
+                   BatchLayout srcLayout, const MatrixBaseType *src,
+                   BatchLayout dstLayout, MatrixBaseType *dst)
+{
+  const size_t size = (size_t)nRows*nCols;
+  if (srcLayout == dstLayout) {
+    memcpy(dst, src, count*size*sizeof(MatrixBaseType));
+    return;
+  }
+  //entry e of matrix t is at [t*size + e] in AOS, [e*count + t] in SOA
+  for (int t = 0; t < count; t++) {
+    for (size_t e = 0; e < size; e++) {
+      if (srcLayout == BATCH_LAYOUT_AOS) {
+        dst[e*count + t] = src[t*size + e];
+      }
+      else {
+        dst[t*size + e] = src[e*count + t];
+      }
+    }
+  }
+}
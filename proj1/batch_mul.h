@@ -0,0 +1,52 @@
+#ifndef _BATCH_MUL_H
+#define _BATCH_MUL_H
+
+#include "matrix.h"
+
+/** Multiplication of batches of small matrices of the same shape.
+ *  Rather than creating a Matrix for each operand, the operands of a
+ *  batch are stored in a single array and all the products are
+ *  computed by a single call, so that the per-matrix costs of
+ *  allocation, function dispatch and dimension checking are paid
+ *  once per batch.
+ */
+
+/** Identifies how the count matrices of a batch are stored in an
+ *  array.
+ */
+typedef enum {
+  /** Array of structures: the matrices are stored one after the
+   *  other, each in row-major order; entry [i][j] of matrix t of a
+   *  batch of nRows x nCols matrices is at [(t*nRows + i)*nCols + j].
+   */
+  BATCH_LAYOUT_AOS,
+
+  /** Structure of arrays: the matrices are interleaved, so that the
+   *  same entry of all the matrices is stored consecutively; entry
+   *  [i][j] of matrix t of a batch of count matrices is at
+   *  [(i*nCols + j)*count + t].  Multiplication in this layout works
+   *  on many matrices at once using SIMD instructions.
+   */
+  BATCH_LAYOUT_SOA,
+} BatchLayout;
+
+/** Set each of the count m x p matrices in c to the product of the
+ *  corresponding m x n matrix in a and n x p matrix in b, where all
+ *  of a, b and c are stored using layout.  c must not overlap a or b.
+ *  The batch is split among the threads of the thread pool.
+ *
+ *  Set *err to EINVAL if count < 0 or any of m, n, p <= 0.
+ */
+void batchMul(BatchLayout layout, int count, int m, int n, int p,
+              const MatrixBaseType *a, const MatrixBaseType *b,
+              MatrixBaseType *c, int *err);
+
+/** Copy the count nRows x nCols matrices stored in src using the
+ *  srcLayout layout into dst using the dstLayout layout.  dst must not
+ *  overlap src.
+ */
+void convertBatchLayout(int count, int nRows, int nCols,
+                        BatchLayout srcLayout, const MatrixBaseType *src,
+                        BatchLayout dstLayout, MatrixBaseType *dst);
+
+#endif //ifndef _BATCH_MUL_H
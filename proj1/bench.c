@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+double
+getBenchTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static int
+compareDoubles(const void *p1, const void *p2)
+{
+  double d1 = *(const double *)p1, d2 = *(const double *)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+void
+computeBenchStats(double secs[], int nTrials, BenchStats *stats)
+{
+  qsort(secs, nTrials, sizeof(double), compareDoubles);
+  stats->nTrials = nTrials;
+  stats->minSecs = secs[0];
+  stats->medianSecs = (nTrials % 2 == 1)
+    ? secs[nTrials/2]
+    : (secs[nTrials/2 - 1] + secs[nTrials/2])/2;
+  int p95Rank = (95*nTrials + 99)/100;   //ceil(0.95*nTrials)
+  stats->p95Secs = secs[p95Rank - 1];
+}
+
+#define CSV_HEADER \
+  "op,lhs,rhs,n,threads,trials,min_s,median_s,p95_s,rate,unit,allocs"
+
+/** Metrics computed from hardware counts: IPC followed by misses per
+ *  multiply-add for each miss counter.
+ */
+static const struct { const char *name; PerfCounterId counter; }
+missMetrics[] = {
+  { "l1d_miss_per_fma", PERF_L1D_MISSES },
+  { "llc_miss_per_fma", PERF_LLC_MISSES },
+  { "dtlb_miss_per_fma", PERF_DTLB_MISSES },
+  { "branch_miss_per_fma", PERF_BRANCH_MISSES },
+};
+
+#define IPC_METRIC "ipc"
+#define N_MISS_METRICS (int)(sizeof(missMetrics)/sizeof(missMetrics[0]))
+
+/** Output metric name with value on report if isValid. */
+static void
+outMetric(BenchReport *report, const char *name, _Bool isValid, double value)
+{
+  if (report->format == BENCH_CSV) {
+    if (isValid) {
+      fprintf(report->out, ",%.4g", value);
+    }
+    else {
+      fprintf(report->out, ",");
+    }
+  }
+  else {
+    if (isValid) {
+      fprintf(report->out, ", \"%s\": %.4g", name, value);
+    }
+    else {
+      fprintf(report->out, ", \"%s\": null", name);
+    }
+  }
+}
+
+/** Output metrics computed from r->counts on report */
+static void
+outCounterMetrics(BenchReport *report, const BenchRecord *r)
+{
+  const PerfCounts *c = r->counts;
+  _Bool isIpcValid = c && c->isValid[PERF_CYCLES] &&
+    c->isValid[PERF_INSTRUCTIONS] && c->values[PERF_CYCLES] > 0;
+  outMetric(report, IPC_METRIC, isIpcValid,
+            isIpcValid
+            ? c->values[PERF_INSTRUCTIONS]/c->values[PERF_CYCLES]
+            : 0);
+  for (int i = 0; i < N_MISS_METRICS; i++) {
+    PerfCounterId id = missMetrics[i].counter;
+    _Bool isValid = c && c->isValid[id] && r->nFmas > 0;
+    outMetric(report, missMetrics[i].name, isValid,
+              isValid ? c->values[id]/r->nFmas : 0);
+  }
+}
+
+void
+beginBenchReport(BenchReport *report, FILE *out, BenchFormat format,
+                 _Bool hasCounters)
+{
+  report->out = out;
+  report->format = format;
+  report->hasCounters = hasCounters;
+  report->nRecords = 0;
+  if (format == BENCH_CSV) {
+    fprintf(out, CSV_HEADER);
+    if (hasCounters) {
+      fprintf(out, "," IPC_METRIC);
+      for (int i = 0; i < N_MISS_METRICS; i++) {
+        fprintf(out, ",%s", missMetrics[i].name);
+      }
+    }
+    fprintf(out, "\n");
+  }
+  else {
+    fprintf(out, "[");
+  }
+}
+
+void
+outBenchRecord(BenchReport *report, const BenchRecord *r)
+{
+  FILE *out = report->out;
+  const char *rhs = (r->rhs) ? r->rhs : "";
+  if (report->format == BENCH_CSV) {
+    fprintf(out, "%s,%s,%s,%d,%d,%d,%.9f,%.9f,%.9f,%.6g,%s,%.4g",
+            r->op, r->lhs, rhs, r->n, r->nThreads, r->stats.nTrials,
+            r->stats.minSecs, r->stats.medianSecs, r->stats.p95Secs,
+            r->rate, r->rateUnit, r->nAllocs);
+    if (report->hasCounters) outCounterMetrics(report, r);
+    fprintf(out, "\n");
+  }
+  else {
+    fprintf(out, "%s\n  {\"op\": \"%s\", \"lhs\": \"%s\", \"rhs\": \"%s\", "
+            "\"n\": %d, \"threads\": %d, \"trials\": %d, "
+            "\"min_s\": %.9f, \"median_s\": %.9f, \"p95_s\": %.9f, "
+            "\"rate\": %.6g, \"unit\": \"%s\", \"allocs\": %.4g",
+            (report->nRecords > 0) ? "," : "",
+            r->op, r->lhs, rhs, r->n, r->nThreads, r->stats.nTrials,
+            r->stats.minSecs, r->stats.medianSecs, r->stats.p95Secs,
+            r->rate, r->rateUnit, r->nAllocs);
+    if (report->hasCounters) outCounterMetrics(report, r);
+    fprintf(out, "}");
+  }
+  fflush(out);
+  report->nRecords++;
+}
+
+void
+endBenchReport(BenchReport *report)
+{
+  if (report->format == BENCH_JSON) fprintf(report->out, "\n]\n");
+}
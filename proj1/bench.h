@@ -0,0 +1,76 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include "perf_counters.h"
+
+#include <stdio.h>
+
+/** Support for benchmarking: high-resolution timing, summary
+ *  statistics over repeated trials and machine-readable output of
+ *  results.
+ */
+
+/** Return the current time in seconds from a monotonic clock with
+ *  nanosecond resolution; only differences between times are
+ *  meaningful.
+ */
+double getBenchTime(void);
+
+/** Summary statistics for the times of repeated trials */
+typedef struct {
+  int nTrials;
+  double minSecs;
+  double medianSecs;
+  double p95Secs;       //95th percentile (nearest rank)
+} BenchStats;
+
+/** Set *stats to the statistics for the nTrials times in secs[];
+ *  secs[] is sorted as a side-effect.
+ */
+void computeBenchStats(double secs[], int nTrials, BenchStats *stats);
+
+/** A single benchmark result */
+typedef struct {
+  const char *op;         //operation benchmarked, e.g. "mul"
+  const char *lhs;        //class of the receiver
+  const char *rhs;        //class of the other operand; NULL if none
+  int n;                  //problem size
+  int nThreads;           //# of threads used
+  BenchStats stats;
+  double rate;            //throughput computed from median time
+  const char *rateUnit;   //unit for rate, e.g. "GOPS"
+  double nAllocs;         //mean # of workspace allocations per run
+  const PerfCounts *counts; //per-run hardware counts; NULL if none
+  double nFmas;           //# of multiply-adds per run; 0 if not relevant
+} BenchRecord;
+
+typedef enum {
+  BENCH_CSV,
+  BENCH_JSON,
+} BenchFormat;
+
+/** Results are written to a report */
+typedef struct {
+  FILE *out;
+  BenchFormat format;
+  _Bool hasCounters;
+  int nRecords;
+} BenchReport;
+
+/** Start writing a report in format on out.  If hasCounters, then
+ *  each record also reports the instructions per cycle and the # of
+ *  misses per multiply-add for each miss counter, computed from its
+ *  counts (which include the work of all the threads used); metrics
+ *  which cannot be computed are output as empty CSV fields or JSON
+ *  nulls.
+ */
+void beginBenchReport(BenchReport *report, FILE *out, BenchFormat format,
+                      _Bool hasCounters);
+
+/** Write record to report */
+void outBenchRecord(BenchReport *report, const BenchRecord *record);
+
+/** Finish writing report */
+void endBenchReport(BenchReport *report);
+
+#endif //ifndef _BENCH_H
@@ -0,0 +1,131 @@
+#include "blocked_mul_matrix.h"
+#include "dense_matrix.h"
+#include "gemm_kernel.h"
+#include "transpose_view.h"
+#include "typed_matrix.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+typedef struct {
+  DenseMatrix;
+} BlockedMulMatrixImpl;
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  return "blockedMulMatrix";
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  return MATRIX_KLASS_BLOCKED_MUL;
+}
+
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of all the matrices
+  int lda, ldb, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (a && c && !b) {
+    // A transpose view of a matrix with row-major storage can be
+    // multiplied using dot products of rows without transposing
+    const Matrix *viewBase = getTransposeViewBase(multiplier);
+    const MatrixBaseType *bt =
+      (viewBase) ? viewBase->fns->getData(viewBase, &ldb, err) : NULL;
+    if (*err == EINVAL) return;
+    if (bt) {
+      gemmTransB(pr_m, this_n, pr_p, a, lda, bt, ldb, c, ldc);
+      return;
+    }
+  }
+  if (!a || !b || !c) {
+    getDenseMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+  gemmBlocked(pr_m, this_n, pr_p, a, lda, b, ldb, c, ldc);
+}
+
+static _Bool isInit = false;
+static BlockedMulMatrixFns blockedMulMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .mul = mul,
+};
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a cache-blocked multiplication algorithm.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+BlockedMulMatrix *
+newBlockedMulMatrix(int nRows, int nCols, int *err)
+{
+  BlockedMulMatrixImpl *matrix =
+    (BlockedMulMatrixImpl *)newDenseMatrix(nRows, nCols, err);
+  if (*err == EINVAL || *err == ENOMEM) return NULL;
+
+  matrix->fns = (MatrixFns *)getBlockedMulMatrixFns();
+  return (BlockedMulMatrix *)matrix;
+}
+
+static void patchBlockedMulMatrixFns(void)
+{
+  if (!isInit) {
+    const DenseMatrixFns *fns = getDenseMatrixFns();
+    blockedMulMatrixFns.free = fns->free;
+    blockedMulMatrixFns.getNRows = fns->getNRows;
+    blockedMulMatrixFns.getNCols = fns->getNCols;
+    blockedMulMatrixFns.getElement = fns->getElement;
+    blockedMulMatrixFns.setElement = fns->setElement;
+    blockedMulMatrixFns.getRow = fns->getRow;
+    blockedMulMatrixFns.setRow = fns->setRow;
+    blockedMulMatrixFns.getData = fns->getData;
+    blockedMulMatrixFns.transpose = fns->transpose;
+    blockedMulMatrixFns.mulVec = fns->mulVec;
+    blockedMulMatrixFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+/** Return implementation of functions for a blocked multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const BlockedMulMatrixFns *
+getBlockedMulMatrixFns(void)
+{
+  patchBlockedMulMatrixFns();
+  return &blockedMulMatrixFns;
+}
+
+#define TM_TEMPLATE "blocked_mul_matrix_template.h"
+#include "typed_matrix_instances.h"
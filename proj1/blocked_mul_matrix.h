@@ -0,0 +1,35 @@
+#ifndef _BLOCKED_MUL_MATRIX_H
+#define _BLOCKED_MUL_MATRIX_H
+
+#include "matrix.h"
+
+typedef struct BlockedMulMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} BlockedMulMatrixFns;
+
+typedef struct BlockedMulMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} BlockedMulMatrix;
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a cache-blocked multiplication algorithm: the multiplication is
+ *  tiled so that blocks of the operands stay resident in the L1/L2
+ *  caches, working directly on the dense storage when the
+ *  multiplier and product are also dense matrices.  A multiplier
+ *  which is a transpose view (see transpose_view.h) of a dense matrix
+ *  is handled using dot products of rows without transposing it.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+BlockedMulMatrix *newBlockedMulMatrix(int nRows, int nCols, int *err);
+
+/** Return implementation of functions for a blocked multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const BlockedMulMatrixFns *getBlockedMulMatrixFns(void);
+
+#endif //ifndef _BLOCKED_MUL_MATRIX_H
@@ -0,0 +1,127 @@
+/** Template for the implementation of the blocked multiplication
+ *  matrix class for a single element type; see typed_template.h.
+ */
+
+typedef struct {
+  TM_NAME(DenseMatrix);
+} TM_NAME(BlockedMulMatrixImpl);
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  return "blockedMulMatrix" TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  return MATRIX_KLASS_BLOCKED_MUL;
+}
+
+static void
+TM_NAME(mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+             TM_NAME(Matrix) *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of all the matrices
+  int lda, ldb, ldc;
+  const TM_TYPE *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return;
+  const TM_TYPE *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (a && c && !b) {
+    // A transpose view of a matrix with row-major storage can be
+    // multiplied using dot products of rows without transposing
+    const TM_NAME(Matrix) *viewBase = TM_NAME(getTransposeViewBase)(multiplier);
+    const TM_TYPE *bt =
+      (viewBase) ? viewBase->fns->getData(viewBase, &ldb, err) : NULL;
+    if (*err == EINVAL) return;
+    if (bt) {
+      TM_NAME(gemmTransB)(pr_m, this_n, pr_p, a, lda, bt, ldb, c, ldc);
+      return;
+    }
+  }
+  if (!a || !b || !c) {
+    TM_NAME(getDenseMatrixFns)()->mul(this, multiplier, product, err);
+    return;
+  }
+  TM_NAME(gemmBlocked)(pr_m, this_n, pr_p, a, lda, b, ldb, c, ldc);
+}
+
+static _Bool TM_NAME(isInit) = false;
+static TM_NAME(BlockedMulMatrixFns) TM_NAME(blockedMulMatrixFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .mul = TM_NAME(mul),
+};
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a cache-blocked multiplication algorithm.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+TM_NAME(BlockedMulMatrix) *
+TM_NAME(newBlockedMulMatrix)(int nRows, int nCols, int *err)
+{
+  TM_NAME(BlockedMulMatrixImpl) *matrix =
+    (TM_NAME(BlockedMulMatrixImpl) *)TM_NAME(newDenseMatrix)(nRows, nCols, err);
+  if (*err == EINVAL || *err == ENOMEM) return NULL;
+
+  matrix->fns = (TM_NAME(MatrixFns) *)TM_NAME(getBlockedMulMatrixFns)();
+  return (TM_NAME(BlockedMulMatrix) *)matrix;
+}
+
+static void
+TM_NAME(patchBlockedMulMatrixFns)(void)
+{
+  if (!TM_NAME(isInit)) {
+    const TM_NAME(DenseMatrixFns) *fns = TM_NAME(getDenseMatrixFns)();
+    TM_NAME(blockedMulMatrixFns).free = fns->free;
+    TM_NAME(blockedMulMatrixFns).getNRows = fns->getNRows;
+    TM_NAME(blockedMulMatrixFns).getNCols = fns->getNCols;
+    TM_NAME(blockedMulMatrixFns).getElement = fns->getElement;
+    TM_NAME(blockedMulMatrixFns).setElement = fns->setElement;
+    TM_NAME(blockedMulMatrixFns).getRow = fns->getRow;
+    TM_NAME(blockedMulMatrixFns).setRow = fns->setRow;
+    TM_NAME(blockedMulMatrixFns).getData = fns->getData;
+    TM_NAME(blockedMulMatrixFns).transpose = fns->transpose;
+    TM_NAME(blockedMulMatrixFns).mulVec = fns->mulVec;
+    TM_NAME(blockedMulMatrixFns).vecMul = fns->vecMul;
+    TM_NAME(isInit) = true;
+  }
+}
+
+/** Return implementation of functions for a blocked multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const TM_NAME(BlockedMulMatrixFns) *
+TM_NAME(getBlockedMulMatrixFns)(void)
+{
+  TM_NAME(patchBlockedMulMatrixFns)();
+  return &TM_NAME(blockedMulMatrixFns);
+}
@@ -1,16 +1,26 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "abstract_matrix.h"
 #include "dense_matrix.h"
+#include "dense_matrix_impl.h"
+#include "gemm_kernel.h"
+#include "matrix_file.h"
+#include "mul_dispatch.h"
+#include "small_mul_kernel.h"
+#include "thread_pool.h"
+#include "transpose_kernel.h"
+#include "typed_matrix.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
-typedef struct {
-  DenseMatrix;
-  int nRows;
-  int nCols;
-  MatrixBaseType mat[];
-} DenseMatrixImpl;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 /** Examines the matrix as a DenseMatrix, and verifies that it is
     in a valid state, otherwise, set *err to EINVAL. */
@@ -28,10 +38,17 @@ static const char *getKlass(const Matrix *this, int *err)
   return "denseMatrix";
 }
 
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifyDenseMatrix(this, err);
+  return MATRIX_KLASS_DENSE;
+}
+
 static void freeDenseMatrix(Matrix *this, int *err)
 {
   verifyDenseMatrix(this, err);
   DenseMatrixImpl *matrix = (DenseMatrixImpl *)this;
+  if (matrix->mapping) munmap(matrix->mapping, matrix->mappingSize);
   free(matrix);
 }
 
@@ -63,7 +80,7 @@ static MatrixBaseType getElement(const Matrix *this,
     return 0;
   }
 
-  return matrix->mat[rowIndex*nCols+colIndex];
+  return matrix->mat[(size_t)rowIndex*matrix->rowStride + colIndex];
 }
 
 static void setElement(Matrix *this, int rowIndex, int colIndex,
@@ -80,34 +97,213 @@ static void setElement(Matrix *this, int rowIndex, int colIndex,
     return;
   }
 
-  matrix->mat[rowIndex*nCols+colIndex] = element;
+  matrix->mat[(size_t)rowIndex*matrix->rowStride + colIndex] = element;
+}
+
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const DenseMatrixImpl *matrix = (const DenseMatrixImpl *)this;
+  verifyDenseMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  memcpy(row, &matrix->mat[(size_t)rowIndex*matrix->rowStride],
+         matrix->nCols*sizeof(MatrixBaseType));
+}
+
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  DenseMatrixImpl *matrix = (DenseMatrixImpl *)this;
+  verifyDenseMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  memcpy(&matrix->mat[(size_t)rowIndex*matrix->rowStride], row,
+         matrix->nCols*sizeof(MatrixBaseType));
+}
+
+static MatrixBaseType *getData(const Matrix *this, int *rowStride, int *err)
+{
+  DenseMatrixImpl *matrix = (DenseMatrixImpl *)this;
+  verifyDenseMatrix(this, err);
+  if (*err == EINVAL) return NULL;
+  *rowStride = matrix->rowStride;
+  return matrix->mat;
+}
+
+static void transpose(const Matrix *this, Matrix *result, int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const DenseMatrixImpl *matrix = (const DenseMatrixImpl *)this;
+  verifyDenseMatrix(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(matrix->nRows == result_m && matrix->nCols == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic transpose unless we can get at the
+  // storage of the result
+  int resultLd;
+  MatrixBaseType *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!res) {
+    getAbstractMatrixFns()->transpose(this, result, err);
+    return;
+  }
+  transposeRecursive(matrix->nRows, matrix->nCols, matrix->mat,
+                     matrix->rowStride, res, resultLd);
+}
+
+/** Works on any matrices, since sub-classes and views fall back to
+ *  it when the storage of some operand is not available.
+ */
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Use the kernel specialized for the shape if there is one and we
+  // can get at the storage of all the matrices
+  SmallMulFn smallKernel = getSmallMulKernel(pr_m, mul_n, pr_p);
+  if (smallKernel) {
+    int lda, ldb, ldc;
+    const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+    if (*err == EINVAL) return;
+    const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+    if (*err == EINVAL) return;
+    MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+    if (*err == EINVAL) return;
+    if (a && b && c) {
+      smallKernel(pr_m, mul_n, a, lda, b, ldb, c, ldc);
+      return;
+    }
+  }
+
+  // Otherwise use the kernel registered for the classes of the
+  // matrices, falling back to the generic multiplication
+  MulKernelFn kernel = getMulKernel(this, multiplier, product, err);
+  if (*err == EINVAL) return;
+  if (kernel && kernel(this, multiplier, product, err)) return;
+  if (*err == EINVAL) return;
+  getAbstractMatrixFns()->mul(this, multiplier, product, err);
+}
+
+/** Works on the storage of any matrix which provides it, so that
+ *  views and sub-classes can inherit it.
+ */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  int ld;
+  const MatrixBaseType *data = this->fns->getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    getAbstractMatrixFns()->mulVec(this, vec, result, err);
+    return;
+  }
+  gemv(nRows, nCols, data, ld, vec, result);
+}
+
+/** Works on the storage of any matrix which provides it, so that
+ *  views and sub-classes can inherit it.
+ */
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  int ld;
+  const MatrixBaseType *data = this->fns->getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    getAbstractMatrixFns()->vecMul(this, vec, result, err);
+    return;
+  }
+  gemvTrans(nRows, nCols, data, ld, vec, result);
 }
 
-static _Bool isInit = false;
 static DenseMatrixFns denseMatrixFns = {
   .getKlass = getKlass,
+  .getKlassId = getKlassId,
   .free = freeDenseMatrix,
   .getNRows = getNRows,
   .getNCols = getNCols,
   .getElement = getElement,
   .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .getData = getData,
+  .transpose = transpose,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
 };
 
-static void patchDenseMatrixFns(void)
+static _Bool isPadded = true;
+
+void
+setDenseMatrixPadding(_Bool padded)
 {
-  // Set up the methods if not already done
-  if (!isInit) {
-    const MatrixFns *fns = getAbstractMatrixFns();
-    denseMatrixFns.transpose = fns->transpose;
-    denseMatrixFns.mul = fns->mul;
-    isInit = true;
+  isPadded = padded;
+}
+
+/** Return the row stride for a new matrix with nCols columns: a whole
+ *  # of cache lines, plus one more line when that # is a multiple of
+ *  DENSE_MATRIX_CONFLICT_LINES.
+ */
+static int
+getPaddedRowStride(int nCols)
+{
+  enum { LINE_ENTRIES = DENSE_MATRIX_ALIGN/sizeof(MatrixBaseType) };
+  if (!isPadded || nCols < LINE_ENTRIES || nCols > INT_MAX - 2*LINE_ENTRIES) {
+    return nCols;
   }
+  int nLines = (nCols + LINE_ENTRIES - 1)/LINE_ENTRIES;
+  if (nLines % DENSE_MATRIX_CONFLICT_LINES == 0) nLines++;
+  return nLines*LINE_ENTRIES;
 }
 
-/** Return a newly allocated matrix with all entries in consecutive
- *  memory locations (row-major layout).  All entries in the newly
- *  created matrix are initialized to 0.  Set *err to EINVAL if nRows
- *  or nCols <= 0, to ENOMEM if not enough memory.
+/** Return a newly allocated matrix with its entries in row-major
+ *  layout, with aligned and padded storage.  All entries in the newly
+ *  created matrix are initialized to 0.  Multiplications where all
+ *  dimensions are small use the specialized kernels in
+ *  small_mul_kernel.h; others use the kernel registered in
+ *  mul_dispatch.h, or else the generic algorithm.  Set *err to
+ *  EINVAL if nRows or nCols <= 0, to ENOMEM if not enough memory.
  */
 DenseMatrix *
 newDenseMatrix(int nRows, int nCols, int *err)
@@ -118,27 +314,190 @@ newDenseMatrix(int nRows, int nCols, int *err)
     return NULL;
   }
 
-  // Allocate the matrix with rows, check
-  DenseMatrixImpl *matrix = malloc(sizeof(DenseMatrixImpl) +
-				   nRows*nCols*sizeof(MatrixBaseType *));
+  // Allocate the header and storage together, with enough slack to
+  // align the storage; calloc() leaves freshly mapped pages of large
+  // matrices untouched until they are used
+  const int rowStride = getPaddedRowStride(nCols);
+  const size_t storageSize = (size_t)nRows*rowStride*sizeof(MatrixBaseType);
+  if (storageSize/rowStride/sizeof(MatrixBaseType) != (size_t)nRows) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  DenseMatrixImpl *matrix =
+    calloc(1, sizeof(DenseMatrixImpl) + DENSE_MATRIX_ALIGN - 1 + storageSize);
   if (!matrix) {
     *err = ENOMEM;
     return NULL;
   }
 
+  const uintptr_t storage = (uintptr_t)&matrix[1];
   matrix->nRows = nRows;
   matrix->nCols = nCols;
+  matrix->rowStride = rowStride;
+  matrix->mat = (MatrixBaseType *)
+    ((storage + DENSE_MATRIX_ALIGN - 1) & ~(uintptr_t)(DENSE_MATRIX_ALIGN - 1));
+  matrix->mapping = NULL;
+  matrix->mappingSize = 0;
+  matrix->workspace = NULL;
   matrix->fns = (MatrixFns *)getDenseMatrixFns();
   
   return (DenseMatrix *)matrix;
 }
 
+DenseMatrix *
+newDenseMatrixFromFile(const char *path, _Bool isShared, int *err)
+{
+  int fd = open(path, (isShared) ? O_RDWR : O_RDONLY);
+  if (fd < 0) {
+    *err = errno;
+    return NULL;
+  }
+  MatrixFileHeader header;
+  readMatrixFileHeader(fd, &header, err);
+  size_t size = (*err) ? 0 : getMatrixFileSize(&header, err);
+  if (*err) {
+    close(fd);
+    return NULL;
+  }
+  DenseMatrixImpl *matrix = malloc(sizeof(DenseMatrixImpl));
+  if (!matrix) {
+    *err = ENOMEM;
+    close(fd);
+    return NULL;
+  }
+
+  // Map the whole file, since the offset of a mapping must be page
+  // aligned; the mapping remains valid after the file is closed
+  void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       (isShared) ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) {
+    *err = errno;
+    free(matrix);
+    close(fd);
+    return NULL;
+  }
+  close(fd);
+
+  matrix->nRows = header.nRows;
+  matrix->nCols = header.nCols;
+  matrix->rowStride = header.rowStride;
+  matrix->mat = (MatrixBaseType *)((char *)mapping + header.dataOffset);
+  matrix->mapping = mapping;
+  matrix->mappingSize = size;
+  matrix->workspace = NULL;
+  matrix->fns = (MatrixFns *)getDenseMatrixFns();
+  return (DenseMatrix *)matrix;
+}
+
+void
+setDenseMatrixWorkspace(DenseMatrix *matrix, Workspace *workspace)
+{
+  ((DenseMatrixImpl *)matrix)->workspace = workspace;
+}
+
+Workspace *
+getDenseMatrixWorkspace(const DenseMatrix *matrix, int *err)
+{
+  Workspace *workspace = ((const DenseMatrixImpl *)matrix)->workspace;
+  return (workspace) ? workspace : getThreadWorkspace(err);
+}
+
+DenseMatrix *
+asDenseMatrix(const Matrix *matrix)
+{
+  int err = 0;
+  switch (matrix->fns->getKlassId(matrix, &err)) {
+  case MATRIX_KLASS_DENSE:
+  case MATRIX_KLASS_SMART_MUL:
+  case MATRIX_KLASS_BLOCKED_MUL:
+  case MATRIX_KLASS_PARALLEL_MUL:
+  case MATRIX_KLASS_STRASSEN:
+    return (err) ? NULL : (DenseMatrix *)matrix;
+  default:
+    return NULL;
+  }
+}
+
+/** Arguments for filling or copying a band of rows of a matrix */
+typedef struct {
+  DenseMatrixImpl *matrix;
+  MatrixBaseType element;       //for filling
+  const MatrixBaseType *src;    //for copying
+  int lds;
+} CopyBand;
+
+/** Minimum # of entries in each band of rows filled or copied by a
+ *  task, so that small matrices are done by the calling thread alone
+ */
+enum { COPY_BAND_ENTRIES = 1 << 14 };
+
+static int
+getCopyBandRows(const DenseMatrixImpl *matrix)
+{
+  const int bandRows = COPY_BAND_ENTRIES/matrix->nCols;
+  return (bandRows < 1) ? 1 : bandRows;
+}
+
+static void
+fillBand(void *arg, int begin, int end)
+{
+  const CopyBand *band = arg;
+  const DenseMatrixImpl *matrix = band->matrix;
+  for (int i = begin; i < end; i++) {
+    MatrixBaseType *row = &matrix->mat[(size_t)i*matrix->rowStride];
+    for (int j = 0; j < matrix->nCols; j++) row[j] = band->element;
+  }
+}
+
+void
+fillDenseMatrix(DenseMatrix *matrix, MatrixBaseType element)
+{
+  CopyBand band = {
+    .matrix = (DenseMatrixImpl *)matrix, .element = element,
+  };
+  parallelFor(band.matrix->nRows, getCopyBandRows(band.matrix), fillBand,
+              &band);
+}
+
+static void
+copyBand(void *arg, int begin, int end)
+{
+  const CopyBand *band = arg;
+  const DenseMatrixImpl *matrix = band->matrix;
+  for (int i = begin; i < end; i++) {
+    memcpy(&matrix->mat[(size_t)i*matrix->rowStride],
+           &band->src[(size_t)i*band->lds],
+           matrix->nCols*sizeof(MatrixBaseType));
+  }
+}
+
+void
+copyToDenseMatrix(DenseMatrix *matrix, const MatrixBaseType src[], int lds)
+{
+  CopyBand band = { .matrix = (DenseMatrixImpl *)matrix, .src = src,
+                    .lds = lds };
+  parallelFor(band.matrix->nRows, getCopyBandRows(band.matrix), copyBand,
+              &band);
+}
+
+void
+copyFromDenseMatrix(const DenseMatrix *matrix, MatrixBaseType dst[], int ldd)
+{
+  const DenseMatrixImpl *impl = (const DenseMatrixImpl *)matrix;
+  for (int i = 0; i < impl->nRows; i++) {
+    memcpy(&dst[(size_t)i*ldd], &impl->mat[(size_t)i*impl->rowStride],
+           impl->nCols*sizeof(MatrixBaseType));
+  }
+}
+
 /** Return implementation of functions for a dense matrix; these functions
  *  can be used by sub-classes to inherit behavior from this class.
  */
 const DenseMatrixFns *
 getDenseMatrixFns(void)
 {
-  patchDenseMatrixFns();
   return &denseMatrixFns;
 }
+
+#define TM_TEMPLATE "dense_matrix_template.h"
+#include "typed_matrix_instances.h"
@@ -2,6 +2,7 @@
 #define _SIMPLE_MATRIX_H
 
 #include "matrix.h"
+#include "workspace.h"
 
 typedef struct {
   MatrixFns;     //-fms-extensions inserts MatrixFns fields into struct
@@ -11,13 +12,158 @@ typedef struct {
   Matrix;        //-fms-extensions inserts Matrix fields into struct
 } DenseMatrix;
 
-/** Return a newly allocated matrix with all entries in consecutive
- *  memory locations (row-major layout).  All entries in the newly
- *  created matrix are initialized to 0.  Set *err to EINVAL if nRows
- *  or nCols <= 0, to ENOMEM if not enough memory.
+/** Alignment in bytes of the storage of a dense matrix: a cache line,
+ *  which is also the width of the widest vector registers.
+ */
+enum { DENSE_MATRIX_ALIGN = 64 };
+
+/** Padded rows are given an extra cache line when their # of lines is
+ *  a multiple of this (512 bytes): such strides map successive rows to
+ *  only a fraction of the cache sets.
+ */
+enum { DENSE_MATRIX_CONFLICT_LINES = 8 };
+
+/** The leading fields of every dense matrix (an instance of
+ *  DenseMatrix or any of its sub-classes).  These are only public so
+ *  that the inline accessors below can be used in hot loops without
+ *  calling through fns; use the accessors rather than the fields.
+ */
+typedef struct {
+  DenseMatrix;
+  int nRows;
+  int nCols;
+  int rowStride;          //# of entries between starts of successive rows
+  MatrixBaseType *mat;    //DENSE_MATRIX_ALIGN-aligned storage allocated
+                          //after the matrix, or into a mapped file
+} DenseMatrixHeader;
+
+/** Unchecked accessors for dense matrices.  Unlike the functions in
+ *  fns, these do not validate the matrix or check indexes, and are
+ *  inlined rather than called indirectly; they are intended for loops
+ *  over many entries of a matrix which is known to be valid.
+ */
+
+static inline int
+getDenseMatrixNRows(const DenseMatrix *matrix)
+{
+  return ((const DenseMatrixHeader *)matrix)->nRows;
+}
+
+static inline int
+getDenseMatrixNCols(const DenseMatrix *matrix)
+{
+  return ((const DenseMatrixHeader *)matrix)->nCols;
+}
+
+/** Return the # of entries between the starts of successive rows. */
+static inline int
+getDenseMatrixRowStride(const DenseMatrix *matrix)
+{
+  return ((const DenseMatrixHeader *)matrix)->rowStride;
+}
+
+/** Return a pointer to entry [0][0]; entry [i][j] is at offset
+ *  i*getDenseMatrixRowStride() + j.
+ */
+static inline MatrixBaseType *
+getDenseMatrixData(const DenseMatrix *matrix)
+{
+  return ((const DenseMatrixHeader *)matrix)->mat;
+}
+
+static inline MatrixBaseType
+getDenseMatrixElement(const DenseMatrix *matrix, int rowIndex, int colIndex)
+{
+  const DenseMatrixHeader *header = (const DenseMatrixHeader *)matrix;
+  return header->mat[(size_t)rowIndex*header->rowStride + colIndex];
+}
+
+static inline void
+setDenseMatrixElement(DenseMatrix *matrix, int rowIndex, int colIndex,
+                      MatrixBaseType element)
+{
+  DenseMatrixHeader *header = (DenseMatrixHeader *)matrix;
+  header->mat[(size_t)rowIndex*header->rowStride + colIndex] = element;
+}
+
+/** Return a newly allocated matrix with its entries in row-major
+ *  layout.  The storage starts on a DENSE_MATRIX_ALIGN boundary and,
+ *  unless disabled by setDenseMatrixPadding(), rows of at least a
+ *  cache line are padded to a whole # of cache lines, plus one more
+ *  line when that # is a multiple of DENSE_MATRIX_CONFLICT_LINES, so
+ *  that walking down a column touches every cache set rather than
+ *  repeatedly evicting the same few (as happens when the row length
+ *  is a large power of two); getData() returns the padded row stride.
+ *  All entries in the newly created matrix are initialized to 0.
+ *  Multiplications where all dimensions are small use the
+ *  specialized kernels in small_mul_kernel.h; others use the kernel
+ *  registered in mul_dispatch.h for the classes of the operands, or
+ *  else the generic algorithm.  Set *err to EINVAL if nRows or
+ *  nCols <= 0, to ENOMEM if not enough memory.
  */
 DenseMatrix *newDenseMatrix(int nRows, int nCols, int *err);
 
+/** Set whether the rows of dense matrices (including those of all the
+ *  sub-classes) created after this call are padded; they are padded by
+ *  default.  Intended for measuring the effect of the padding.
+ */
+void setDenseMatrixPadding(_Bool isPadded);
+
+/** Return a new dense matrix whose entries are stored in the matrix
+ *  file (see matrix_file.h) at path, which is mapped into memory
+ *  rather than copied: pages are only read when they are accessed.  If
+ *  isShared, then changes to the matrix are written back to the file;
+ *  otherwise changes are private to the matrix and the file is only
+ *  read.  The file may be removed once the matrix has been created,
+ *  but must not be truncated while the matrix is in use.
+ *
+ *  Set *err to EINVAL if the file is not a valid matrix file with
+ *  entries of type MatrixBaseType, to ENOMEM if not enough memory, or
+ *  to errno if the file cannot be opened or mapped.
+ */
+DenseMatrix *newDenseMatrixFromFile(const char *path, _Bool isShared,
+                                    int *err);
+
+/** Make operations on matrix (an instance of DenseMatrix or any of its
+ *  sub-classes) take their scratch memory from workspace rather than
+ *  from the calling thread's workspace; if workspace is NULL, revert
+ *  to using the calling thread's workspace.  The workspace is not
+ *  freed when matrix is freed.
+ */
+void setDenseMatrixWorkspace(DenseMatrix *matrix, Workspace *workspace);
+
+/** Return the workspace which operations on matrix should use for
+ *  scratch memory: the one set by setDenseMatrixWorkspace() or else
+ *  the calling thread's workspace.  Set *err to ENOMEM if not enough
+ *  memory.
+ */
+Workspace *getDenseMatrixWorkspace(const DenseMatrix *matrix, int *err);
+
+/** Return matrix as a dense matrix if it is an instance of DenseMatrix
+ *  or any of its sub-classes (so that the accessors above can be used
+ *  on it); otherwise return NULL.
+ */
+DenseMatrix *asDenseMatrix(const Matrix *matrix);
+
+/** Set all entries of matrix to element.  Large matrices are filled
+ *  in parallel on the thread pool.
+ */
+void fillDenseMatrix(DenseMatrix *matrix, MatrixBaseType element);
+
+/** Set the entries of matrix from the row-major entries in src, whose
+ *  rows start lds entries apart.  Large matrices are copied in
+ *  parallel on the thread pool, so that the pages of the storage are
+ *  first touched by the threads which go on to use them.
+ */
+void copyToDenseMatrix(DenseMatrix *matrix, const MatrixBaseType src[],
+                       int lds);
+
+/** Copy the entries of matrix in row-major order into dst, whose rows
+ *  start ldd entries apart.
+ */
+void copyFromDenseMatrix(const DenseMatrix *matrix, MatrixBaseType dst[],
+                         int ldd);
+
 /** Return implementation of functions for a dense matrix; these functions
  *  can be used by sub-classes to inherit behavior from this class.
  */
@@ -0,0 +1,139 @@
+/** Template for the dense matrix class for a single element type; see
+ *  typed_template.h.
+ */
+
+typedef struct {
+  TM_NAME(MatrixFns); //-fms-extensions inserts MatrixFns fields into struct
+} TM_NAME(DenseMatrixFns);
+
+typedef struct {
+  TM_NAME(Matrix);    //-fms-extensions inserts Matrix fields into struct
+} TM_NAME(DenseMatrix);
+
+/** The leading fields of every dense matrix (an instance of
+ *  DenseMatrix or any of its sub-classes).  These are only public so
+ *  that the inline accessors below can be used in hot loops without
+ *  calling through fns; use the accessors rather than the fields.
+ */
+typedef struct {
+  TM_NAME(DenseMatrix);
+  int nRows;
+  int nCols;
+  int rowStride;          //# of entries between starts of successive rows
+  TM_TYPE *mat;           //DENSE_MATRIX_ALIGN-aligned storage allocated
+                          //after the matrix, or into a mapped file
+} TM_NAME(DenseMatrixHeader);
+
+/** Unchecked accessors for dense matrices.  Unlike the functions in
+ *  fns, these do not validate the matrix or check indexes, and are
+ *  inlined rather than called indirectly; they are intended for loops
+ *  over many entries of a matrix which is known to be valid.
+ */
+
+static inline int
+TM_NAME(getDenseMatrixNRows)(const TM_NAME(DenseMatrix) *matrix)
+{
+  return ((const TM_NAME(DenseMatrixHeader) *)matrix)->nRows;
+}
+
+static inline int
+TM_NAME(getDenseMatrixNCols)(const TM_NAME(DenseMatrix) *matrix)
+{
+  return ((const TM_NAME(DenseMatrixHeader) *)matrix)->nCols;
+}
+
+/** Return the # of entries between the starts of successive rows. */
+static inline int
+TM_NAME(getDenseMatrixRowStride)(const TM_NAME(DenseMatrix) *matrix)
+{
+  return ((const TM_NAME(DenseMatrixHeader) *)matrix)->rowStride;
+}
+
+/** Return a pointer to entry [0][0]; entry [i][j] is at offset
+ *  i*getDenseMatrixRowStride() + j.
+ */
+static inline TM_TYPE *
+TM_NAME(getDenseMatrixData)(const TM_NAME(DenseMatrix) *matrix)
+{
+  return ((const TM_NAME(DenseMatrixHeader) *)matrix)->mat;
+}
+
+static inline TM_TYPE
+TM_NAME(getDenseMatrixElement)(const TM_NAME(DenseMatrix) *matrix,
+                               int rowIndex, int colIndex)
+{
+  const TM_NAME(DenseMatrixHeader) *header =
+    (const TM_NAME(DenseMatrixHeader) *)matrix;
+  return header->mat[(size_t)rowIndex*header->rowStride + colIndex];
+}
+
+static inline void
+TM_NAME(setDenseMatrixElement)(TM_NAME(DenseMatrix) *matrix,
+                               int rowIndex, int colIndex, TM_TYPE element)
+{
+  TM_NAME(DenseMatrixHeader) *header = (TM_NAME(DenseMatrixHeader) *)matrix;
+  header->mat[(size_t)rowIndex*header->rowStride + colIndex] = element;
+}
+
+/** Return a newly allocated matrix with its entries in row-major
+ *  layout.  The storage starts on a DENSE_MATRIX_ALIGN boundary and,
+ *  unless disabled by setDenseMatrixPadding(), rows of at least a
+ *  cache line are padded to a whole # of cache lines, plus one more
+ *  line when that # is a multiple of DENSE_MATRIX_CONFLICT_LINES, so
+ *  that walking down a column touches every cache set rather than
+ *  repeatedly evicting the same few (as happens when the row length
+ *  is a large power of two); getData() returns the padded row stride.
+ *  All entries in the newly created matrix are initialized to 0.
+ *  Operands with storage are multiplied by gemmBlocked(), or by
+ *  gemmTransB() when the multiplier is a transpose view; otherwise the
+ *  generic algorithm is used.  Set *err to EINVAL if nRows or
+ *  nCols <= 0, to ENOMEM if not enough memory.
+ */
+TM_NAME(DenseMatrix) *TM_NAME(newDenseMatrix)(int nRows, int nCols, int *err);
+
+/** Make operations on matrix (an instance of DenseMatrix or any of its
+ *  sub-classes) take their scratch memory from workspace rather than
+ *  from the calling thread's workspace; if workspace is NULL, revert
+ *  to using the calling thread's workspace.  The workspace is not
+ *  freed when matrix is freed.
+ */
+void TM_NAME(setDenseMatrixWorkspace)(TM_NAME(DenseMatrix) *matrix,
+                                      Workspace *workspace);
+
+/** Return the workspace which operations on matrix should use for
+ *  scratch memory: the one set by setDenseMatrixWorkspace() or else
+ *  the calling thread's workspace.  Set *err to ENOMEM if not enough
+ *  memory.
+ */
+Workspace *TM_NAME(getDenseMatrixWorkspace)(const TM_NAME(DenseMatrix) *matrix,
+                                            int *err);
+
+/** Return matrix as a dense matrix if it is an instance of DenseMatrix
+ *  or any of its sub-classes (so that the accessors above can be used
+ *  on it); otherwise return NULL.
+ */
+TM_NAME(DenseMatrix) *TM_NAME(asDenseMatrix)(const TM_NAME(Matrix) *matrix);
+
+/** Set all entries of matrix to element.  Large matrices are filled
+ *  in parallel on the thread pool.
+ */
+void TM_NAME(fillDenseMatrix)(TM_NAME(DenseMatrix) *matrix, TM_TYPE element);
+
+/** Set the entries of matrix from the row-major entries in src, whose
+ *  rows start lds entries apart.  Large matrices are copied in
+ *  parallel on the thread pool, so that the pages of the storage are
+ *  first touched by the threads which go on to use them.
+ */
+void TM_NAME(copyToDenseMatrix)(TM_NAME(DenseMatrix) *matrix,
+                                const TM_TYPE src[], int lds);
+
+/** Copy the entries of matrix in row-major order into dst, whose rows
+ *  start ldd entries apart.
+ */
+void TM_NAME(copyFromDenseMatrix)(const TM_NAME(DenseMatrix) *matrix,
+                                  TM_TYPE dst[], int ldd);
+
+/** Return implementation of functions for a dense matrix; these functions
+ *  can be used by sub-classes to inherit behavior from this class.
+ */
+const TM_NAME(DenseMatrixFns) *TM_NAME(getDenseMatrixFns)(void);
@@ -0,0 +1,20 @@
+#ifndef _DENSE_MATRIX_IMPL_H
+#define _DENSE_MATRIX_IMPL_H
+
+#include "dense_matrix.h"
+#include "workspace.h"
+
+/** Layout of a dense matrix.  Beyond the DenseMatrixHeader fields
+ *  used by the inline accessors in dense_matrix.h, this is private to
+ *  the dense matrix family of classes (DenseMatrix and its
+ *  sub-classes); other code should only use the abstract Matrix
+ *  interface or those accessors.
+ */
+typedef struct {
+  DenseMatrixHeader;
+  void *mapping;          //file mapped by newDenseMatrixFromFile(); or NULL
+  size_t mappingSize;
+  Workspace *workspace;   //NULL to use the calling thread's workspace
+} DenseMatrixImpl;
+
+#endif //ifndef _DENSE_MATRIX_IMPL_H
@@ -0,0 +1,456 @@
+
+/** Template for the implementation of the dense matrix class for a
+ *  single element type; see typed_template.h.
+ */
+
+/** Layout of a dense matrix.  Beyond the DenseMatrixHeader fields
+ *  used by the inline accessors in dense_matrix.h, this is private to
+ *  the dense matrix family of classes (DenseMatrix and its
+ *  sub-classes); other code should only use the abstract Matrix
+ *  interface or those accessors.
+ */
+typedef struct {
+  TM_NAME(DenseMatrixHeader);
+  Workspace *workspace;   //NULL to use the calling thread's workspace
+} TM_NAME(DenseMatrixImpl);
+
+/** Examines the matrix as a DenseMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void
+TM_NAME(verifyDenseMatrix)(const TM_NAME(Matrix) *this, int *err)
+{
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  if (matrix->nRows <= 0 || matrix->nCols <= 0) {
+    *err = EINVAL;
+  }
+}
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyDenseMatrix)(this, err);
+  return "denseMatrix" TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyDenseMatrix)(this, err);
+  return MATRIX_KLASS_DENSE;
+}
+
+static void
+TM_NAME(freeDenseMatrix)(TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyDenseMatrix)(this, err);
+  TM_NAME(DenseMatrixImpl) *matrix = (TM_NAME(DenseMatrixImpl) *)this;
+  free(matrix);
+}
+
+static int
+TM_NAME(getNRows)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyDenseMatrix)(this, err);
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  return matrix->nRows;
+}
+
+static int
+TM_NAME(getNCols)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyDenseMatrix)(this, err);
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  return matrix->nCols;
+}
+
+static TM_TYPE
+TM_NAME(getElement)(const TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    int *err)
+{
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return 0;
+  int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return 0;
+  // Range check
+  if (rowIndex >= nRows || colIndex >= nCols) {
+    *err = EDOM;
+    return 0;
+  }
+
+  return matrix->mat[(size_t)rowIndex*matrix->rowStride + colIndex];
+}
+
+static void
+TM_NAME(setElement)(TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    TM_TYPE element, int *err)
+{
+  TM_NAME(DenseMatrixImpl) *matrix = (TM_NAME(DenseMatrixImpl) *)this;
+  int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  // Range check
+  if (rowIndex >= nRows || colIndex >= nCols) {
+    *err = EDOM;
+    return;
+  }
+
+  matrix->mat[(size_t)rowIndex*matrix->rowStride + colIndex] = element;
+}
+
+static void
+TM_NAME(getRow)(const TM_NAME(Matrix) *this, int rowIndex, TM_TYPE row[],
+                int *err)
+{
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  TM_NAME(verifyDenseMatrix)(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  memcpy(row, &matrix->mat[(size_t)rowIndex*matrix->rowStride],
+         matrix->nCols*sizeof(TM_TYPE));
+}
+
+static void
+TM_NAME(setRow)(TM_NAME(Matrix) *this, int rowIndex, const TM_TYPE row[],
+                int *err)
+{
+  TM_NAME(DenseMatrixImpl) *matrix = (TM_NAME(DenseMatrixImpl) *)this;
+  TM_NAME(verifyDenseMatrix)(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  memcpy(&matrix->mat[(size_t)rowIndex*matrix->rowStride], row,
+         matrix->nCols*sizeof(TM_TYPE));
+}
+
+static TM_TYPE *
+TM_NAME(getData)(const TM_NAME(Matrix) *this, int *rowStride, int *err)
+{
+  TM_NAME(DenseMatrixImpl) *matrix = (TM_NAME(DenseMatrixImpl) *)this;
+  TM_NAME(verifyDenseMatrix)(this, err);
+  if (*err == EINVAL) return NULL;
+  *rowStride = matrix->rowStride;
+  return matrix->mat;
+}
+
+static void
+TM_NAME(transpose)(const TM_NAME(Matrix) *this, TM_NAME(Matrix) *result,
+                   int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const TM_NAME(DenseMatrixImpl) *matrix =
+    (const TM_NAME(DenseMatrixImpl) *)this;
+  TM_NAME(verifyDenseMatrix)(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(matrix->nRows == result_m && matrix->nCols == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic transpose unless we can get at the
+  // storage of the result
+  int resultLd;
+  TM_TYPE *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!res) {
+    TM_NAME(getAbstractMatrixFns)()->transpose(this, result, err);
+    return;
+  }
+  TM_NAME(transposeRecursive)(matrix->nRows, matrix->nCols, matrix->mat,
+                              matrix->rowStride, res, resultLd);
+}
+
+/** Works on any matrices, since sub-classes and views fall back to
+ *  it when the storage of some operand is not available.
+ */
+static void
+TM_NAME(mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+             TM_NAME(Matrix) *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Multiply directly on the storage of the matrices, as the kernels
+  // registered for the MatrixBaseType classes do, falling back to the
+  // generic multiplication
+  int lda, ldb, ldc;
+  const TM_TYPE *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return;
+  const TM_TYPE *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (a && b && c) {
+    TM_NAME(gemmBlocked)(pr_m, mul_n, pr_p, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  const TM_NAME(Matrix) *viewBase = TM_NAME(getTransposeViewBase)(multiplier);
+  const TM_TYPE *bt =
+    (a && c && viewBase) ? viewBase->fns->getData(viewBase, &ldb, err) : NULL;
+  if (*err == EINVAL) return;
+  if (bt) {
+    TM_NAME(gemmTransB)(pr_m, mul_n, pr_p, a, lda, bt, ldb, c, ldc);
+    return;
+  }
+  TM_NAME(getAbstractMatrixFns)()->mul(this, multiplier, product, err);
+}
+
+/** Works on the storage of any matrix which provides it, so that
+ *  views and sub-classes can inherit it.
+ */
+static void
+TM_NAME(mulVec)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  int ld;
+  const TM_TYPE *data = this->fns->getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    TM_NAME(getAbstractMatrixFns)()->mulVec(this, vec, result, err);
+    return;
+  }
+  TM_NAME(gemv)(nRows, nCols, data, ld, vec, result);
+}
+
+/** Works on the storage of any matrix which provides it, so that
+ *  views and sub-classes can inherit it.
+ */
+static void
+TM_NAME(vecMul)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  const int nRows = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  int ld;
+  const TM_TYPE *data = this->fns->getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    TM_NAME(getAbstractMatrixFns)()->vecMul(this, vec, result, err);
+    return;
+  }
+  TM_NAME(gemvTrans)(nRows, nCols, data, ld, vec, result);
+}
+
+static TM_NAME(DenseMatrixFns) TM_NAME(denseMatrixFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .free = TM_NAME(freeDenseMatrix),
+  .getNRows = TM_NAME(getNRows),
+  .getNCols = TM_NAME(getNCols),
+  .getElement = TM_NAME(getElement),
+  .setElement = TM_NAME(setElement),
+  .getRow = TM_NAME(getRow),
+  .setRow = TM_NAME(setRow),
+  .getData = TM_NAME(getData),
+  .transpose = TM_NAME(transpose),
+  .mul = TM_NAME(mul),
+  .mulVec = TM_NAME(mulVec),
+  .vecMul = TM_NAME(vecMul),
+};
+
+/** Return the row stride for a new matrix with nCols columns, padded
+ *  as for MatrixBaseType matrices (see setDenseMatrixPadding()).
+ */
+static int
+TM_NAME(getPaddedRowStride)(int nCols)
+{
+  enum { LINE_ENTRIES = DENSE_MATRIX_ALIGN/sizeof(TM_TYPE) };
+  if (!isPadded || nCols < LINE_ENTRIES || nCols > INT_MAX - 2*LINE_ENTRIES) {
+    return nCols;
+  }
+  int nLines = (nCols + LINE_ENTRIES - 1)/LINE_ENTRIES;
+  if (nLines % DENSE_MATRIX_CONFLICT_LINES == 0) nLines++;
+  return nLines*LINE_ENTRIES;
+}
+
+/** Return a newly allocated matrix with its entries in row-major
+ *  layout, with aligned and padded storage.  All entries in the newly
+ *  created matrix are initialized to 0.  Set *err to EINVAL if nRows
+ *  or nCols <= 0, to ENOMEM if not enough memory.
+ */
+TM_NAME(DenseMatrix) *
+TM_NAME(newDenseMatrix)(int nRows, int nCols, int *err)
+{
+  // Check if dimensions make sense
+  if (nRows <=0 || nCols <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+
+  // Allocate the header and storage together, with enough slack to
+  // align the storage; calloc() leaves freshly mapped pages of large
+  // matrices untouched until they are used
+  const int rowStride = TM_NAME(getPaddedRowStride)(nCols);
+  const size_t storageSize = (size_t)nRows*rowStride*sizeof(TM_TYPE);
+  if (storageSize/rowStride/sizeof(TM_TYPE) != (size_t)nRows) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  TM_NAME(DenseMatrixImpl) *matrix =
+    calloc(1, sizeof(TM_NAME(DenseMatrixImpl)) + DENSE_MATRIX_ALIGN - 1 +
+           storageSize);
+  if (!matrix) {
+    *err = ENOMEM;
+    return NULL;
+  }
+
+  const uintptr_t storage = (uintptr_t)&matrix[1];
+  matrix->nRows = nRows;
+  matrix->nCols = nCols;
+  matrix->rowStride = rowStride;
+  matrix->mat = (TM_TYPE *)
+    ((storage + DENSE_MATRIX_ALIGN - 1) & ~(uintptr_t)(DENSE_MATRIX_ALIGN - 1));
+  matrix->workspace = NULL;
+  matrix->fns = (TM_NAME(MatrixFns) *)TM_NAME(getDenseMatrixFns)();
+
+  return (TM_NAME(DenseMatrix) *)matrix;
+}
+
+void
+TM_NAME(setDenseMatrixWorkspace)(TM_NAME(DenseMatrix) *matrix,
+                                 Workspace *workspace)
+{
+  ((TM_NAME(DenseMatrixImpl) *)matrix)->workspace = workspace;
+}
+
+Workspace *
+TM_NAME(getDenseMatrixWorkspace)(const TM_NAME(DenseMatrix) *matrix,
+                                 int *err)
+{
+  Workspace *workspace =
+    ((const TM_NAME(DenseMatrixImpl) *)matrix)->workspace;
+  return (workspace) ? workspace : getThreadWorkspace(err);
+}
+
+TM_NAME(DenseMatrix) *
+TM_NAME(asDenseMatrix)(const TM_NAME(Matrix) *matrix)
+{
+  int err = 0;
+  switch (matrix->fns->getKlassId(matrix, &err)) {
+  case MATRIX_KLASS_DENSE:
+  case MATRIX_KLASS_SMART_MUL:
+  case MATRIX_KLASS_BLOCKED_MUL:
+  case MATRIX_KLASS_PARALLEL_MUL:
+  case MATRIX_KLASS_STRASSEN:
+    return (err) ? NULL : (TM_NAME(DenseMatrix) *)matrix;
+  default:
+    return NULL;
+  }
+}
+
+/** Arguments for filling or copying a band of rows of a matrix */
+typedef struct {
+  TM_NAME(DenseMatrixImpl) *matrix;
+  TM_TYPE element;       //for filling
+  const TM_TYPE *src;    //for copying
+  int lds;
+} TM_NAME(CopyBand);
+
+static int
+TM_NAME(getCopyBandRows)(const TM_NAME(DenseMatrixImpl) *matrix)
+{
+  const int bandRows = COPY_BAND_ENTRIES/matrix->nCols;
+  return (bandRows < 1) ? 1 : bandRows;
+}
+
+static void
+TM_NAME(fillBand)(void *arg, int begin, int end)
+{
+  const TM_NAME(CopyBand) *band = arg;
+  const TM_NAME(DenseMatrixImpl) *matrix = band->matrix;
+  for (int i = begin; i < end; i++) {
+    TM_TYPE *row = &matrix->mat[(size_t)i*matrix->rowStride];
+    for (int j = 0; j < matrix->nCols; j++) row[j] = band->element;
+  }
+}
+
+void
+TM_NAME(fillDenseMatrix)(TM_NAME(DenseMatrix) *matrix, TM_TYPE element)
+{
+  TM_NAME(CopyBand) band = {
+    .matrix = (TM_NAME(DenseMatrixImpl) *)matrix, .element = element,
+  };
+  parallelFor(band.matrix->nRows, TM_NAME(getCopyBandRows)(band.matrix),
+              TM_NAME(fillBand), &band);
+}
+
+static void
+TM_NAME(copyBand)(void *arg, int begin, int end)
+{
+  const TM_NAME(CopyBand) *band = arg;
+  const TM_NAME(DenseMatrixImpl) *matrix = band->matrix;
+  for (int i = begin; i < end; i++) {
+    memcpy(&matrix->mat[(size_t)i*matrix->rowStride],
+           &band->src[(size_t)i*band->lds],
+           matrix->nCols*sizeof(TM_TYPE));
+  }
+}
+
+void
+TM_NAME(copyToDenseMatrix)(TM_NAME(DenseMatrix) *matrix, const TM_TYPE src[],
+                           int lds)
+{
+  TM_NAME(CopyBand) band = {
+    .matrix = (TM_NAME(DenseMatrixImpl) *)matrix, .src = src, .lds = lds,
+  };
+  parallelFor(band.matrix->nRows, TM_NAME(getCopyBandRows)(band.matrix),
+              TM_NAME(copyBand), &band);
+}
+
+void
+TM_NAME(copyFromDenseMatrix)(const TM_NAME(DenseMatrix) *matrix,
+                             TM_TYPE dst[], int ldd)
+{
+  const TM_NAME(DenseMatrixImpl) *impl =
+    (const TM_NAME(DenseMatrixImpl) *)matrix;
+  for (int i = 0; i < impl->nRows; i++) {
+    memcpy(&dst[(size_t)i*ldd], &impl->mat[(size_t)i*impl->rowStride],
+           impl->nCols*sizeof(TM_TYPE));
+  }
+}
+
+/** Return implementation of functions for a dense matrix; these functions
+ *  can be used by sub-classes to inherit behavior from this class.
+ */
+const TM_NAME(DenseMatrixFns) *
+TM_NAME(getDenseMatrixFns)(void)
+{
+  return &TM_NAME(denseMatrixFns);
+}
@@ -0,0 +1,87 @@
+#include "diagonal_matrix.h"
+#include "structured_matrix_impl.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+typedef struct {
+  StructuredMatrixImpl;
+} DiagonalMatrixImpl;
+
+#define KLASS "diagonalMatrix"
+
+/** Examines the matrix as a DiagonalMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifyDiagonalMatrix(const Matrix *this, int *err)
+{
+  const DiagonalMatrixImpl *matrix = (const DiagonalMatrixImpl *)this;
+  if (matrix->nRows <= 0 || matrix->nRows != matrix->nCols) *err = EINVAL;
+}
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifyDiagonalMatrix(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifyDiagonalMatrix(this, err);
+  return MATRIX_KLASS_DIAGONAL;
+}
+
+static MatrixBaseType *
+getRowEntries(const Matrix *this, int rowIndex, int *begin, int *end)
+{
+  const DiagonalMatrixImpl *matrix = (const DiagonalMatrixImpl *)this;
+  *begin = rowIndex;
+  *end = rowIndex + 1;
+  return &matrix->entries[rowIndex];
+}
+
+static _Bool isInit = false;
+static DiagonalMatrixFns diagonalMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .getRowEntries = getRowEntries,
+};
+
+static void patchDiagonalMatrixFns(void)
+{
+  if (!isInit) {
+    const StructuredMatrixFns *fns = getStructuredMatrixFns();
+    diagonalMatrixFns.free = fns->free;
+    diagonalMatrixFns.getNRows = fns->getNRows;
+    diagonalMatrixFns.getNCols = fns->getNCols;
+    diagonalMatrixFns.getElement = fns->getElement;
+    diagonalMatrixFns.setElement = fns->setElement;
+    diagonalMatrixFns.getRow = fns->getRow;
+    diagonalMatrixFns.setRow = fns->setRow;
+    diagonalMatrixFns.getData = fns->getData;
+    diagonalMatrixFns.transpose = fns->transpose;
+    diagonalMatrixFns.mul = fns->mul;
+    diagonalMatrixFns.mulVec = fns->mulVec;
+    diagonalMatrixFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+DiagonalMatrix *
+newDiagonalMatrix(int n, int *err)
+{
+  if (n <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+  return (DiagonalMatrix *)
+    newStructuredMatrix(sizeof(DiagonalMatrixImpl), n, n, n,
+                        (const StructuredMatrixFns *)getDiagonalMatrixFns(),
+                        err);
+}
+
+const DiagonalMatrixFns *
+getDiagonalMatrixFns(void)
+{
+  patchDiagonalMatrixFns();
+  return &diagonalMatrixFns;
+}
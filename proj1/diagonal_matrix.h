@@ -0,0 +1,28 @@
+#ifndef _DIAGONAL_MATRIX_H
+#define _DIAGONAL_MATRIX_H
+
+#include "structured_matrix.h"
+
+typedef struct DiagonalMatrixFns {
+  StructuredMatrixFns; //-fms-extensions inserts StructuredMatrixFns fields
+} DiagonalMatrixFns;
+
+typedef struct DiagonalMatrix {
+  StructuredMatrix; //-fms-extensions inserts StructuredMatrix fields
+} DiagonalMatrix;
+
+/** Return a newly allocated n x n diagonal matrix (entry [i][j] is 0
+ *  for j != i) with all entries initialized to 0.  Only the n diagonal
+ *  entries are stored.
+ *
+ *  Set *err to EINVAL if n <= 0, to ENOMEM if not enough memory.
+ */
+DiagonalMatrix *newDiagonalMatrix(int n, int *err);
+
+/** Return implementation of functions for a diagonal matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const DiagonalMatrixFns *getDiagonalMatrixFns(void);
+
+#endif //ifndef _DIAGONAL_MATRIX_H
@@ -0,0 +1,369 @@
+#include "gemm_kernel.h"
+#include "gemm_kernel_impl.h"
+#include "typed_matrix.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Block sizes (in elements) for the M, N (inner) and P dimensions.
+ * A KC x PC block of b is 128 x 256 x 4 bytes = 128K which fits in
+ * L2; a PC segment of a c row is 1K which leaves plenty of room in
+ * L1 for the a row segment and the b row being streamed.  PC must be
+ * a multiple of the widest micro-kernel.
+ */
+enum {
+  MC = 64,
+  KC = 128,
+  PC = 256,
+};
+
+static inline int min(int a, int b) { return a < b ? a : b; }
+
+/******************************* Scalar ********************************/
+
+enum { SCALAR_NR = 4 };
+
+static _Bool
+isScalarSupported(void)
+{
+  return true;
+}
+
+static void
+microKernelScalar(int k, const MatrixBaseType *a, int lda,
+                  const MatrixBaseType *b, int ldb,
+                  MatrixBaseType *c, int ldc)
+{
+  MatrixBaseType acc[GEMM_MR][SCALAR_NR];
+  for (int i = 0; i < GEMM_MR; i++) {
+    for (int j = 0; j < SCALAR_NR; j++) acc[i][j] = c[(size_t)i*ldc + j];
+  }
+  for (int kk = 0; kk < k; kk++) {
+    for (int i = 0; i < GEMM_MR; i++) {
+      const MatrixBaseType aik = a[(size_t)i*lda + kk];
+      for (int j = 0; j < SCALAR_NR; j++) {
+        acc[i][j] += aik*b[(size_t)kk*ldb + j];
+      }
+    }
+  }
+  for (int i = 0; i < GEMM_MR; i++) {
+    for (int j = 0; j < SCALAR_NR; j++) c[(size_t)i*ldc + j] = acc[i][j];
+  }
+}
+
+static MatrixBaseType
+dotScalar(int n, const MatrixBaseType *a, const MatrixBaseType *b)
+{
+  MatrixBaseType sum = 0;
+  for (int i = 0; i < n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+static void
+axpyScalar(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+           MatrixBaseType *y)
+{
+  for (int i = 0; i < n; i++) y[i] += alpha*x[i];
+}
+
+static const GemmKernelImpl gemmScalarKernel = {
+  .name = "scalar",
+  .nr = SCALAR_NR,
+  .microKernel = microKernelScalar,
+  .dot = dotScalar,
+  .axpy = axpyScalar,
+  .isSupported = isScalarSupported,
+};
+
+/****************************** Dispatch *******************************/
+
+//indexed by GemmKernelId
+static const GemmKernelImpl *const kernels[N_GEMM_KERNELS] = {
+  &gemmScalarKernel,
+  &gemmSse41Kernel,
+  &gemmAvx2Kernel,
+  &gemmAvx512Kernel,
+};
+
+static GemmKernelId kernelId = GEMM_KERNEL_SCALAR;
+static const GemmKernelImpl *kernel = &gemmScalarKernel;
+static pthread_once_t autoSelectOnce = PTHREAD_ONCE_INIT;
+
+/** Return best kernel supported by processor; kernels[] is ordered by
+ *  preference.
+ */
+static GemmKernelId
+getBestKernel(void)
+{
+  GemmKernelId id = N_GEMM_KERNELS - 1;
+  while (!kernels[id]->isSupported()) id--;
+  return id;
+}
+
+/** Select best kernel the first time any kernel is used. */
+static void
+autoSelectKernel(void)
+{
+  kernelId = getBestKernel();
+  kernel = kernels[kernelId];
+}
+
+static inline const GemmKernelImpl *
+getKernel(void)
+{
+  pthread_once(&autoSelectOnce, autoSelectKernel);
+  return kernel;
+}
+
+const char *
+getGemmKernelName(GemmKernelId id)
+{
+  if (id < 0 || id >= N_GEMM_KERNELS) return "auto";
+  return kernels[id]->name;
+}
+
+_Bool
+isGemmKernelSupported(GemmKernelId id)
+{
+  if (id == GEMM_KERNEL_AUTO) return true;
+  if (id < 0 || id >= N_GEMM_KERNELS) return false;
+  return kernels[id]->isSupported();
+}
+
+_Bool
+setGemmKernel(GemmKernelId id)
+{
+  pthread_once(&autoSelectOnce, autoSelectKernel);
+  if (id == GEMM_KERNEL_AUTO) id = getBestKernel();
+  if (!isGemmKernelSupported(id)) return false;
+  kernelId = id;
+  kernel = kernels[id];
+  return true;
+}
+
+GemmKernelId
+getGemmKernel(void)
+{
+  getKernel();
+  return kernelId;
+}
+
+/******************************* Driver ********************************/
+
+/** c[m][p] += a[m][k] * b[k][p] element by element; used for the
+ *  edges of blocks which do not fill up a micro-kernel.
+ */
+static void
+mulEdge(int m, int k, int p,
+        const MatrixBaseType *restrict a, int lda,
+        const MatrixBaseType *restrict b, int ldb,
+        MatrixBaseType *restrict c, int ldc)
+{
+  for (int i = 0; i < m; i++) {
+    MatrixBaseType *restrict cRow = &c[(size_t)i*ldc];
+    const MatrixBaseType *aRow = &a[(size_t)i*lda];
+    for (int kk = 0; kk < k; kk++) {
+      const MatrixBaseType aik = aRow[kk];
+      const MatrixBaseType *restrict bRow = &b[(size_t)kk*ldb];
+      for (int j = 0; j < p; j++) {
+        cRow[j] += aik*bRow[j];
+      }
+    }
+  }
+}
+
+/** c[m][p] += a[m][k] * b[k][p] for a single block; all dimensions
+ *  are assumed to be within the block sizes.
+ */
+static void
+mulBlock(const GemmKernelImpl *kern, int m, int k, int p,
+         const MatrixBaseType *a, int lda,
+         const MatrixBaseType *b, int ldb,
+         MatrixBaseType *c, int ldc)
+{
+  const int mFull = m - m % GEMM_MR;
+  const int pFull = p - p % kern->nr;
+  for (int i = 0; i < mFull; i += GEMM_MR) {
+    for (int j = 0; j < pFull; j += kern->nr) {
+      kern->microKernel(k, &a[(size_t)i*lda], lda, &b[j], ldb,
+                        &c[(size_t)i*ldc + j], ldc);
+    }
+  }
+  if (pFull < p) {
+    mulEdge(mFull, k, p - pFull, a, lda, &b[pFull], ldb, &c[pFull], ldc);
+  }
+  if (mFull < m) {
+    mulEdge(m - mFull, k, p, &a[(size_t)mFull*lda], lda, b, ldb,
+            &c[(size_t)mFull*ldc], ldc);
+  }
+}
+
+void
+gemmBlocked(int m, int n, int p,
+            const MatrixBaseType *a, int lda,
+            const MatrixBaseType *b, int ldb,
+            MatrixBaseType *c, int ldc)
+{
+  for (int i = 0; i < m; i++) {
+    memset(&c[(size_t)i*ldc], 0, p*sizeof(MatrixBaseType));
+  }
+  gemmBlockedAdd(m, n, p, a, lda, b, ldb, c, ldc);
+}
+
+void
+gemmBlockedAdd(int m, int n, int p,
+               const MatrixBaseType *a, int lda,
+               const MatrixBaseType *b, int ldb,
+               MatrixBaseType *c, int ldc)
+{
+  const GemmKernelImpl *kern = getKernel();
+  for (int j0 = 0; j0 < p; j0 += PC) {
+    const int pc = min(PC, p - j0);
+    for (int k0 = 0; k0 < n; k0 += KC) {
+      const int kc = min(KC, n - k0);
+      for (int i0 = 0; i0 < m; i0 += MC) {
+        const int mc = min(MC, m - i0);
+        mulBlock(kern, mc, kc, pc, &a[(size_t)i0*lda + k0], lda,
+                 &b[(size_t)k0*ldb + j0], ldb, &c[(size_t)i0*ldc + j0], ldc);
+      }
+    }
+  }
+}
+
+void
+gemmTransB(int m, int n, int p,
+           const MatrixBaseType *a, int lda,
+           const MatrixBaseType *b, int ldb,
+           MatrixBaseType *c, int ldc)
+{
+  const GemmKernelImpl *kern = getKernel();
+  for (int i = 0; i < m; i++) {
+    memset(&c[(size_t)i*ldc], 0, p*sizeof(MatrixBaseType));
+  }
+  for (int k0 = 0; k0 < n; k0 += KC) {
+    const int kc = min(KC, n - k0);
+    for (int j0 = 0; j0 < p; j0 += PC) {
+      const int pc = min(PC, p - j0);
+      for (int i = 0; i < m; i++) {
+        const MatrixBaseType *aRow = &a[(size_t)i*lda + k0];
+        MatrixBaseType *cRow = &c[(size_t)i*ldc + j0];
+        for (int j = 0; j < pc; j++) {
+          cRow[j] += kern->dot(kc, aRow, &b[(size_t)(j0 + j)*ldb + k0]);
+        }
+      }
+    }
+  }
+}
+
+/** Return the offset of row i of the packed upper triangle of an
+ *  n x n matrix, adjusted so that entry [i][j] is at the returned
+ *  offset plus j.
+ */
+static inline size_t
+packedUpperRow(int n, int i)
+{
+  return (size_t)i*n - (size_t)i*(i + 1)/2;
+}
+
+void
+syrkPacked(int n, int k, const MatrixBaseType *a, int lda, MatrixBaseType *c)
+{
+  const GemmKernelImpl *kern = getKernel();
+  memset(c, 0, (size_t)n*(n + 1)/2*sizeof(MatrixBaseType));
+  for (int k0 = 0; k0 < k; k0 += KC) {
+    const int kc = min(KC, k - k0);
+    for (int j0 = 0; j0 < n; j0 += PC) {
+      const int j1 = min(j0 + PC, n);
+      //rows below the block of columns lie below the diagonal
+      for (int i = 0; i < j1; i++) {
+        const MatrixBaseType *aRow = &a[(size_t)i*lda + k0];
+        MatrixBaseType *cRow = &c[packedUpperRow(n, i)];
+        for (int j = (i > j0) ? i : j0; j < j1; j++) {
+          cRow[j] += kern->dot(kc, aRow, &a[(size_t)j*lda + k0]);
+        }
+      }
+    }
+  }
+}
+
+void
+syrkTransPacked(int n, int k, const MatrixBaseType *a, int lda,
+                MatrixBaseType *c)
+{
+  // Each MC x SYRK_COLS tile of the product (32K) on or above the
+  // diagonal is accumulated densely by the micro-kernel from a packed
+  // MC x KC panel of columns of a (32K) and the rows of a, then its
+  // entries on or above the diagonal are stored into c
+  enum { SYRK_COLS = 128 };
+  const GemmKernelImpl *kern = getKernel();
+  MatrixBaseType panel[MC*KC];
+  MatrixBaseType tile[MC*SYRK_COLS];
+  for (int i0 = 0; i0 < n; i0 += MC) {
+    const int mc = min(MC, n - i0);
+    for (int j0 = i0; j0 < n; j0 += SYRK_COLS) {
+      const int pc = min(SYRK_COLS, n - j0);
+      memset(tile, 0, sizeof(tile));
+      for (int k0 = 0; k0 < k; k0 += KC) {
+        const int kc = min(KC, k - k0);
+        //panel[i][r] = a[k0 + r][i0 + i]
+        for (int r = 0; r < kc; r++) {
+          const MatrixBaseType *aRow = &a[(size_t)(k0 + r)*lda + i0];
+          for (int i = 0; i < mc; i++) panel[i*kc + r] = aRow[i];
+        }
+        mulBlock(kern, mc, kc, pc, panel, kc, &a[(size_t)k0*lda + j0], lda,
+                 tile, pc);
+      }
+      for (int i = 0; i < mc; i++) {
+        const int jStart = (i0 + i > j0) ? i0 + i : j0;
+        if (jStart >= j0 + pc) break;
+        memcpy(&c[packedUpperRow(n, i0 + i) + jStart],
+               &tile[i*pc + jStart - j0],
+               (j0 + pc - jStart)*sizeof(MatrixBaseType));
+      }
+    }
+  }
+}
+
+void
+gemv(int m, int n, const MatrixBaseType *a, int lda,
+     const MatrixBaseType *x, MatrixBaseType *y)
+{
+  const GemmKernelImpl *kern = getKernel();
+  for (int i = 0; i < m; i++) y[i] = kern->dot(n, &a[(size_t)i*lda], x);
+}
+
+void
+gemvTrans(int m, int n, const MatrixBaseType *a, int lda,
+          const MatrixBaseType *x, MatrixBaseType *y)
+{
+  // Accumulate a segment of y at a time so that it stays resident in
+  // L1 while the rows of a stream past it
+  enum { YC = 2048 };
+  const GemmKernelImpl *kern = getKernel();
+  memset(y, 0, n*sizeof(MatrixBaseType));
+  for (int j0 = 0; j0 < n; j0 += YC) {
+    const int nc = min(YC, n - j0);
+    for (int i = 0; i < m; i++) {
+      kern->axpy(nc, x[i], &a[(size_t)i*lda + j0], &y[j0]);
+    }
+  }
+}
+
+MatrixBaseType
+dotProduct(int n, const MatrixBaseType *a, const MatrixBaseType *b)
+{
+  return getKernel()->dot(n, a, b);
+}
+
+void
+axpyVector(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+           MatrixBaseType *y)
+{
+  getKernel()->axpy(n, alpha, x, y);
+}
+
+/**************************** Other Types ******************************/
+
+#define TM_TEMPLATE "gemm_kernel_template.h"
+#include "typed_matrix_instances.h"
@@ -0,0 +1,121 @@
+#ifndef _GEMM_KERNEL_H
+#define _GEMM_KERNEL_H
+
+#include "matrix.h"
+
+/** Raw-memory matrix multiplication kernels.  These work directly on
+ *  row-major element storage and do no error checking; callers are
+ *  responsible for verifying dimensions.
+ *
+ *  Each matrix is described by a pointer to its first element and a
+ *  leading dimension (ld): the distance in elements between the
+ *  start of consecutive rows.
+ *
+ *  The innermost loops are done by register-blocked micro-kernels
+ *  which exist in several variants: a portable scalar variant and
+ *  SIMD variants for x86 processors.  By default, the best variant
+ *  supported by the processor we are running on is selected the
+ *  first time a kernel is used.
+ */
+
+/** Identifies micro-kernel variants */
+typedef enum {
+  GEMM_KERNEL_AUTO = -1,   //best variant supported by processor
+  GEMM_KERNEL_SCALAR,
+  GEMM_KERNEL_SSE41,
+  GEMM_KERNEL_AVX2,
+  GEMM_KERNEL_AVX512,
+  N_GEMM_KERNELS
+} GemmKernelId;
+
+/** Return name of micro-kernel variant id. */
+const char *getGemmKernelName(GemmKernelId id);
+
+/** Return true iff micro-kernel variant id can run on this processor. */
+_Bool isGemmKernelSupported(GemmKernelId id);
+
+/** Use micro-kernel variant id for all subsequent kernel calls;
+ *  GEMM_KERNEL_AUTO selects the best supported variant.  Return false
+ *  (leaving the current variant unchanged) if id is not supported.
+ *  Must not be called while kernels are running in other threads.
+ */
+_Bool setGemmKernel(GemmKernelId id);
+
+/** Return the micro-kernel variant currently in use. */
+GemmKernelId getGemmKernel(void);
+
+/** Set c[m][p] to a[m][n] * b[n][p] using a cache-blocked algorithm:
+ *  the computation is tiled so that a block of b stays resident in
+ *  the L2 cache while a row of the c block and the corresponding
+ *  row of the a block stay resident in the L1 cache.  c must not
+ *  overlap a or b.
+ */
+void gemmBlocked(int m, int n, int p,
+                 const MatrixBaseType *a, int lda,
+                 const MatrixBaseType *b, int ldb,
+                 MatrixBaseType *c, int ldc);
+
+/** Like gemmBlocked(), but add a[m][n] * b[n][p] to c[m][p] rather
+ *  than overwriting c.
+ */
+void gemmBlockedAdd(int m, int n, int p,
+                    const MatrixBaseType *a, int lda,
+                    const MatrixBaseType *b, int ldb,
+                    MatrixBaseType *c, int ldc);
+
+/** Set c[m][p] to a[m][n] * transpose(b[p][n]): each entry is the dot
+ *  product of a row of a and a row of b, so that no transposed copy
+ *  of b is needed.  The computation is tiled so that a block of rows
+ *  of b stays resident in the L2 cache while the rows of a stream
+ *  past it.  c must not overlap a or b.
+ */
+void gemmTransB(int m, int n, int p,
+                const MatrixBaseType *a, int lda,
+                const MatrixBaseType *b, int ldb,
+                MatrixBaseType *c, int ldc);
+
+/** Set c to a[n][k] * transpose(a[n][k]), where c is the upper
+ *  triangle of an n x n matrix packed a row at a time (row i holds
+ *  columns [i, n)).  Only the dot products of a row of a with itself
+ *  and the rows which follow it are computed, tiled as in
+ *  gemmTransB(), so a is read a row at a time without transposing
+ *  it.  c must not overlap a.
+ */
+void syrkPacked(int n, int k, const MatrixBaseType *a, int lda,
+                MatrixBaseType *c);
+
+/** Set c to transpose(a[k][n]) * a[k][n], where c is packed as for
+ *  syrkPacked().  Only the tiles of c on or above the diagonal are
+ *  computed, by the cache-blocked micro-kernel reading the rows of a
+ *  directly; just a small panel of columns of a at a time is packed
+ *  into rows.  c must not overlap a.
+ */
+void syrkTransPacked(int n, int k, const MatrixBaseType *a, int lda,
+                     MatrixBaseType *c);
+
+/** Set y[m] to a[m][n] * x[n]: each entry is the dot product of a row
+ *  of a with x, so a is read exactly once, a row at a time.  y must
+ *  not overlap a or x.
+ */
+void gemv(int m, int n, const MatrixBaseType *a, int lda,
+          const MatrixBaseType *x, MatrixBaseType *y);
+
+/** Set y[n] to transpose(a[m][n]) * x[m] (that is, the row vector x
+ *  times a): y is the sum of the rows of a, each scaled by the
+ *  corresponding entry of x, so a is again read exactly once, a row
+ *  at a time.  y must not overlap a or x.
+ */
+void gemvTrans(int m, int n, const MatrixBaseType *a, int lda,
+               const MatrixBaseType *x, MatrixBaseType *y);
+
+/** Return the dot product of the n-element vectors a[] and b[]. */
+MatrixBaseType dotProduct(int n, const MatrixBaseType *a,
+                          const MatrixBaseType *b);
+
+/** Add alpha times the n-element vector x[] to y[]; y must not
+ *  overlap x.
+ */
+void axpyVector(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+                MatrixBaseType *y);
+
+#endif //ifndef _GEMM_KERNEL_H
@@ -0,0 +1,76 @@
+/** Template for the raw-memory kernels for a single element type; see
+ *  typed_template.h.
+ */
+
+/** Set c[m][p] to a[m][n] * b[n][p] using a cache-blocked algorithm:
+ *  the computation is tiled so that a block of b stays resident in
+ *  the L2 cache while a row of the c block and the corresponding
+ *  row of the a block stay resident in the L1 cache.  c must not
+ *  overlap a or b.
+ */
+void TM_NAME(gemmBlocked)(int m, int n, int p,
+                          const TM_TYPE *a, int lda,
+                          const TM_TYPE *b, int ldb,
+                          TM_TYPE *c, int ldc);
+
+/** Like gemmBlocked(), but add a[m][n] * b[n][p] to c[m][p] rather
+ *  than overwriting c.
+ */
+void TM_NAME(gemmBlockedAdd)(int m, int n, int p,
+                             const TM_TYPE *a, int lda,
+                             const TM_TYPE *b, int ldb,
+                             TM_TYPE *c, int ldc);
+
+/** Set c[m][p] to a[m][n] * transpose(b[p][n]): each entry is the dot
+ *  product of a row of a and a row of b, so that no transposed copy
+ *  of b is needed.  The computation is tiled so that a block of rows
+ *  of b stays resident in the L2 cache while the rows of a stream
+ *  past it.  c must not overlap a or b.
+ */
+void TM_NAME(gemmTransB)(int m, int n, int p,
+                         const TM_TYPE *a, int lda,
+                         const TM_TYPE *b, int ldb,
+                         TM_TYPE *c, int ldc);
+
+/** Set c to a[n][k] * transpose(a[n][k]), where c is the upper
+ *  triangle of an n x n matrix packed a row at a time (row i holds
+ *  columns [i, n)).  Only the dot products of a row of a with itself
+ *  and the rows which follow it are computed, tiled as in
+ *  gemmTransB(), so a is read a row at a time without transposing
+ *  it.  c must not overlap a.
+ */
+void TM_NAME(syrkPacked)(int n, int k, const TM_TYPE *a, int lda,
+                         TM_TYPE *c);
+
+/** Set c to transpose(a[k][n]) * a[k][n], where c is packed as for
+ *  syrkPacked().  Only the tiles of c on or above the diagonal are
+ *  computed, by the cache-blocked micro-kernel reading the rows of a
+ *  directly; just a small panel of columns of a at a time is packed
+ *  into rows.  c must not overlap a.
+ */
+void TM_NAME(syrkTransPacked)(int n, int k, const TM_TYPE *a, int lda,
+                              TM_TYPE *c);
+
+/** Set y[m] to a[m][n] * x[n]: each entry is the dot product of a row
+ *  of a with x, so a is read exactly once, a row at a time.  y must
+ *  not overlap a or x.
+ */
+void TM_NAME(gemv)(int m, int n, const TM_TYPE *a, int lda,
+                   const TM_TYPE *x, TM_TYPE *y);
+
+/** Set y[n] to transpose(a[m][n]) * x[m] (that is, the row vector x
+ *  times a): y is the sum of the rows of a, each scaled by the
+ *  corresponding entry of x, so a is again read exactly once, a row
+ *  at a time.  y must not overlap a or x.
+ */
+void TM_NAME(gemvTrans)(int m, int n, const TM_TYPE *a, int lda,
+                        const TM_TYPE *x, TM_TYPE *y);
+
+/** Return the dot product of the n-element vectors a[] and b[]. */
+TM_TYPE TM_NAME(dotProduct)(int n, const TM_TYPE *a, const TM_TYPE *b);
+
+/** Add alpha times the n-element vector x[] to y[]; y must not
+ *  overlap x.
+ */
+void TM_NAME(axpyVector)(int n, TM_TYPE alpha, const TM_TYPE *x,
+                         TM_TYPE *y);
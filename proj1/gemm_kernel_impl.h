@@ -0,0 +1,45 @@
+#ifndef _GEMM_KERNEL_IMPL_H
+#define _GEMM_KERNEL_IMPL_H
+
+#include "gemm_kernel.h"
+
+/** Private interface between the kernel driver and the micro-kernel
+ *  variants.
+ */
+
+/** # of rows of c computed by each micro-kernel call */
+enum { GEMM_MR = 4 };
+
+/** c[GEMM_MR][nr] += a[GEMM_MR][k] * b[k][nr] where nr is the width
+ *  of the micro-kernel variant.
+ */
+typedef void (*GemmMicroKernelFn)(int k,
+                                  const MatrixBaseType *a, int lda,
+                                  const MatrixBaseType *b, int ldb,
+                                  MatrixBaseType *c, int ldc);
+
+/** Return dot product of n-element vectors a[] and b[]. */
+typedef MatrixBaseType (*DotProductFn)(int n, const MatrixBaseType *a,
+                                       const MatrixBaseType *b);
+
+/** y[n] += alpha * x[n] */
+typedef void (*AxpyFn)(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+                       MatrixBaseType *y);
+
+typedef struct {
+  const char *name;
+  int nr;                         //# of columns of c per micro-kernel call
+  GemmMicroKernelFn microKernel;
+  DotProductFn dot;
+  AxpyFn axpy;
+  _Bool (*isSupported)(void);
+} GemmKernelImpl;
+
+/** SIMD variants defined in gemm_kernel_x86.c; their isSupported()
+ *  always returns false when not compiled for x86.
+ */
+extern const GemmKernelImpl gemmSse41Kernel;
+extern const GemmKernelImpl gemmAvx2Kernel;
+extern const GemmKernelImpl gemmAvx512Kernel;
+
+#endif //ifndef _GEMM_KERNEL_IMPL_H
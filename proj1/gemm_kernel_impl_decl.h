@@ -0,0 +1,29 @@
+/** Template for the private interface between the kernel driver and
+ *  the micro-kernel variants for a single element type; see
+ *  typed_template.h.
+ */
+
+/** c[GEMM_MR][nr] += a[GEMM_MR][k] * b[k][nr] where nr is the width
+ *  of the micro-kernel variant.
+ */
+typedef void (*TM_NAME(GemmMicroKernelFn))(int k,
+                                           const TM_TYPE *a, int lda,
+                                           const TM_TYPE *b, int ldb,
+                                           TM_TYPE *c, int ldc);
+
+/** Return dot product of n-element vectors a[] and b[]. */
+typedef TM_TYPE (*TM_NAME(DotProductFn))(int n, const TM_TYPE *a,
+                                         const TM_TYPE *b);
+
+/** y[n] += alpha * x[n] */
+typedef void (*TM_NAME(AxpyFn))(int n, TM_TYPE alpha, const TM_TYPE *x,
+                                TM_TYPE *y);
+
+typedef struct {
+  const char *name;
+  int nr;                         //# of columns of c per micro-kernel call
+  TM_NAME(GemmMicroKernelFn) microKernel;
+  TM_NAME(DotProductFn) dot;
+  TM_NAME(AxpyFn) axpy;
+  _Bool (*isSupported)(void);
+} TM_NAME(GemmKernelImpl);
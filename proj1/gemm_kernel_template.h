@@ -0,0 +1,227 @@
+/** Template for the implementation of the kernel driver for a single
+ *  element type; see typed_template.h.  The driver follows the one for
+ *  MatrixBaseType in gemm_kernel.c, using the micro-kernel variants
+ *  generated by typed_gemm_kernel_template.h.
+ */
+
+#include "typed_gemm_kernel_template.h"
+
+/** PC scaled by the element size, so that a KC x PC block of b and a
+ *  PC segment of a c row occupy the same memory as for MatrixBaseType.
+ */
+enum { TM_NAME(PC) = PC*sizeof(MatrixBaseType)/sizeof(TM_TYPE) };
+
+/** Return the variant selected by setGemmKernel() */
+static inline const TM_NAME(GemmKernelImpl) *
+TM_NAME(getKernel)(void)
+{
+  return TM_NAME(gemmKernels)[getGemmKernel()];
+}
+
+/** c[m][p] += a[m][k] * b[k][p] element by element; used for the
+ *  edges of blocks which do not fill up a micro-kernel.
+ */
+static void
+TM_NAME(mulEdge)(int m, int k, int p,
+                 const TM_TYPE *restrict a, int lda,
+                 const TM_TYPE *restrict b, int ldb,
+                 TM_TYPE *restrict c, int ldc)
+{
+  for (int i = 0; i < m; i++) {
+    TM_TYPE *restrict cRow = &c[(size_t)i*ldc];
+    const TM_TYPE *aRow = &a[(size_t)i*lda];
+    for (int kk = 0; kk < k; kk++) {
+      const TM_TYPE aik = aRow[kk];
+      const TM_TYPE *restrict bRow = &b[(size_t)kk*ldb];
+      for (int j = 0; j < p; j++) {
+        cRow[j] += aik*bRow[j];
+      }
+    }
+  }
+}
+
+/** c[m][p] += a[m][k] * b[k][p] for a single block; all dimensions
+ *  are assumed to be within the block sizes.
+ */
+static void
+TM_NAME(mulBlock)(const TM_NAME(GemmKernelImpl) *kern, int m, int k, int p,
+                  const TM_TYPE *a, int lda,
+                  const TM_TYPE *b, int ldb,
+                  TM_TYPE *c, int ldc)
+{
+  const int mFull = m - m % GEMM_MR;
+  const int pFull = p - p % kern->nr;
+  for (int i = 0; i < mFull; i += GEMM_MR) {
+    for (int j = 0; j < pFull; j += kern->nr) {
+      kern->microKernel(k, &a[(size_t)i*lda], lda, &b[j], ldb,
+                        &c[(size_t)i*ldc + j], ldc);
+    }
+  }
+  if (pFull < p) {
+    TM_NAME(mulEdge)(mFull, k, p - pFull, a, lda, &b[pFull], ldb,
+                     &c[pFull], ldc);
+  }
+  if (mFull < m) {
+    TM_NAME(mulEdge)(m - mFull, k, p, &a[(size_t)mFull*lda], lda, b, ldb,
+                     &c[(size_t)mFull*ldc], ldc);
+  }
+}
+
+void
+TM_NAME(gemmBlocked)(int m, int n, int p,
+                     const TM_TYPE *a, int lda,
+                     const TM_TYPE *b, int ldb,
+                     TM_TYPE *c, int ldc)
+{
+  for (int i = 0; i < m; i++) {
+    memset(&c[(size_t)i*ldc], 0, p*sizeof(TM_TYPE));
+  }
+  TM_NAME(gemmBlockedAdd)(m, n, p, a, lda, b, ldb, c, ldc);
+}
+
+void
+TM_NAME(gemmBlockedAdd)(int m, int n, int p,
+                        const TM_TYPE *a, int lda,
+                        const TM_TYPE *b, int ldb,
+                        TM_TYPE *c, int ldc)
+{
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  for (int j0 = 0; j0 < p; j0 += TM_NAME(PC)) {
+    const int pc = min(TM_NAME(PC), p - j0);
+    for (int k0 = 0; k0 < n; k0 += KC) {
+      const int kc = min(KC, n - k0);
+      for (int i0 = 0; i0 < m; i0 += MC) {
+        const int mc = min(MC, m - i0);
+        TM_NAME(mulBlock)(kern, mc, kc, pc, &a[(size_t)i0*lda + k0], lda,
+                          &b[(size_t)k0*ldb + j0], ldb,
+                          &c[(size_t)i0*ldc + j0], ldc);
+      }
+    }
+  }
+}
+
+void
+TM_NAME(gemmTransB)(int m, int n, int p,
+                    const TM_TYPE *a, int lda,
+                    const TM_TYPE *b, int ldb,
+                    TM_TYPE *c, int ldc)
+{
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  for (int i = 0; i < m; i++) {
+    memset(&c[(size_t)i*ldc], 0, p*sizeof(TM_TYPE));
+  }
+  for (int k0 = 0; k0 < n; k0 += KC) {
+    const int kc = min(KC, n - k0);
+    for (int j0 = 0; j0 < p; j0 += TM_NAME(PC)) {
+      const int pc = min(TM_NAME(PC), p - j0);
+      for (int i = 0; i < m; i++) {
+        const TM_TYPE *aRow = &a[(size_t)i*lda + k0];
+        TM_TYPE *cRow = &c[(size_t)i*ldc + j0];
+        for (int j = 0; j < pc; j++) {
+          cRow[j] += kern->dot(kc, aRow, &b[(size_t)(j0 + j)*ldb + k0]);
+        }
+      }
+    }
+  }
+}
+
+void
+TM_NAME(syrkPacked)(int n, int k, const TM_TYPE *a, int lda, TM_TYPE *c)
+{
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  memset(c, 0, (size_t)n*(n + 1)/2*sizeof(TM_TYPE));
+  for (int k0 = 0; k0 < k; k0 += KC) {
+    const int kc = min(KC, k - k0);
+    for (int j0 = 0; j0 < n; j0 += TM_NAME(PC)) {
+      const int j1 = min(j0 + TM_NAME(PC), n);
+      //rows below the block of columns lie below the diagonal
+      for (int i = 0; i < j1; i++) {
+        const TM_TYPE *aRow = &a[(size_t)i*lda + k0];
+        TM_TYPE *cRow = &c[packedUpperRow(n, i)];
+        for (int j = (i > j0) ? i : j0; j < j1; j++) {
+          cRow[j] += kern->dot(kc, aRow, &a[(size_t)j*lda + k0]);
+        }
+      }
+    }
+  }
+}
+
+void
+TM_NAME(syrkTransPacked)(int n, int k, const TM_TYPE *a, int lda,
+                         TM_TYPE *c)
+{
+  // Each MC x SYRK_COLS tile of the product on or above the diagonal
+  // is accumulated densely by the micro-kernel from a packed
+  // MC x SYRK_KC panel of columns of a and the rows of a, then its
+  // entries on or above the diagonal are stored into c.  Both are on
+  // the stack, so their widths are scaled by the element size to keep
+  // each at 32K as for MatrixBaseType
+  enum {
+    SYRK_COLS = 128*sizeof(MatrixBaseType)/sizeof(TM_TYPE),
+    SYRK_KC = KC*sizeof(MatrixBaseType)/sizeof(TM_TYPE),
+  };
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  TM_TYPE panel[MC*SYRK_KC];
+  TM_TYPE tile[MC*SYRK_COLS];
+  for (int i0 = 0; i0 < n; i0 += MC) {
+    const int mc = min(MC, n - i0);
+    for (int j0 = i0; j0 < n; j0 += SYRK_COLS) {
+      const int pc = min(SYRK_COLS, n - j0);
+      memset(tile, 0, sizeof(tile));
+      for (int k0 = 0; k0 < k; k0 += SYRK_KC) {
+        const int kc = min(SYRK_KC, k - k0);
+        //panel[i][r] = a[k0 + r][i0 + i]
+        for (int r = 0; r < kc; r++) {
+          const TM_TYPE *aRow = &a[(size_t)(k0 + r)*lda + i0];
+          for (int i = 0; i < mc; i++) panel[i*kc + r] = aRow[i];
+        }
+        TM_NAME(mulBlock)(kern, mc, kc, pc, panel, kc,
+                          &a[(size_t)k0*lda + j0], lda, tile, pc);
+      }
+      for (int i = 0; i < mc; i++) {
+        const int jStart = (i0 + i > j0) ? i0 + i : j0;
+        if (jStart >= j0 + pc) break;
+        memcpy(&c[packedUpperRow(n, i0 + i) + jStart],
+               &tile[i*pc + jStart - j0],
+               (j0 + pc - jStart)*sizeof(TM_TYPE));
+      }
+    }
+  }
+}
+
+void
+TM_NAME(gemv)(int m, int n, const TM_TYPE *a, int lda,
+              const TM_TYPE *x, TM_TYPE *y)
+{
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  for (int i = 0; i < m; i++) y[i] = kern->dot(n, &a[(size_t)i*lda], x);
+}
+
+void
+TM_NAME(gemvTrans)(int m, int n, const TM_TYPE *a, int lda,
+                   const TM_TYPE *x, TM_TYPE *y)
+{
+  // Accumulate a segment of y at a time so that it stays resident in
+  // L1 while the rows of a stream past it
+  enum { YC = 2048 };
+  const TM_NAME(GemmKernelImpl) *kern = TM_NAME(getKernel)();
+  memset(y, 0, n*sizeof(TM_TYPE));
+  for (int j0 = 0; j0 < n; j0 += YC) {
+    const int nc = min(YC, n - j0);
+    for (int i = 0; i < m; i++) {
+      kern->axpy(nc, x[i], &a[(size_t)i*lda + j0], &y[j0]);
+    }
+  }
+}
+
+TM_TYPE
+TM_NAME(dotProduct)(int n, const TM_TYPE *a, const TM_TYPE *b)
+{
+  return TM_NAME(getKernel)()->dot(n, a, b);
+}
+
+void
+TM_NAME(axpyVector)(int n, TM_TYPE alpha, const TM_TYPE *x, TM_TYPE *y)
+{
+  TM_NAME(getKernel)()->axpy(n, alpha, x, y);
+}
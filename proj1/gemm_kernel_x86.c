@@ -0,0 +1,271 @@
+#include "gemm_kernel_impl.h"
+
+#include <stdbool.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+/* Each variant is compiled for its instruction set using a target
+ * attribute rather than a command-line flag, so that a single binary
+ * runs on all processors; the variant is only called after
+ * isSupported() has checked the processor using cpuid.
+ *
+ * All micro-kernels keep a GEMM_MR x 2-vector block of c in registers
+ * while streaming through k, broadcasting an element of each a row
+ * and multiplying it into two vectors loaded from a b row.
+ */
+
+/******************************** SSE4.1 *******************************/
+
+static _Bool
+isSse41Supported(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1");
+}
+
+__attribute__((target("sse4.1")))
+static void
+microKernelSse41(int k, const MatrixBaseType *a, int lda,
+                 const MatrixBaseType *b, int ldb,
+                 MatrixBaseType *c, int ldc)
+{
+  __m128i acc[GEMM_MR][2];
+  for (int i = 0; i < GEMM_MR; i++) {
+    acc[i][0] = _mm_loadu_si128((const __m128i *)&c[(size_t)i*ldc]);
+    acc[i][1] = _mm_loadu_si128((const __m128i *)&c[(size_t)i*ldc + 4]);
+  }
+  for (int kk = 0; kk < k; kk++) {
+    __m128i b0 = _mm_loadu_si128((const __m128i *)&b[(size_t)kk*ldb]);
+    __m128i b1 = _mm_loadu_si128((const __m128i *)&b[(size_t)kk*ldb + 4]);
+    for (int i = 0; i < GEMM_MR; i++) {
+      __m128i aik = _mm_set1_epi32(a[(size_t)i*lda + kk]);
+      acc[i][0] = _mm_add_epi32(acc[i][0], _mm_mullo_epi32(aik, b0));
+      acc[i][1] = _mm_add_epi32(acc[i][1], _mm_mullo_epi32(aik, b1));
+    }
+  }
+  for (int i = 0; i < GEMM_MR; i++) {
+    _mm_storeu_si128((__m128i *)&c[(size_t)i*ldc], acc[i][0]);
+    _mm_storeu_si128((__m128i *)&c[(size_t)i*ldc + 4], acc[i][1]);
+  }
+}
+
+__attribute__((target("sse4.1")))
+static MatrixBaseType
+dotSse41(int n, const MatrixBaseType *a, const MatrixBaseType *b)
+{
+  __m128i acc = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i *)&a[i]);
+    __m128i y = _mm_loadu_si128((const __m128i *)&b[i]);
+    acc = _mm_add_epi32(acc, _mm_mullo_epi32(x, y));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  MatrixBaseType sum = _mm_cvtsi128_si32(acc);
+  for (; i < n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+__attribute__((target("sse4.1")))
+static void
+axpySse41(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+          MatrixBaseType *y)
+{
+  __m128i a = _mm_set1_epi32(alpha);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i xi = _mm_loadu_si128((const __m128i *)&x[i]);
+    __m128i yi = _mm_loadu_si128((const __m128i *)&y[i]);
+    _mm_storeu_si128((__m128i *)&y[i],
+                     _mm_add_epi32(yi, _mm_mullo_epi32(a, xi)));
+  }
+  for (; i < n; i++) y[i] += alpha*x[i];
+}
+
+const GemmKernelImpl gemmSse41Kernel = {
+  .name = "sse4.1",
+  .nr = 8,
+  .microKernel = microKernelSse41,
+  .dot = dotSse41,
+  .axpy = axpySse41,
+  .isSupported = isSse41Supported,
+};
+
+/********************************* AVX2 ********************************/
+
+static _Bool
+isAvx2Supported(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+static void
+microKernelAvx2(int k, const MatrixBaseType *a, int lda,
+                const MatrixBaseType *b, int ldb,
+                MatrixBaseType *c, int ldc)
+{
+  __m256i acc[GEMM_MR][2];
+  for (int i = 0; i < GEMM_MR; i++) {
+    acc[i][0] = _mm256_loadu_si256((const __m256i *)&c[(size_t)i*ldc]);
+    acc[i][1] = _mm256_loadu_si256((const __m256i *)&c[(size_t)i*ldc + 8]);
+  }
+  for (int kk = 0; kk < k; kk++) {
+    __m256i b0 = _mm256_loadu_si256((const __m256i *)&b[(size_t)kk*ldb]);
+    __m256i b1 = _mm256_loadu_si256((const __m256i *)&b[(size_t)kk*ldb + 8]);
+    for (int i = 0; i < GEMM_MR; i++) {
+      __m256i aik = _mm256_set1_epi32(a[(size_t)i*lda + kk]);
+      acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_mullo_epi32(aik, b0));
+      acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_mullo_epi32(aik, b1));
+    }
+  }
+  for (int i = 0; i < GEMM_MR; i++) {
+    _mm256_storeu_si256((__m256i *)&c[(size_t)i*ldc], acc[i][0]);
+    _mm256_storeu_si256((__m256i *)&c[(size_t)i*ldc + 8], acc[i][1]);
+  }
+}
+
+__attribute__((target("avx2")))
+static MatrixBaseType
+dotAvx2(int n, const MatrixBaseType *a, const MatrixBaseType *b)
+{
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+    __m256i y = _mm256_loadu_si256((const __m256i *)&b[i]);
+    acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(x, y));
+  }
+  __m128i acc4 = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                               _mm256_extracti128_si256(acc, 1));
+  acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, _MM_SHUFFLE(2, 3, 0, 1)));
+  MatrixBaseType sum = _mm_cvtsi128_si32(acc4);
+  for (; i < n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+__attribute__((target("avx2")))
+static void
+axpyAvx2(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+         MatrixBaseType *y)
+{
+  __m256i a = _mm256_set1_epi32(alpha);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i xi = _mm256_loadu_si256((const __m256i *)&x[i]);
+    __m256i yi = _mm256_loadu_si256((const __m256i *)&y[i]);
+    _mm256_storeu_si256((__m256i *)&y[i],
+                        _mm256_add_epi32(yi, _mm256_mullo_epi32(a, xi)));
+  }
+  for (; i < n; i++) y[i] += alpha*x[i];
+}
+
+const GemmKernelImpl gemmAvx2Kernel = {
+  .name = "avx2",
+  .nr = 16,
+  .microKernel = microKernelAvx2,
+  .dot = dotAvx2,
+  .axpy = axpyAvx2,
+  .isSupported = isAvx2Supported,
+};
+
+/******************************* AVX-512 *******************************/
+
+static _Bool
+isAvx512Supported(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+}
+
+__attribute__((target("avx512f")))
+static void
+microKernelAvx512(int k, const MatrixBaseType *a, int lda,
+                  const MatrixBaseType *b, int ldb,
+                  MatrixBaseType *c, int ldc)
+{
+  __m512i acc[GEMM_MR][2];
+  for (int i = 0; i < GEMM_MR; i++) {
+    acc[i][0] = _mm512_loadu_si512(&c[(size_t)i*ldc]);
+    acc[i][1] = _mm512_loadu_si512(&c[(size_t)i*ldc + 16]);
+  }
+  for (int kk = 0; kk < k; kk++) {
+    __m512i b0 = _mm512_loadu_si512(&b[(size_t)kk*ldb]);
+    __m512i b1 = _mm512_loadu_si512(&b[(size_t)kk*ldb + 16]);
+    for (int i = 0; i < GEMM_MR; i++) {
+      __m512i aik = _mm512_set1_epi32(a[(size_t)i*lda + kk]);
+      acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_mullo_epi32(aik, b0));
+      acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_mullo_epi32(aik, b1));
+    }
+  }
+  for (int i = 0; i < GEMM_MR; i++) {
+    _mm512_storeu_si512(&c[(size_t)i*ldc], acc[i][0]);
+    _mm512_storeu_si512(&c[(size_t)i*ldc + 16], acc[i][1]);
+  }
+}
+
+__attribute__((target("avx512f")))
+static MatrixBaseType
+dotAvx512(int n, const MatrixBaseType *a, const MatrixBaseType *b)
+{
+  __m512i acc = _mm512_setzero_si512();
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(&a[i]);
+    __m512i y = _mm512_loadu_si512(&b[i]);
+    acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(x, y));
+  }
+  MatrixBaseType sum = _mm512_reduce_add_epi32(acc);
+  for (; i < n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+__attribute__((target("avx512f")))
+static void
+axpyAvx512(int n, MatrixBaseType alpha, const MatrixBaseType *x,
+           MatrixBaseType *y)
+{
+  __m512i a = _mm512_set1_epi32(alpha);
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i xi = _mm512_loadu_si512(&x[i]);
+    __m512i yi = _mm512_loadu_si512(&y[i]);
+    _mm512_storeu_si512(&y[i],
+                        _mm512_add_epi32(yi, _mm512_mullo_epi32(a, xi)));
+  }
+  for (; i < n; i++) y[i] += alpha*x[i];
+}
+
+const GemmKernelImpl gemmAvx512Kernel = {
+  .name = "avx512",
+  .nr = 32,
+  .microKernel = microKernelAvx512,
+  .dot = dotAvx512,
+  .axpy = axpyAvx512,
+  .isSupported = isAvx512Supported,
+};
+
+#else //not x86
+
+static _Bool
+isNotSupported(void)
+{
+  return false;
+}
+
+const GemmKernelImpl gemmSse41Kernel = {
+  .name = "sse4.1", .isSupported = isNotSupported,
+};
+const GemmKernelImpl gemmAvx2Kernel = {
+  .name = "avx2", .isSupported = isNotSupported,
+};
+const GemmKernelImpl gemmAvx512Kernel = {
+  .name = "avx512", .isSupported = isNotSupported,
+};
+
+#endif //if x86
@@ -1,35 +1,103 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "matrix.h"
+#include "band_matrix.h"
+#include "batch_mul.h"
+#include "bench.h"
+#include "blocked_mul_matrix.h"
 #include "dense_matrix.h"
+#include "diagonal_matrix.h"
+#include "gemm_kernel.h"
+#include "matrix_file.h"
+#include "mul_dispatch.h"
+#include "parallel_mul_matrix.h"
+#include "perf_counters.h"
+#include "small_mul_kernel.h"
 #include "smart_mul_matrix.h"
+#include "sparse_csr_matrix.h"
+#include "stream_mul.h"
+#include "strassen_matrix.h"
+#include "sub_matrix_view.h"
+#include "symmetric_matrix.h"
+#include "thread_pool.h"
+#include "transpose_view.h"
+#include "triangular_matrix.h"
+#include "typed_matrix.h"
+#include "workspace.h"
 
 #include "errors.h"
 #include "memalloc.h"
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include <getopt.h>
-#include <sys/times.h>
+#include <unistd.h>
 
 /** struct to allow defining test matrices */
 typedef struct {
   const char *desc;
   int nRows, nCols;
   int *data;      //pointer to matrix data
+  const char *path; //matrix file containing data; NULL if none
 } TestData;
 
 /** Function used for creating matrices */
 typedef Matrix *(*NewFn)(int nRows, int nCols, int *err);
 
+/** Return a new nRows x nCols transpose view of a dense matrix which
+ *  is owned by the view.
+ */
+static Matrix *
+newDenseTransposeView(int nRows, int nCols, int *err)
+{
+  Matrix *base = (Matrix *)newDenseMatrix(nCols, nRows, err);
+  if (!base) return NULL;
+  Matrix *view = (Matrix *)newTransposeView(base, true, err);
+  if (!view) base->fns->free(base, err);
+  return view;
+}
+
+/** Padding around the sub-matrix views created by newPaddedSubMatrixView() */
+enum { VIEW_ROW_OFFSET = 1, VIEW_COL_OFFSET = 2, VIEW_PAD = 3 };
+
+/** Return a new nRows x nCols view of a block in the interior of a
+ *  larger dense matrix which is owned by the view, so that the view's
+ *  storage does not start at the start of a row and its row stride is
+ *  larger than nCols.
+ */
+static Matrix *
+newPaddedSubMatrixView(int nRows, int nCols, int *err)
+{
+  Matrix *parent = (Matrix *)newDenseMatrix(nRows + VIEW_PAD,
+                                            nCols + VIEW_PAD + 2, err);
+  if (!parent) return NULL;
+  Matrix *view = (Matrix *)newSubMatrixView(parent, VIEW_ROW_OFFSET,
+                                            VIEW_COL_OFFSET, nRows, nCols,
+                                            true, err);
+  if (!view) parent->fns->free(parent, err);
+  return view;
+}
+
 /** Define all NewFn's used for creating test matrices */
 static  struct {
   const char *desc;
   NewFn new;
+  _Bool isParallel;     //true if operations run on the thread pool
 } newFns[] = {
   { .desc = "denseMatrix", .new = (NewFn)newDenseMatrix },
   { .desc = "smartMulMatrix", .new = (NewFn)newSmartMulMatrix },
+  { .desc = "blockedMulMatrix", .new = (NewFn)newBlockedMulMatrix },
+  { .desc = "parallelMulMatrix", .new = (NewFn)newParallelMulMatrix,
+    .isParallel = true },
+  { .desc = "strassenMatrix", .new = (NewFn)newStrassenMatrix },
+  { .desc = "sparseCsrMatrix", .new = (NewFn)newSparseCsrMatrix },
+  { .desc = "transposeView", .new = newDenseTransposeView },
+  { .desc = "subMatrixView", .new = newPaddedSubMatrixView },
 };
 
 /************************* Matrix Output Routines **********************/
@@ -52,9 +120,12 @@ outMatrix(FILE *out, const Matrix *matrix, const char *labels[])
     fprintf(out, "%s ", *p);
   }
   if (labels[0]) fprintf(out, "\n");
+  const DenseMatrix *dense = asDenseMatrix(matrix);
   for (int i = 0; i < nRows; i++) {
     for (int j = 0; j < nCols; j++) {
-      int element = matrix->fns->getElement(matrix, i, j, &err);
+      int element = (dense)
+        ? getDenseMatrixElement(dense, i, j)
+        : matrix->fns->getElement(matrix, i, j, &err);
       if (err) {
         fprintf(out, "cannot access entry [%d][%d]: %s\n", i, j, strerror(err));
       }
@@ -102,19 +173,41 @@ outTransposeTest(FILE *out, const Matrix *matrix, const char *desc,
 
 /*********************** Multiplication Test Routines ******************/
 
-/** Standard matrix multiplication using a plain (non-oo) dense matrix */
+/** Arguments for computing a band of rows of a gold product */
+typedef struct {
+  int n2, n3;
+  const int *a, *b;
+  int *c;
+} GoldMulBand;
+
+static void
+goldMulBand(void *arg, int begin, int end)
+{
+  const GoldMulBand *band = arg;
+  const int n2 = band->n2, n3 = band->n3;
+  for (int i = begin; i < end; i++) {
+    for (int j = 0; j < n3; j++) {
+      int sum = 0;
+      for (int k = 0; k < n2; k++) sum += band->a[i*n2 + k]*band->b[k*n3 + j];
+      band->c[i*n3 + j] = sum;
+    }
+  }
+}
+
+/** Standard matrix multiplication using a plain (non-oo) dense matrix;
+ *  bands of rows are computed in parallel on the thread pool.
+ */
 //a[][] and b[][] should be declared const int, but doing so results
 //in warnings on gcc 4.9.2-10.
 static void
 goldMatrixMultiply(int n1, int n2, int n3,
                    int a[n1][n2], int b[n2][n3], int c[n1][n3])
 {
-  for (int i = 0; i < n1; i++) {
-    for (int j = 0; j < n3; j++) {
-      c[i][j] = 0;
-      for (int k = 0; k < n2; k++) c[i][j] += a[i][k]*b[k][j];
-    }
-  }
+  enum { GOLD_BAND_ROWS = 16 };
+  GoldMulBand band = {
+    .n2 = n2, .n3 = n3, .a = &a[0][0], .b = &b[0][0], .c = &c[0][0],
+  };
+  parallelFor(n1, GOLD_BAND_ROWS, goldMulBand, &band);
 }
 
 /** Return pointer to dynamic array of int's containing entries from
@@ -132,6 +225,12 @@ matrixToPlainMatrix(Matrix *matrix, const char *desc, int *nRows, int *nCols)
           desc, strerror(err));
   }
   int *plain = mallocChk(sizeof(MatrixBaseType) * n1 * n2);
+  const DenseMatrix *dense = asDenseMatrix(matrix);
+  if (dense) {
+    copyFromDenseMatrix(dense, plain, n2);
+    *nRows = n1; *nCols = n2;
+    return plain;
+  }
   for (int i = 0; i < n1; i++) {
     for (int j = 0; j < n2; j++) {
       int element = matrix->fns->getElement(matrix, i, j, &err);
@@ -162,9 +261,12 @@ compareMatrixToPlainMatrix(Matrix *matrix, const char *desc,
     fatal("compareMatrixToPlainMatrix(): matrix %s dimensions differ: "
           "matrix is %dx%d; plain is %dx%d", desc, n1, n2, nRows, nCols);
   }
+  const DenseMatrix *dense = asDenseMatrix(matrix);
   for (int i = 0; i < n1; i++) {
     for (int j = 0; j < n2; j++) {
-      int element = matrix->fns->getElement(matrix, i, j, &err);
+      int element = (dense)
+        ? getDenseMatrixElement(dense, i, j)
+        : matrix->fns->getElement(matrix, i, j, &err);
       if (err) {
         fatal("matrixToPlainMatrix(): cannot access element at "
               "[%d][%d] in matrix %s: %s", i, j, desc, strerror(err));
@@ -178,12 +280,23 @@ compareMatrixToPlainMatrix(Matrix *matrix, const char *desc,
   return true;
 }
 
-/** Return true iff product is m1 * m2.  If false, report erroneous
- *  first entry on stderr.
+/** How doMulTestMatrix() verifies products: either by comparing with
+ *  the product computed by goldMatrixMultiply(), which takes O(n^3)
+ *  time, or by nRounds rounds of Freivalds' randomized check, each of
+ *  which takes O(n^2) time.
+ */
+enum { DEFAULT_VERIFY_ROUNDS = 8 };
+static struct {
+  _Bool isGold;
+  int nRounds;
+} verifyMode = { .isGold = false, .nRounds = DEFAULT_VERIFY_ROUNDS };
+
+/** Return true iff product is m1 * m2 by comparing it with the gold
+ *  product.  If false, report erroneous first entry on stderr.
  */
 static _Bool
-doMulTestMatrix(Matrix *m1, const char *m1Desc,
-                Matrix *m2, const char *m2Desc, Matrix *product)
+doGoldMulTestMatrix(Matrix *m1, const char *m1Desc,
+                    Matrix *m2, const char *m2Desc, Matrix *product)
 {
   int m1NRows, m1NCols;
   int *plain1 = matrixToPlainMatrix(m1, m1Desc, &m1NRows, &m1NCols);
@@ -214,6 +327,156 @@ doMulTestMatrix(Matrix *m1, const char *m1Desc,
   return isOk;
 }
 
+/** Return the next value of a xorshift generator.  This is used rather
+ *  than rand() so that verifying products does not change the random
+ *  test data which follows.
+ */
+static uint32_t
+nextVerifyRandom(void)
+{
+  static uint32_t state = 2463534242u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+/** Set y[] to matrix * x[] modulo 2^32, reading rows directly from the
+ *  matrix storage when available and into row[] otherwise.  Unsigned
+ *  arithmetic makes overflow well-defined while agreeing with the low
+ *  32 bits of the int products computed by the matrix classes.
+ */
+static void
+mulVecModular(const Matrix *matrix, const char *desc, int nRows, int nCols,
+              const uint32_t x[], uint32_t y[], MatrixBaseType row[])
+{
+  int err = 0;
+  int rowStride;
+  const MatrixBaseType *data = matrix->fns->getData(matrix, &rowStride, &err);
+  for (int i = 0; i < nRows; i++) {
+    const MatrixBaseType *r = row;
+    if (data) {
+      r = &data[(size_t)i*rowStride];
+    }
+    else {
+      matrix->fns->getRow(matrix, i, row, &err);
+      if (err) {
+        fatal("mulVecModular(): cannot get row %s[%d]: %s", desc, i,
+              strerror(err));
+      }
+    }
+    uint32_t sum = 0;
+    for (int j = 0; j < nCols; j++) sum += (uint32_t)r[j]*x[j];
+    y[i] = sum;
+  }
+}
+
+/** Return true if nRounds rounds of Freivalds' check find product to
+ *  be m1 * m2: for a random vector r, m1 * (m2 * r) must equal
+ *  product * r.  Each round misses an erroneous product with
+ *  probability at most 1/2 (and usually far less since r is not
+ *  restricted to 0's and 1's).  If false, set *diffRowN to the index
+ *  of a row of product which is wrong.
+ */
+static _Bool
+freivaldsCheck(Matrix *m1, Matrix *m2, Matrix *product, int nRounds,
+               int *diffRowN)
+{
+  int err = 0;
+  const int n1 = m1->fns->getNRows(m1, &err);
+  const int n2 = m1->fns->getNCols(m1, &err);
+  const int n3 = m2->fns->getNCols(m2, &err);
+  if (err) {
+    fatal("freivaldsCheck(): cannot get matrix dimensions: %s",
+          strerror(err));
+  }
+  const int maxN = (n2 > n3) ? n2 : n3;
+  uint32_t *r = mallocChk(sizeof(uint32_t)*n3);
+  uint32_t *m2r = mallocChk(sizeof(uint32_t)*n2);
+  uint32_t *m1m2r = mallocChk(sizeof(uint32_t)*n1);
+  uint32_t *productR = mallocChk(sizeof(uint32_t)*n1);
+  MatrixBaseType *row = mallocChk(sizeof(MatrixBaseType)*maxN);
+  _Bool isOk = true;
+  for (int round = 0; isOk && round < nRounds; round++) {
+    for (int j = 0; j < n3; j++) r[j] = nextVerifyRandom();
+    mulVecModular(m2, "multiplier", n2, n3, r, m2r, row);
+    mulVecModular(m1, "multiplicand", n1, n2, m2r, m1m2r, row);
+    mulVecModular(product, "product", n1, n3, r, productR, row);
+    for (int i = 0; i < n1; i++) {
+      if (m1m2r[i] != productR[i]) {
+        *diffRowN = i;
+        isOk = false;
+        break;
+      }
+    }
+  }
+  free(r);
+  free(m2r);
+  free(m1m2r);
+  free(productR);
+  free(row);
+  return isOk;
+}
+
+/** Return true iff Freivalds' check finds product to be m1 * m2.  If
+ *  false, compute the offending row of m1 * m2 exactly to report its
+ *  first erroneous entry on stderr.
+ */
+static _Bool
+doFreivaldsMulTestMatrix(Matrix *m1, const char *m1Desc,
+                         Matrix *m2, const char *m2Desc, Matrix *product)
+{
+  int diffRowN;
+  if (freivaldsCheck(m1, m2, product, verifyMode.nRounds, &diffRowN)) {
+    return true;
+  }
+  int err = 0;
+  const int n2 = m1->fns->getNCols(m1, &err);
+  const int n3 = m2->fns->getNCols(m2, &err);
+  MatrixBaseType *m1Row = mallocChk(sizeof(MatrixBaseType)*n2);
+  MatrixBaseType *m2Row = mallocChk(sizeof(MatrixBaseType)*n3);
+  MatrixBaseType *productRow = mallocChk(sizeof(MatrixBaseType)*n3);
+  uint32_t *expected = mallocChk(sizeof(uint32_t)*n3);
+  m1->fns->getRow(m1, diffRowN, m1Row, &err);
+  product->fns->getRow(product, diffRowN, productRow, &err);
+  for (int j = 0; j < n3; j++) expected[j] = 0;
+  for (int k = 0; k < n2; k++) {
+    m2->fns->getRow(m2, k, m2Row, &err);
+    for (int j = 0; j < n3; j++) {
+      expected[j] += (uint32_t)m1Row[k]*(uint32_t)m2Row[j];
+    }
+  }
+  if (err) {
+    fatal("doFreivaldsMulTestMatrix(): cannot get rows for %s x %s: %s",
+          m1Desc, m2Desc, strerror(err));
+  }
+  int diffColN = 0;
+  while (diffColN < n3 - 1 &&
+         (MatrixBaseType)expected[diffColN] == productRow[diffColN]) {
+    diffColN++;
+  }
+  error("%s x %s: differs at [%d][%d]; expected %d, got %d", m1Desc, m2Desc,
+        diffRowN, diffColN, (MatrixBaseType)expected[diffColN],
+        productRow[diffColN]);
+  free(m1Row);
+  free(m2Row);
+  free(productRow);
+  free(expected);
+  return false;
+}
+
+/** Return true iff product is m1 * m2, verified as specified by
+ *  verifyMode.  If false, report erroneous first entry on stderr.
+ */
+static _Bool
+doMulTestMatrix(Matrix *m1, const char *m1Desc,
+                Matrix *m2, const char *m2Desc, Matrix *product)
+{
+  return (verifyMode.isGold)
+    ? doGoldMulTestMatrix(m1, m1Desc, m2, m2Desc, product)
+    : doFreivaldsMulTestMatrix(m1, m1Desc, m2, m2Desc, product);
+}
+
 /************************ Transpose Test Routines **********************/
 
 static _Bool
@@ -272,6 +535,15 @@ doTransposeTestMatrix(FILE *out, _Bool doOutput,
     return;
   }
   testTranspose(matrix, desc, transpose, nRows, nCols);
+  Matrix *view = (Matrix *)newTransposeView((Matrix *)matrix, false, &err);
+  if (err) {
+    error("doTransposeTestMatrix(): cannot create transpose view for %s: %s",
+          desc, strerror(err));
+  }
+  else {
+    testTranspose(matrix, desc, view, nRows, nCols);
+    view->fns->free(view, &err);
+  }
   if (doOutput) {
     outTransposeTest(out, matrix, desc, transpose);
   }
@@ -285,7 +557,9 @@ doTransposeTestMatrix(FILE *out, _Bool doOutput,
 
 /************************* Test Data to Matrix *************************/
 
-/** Initialize matrix from init. */
+/** Initialize matrix from init: a dense matrix using a bulk copy
+ *  into its storage, any other matrix an element at a time.
+ */
 static void
 initMatrix(int n1, int n2, int init[n1][n2], Matrix *matrix, int *err)
 {
@@ -294,6 +568,11 @@ initMatrix(int n1, int n2, int init[n1][n2], Matrix *matrix, int *err)
     *err = EDOM;
   }
   if (*err) return;
+  DenseMatrix *dense = asDenseMatrix(matrix);
+  if (dense) {
+    copyToDenseMatrix(dense, &init[0][0], n2);
+    return;
+  }
   for (int i = 0; i < n1; i++) {
     for (int j = 0; j < n2; j++) {
       matrix->fns->setElement(matrix, i, j, init[i][j], err);
@@ -302,9 +581,16 @@ initMatrix(int n1, int n2, int init[n1][n2], Matrix *matrix, int *err)
   }
 }
 
+/** Return a new matrix created using newMatrix and initialized from
+ *  dataP.  Dense matrices for data from a matrix file are mapped
+ *  directly from the file without copying.
+ */
 static Matrix *
 createMatrix(const TestData *dataP, NewFn newMatrix, int *err)
 {
+  if (dataP->path && newMatrix == (NewFn)newDenseMatrix) {
+    return (Matrix *)newDenseMatrixFromFile(dataP->path, false, err);
+  }
   int nRows = dataP->nRows;
   int nCols = dataP->nCols;
   Matrix *matrix = newMatrix(nRows, nCols, err);
@@ -338,20 +624,10 @@ doTransposeTestData(FILE *out, _Bool doOutput, const TestData *data)
   }
 }
 
-static void
-outTimes(const char *desc1, const char *desc2,
-         const struct tms *start, const struct tms *end)
-{
-  long utime = end->tms_utime - start->tms_utime;
-  long stime = end->tms_stime - start->tms_stime;
-  fprintf(stderr, "%s x %s: utime: %ld, stime: %ld, total: %ld\n",
-          desc1, desc2, utime, stime, utime + stime);
-}
-
 /** Test multiplication for data1 and data2 for all possible newFns.
  */
 static void
-doMulTestData(FILE *out, _Bool doOutput, int perfCount,
+doMulTestData(FILE *out, _Bool doOutput,
               const TestData *data1, const TestData *data2)
 {
   int err = 0;
@@ -394,22 +670,8 @@ doMulTestData(FILE *out, _Bool doOutput, int perfCount,
                 desc1, desc2, strerror(err));
         continue;
       }
-      struct tms start, end;
-      if (times(&start) < 0) {
-        fatal("cannot get start time for %s x %s:", desc1, desc2);
-      }
-      int nPerfIters = 0;
-      do {
-        multiplicand->fns->mul(multiplicand, multiplier, product, &err);
-        nPerfIters++;
-      } while (nPerfIters < perfCount);
-      if (times(&end) < 0) {
-        fatal("cannot get start time for %s x %s:", desc1, desc2);
-      }
-      if (!err && perfCount >= 0) {
-        outTimes(newFns[i].desc, newFns[j].desc, &start, &end);
-      }
-      if (!err && perfCount < 0) {
+      multiplicand->fns->mul(multiplicand, multiplier, product, &err);
+      if (!err) {
         doMulTestMatrix(multiplicand, data1->desc, multiplier, data2->desc,
                         product);
       }
@@ -441,6 +703,97 @@ doMulTestData(FILE *out, _Bool doOutput, int perfCount,
   } //for (int i = 0; ...)
 }
 
+/********************* Matrix-Vector Test Routines *********************/
+
+/** Check matrix->mulVec() and matrix->vecMul() against products
+ *  computed from the entries of matrix, for vectors with random
+ *  entries; the results are poisoned before each operation so that
+ *  entries which are not written are detected.  Return true iff ok.
+ */
+static _Bool
+doMulVecTestMatrix(const Matrix *matrix, const char *desc)
+{
+  int nRows, nCols;
+  int *plain = matrixToPlainMatrix((Matrix *)matrix, desc, &nRows, &nCols);
+  int *x = mallocChk(sizeof(MatrixBaseType)*nCols);
+  int *y = mallocChk(sizeof(MatrixBaseType)*nRows);
+  int *gold = mallocChk(sizeof(MatrixBaseType)*(nRows + nCols));
+  int *result = mallocChk(sizeof(MatrixBaseType)*(nRows + nCols));
+  for (int j = 0; j < nCols; j++) x[j] = rand() % 19 - 9;
+  for (int i = 0; i < nRows; i++) y[i] = rand() % 19 - 9;
+  _Bool isOk = true;
+  int err = 0;
+
+  //gold[i] = Sum_j plain[i][j]*x[j]
+  for (int i = 0; i < nRows; i++) {
+    gold[i] = 0;
+    for (int j = 0; j < nCols; j++) gold[i] += plain[i*nCols + j]*x[j];
+  }
+  memset(result, -1, sizeof(MatrixBaseType)*nRows);
+  matrix->fns->mulVec(matrix, x, result, &err);
+  if (err) {
+    error("%s: mulVec(): %s", desc, strerror(err));
+    isOk = false;
+  }
+  for (int i = 0; i < nRows && isOk; i++) {
+    if (result[i] != gold[i]) {
+      error("%s: mulVec() differs at [%d]; expected %d, got %d", desc, i,
+            gold[i], result[i]);
+      isOk = false;
+    }
+  }
+
+  //gold[j] = Sum_i y[i]*plain[i][j]
+  for (int j = 0; j < nCols; j++) {
+    gold[j] = 0;
+    for (int i = 0; i < nRows; i++) gold[j] += y[i]*plain[i*nCols + j];
+  }
+  memset(result, -1, sizeof(MatrixBaseType)*nCols);
+  err = 0;
+  matrix->fns->vecMul(matrix, y, result, &err);
+  if (err) {
+    error("%s: vecMul(): %s", desc, strerror(err));
+    isOk = false;
+  }
+  for (int j = 0; j < nCols && !err; j++) {
+    if (result[j] != gold[j]) {
+      error("%s: vecMul() differs at [%d]; expected %d, got %d", desc, j,
+            gold[j], result[j]);
+      isOk = false;
+      break;
+    }
+  }
+  free(plain);
+  free(x);
+  free(y);
+  free(gold);
+  free(result);
+  return isOk;
+}
+
+/** Test mulVec() and vecMul() for data for all possible newFns. */
+static void
+doMulVecTestData(const TestData *data)
+{
+  int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  for (int i = 0; i < nNewFns; i++) {
+    int err = 0;
+    Matrix *matrix = createMatrix(data, newFns[i].new, &err);
+    const char *useStr = " using ";
+    char *desc = mallocChk(strlen(data->desc) + strlen(useStr) +
+                            strlen(newFns[i].desc) + 1);
+    sprintf(desc, "%s%s%s", data->desc, useStr, newFns[i].desc);
+    if (err) {
+      error("cannot create matrix %s: %s", desc, strerror(err));
+    }
+    else {
+      doMulVecTestMatrix(matrix, desc);
+      matrix->fns->free(matrix, &err);
+    }
+    free(desc);
+  }
+}
+
 /****************** Tests with Predefined Matrix Data ******************/
 
 static void
@@ -453,21 +806,27 @@ doTransposeTests(FILE *out, _Bool doOutput,
 }
 
 static void
-doMulTests(FILE *out, _Bool doOutput, int perfCount,
-           const TestData *data, int nData)
+doMulTests(FILE *out, _Bool doOutput, const TestData *data, int nData)
 {
   for (int i = 0; i < nData; i++) {
     for (int j = 0; j < nData; j++) {
-      doMulTestData(out, doOutput, perfCount, &data[i], &data[j]);
+      doMulTestData(out, doOutput, &data[i], &data[j]);
     }
   }
 }
 
+static void
+doMulVecTests(const TestData *data, int nData)
+{
+  for (int i = 0; i < nData; i++) doMulVecTestData(&data[i]);
+}
+
 static void
 doTests(FILE *out, _Bool doOutput, const TestData *data, int nData)
 {
   doTransposeTests(out, doOutput, data, nData);
-  doMulTests(out, doOutput, -1, data, nData);
+  doMulTests(out, doOutput, data, nData);
+  doMulVecTests(data, nData);
 }
 
 
@@ -484,6 +843,7 @@ createRandomTestData(const RandSpec *spec)
 {
   TestData data;
   data.desc = spec->desc;
+  data.path = NULL;
   data.nRows = spec->nRows; data.nCols = spec->nCols;
   data.data = mallocChk(spec->nRows * spec->nCols * sizeof(MatrixBaseType));
   for (int i = 0; i < spec->nRows * spec->nCols; i++) {
@@ -507,95 +867,2971 @@ static const RandSpec randSpecs[] = {
   { .desc = "rand(5x6)", .nRows = 5, .nCols = 6, .max = 10 }
 };
 
-static void doRandomTests(FILE *out, _Bool doOutput) {
-  int nSpecs = sizeof(randSpecs)/sizeof(randSpecs[0]);
-  TestData data[nSpecs];
-  for (int i = 0; i < nSpecs; i++) {
-    data[i] = createRandomTestData(&randSpecs[i]);
-  }
-  doTests(out, doOutput, data, nSpecs);
-  for (int i = 0; i < nSpecs; i++) {
-    freeRandomTestData(&data[i]);
+/** Dimensions n1 x n2 x n3 used for cross-checking kernel variants;
+ *  chosen to exercise partial micro-kernel and cache blocks.
+ */
+static const struct { int n1, n2, n3; } kernelTestDims[] = {
+  { 1, 1, 1 }, { 5, 7, 3 }, { 4, 16, 32 }, { 37, 33, 35 },
+  { 67, 130, 300 },
+};
+
+/** Check that freivaldsCheck() accepts correct products and rejects
+ *  products with a single corrupted entry, identifying its row.
+ */
+static void
+doVerifyTests(void)
+{
+  const int deltas[] = { 1, -1, 1 << 16 };
+  const int nDeltas = sizeof(deltas)/sizeof(deltas[0]);
+  int nDims = sizeof(kernelTestDims)/sizeof(kernelTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = kernelTestDims[d].n1, n2 = kernelTestDims[d].n2,
+        n3 = kernelTestDims[d].n3;
+    RandSpec spec1 = { .desc = "a", .nRows = n1, .nCols = n2, .max = 100 };
+    RandSpec spec2 = { .desc = "b", .nRows = n2, .nCols = n3, .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    int err = 0;
+    Matrix *m1 = createMatrix(&a, (NewFn)newDenseMatrix, &err);
+    Matrix *m2 = createMatrix(&b, (NewFn)newSparseCsrMatrix, &err);
+    Matrix *product = (Matrix *)newDenseMatrix(n1, n3, &err);
+    if (err) fatal("cannot create verify test matrices: %s", strerror(err));
+    m1->fns->mul(m1, m2, product, &err);
+    int diffRowN;
+    if (!freivaldsCheck(m1, m2, product, DEFAULT_VERIFY_ROUNDS, &diffRowN)) {
+      error("verify %dx%dx%d: correct product rejected at row %d",
+            n1, n2, n3, diffRowN);
+    }
+    for (int k = 0; k < nDeltas; k++) {
+      const int i = rand() % n1, j = rand() % n3;
+      const int value = product->fns->getElement(product, i, j, &err);
+      product->fns->setElement(product, i, j, value + deltas[k], &err);
+      diffRowN = -1;
+      if (freivaldsCheck(m1, m2, product, DEFAULT_VERIFY_ROUNDS,
+                         &diffRowN)) {
+        error("verify %dx%dx%d: [%d][%d] += %d not detected",
+              n1, n2, n3, i, j, deltas[k]);
+      }
+      else if (diffRowN != i) {
+        error("verify %dx%dx%d: [%d][%d] += %d reported at row %d",
+              n1, n2, n3, i, j, deltas[k], diffRowN);
+      }
+      product->fns->setElement(product, i, j, value, &err);
+    }
+    m1->fns->free(m1, &err);
+    m2->fns->free(m2, &err);
+    product->fns->free(product, &err);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
   }
 }
 
-/*************************** Predefined Tests **************************/
-
-#include "test.data"
-
+/** Cross-check all supported micro-kernel variants against the scalar
+ *  variant, after checking the scalar variant against
+ *  goldMatrixMultiply().
+ */
 static void
-doPredefinedTests(FILE *out, _Bool doOutput)
+doGemmKernelTests(void)
 {
-  doTests(out, doOutput, testData, sizeof(testData)/sizeof(testData[0]));
+  GemmKernelId savedKernel = getGemmKernel();
+  int nDims = sizeof(kernelTestDims)/sizeof(kernelTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = kernelTestDims[d].n1, n2 = kernelTestDims[d].n2,
+        n3 = kernelTestDims[d].n3;
+    RandSpec spec1 = { .desc = "a", .nRows = n1, .nCols = n2, .max = 100 };
+    RandSpec spec2 = { .desc = "b", .nRows = n2, .nCols = n3, .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    int *gold = mallocChk(sizeof(MatrixBaseType)*n1*n3);
+    int *scalar = mallocChk(sizeof(MatrixBaseType)*n1*n3);
+    int *c = mallocChk(sizeof(MatrixBaseType)*n1*n3);
+    goldMatrixMultiply(n1, n2, n3, (int (*)[n2])a.data, (int (*)[n3])b.data,
+                       (int (*)[n3])gold);
+    setGemmKernel(GEMM_KERNEL_SCALAR);
+    gemmBlocked(n1, n2, n3, a.data, n2, b.data, n3, scalar, n3);
+    int scalarDot = dotProduct(n2, a.data, a.data);
+    if (memcmp(gold, scalar, sizeof(MatrixBaseType)*n1*n3) != 0) {
+      error("%s kernel: %dx%dx%d product differs from gold",
+            getGemmKernelName(GEMM_KERNEL_SCALAR), n1, n2, n3);
+    }
+    for (GemmKernelId k = GEMM_KERNEL_SCALAR + 1; k < N_GEMM_KERNELS; k++) {
+      if (!setGemmKernel(k)) continue;
+      gemmBlocked(n1, n2, n3, a.data, n2, b.data, n3, c, n3);
+      if (memcmp(scalar, c, sizeof(MatrixBaseType)*n1*n3) != 0) {
+        error("%s kernel: %dx%dx%d product differs from scalar kernel",
+              getGemmKernelName(k), n1, n2, n3);
+      }
+      int dot = dotProduct(n2, a.data, a.data);
+      if (dot != scalarDot) {
+        error("%s kernel: %d-element dot product: expected %d, got %d",
+              getGemmKernelName(k), n2, scalarDot, dot);
+      }
+    }
+    free(gold);
+    free(scalar);
+    free(c);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+  }
+  setGemmKernel(savedKernel);
 }
 
+/** Dimensions used for checking the storage of dense matrices: rows
+ *  shorter than, equal to and spanning several cache lines, including
+ *  power-of-two lengths.
+ */
+static const struct { int nRows, nCols; } storageTestDims[] = {
+  { 1, 1 }, { 5, 7 }, { 3, 16 }, { 7, 33 }, { 4, 1024 }, { 3, 1025 },
+  { 2, 2048 }, { 5, 64 }, { 3, 200 },
+};
+
+/** # of calls of countingMulKernel() */
+static int nCountingMulCalls = 0;
 
-/************************** Performance Tests **************************/
+/** Count the call and decline, so that the generic algorithm is used */
+static _Bool
+countingMulKernel(const Matrix *this, const Matrix *multiplier,
+                  Matrix *product, int *err)
+{
+  nCountingMulCalls++;
+  return false;
+}
 
+/** Check that each class in newFns has the id corresponding to its
+ *  name, that the registry has a kernel for every combination of
+ *  classes with storage (and none for a sparse multiplier), and that
+ *  a registered kernel is used by multiplications of its classes.
+ */
 static void
-doPerformanceTests(int n)
+doMulDispatchTests(void)
 {
-  enum { N_ITER = 1 };
-  RandSpec randSpec = {
-    .desc = "randPerfMatrix", .nRows = n, .nCols = n, .max = 100,
+  static const MatrixKlassId ids[] = {
+    MATRIX_KLASS_DENSE, MATRIX_KLASS_SMART_MUL, MATRIX_KLASS_BLOCKED_MUL,
+    MATRIX_KLASS_PARALLEL_MUL, MATRIX_KLASS_STRASSEN,
+    MATRIX_KLASS_SPARSE_CSR, MATRIX_KLASS_TRANSPOSE_VIEW,
+    MATRIX_KLASS_SUB_MATRIX_VIEW,
   };
-  TestData data = createRandomTestData(&randSpec);
-  doMulTests(NULL, false, N_ITER, &data, 1);
+  enum { N = 16 };
+  const int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  Matrix *matrices[nNewFns];
+  int err = 0;
+  for (int i = 0; i < nNewFns; i++) {
+    matrices[i] = newFns[i].new(N, N, &err);
+    if (err) fatal("cannot create %s: %s", newFns[i].desc, strerror(err));
+    const MatrixKlassId id = matrices[i]->fns->getKlassId(matrices[i], &err);
+    if (id != ids[i]) {
+      error("%s: class id %d; expected %d", newFns[i].desc, id, ids[i]);
+    }
+  }
+  Matrix *product = matrices[0];
+  for (int i = 0; i < nNewFns; i++) {
+    for (int j = 0; j < nNewFns; j++) {
+      const _Bool isSparse = ids[i] == MATRIX_KLASS_SPARSE_CSR ||
+        ids[j] == MATRIX_KLASS_SPARSE_CSR;
+      const _Bool isView = ids[i] == MATRIX_KLASS_TRANSPOSE_VIEW;
+      MulKernelFn kernel =
+        getMulKernel(matrices[i], matrices[j], product, &err);
+      if (!kernel != (isSparse || isView)) {
+        error("%s x %s: %s mul kernel registered", newFns[i].desc,
+              newFns[j].desc, (kernel) ? "unexpected" : "no");
+      }
+    }
+  }
+
+  RandSpec spec = { .desc = "dispatch", .nRows = N, .nCols = N, .max = 100 };
+  TestData data = createRandomTestData(&spec);
+  Matrix *m1 = createMatrix(&data, (NewFn)newDenseMatrix, &err);
+  Matrix *m2 = createMatrix(&data, (NewFn)newSmartMulMatrix, &err);
+  if (err) fatal("cannot create dispatch test matrices: %s", strerror(err));
+  MulKernelFn saved = getMulKernel(m1, m2, product, &err);
+  setMulKernel(MATRIX_KLASS_DENSE, MATRIX_KLASS_SMART_MUL, MATRIX_KLASS_DENSE,
+               countingMulKernel);
+  nCountingMulCalls = 0;
+  m1->fns->mul(m1, m2, product, &err);
+  setMulKernel(MATRIX_KLASS_DENSE, MATRIX_KLASS_SMART_MUL, MATRIX_KLASS_DENSE,
+               saved);
+  if (err) {
+    error("dispatch: denseMatrix x smartMulMatrix: %s", strerror(err));
+  }
+  else {
+    if (nCountingMulCalls != 1) {
+      error("dispatch: registered kernel called %d times", nCountingMulCalls);
+    }
+    doMulTestMatrix(m1, "dispatch", m2, "dispatch", product);
+  }
+  m1->fns->free(m1, &err);
+  m2->fns->free(m2, &err);
   freeRandomTestData(&data);
+  for (int i = 0; i < nNewFns; i++) matrices[i]->fns->free(matrices[i], &err);
 }
 
-/***************************** Main Program ****************************/
-
-#define OUTPUT_LONG_OPT            "output"
-#define OUTPUT_SHORT_OPT           'o'
-#define PREDEF_TESTS_LONG_OPT      "predefined-tests"
-#define PREDEF_TESTS_SHORT_OPT     't'
-#define RAND_TESTS_LONG_OPT        "random-tests"
-#define RAND_TESTS_SHORT_OPT       'r'
-#define PERF_MATRIX_SIZE_LONG_OPT  "perf-matrix-size"
-#define PERF_MATRIX_SIZE_SHORT_OPT 's'
-
-#define SHORT_OPTS {     \
-  PREDEF_TESTS_SHORT_OPT, \
-  RAND_TESTS_SHORT_OPT, \
-  OUTPUT_SHORT_OPT, \
-  PERF_MATRIX_SIZE_SHORT_OPT, ':', \
-  '\0' \
+/** Check that the storage of each class with dense storage is aligned
+ *  and initialized to 0, and that rows are padded to a whole # of cache
+ *  lines (plus one if a multiple of DENSE_MATRIX_CONFLICT_LINES) unless
+ *  padding is disabled or rows are shorter than a cache line.
+ */
+static void
+doDenseStorageTests(void)
+{
+  enum { LINE_ENTRIES = DENSE_MATRIX_ALIGN/sizeof(MatrixBaseType) };
+  const struct { const char *desc; NewFn new; } denseNewFns[] = {
+    { "denseMatrix", (NewFn)newDenseMatrix },
+    { "smartMulMatrix", (NewFn)newSmartMulMatrix },
+    { "blockedMulMatrix", (NewFn)newBlockedMulMatrix },
+    { "parallelMulMatrix", (NewFn)newParallelMulMatrix },
+    { "strassenMatrix", (NewFn)newStrassenMatrix },
+  };
+  int nNewFns = sizeof(denseNewFns)/sizeof(denseNewFns[0]);
+  int nDims = sizeof(storageTestDims)/sizeof(storageTestDims[0]);
+  for (int isPadded = 0; isPadded < 2; isPadded++) {
+    setDenseMatrixPadding(isPadded);
+    for (int d = 0; d < nDims; d++) {
+      const int nRows = storageTestDims[d].nRows;
+      const int nCols = storageTestDims[d].nCols;
+      for (int f = 0; f < nNewFns; f++) {
+        int err = 0, ld;
+        Matrix *matrix = denseNewFns[f].new(nRows, nCols, &err);
+        const MatrixBaseType *data =
+          (err) ? NULL : matrix->fns->getData(matrix, &ld, &err);
+        if (!data) {
+          error("%s %dx%d: cannot get storage: %s", denseNewFns[f].desc,
+                nRows, nCols, strerror(err));
+          continue;
+        }
+        if ((uintptr_t)data % DENSE_MATRIX_ALIGN != 0) {
+          error("%s %dx%d: storage at %p is not aligned",
+                denseNewFns[f].desc, nRows, nCols, (const void *)data);
+        }
+        int nLines = (nCols + LINE_ENTRIES - 1)/LINE_ENTRIES;
+        if (nLines % DENSE_MATRIX_CONFLICT_LINES == 0) nLines++;
+        const int expectedLd = (isPadded && nCols >= LINE_ENTRIES)
+          ? nLines*LINE_ENTRIES
+          : nCols;
+        if (ld != expectedLd) {
+          error("%s %dx%d: unexpected %s row stride %d", denseNewFns[f].desc,
+                nRows, nCols, (isPadded) ? "padded" : "unpadded", ld);
+        }
+        for (int i = 0; i < nRows; i++) {
+          for (int j = 0; j < nCols; j++) {
+            if (data[(size_t)i*ld + j] != 0) {
+              error("%s %dx%d: entry [%d][%d] not initialized to 0",
+                    denseNewFns[f].desc, nRows, nCols, i, j);
+              i = nRows;
+              break;
+            }
+          }
+        }
+        matrix->fns->free(matrix, &err);
+      }
+    }
   }
+  setDenseMatrixPadding(true);
+}
 
-static struct option options[] = {
-  { .name = OUTPUT_LONG_OPT, .has_arg = 0, .flag = 0,
-    .val = OUTPUT_SHORT_OPT
-  },
-  { .name = PREDEF_TESTS_LONG_OPT, .has_arg = 0, .flag = 0,
-    .val = PREDEF_TESTS_SHORT_OPT
-  },
-  { .name = RAND_TESTS_LONG_OPT, .has_arg = 0, .flag = 0,
-    .val = RAND_TESTS_SHORT_OPT
-  },
-  { .name = PERF_MATRIX_SIZE_LONG_OPT, .has_arg = 1, .flag = 0,
-    .val = PERF_MATRIX_SIZE_SHORT_OPT
-  },
+/** Check that the inline accessors and bulk copies of dense_matrix.h
+ *  agree with the checked functions in fns for every class with dense
+ *  storage, and that asDenseMatrix() accepts only those classes.
+ */
+static void
+doDenseAccessorTests(void)
+{
+  const int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  const int nDims = sizeof(storageTestDims)/sizeof(storageTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    RandSpec spec = {
+      .desc = "accessor", .nRows = storageTestDims[d].nRows,
+      .nCols = storageTestDims[d].nCols, .max = 100,
+    };
+    const int nRows = spec.nRows, nCols = spec.nCols;
+    TestData data = createRandomTestData(&spec);
+    int *copy = mallocChk(sizeof(MatrixBaseType)*nRows*nCols);
+    for (int f = 0; f < nNewFns; f++) {
+      int err = 0;
+      Matrix *matrix = newFns[f].new(nRows, nCols, &err);
+      if (err) fatal("cannot create %s: %s", newFns[f].desc, strerror(err));
+      const MatrixKlassId id = matrix->fns->getKlassId(matrix, &err);
+      const _Bool isDense = id != MATRIX_KLASS_SPARSE_CSR &&
+        id != MATRIX_KLASS_TRANSPOSE_VIEW && id != MATRIX_KLASS_SUB_MATRIX_VIEW;
+      DenseMatrix *dense = asDenseMatrix(matrix);
+      if (!dense != !isDense) {
+        error("%s: asDenseMatrix() return'd %p", newFns[f].desc,
+              (void *)dense);
+      }
+      if (!dense) {
+        matrix->fns->free(matrix, &err);
+        continue;
+      }
+      int ld;
+      const MatrixBaseType *storage = matrix->fns->getData(matrix, &ld, &err);
+      if (getDenseMatrixNRows(dense) != nRows ||
+          getDenseMatrixNCols(dense) != nCols ||
+          getDenseMatrixRowStride(dense) != ld ||
+          getDenseMatrixData(dense) != storage) {
+        error("%s %dx%d: inline dimensions or storage differ from fns",
+              newFns[f].desc, nRows, nCols);
+      }
+      fillDenseMatrix(dense, -7);
+      copyToDenseMatrix(dense, data.data, nCols);
+      setDenseMatrixElement(dense, nRows - 1, nCols - 1, 12345);
+      data.data[nRows*nCols - 1] = 12345;
+      for (int i = 0; i < nRows; i++) {
+        for (int j = 0; j < nCols; j++) {
+          const int value = matrix->fns->getElement(matrix, i, j, &err);
+          if (value != data.data[i*nCols + j] ||
+              getDenseMatrixElement(dense, i, j) != value) {
+            error("%s %dx%d: entry [%d][%d] differs after bulk copy",
+                  newFns[f].desc, nRows, nCols, i, j);
+            i = nRows;
+            break;
+          }
+        }
+      }
+      copyFromDenseMatrix(dense, copy, nCols);
+      if (memcmp(copy, data.data, sizeof(MatrixBaseType)*nRows*nCols) != 0) {
+        error("%s %dx%d: copy from matrix differs", newFns[f].desc,
+              nRows, nCols);
+      }
+      fillDenseMatrix(dense, -7);
+      for (int i = 0; i < nRows; i++) {
+        if (matrix->fns->getElement(matrix, i, nCols - 1, &err) != -7) {
+          error("%s %dx%d: row %d not filled", newFns[f].desc,
+                nRows, nCols, i);
+          break;
+        }
+      }
+      matrix->fns->free(matrix, &err);
+    }
+    free(copy);
+    freeRandomTestData(&data);
+  }
+}
 
+/** Dimensions used for checking matrix-vector products with every
+ *  micro-kernel variant; chosen to exercise partial vectors and, with
+ *  more than 2048 columns, the segments of the result of vecMul().
+ */
+static const struct { int nRows, nCols; } mulVecTestDims[] = {
+  { 1, 1 }, { 5, 7 }, { 37, 33 }, { 67, 300 }, { 300, 67 }, { 3, 4099 },
 };
 
-typedef struct {
-  _Bool isErr;
-  _Bool doOutput;
-  _Bool doPredefTests;
-  _Bool doRandomTests;
-  int perfMatrixSize;
-} Opts;
-
+/** Check mulVec() and vecMul() of all classes using every supported
+ *  micro-kernel variant.
+ */
+static void
+doMulVecKernelTests(void)
+{
+  GemmKernelId savedKernel = getGemmKernel();
+  int nDims = sizeof(mulVecTestDims)/sizeof(mulVecTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    RandSpec spec = {
+      .desc = "randMulVec", .nRows = mulVecTestDims[d].nRows,
+      .nCols = mulVecTestDims[d].nCols, .max = 100,
+    };
+    TestData data = createRandomTestData(&spec);
+    for (GemmKernelId k = GEMM_KERNEL_SCALAR; k < N_GEMM_KERNELS; k++) {
+      if (!setGemmKernel(k)) continue;
+      doMulVecTestData(&data);
+    }
+    freeRandomTestData(&data);
+  }
+  setGemmKernel(savedKernel);
+}
+
+/** Operations on the matrix classes for a single element type from
+ *  typed_matrix.h, so that doTypedTests() can test all the types.
+ *  Matrices, elements and vectors are passed as void pointers.
+ */
+typedef struct {
+  const char *desc;                   //element type
+  size_t elemSize;
+  int nKlasses;                       //# of classes newMatrix() creates
+  /** Set n elements to random integers small enough to be exact */
+  void (*fill)(void *elements, int n);
+  /** c[m][p] = a[m][n] * b[n][p] computed straightforwardly */
+  void (*goldMul)(int m, int n, int p, const void *a, const void *b,
+                  void *c);
+  /** *result = dot product of n-vectors a and b using the kernels */
+  void (*dot)(int n, const void *a, const void *b, void *result);
+  /** Return a new nRows x nCols matrix of class # klass */
+  void *(*newMatrix)(int klass, int nRows, int nCols, int *err);
+  const char *(*getKlass)(const void *matrix, int *err);
+  void (*free)(void *matrix, int *err);
+  void (*getRow)(const void *matrix, int rowIndex, void *row, int *err);
+  void (*setRow)(void *matrix, int rowIndex, const void *row, int *err);
+  void (*transpose)(const void *matrix, void *result, int *err);
+  void (*mul)(const void *matrix, const void *multiplier, void *product,
+              int *err);
+  void (*mulVec)(const void *matrix, const void *vec, void *result,
+                 int *err);
+  void (*vecMul)(const void *matrix, const void *vec, void *result,
+                 int *err);
+} TypedTestOps;
+
+/** Set the rows of matrix from row-major elements; return false
+ *  after reporting an error on failure.
+ */
+static _Bool
+setTypedRows(const TypedTestOps *ops, void *matrix, int nRows, int nCols,
+             const void *elements)
+{
+  int err = 0;
+  const char *bytes = elements;
+  for (int i = 0; i < nRows && !err; i++) {
+    ops->setRow(matrix, i, &bytes[ops->elemSize*i*nCols], &err);
+  }
+  if (err) error("%s: setRow(): %s", ops->desc, strerror(err));
+  return !err;
+}
+
+/** Return true iff the rows of matrix are the row-major gold
+ *  elements; report an error described by what otherwise.
+ */
+static _Bool
+checkTypedRows(const TypedTestOps *ops, const void *matrix,
+               int nRows, int nCols, const void *gold, const char *what)
+{
+  int err = 0;
+  const char *klass = ops->getKlass(matrix, &err);
+  char *row = mallocChk(ops->elemSize*nCols);
+  const char *goldBytes = gold;
+  _Bool isOk = !err;
+  for (int i = 0; i < nRows && isOk; i++) {
+    ops->getRow(matrix, i, row, &err);
+    if (err) {
+      error("%s %s: %s: getRow(): %s", ops->desc, klass, what,
+            strerror(err));
+      isOk = false;
+    }
+    else if (memcmp(row, &goldBytes[ops->elemSize*i*nCols],
+                    ops->elemSize*nCols) != 0) {
+      error("%s %s: %dx%d %s differs from gold in row %d", ops->desc,
+            klass, nRows, nCols, what, i);
+      isOk = false;
+    }
+  }
+  free(row);
+  return isOk;
+}
+
+/** Check the transpose and matrix-vector products of n1 x n2 matrix
+ *  m1 of class # klass, whose entries are a[].
+ */
+static void
+doTypedUnaryTests(const TypedTestOps *ops, int klass, const void *m1,
+                  int n1, int n2, const void *a)
+{
+  const size_t size = ops->elemSize;
+  const char *aBytes = a;
+  char *gold = mallocChk(size*n1*n2);
+  int err = 0;
+
+  void *tr = ops->newMatrix(klass, n2, n1, &err);
+  if (err) fatal("cannot create %s matrix: %s", ops->desc, strerror(err));
+  for (int i = 0; i < n1; i++) {
+    for (int j = 0; j < n2; j++) {
+      memcpy(&gold[size*(j*n1 + i)], &aBytes[size*(i*n2 + j)], size);
+    }
+  }
+  ops->transpose(m1, tr, &err);
+  if (err) error("%s: transpose: %s", ops->desc, strerror(err));
+  else checkTypedRows(ops, tr, n2, n1, gold, "transpose");
+  ops->free(tr, &err);
+
+  //the vectors are the first entries of a[]
+  char *x = mallocChk(size*(n1 + n2));
+  ops->mulVec(m1, a, x, &err);
+  ops->goldMul(n1, n2, 1, a, a, gold);
+  if (err) error("%s: mulVec(): %s", ops->desc, strerror(err));
+  else if (memcmp(x, gold, size*n1) != 0) {
+    error("%s %s: %dx%d mulVec() differs from gold", ops->desc,
+          ops->getKlass(m1, &err), n1, n2);
+  }
+  ops->vecMul(m1, a, x, &err);
+  ops->goldMul(1, n1, n2, a, a, gold);
+  if (err) error("%s: vecMul(): %s", ops->desc, strerror(err));
+  else if (memcmp(x, gold, size*n2) != 0) {
+    error("%s %s: %dx%d vecMul() differs from gold", ops->desc,
+          ops->getKlass(m1, &err), n1, n2);
+  }
+  free(x);
+  free(gold);
+}
+
+/** Test the matrix classes for the element type of ops: for each
+ *  supported micro-kernel variant, every pair of classes is
+ *  multiplied and checked against a straightforward product, as are
+ *  transposes, matrix-vector products and dot products.
+ */
+static void
+doTypedTests(const TypedTestOps *ops)
+{
+  const size_t size = ops->elemSize;
+  GemmKernelId savedKernel = getGemmKernel();
+  int nDims = sizeof(kernelTestDims)/sizeof(kernelTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = kernelTestDims[d].n1, n2 = kernelTestDims[d].n2,
+        n3 = kernelTestDims[d].n3;
+    void *a = mallocChk(size*n1*n2);
+    void *b = mallocChk(size*n2*n3);
+    void *gold = mallocChk(size*n1*n3);
+    char *dots = mallocChk(2*size);
+    ops->fill(a, n1*n2);
+    ops->fill(b, n2*n3);
+    ops->goldMul(n1, n2, n3, a, b, gold);
+    ops->goldMul(1, n2, 1, a, a, &dots[0]);
+    for (GemmKernelId k = GEMM_KERNEL_SCALAR; k < N_GEMM_KERNELS; k++) {
+      if (!setGemmKernel(k)) continue;
+      ops->dot(n2, a, a, &dots[size]);
+      if (memcmp(&dots[0], &dots[size], size) != 0) {
+        error("%s kernel: %d-element %s dot product differs from gold",
+              getGemmKernelName(k), n2, ops->desc);
+      }
+      for (int f1 = 0; f1 < ops->nKlasses; f1++) {
+        for (int f2 = 0; f2 < ops->nKlasses; f2++) {
+          int err = 0;
+          void *m1 = ops->newMatrix(f1, n1, n2, &err);
+          void *m2 = ops->newMatrix(f2, n2, n3, &err);
+          void *product = ops->newMatrix(0, n1, n3, &err);
+          if (err) {
+            fatal("cannot create %s matrices: %s", ops->desc,
+                  strerror(err));
+          }
+          if (setTypedRows(ops, m1, n1, n2, a) &&
+              setTypedRows(ops, m2, n2, n3, b)) {
+            ops->mul(m1, m2, product, &err);
+            if (err) {
+              error("%s kernel: %s %s x %s: %s", getGemmKernelName(k),
+                    ops->desc, ops->getKlass(m1, &err),
+                    ops->getKlass(m2, &err), strerror(err));
+            }
+            else if (!checkTypedRows(ops, product, n1, n3, gold,
+                                     "product")) {
+              error("%s kernel: %s x %s", getGemmKernelName(k),
+                    ops->getKlass(m1, &err), ops->getKlass(m2, &err));
+            }
+            if (f2 == 0) doTypedUnaryTests(ops, f1, m1, n1, n2, a);
+          }
+          ops->free(m1, &err);
+          ops->free(m2, &err);
+          ops->free(product, &err);
+        }
+      }
+    }
+    free(a);
+    free(b);
+    free(gold);
+    free(dots);
+  }
+  setGemmKernel(savedKernel);
+}
+
+/** Define typedTestOpsS, the TypedTestOps for element type T with
+ *  suffix S from typed_matrix.h, whose classes are a dense matrix,
+ *  a smart and a blocked multiplication matrix, and views of dense
+ *  matrices.  Entries are random integers in [0, MAX).
+ */
+#define DEFINE_TYPED_TEST_OPS(S, T, MAX)                                \
+static void                                                             \
+typedFill##S(void *elements, int n)                                     \
+{                                                                       \
+  T *e = elements;                                                      \
+  for (int i = 0; i < n; i++) e[i] = rand() % (MAX);                    \
+}                                                                       \
+static void                                                             \
+typedGoldMul##S(int m, int n, int p, const void *a, const void *b,      \
+                void *c)                                                \
+{                                                                       \
+  const T *ta = a, *tb = b;                                             \
+  T *tc = c;                                                            \
+  for (int i = 0; i < m; i++) {                                         \
+    for (int j = 0; j < p; j++) {                                       \
+      T sum = 0;                                                        \
+      for (int k = 0; k < n; k++) sum += ta[i*n + k]*tb[k*p + j];       \
+      tc[i*p + j] = sum;                                                \
+    }                                                                   \
+  }                                                                     \
+}                                                                       \
+static void                                                             \
+typedDot##S(int n, const void *a, const void *b, void *result)          \
+{                                                                       \
+  *(T *)result = dotProduct##S(n, a, b);                                \
+}                                                                       \
+static void *                                                           \
+typedNewMatrix##S(int klass, int nRows, int nCols, int *err)            \
+{                                                                       \
+  switch (klass) {                                                      \
+  case 0: return newDenseMatrix##S(nRows, nCols, err);                  \
+  case 1: return newSmartMulMatrix##S(nRows, nCols, err);               \
+  case 2: return newBlockedMulMatrix##S(nRows, nCols, err);             \
+  case 3: {                                                             \
+    Matrix##S *base =                                                   \
+      (Matrix##S *)newDenseMatrix##S(nCols, nRows, err);                \
+    return (base) ? newTransposeView##S(base, true, err) : NULL;        \
+  }                                                                     \
+  default: {                                                            \
+    Matrix##S *parent =                                                 \
+      (Matrix##S *)newDenseMatrix##S(nRows + 1, nCols + 2, err);        \
+    return (parent)                                                     \
+      ? newSubMatrixView##S(parent, 1, 2, nRows, nCols, true, err)      \
+      : NULL;                                                           \
+  }                                                                     \
+  }                                                                     \
+}                                                                       \
+static const char *                                                     \
+typedGetKlass##S(const void *matrix, int *err)                          \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  return m->fns->getKlass(m, err);                                      \
+}                                                                       \
+static void                                                             \
+typedFree##S(void *matrix, int *err)                                    \
+{                                                                       \
+  Matrix##S *m = matrix;                                                \
+  m->fns->free(m, err);                                                 \
+}                                                                       \
+static void                                                             \
+typedGetRow##S(const void *matrix, int rowIndex, void *row, int *err)   \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  m->fns->getRow(m, rowIndex, row, err);                                \
+}                                                                       \
+static void                                                             \
+typedSetRow##S(void *matrix, int rowIndex, const void *row, int *err)   \
+{                                                                       \
+  Matrix##S *m = matrix;                                                \
+  m->fns->setRow(m, rowIndex, row, err);                                \
+}                                                                       \
+static void                                                             \
+typedTranspose##S(const void *matrix, void *result, int *err)           \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  m->fns->transpose(m, result, err);                                    \
+}                                                                       \
+static void                                                             \
+typedMul##S(const void *matrix, const void *multiplier, void *product,  \
+            int *err)                                                   \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  m->fns->mul(m, multiplier, product, err);                             \
+}                                                                       \
+static void                                                             \
+typedMulVec##S(const void *matrix, const void *vec, void *result,       \
+               int *err)                                                \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  m->fns->mulVec(m, vec, result, err);                                  \
+}                                                                       \
+static void                                                             \
+typedVecMul##S(const void *matrix, const void *vec, void *result,       \
+               int *err)                                                \
+{                                                                       \
+  const Matrix##S *m = matrix;                                          \
+  m->fns->vecMul(m, vec, result, err);                                  \
+}                                                                       \
+static const TypedTestOps typedTestOps##S = {                           \
+  .desc = #T, .elemSize = sizeof(T), .nKlasses = 5,                     \
+  .fill = typedFill##S, .goldMul = typedGoldMul##S, .dot = typedDot##S, \
+  .newMatrix = typedNewMatrix##S, .getKlass = typedGetKlass##S,         \
+  .free = typedFree##S, .getRow = typedGetRow##S,                       \
+  .setRow = typedSetRow##S, .transpose = typedTranspose##S,             \
+  .mul = typedMul##S, .mulVec = typedMulVec##S,                         \
+  .vecMul = typedVecMul##S,                                             \
+};
+
+DEFINE_TYPED_TEST_OPS(, MatrixBaseType, 100)
+//large enough that products overflow 32 bits
+DEFINE_TYPED_TEST_OPS(I64, int64_t, 1000000)
+//small enough that all sums are exact in a float
+DEFINE_TYPED_TEST_OPS(F32, float, 16)
+DEFINE_TYPED_TEST_OPS(F64, double, 1000)
+
+/** Test multiplications involving transpose views against
+ *  goldMatrixMultiply() for dimensions which exercise the cache
+ *  blocking: each multiplicand class times a view of a dense matrix,
+ *  and a view of a dense matrix times a dense matrix.
+ */
+static void
+doTransposeViewTests(void)
+{
+  const NewFn newFnsView[] = {
+    (NewFn)newDenseMatrix, (NewFn)newSmartMulMatrix,
+    (NewFn)newBlockedMulMatrix, newDenseTransposeView,
+  };
+  int nDims = sizeof(kernelTestDims)/sizeof(kernelTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = kernelTestDims[d].n1, n2 = kernelTestDims[d].n2,
+        n3 = kernelTestDims[d].n3;
+    RandSpec spec1 = { .desc = "viewA", .nRows = n1, .nCols = n2,
+                       .max = 100 };
+    RandSpec spec2 = { .desc = "viewB", .nRows = n2, .nCols = n3,
+                       .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    for (int i = 0; i < sizeof(newFnsView)/sizeof(newFnsView[0]); i++) {
+      int err = 0;
+      Matrix *m1 = createMatrix(&a, newFnsView[i], &err);
+      Matrix *m2 = createMatrix(&b, newDenseTransposeView, &err);
+      Matrix *m3 = createMatrix(&b, (NewFn)newDenseMatrix, &err);
+      Matrix *product2 = (Matrix *)newDenseMatrix(n1, n3, &err);
+      Matrix *product3 = (Matrix *)newDenseMatrix(n1, n3, &err);
+      if (err) fatal("cannot create view test matrices: %s", strerror(err));
+      //poison the products so that entries not computed are detected
+      fillDenseMatrix((DenseMatrix *)product2, -1);
+      fillDenseMatrix((DenseMatrix *)product3, -1);
+      const char *klass = m1->fns->getKlass(m1, &err);
+      m1->fns->mul(m1, m2, product2, &err);
+      if (err) {
+        error("%s x transposeView: %s", klass, strerror(err));
+      }
+      else {
+        doMulTestMatrix(m1, a.desc, m2, b.desc, product2);
+      }
+      m1->fns->mul(m1, m3, product3, &err);
+      if (err) {
+        error("%s x denseMatrix: %s", klass, strerror(err));
+      }
+      else {
+        doMulTestMatrix(m1, a.desc, m3, b.desc, product3);
+      }
+      m1->fns->free(m1, &err);
+      m2->fns->free(m2, &err);
+      m3->fns->free(m3, &err);
+      product2->fns->free(product2, &err);
+      product3->fns->free(product3, &err);
+    }
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+  }
+}
+
+/** Test multiplying blocks of larger matrices in place: for each
+ *  multiplicand class, multiply by a view of a block of one matrix
+ *  into a view of a block of another and check both the product and
+ *  that the entries around the product block are unchanged.
+ */
+static void
+doSubMatrixViewTests(void)
+{
+  enum { TEST_CROSSOVER = 4, BORDER = 3, SENTINEL = -7 };
+  int savedCrossover = getStrassenCrossover();
+  int err = 0;
+  setStrassenCrossover(TEST_CROSSOVER, &err);
+  int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  int nDims = sizeof(kernelTestDims)/sizeof(kernelTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = kernelTestDims[d].n1, n2 = kernelTestDims[d].n2,
+        n3 = kernelTestDims[d].n3;
+    RandSpec spec1 = { .desc = "blockA", .nRows = n1, .nCols = n2,
+                       .max = 100 };
+    RandSpec spec2 = { .desc = "blockB", .nRows = n2, .nCols = n3,
+                       .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    Matrix *m2 = createMatrix(&b, newPaddedSubMatrixView, &err);
+    Matrix *parent = (Matrix *)newDenseMatrix(n1 + 2*BORDER, n3 + 2*BORDER,
+                                              &err);
+    Matrix *product = (Matrix *)newSubMatrixView(parent, BORDER, BORDER,
+                                                 n1, n3, false, &err);
+    if (err) fatal("cannot create sub-matrix test matrices: %s",
+                   strerror(err));
+    for (int i = 0; i < nNewFns; i++) {
+      Matrix *m1 = createMatrix(&a, newFns[i].new, &err);
+      if (err) fatal("cannot create %s: %s", newFns[i].desc, strerror(err));
+      fillDenseMatrix((DenseMatrix *)parent, SENTINEL);
+      m1->fns->mul(m1, m2, product, &err);
+      if (err) {
+        error("%s x subMatrixView: %s", newFns[i].desc, strerror(err));
+        err = 0;
+      }
+      else if (doMulTestMatrix(m1, a.desc, m2, b.desc, product)) {
+        for (int r = 0; r < n1 + 2*BORDER; r++) {
+          for (int c = 0; c < n3 + 2*BORDER; c++) {
+            _Bool isInside = r >= BORDER && r < n1 + BORDER &&
+                             c >= BORDER && c < n3 + BORDER;
+            if (!isInside &&
+                getDenseMatrixElement((DenseMatrix *)parent, r, c)
+                != SENTINEL) {
+              error("%s x subMatrixView: wrote outside product at [%d][%d]",
+                    newFns[i].desc, r - BORDER, c - BORDER);
+              r = n1 + 2*BORDER;
+              break;
+            }
+          }
+        }
+      }
+      m1->fns->free(m1, &err);
+    }
+    m2->fns->free(m2, &err);
+    product->fns->free(product, &err);
+    parent->fns->free(parent, &err);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+  }
+  setStrassenCrossover(savedCrossover, &err);
+}
+
+/** Test the kernel for each small shape against goldMatrixMultiply(),
+ *  both directly on storage with row strides larger than the
+ *  dimensions and via dense matrix multiplication, which selects the
+ *  kernels.  Shapes just outside the range of the kernels check that
+ *  the dense matrix falls back to the generic algorithm.
+ */
+static void
+doSmallMulTests(void)
+{
+  enum { PAD = 3 };
+  const int lo = SMALL_MUL_MIN - 1, hi = SMALL_MUL_MAX + 1;
+  for (int m = lo; m <= hi; m++) {
+    for (int n = lo; n <= hi; n++) {
+      for (int p = lo; p <= hi; p++) {
+        RandSpec spec1 = { .desc = "smallA", .nRows = m, .nCols = n + PAD,
+                           .max = 100 };
+        RandSpec spec2 = { .desc = "smallB", .nRows = n, .nCols = p + PAD,
+                           .max = 100 };
+        TestData a = createRandomTestData(&spec1);
+        TestData b = createRandomTestData(&spec2);
+        int gold[m][p], c[m][p + PAD];
+        for (int i = 0; i < m; i++) {
+          for (int j = 0; j < p; j++) {
+            gold[i][j] = 0;
+            for (int k = 0; k < n; k++) {
+              gold[i][j] += a.data[i*(n + PAD) + k]*b.data[k*(p + PAD) + j];
+            }
+          }
+        }
+        SmallMulFn kernel = getSmallMulKernel(m, n, p);
+        const _Bool isSmall = m > lo && m < hi && n > lo && n < hi &&
+                              p > lo && p < hi;
+        if (!kernel != !isSmall) {
+          error("%dx%dx%d: expected %s kernel", m, n, p,
+                isSmall ? "a" : "no");
+        }
+        else if (kernel) {
+          kernel(m, n, a.data, n + PAD, b.data, p + PAD, &c[0][0], p + PAD);
+          for (int i = 0; i < m; i++) {
+            if (memcmp(gold[i], c[i], p*sizeof(MatrixBaseType)) != 0) {
+              error("%dx%dx%d kernel: product differs from gold in row %d",
+                    m, n, p, i);
+              break;
+            }
+          }
+        }
+        a.nCols = n;
+        b.nCols = p;
+        for (int i = 0; i < m; i++) {
+          memmove(&a.data[i*n], &a.data[i*(n + PAD)], n*sizeof(int));
+        }
+        for (int k = 0; k < n; k++) {
+          memmove(&b.data[k*p], &b.data[k*(p + PAD)], p*sizeof(int));
+        }
+        int err = 0;
+        Matrix *m1 = createMatrix(&a, (NewFn)newDenseMatrix, &err);
+        Matrix *m2 = createMatrix(&b, (NewFn)newDenseMatrix, &err);
+        Matrix *product = (Matrix *)newDenseMatrix(m, p, &err);
+        if (err) fatal("cannot create small matrices: %s", strerror(err));
+        m1->fns->mul(m1, m2, product, &err);
+        if (err) {
+          error("%dx%dx%d dense product: %s", m, n, p, strerror(err));
+        }
+        else {
+          doMulTestMatrix(m1, a.desc, m2, b.desc, product);
+        }
+        m1->fns->free(m1, &err);
+        m2->fns->free(m2, &err);
+        product->fns->free(product, &err);
+        freeRandomTestData(&a);
+        freeRandomTestData(&b);
+      }
+    }
+  }
+}
+
+/** Shapes m x n x p and batch sizes used for testing batched
+ *  multiplication: the batch sizes are not multiples of the chunk
+ *  size, and include an empty batch.
+ */
+static const struct { int m, n, p, count; } batchTestSpecs[] = {
+  { 3, 3, 3, 1000 }, { 5, 5, 5, 300 }, { 2, 7, 3, 129 }, { 1, 1, 1, 5 },
+  { 8, 8, 8, 0 },
+};
+
+/** Test batched multiplication in both layouts against
+ *  goldMatrixMultiply() for each matrix of the batch.
+ */
+static void
+doBatchMulTests(void)
+{
+  int nSpecs = sizeof(batchTestSpecs)/sizeof(batchTestSpecs[0]);
+  for (int s = 0; s < nSpecs; s++) {
+    const int m = batchTestSpecs[s].m, n = batchTestSpecs[s].n,
+      p = batchTestSpecs[s].p, count = batchTestSpecs[s].count;
+    RandSpec spec1 = { .desc = "batchA", .nRows = count*m, .nCols = n,
+                       .max = 100 };
+    RandSpec spec2 = { .desc = "batchB", .nRows = count*n, .nCols = p,
+                       .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    const size_t cSize = (size_t)count*m*p*sizeof(MatrixBaseType);
+    int *gold = mallocChk(cSize + 1);
+    int *c = mallocChk(cSize + 1);
+    int *soaA = mallocChk((size_t)count*m*n*sizeof(MatrixBaseType) + 1);
+    int *soaB = mallocChk((size_t)count*n*p*sizeof(MatrixBaseType) + 1);
+    int *soaC = mallocChk(cSize + 1);
+    for (int t = 0; t < count; t++) {
+      goldMatrixMultiply(m, n, p, (int (*)[n])&a.data[t*m*n],
+                         (int (*)[p])&b.data[t*n*p],
+                         (int (*)[p])&gold[t*m*p]);
+    }
+    int err = 0;
+    batchMul(BATCH_LAYOUT_AOS, count, m, n, p, a.data, b.data, c, &err);
+    if (err || memcmp(gold, c, cSize) != 0) {
+      error("%d x %dx%dx%d AOS batch product differs from gold",
+            count, m, n, p);
+    }
+    convertBatchLayout(count, m, n, BATCH_LAYOUT_AOS, a.data,
+                       BATCH_LAYOUT_SOA, soaA);
+    convertBatchLayout(count, n, p, BATCH_LAYOUT_AOS, b.data,
+                       BATCH_LAYOUT_SOA, soaB);
+    GemmKernelId savedKernel = getGemmKernel();
+    for (GemmKernelId k = GEMM_KERNEL_SCALAR; k < N_GEMM_KERNELS; k++) {
+      if (!setGemmKernel(k)) continue;
+      memset(soaC, 0, cSize);
+      batchMul(BATCH_LAYOUT_SOA, count, m, n, p, soaA, soaB, soaC, &err);
+      convertBatchLayout(count, m, p, BATCH_LAYOUT_SOA, soaC,
+                         BATCH_LAYOUT_AOS, c);
+      if (err || memcmp(gold, c, cSize) != 0) {
+        error("%s kernel: %d x %dx%dx%d SOA batch product differs from gold",
+              getGemmKernelName(k), count, m, n, p);
+      }
+    }
+    setGemmKernel(savedKernel);
+    free(gold);
+    free(c);
+    free(soaA);
+    free(soaB);
+    free(soaC);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+  }
+  int err = 0;
+  batchMul(BATCH_LAYOUT_AOS, 1, 0, 1, 1, NULL, NULL, NULL, &err);
+  if (err != EINVAL) {
+    error("batch of 0x1 matrices: expected EINVAL, got %s", strerror(err));
+  }
+}
+
+/** Dimensions n1 x n2 x n3 used for testing Strassen multiplication
+ *  with a small crossover; chosen to exercise several levels of
+ *  recursion, padding and rectangular operands.
+ */
+static const struct { int n1, n2, n3; } strassenTestDims[] = {
+  { 8, 8, 8 }, { 9, 9, 9 }, { 17, 10, 33 }, { 67, 130, 45 },
+};
+
+/** Test Strassen multiplication against goldMatrixMultiply() using a
+ *  small crossover, so that the recursion is exercised even though
+ *  the test matrices are small.
+ */
+static void
+doStrassenTests(void)
+{
+  enum { TEST_CROSSOVER = 4 };
+  int savedCrossover = getStrassenCrossover();
+  int err = 0;
+  setStrassenCrossover(TEST_CROSSOVER, &err);
+  int nDims = sizeof(strassenTestDims)/sizeof(strassenTestDims[0]);
+  for (int d = 0; d < nDims; d++) {
+    int n1 = strassenTestDims[d].n1, n2 = strassenTestDims[d].n2,
+        n3 = strassenTestDims[d].n3;
+    RandSpec spec1 = { .desc = "strassenA", .nRows = n1, .nCols = n2,
+                       .max = 100 };
+    RandSpec spec2 = { .desc = "strassenB", .nRows = n2, .nCols = n3,
+                       .max = 100 };
+    TestData a = createRandomTestData(&spec1);
+    TestData b = createRandomTestData(&spec2);
+    Matrix *m1 = createMatrix(&a, (NewFn)newStrassenMatrix, &err);
+    Matrix *m2 = createMatrix(&b, (NewFn)newStrassenMatrix, &err);
+    Matrix *product = (Matrix *)newDenseMatrix(n1, n3, &err);
+    if (!err) m1->fns->mul(m1, m2, product, &err);
+    if (err) {
+      error("strassen %dx%dx%d: %s", n1, n2, n3, strerror(err));
+    }
+    else {
+      doMulTestMatrix(m1, a.desc, m2, b.desc, product);
+    }
+    if (m1) m1->fns->free(m1, &err);
+    if (m2) m2->fns->free(m2, &err);
+    if (product) product->fns->free(product, &err);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+  }
+  setStrassenCrossover(savedCrossover, &err);
+}
+
+/** Return random test data for spec where only about 1 in sparsity
+ *  entries are non-zero.
+ */
+static const TestData
+createSparseRandomTestData(const RandSpec *spec, int sparsity)
+{
+  TestData data = createRandomTestData(spec);
+  for (int i = 0; i < spec->nRows * spec->nCols; i++) {
+    if (rand() % sparsity != 0) data.data[i] = 0;
+  }
+  return data;
+}
+
+/** Check that setRow() in build form overrides the entries set earlier
+ *  for its row, and is overridden by entries set later.
+ */
+static void
+doSparseSetRowTests(void)
+{
+  enum { N = 4 };
+  int err = 0;
+  Matrix *matrix = (Matrix *)newSparseCsrMatrix(N, N, &err);
+  if (err) fatal("cannot create sparse matrix: %s", strerror(err));
+  const MatrixBaseType row0[N] = { 3, 0, 0, 0 };
+  const MatrixBaseType zeros[N] = { 0 };
+  matrix->fns->setElement(matrix, 0, 1, 5, &err);
+  matrix->fns->setElement(matrix, 1, 2, 7, &err);
+  matrix->fns->setElement(matrix, 2, 3, 9, &err);
+  matrix->fns->setRow(matrix, 0, row0, &err);
+  matrix->fns->setElement(matrix, 0, 2, 4, &err);
+  matrix->fns->setRow(matrix, 1, zeros, &err);
+  matrix->fns->setRow(matrix, 1, zeros, &err);
+  const MatrixBaseType expected[N][N] = {
+    { 3, 0, 4, 0 }, { 0 }, { 0, 0, 0, 9 }, { 0 }
+  };
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < N; j++) {
+      MatrixBaseType v = matrix->fns->getElement(matrix, i, j, &err);
+      if (err || v != expected[i][j]) {
+        error("sparse setRow() [%d][%d]: expected %d, got %d", i, j,
+              expected[i][j], v);
+      }
+    }
+  }
+  int nnz = getSparseCsrMatrixNnz((SparseCsrMatrix *)matrix, &err);
+  if (nnz != 3) {
+    error("sparse setRow(): expected 3 non-zero entries, got %d", nnz);
+  }
+  matrix->fns->free(matrix, &err);
+}
+
+/** Test sparse x sparse and sparse x dense multiplication into a
+ *  sparse product, and sparse to sparse transpose; these are not
+ *  covered by the generic tests which always use dense results.
+ */
+static void
+doSparseTests(void)
+{
+  enum { SPARSITY = 10 };
+  RandSpec spec1 = { .desc = "sparseA", .nRows = 37, .nCols = 53, .max = 10 };
+  RandSpec spec2 = { .desc = "sparseB", .nRows = 53, .nCols = 29, .max = 10 };
+  TestData a = createSparseRandomTestData(&spec1, SPARSITY);
+  TestData b = createSparseRandomTestData(&spec2, SPARSITY);
+  int nNonZero = 0;
+  for (int i = 0; i < a.nRows * a.nCols; i++) nNonZero += (a.data[i] != 0);
+  const NewFn multiplierFns[] = {
+    (NewFn)newSparseCsrMatrix, (NewFn)newDenseMatrix
+  };
+  for (int i = 0; i < sizeof(multiplierFns)/sizeof(multiplierFns[0]); i++) {
+    int err = 0;
+    Matrix *m1 = createMatrix(&a, (NewFn)newSparseCsrMatrix, &err);
+    Matrix *m2 = createMatrix(&b, multiplierFns[i], &err);
+    Matrix *product = (Matrix *)newSparseCsrMatrix(a.nRows, b.nCols, &err);
+    Matrix *transpose = (Matrix *)newSparseCsrMatrix(a.nCols, a.nRows, &err);
+    if (err) fatal("cannot create sparse test matrices: %s", strerror(err));
+    int nnz = getSparseCsrMatrixNnz((SparseCsrMatrix *)m1, &err);
+    if (nnz != nNonZero) {
+      error("sparse matrix %s: expected %d non-zero entries, got %d",
+            a.desc, nNonZero, nnz);
+    }
+    m1->fns->mul(m1, m2, product, &err);
+    if (err) {
+      error("sparse product %s x %s: %s", a.desc, b.desc, strerror(err));
+    }
+    else {
+      doMulTestMatrix(m1, a.desc, m2, b.desc, product);
+    }
+    m1->fns->transpose(m1, transpose, &err);
+    if (err) {
+      error("sparse transpose %s: %s", a.desc, strerror(err));
+    }
+    else {
+      testTranspose(m1, a.desc, transpose, a.nRows, a.nCols);
+    }
+    m1->fns->free(m1, &err);
+    m2->fns->free(m2, &err);
+    product->fns->free(product, &err);
+    transpose->fns->free(transpose, &err);
+  }
+  doSparseSetRowTests();
+  freeRandomTestData(&a);
+  freeRandomTestData(&b);
+}
+
+/** Constructors for structured matrices with NewFn signatures */
+static Matrix *
+newUpperTriangularMatrix(int nRows, int nCols, int *err)
+{
+  if (nRows != nCols) *err = EINVAL;
+  return (*err) ? NULL : (Matrix *)newTriangularMatrix(nRows, true, err);
+}
+
+static Matrix *
+newLowerTriangularMatrix(int nRows, int nCols, int *err)
+{
+  if (nRows != nCols) *err = EINVAL;
+  return (*err) ? NULL : (Matrix *)newTriangularMatrix(nRows, false, err);
+}
+
+static Matrix *
+newSquareDiagonalMatrix(int nRows, int nCols, int *err)
+{
+  if (nRows != nCols) *err = EINVAL;
+  return (*err) ? NULL : (Matrix *)newDiagonalMatrix(nRows, err);
+}
+
+static Matrix *
+newTridiagonalMatrix(int nRows, int nCols, int *err)
+{
+  return (Matrix *)newBandMatrix(nRows, nCols, 1, 1, err);
+}
+
+static Matrix *
+newWideBandMatrix(int nRows, int nCols, int *err)
+{
+  return (Matrix *)newBandMatrix(nRows, nCols, 16, 16, err);
+}
+
+static Matrix *
+newSkewBandMatrix(int nRows, int nCols, int *err)
+{
+  return (Matrix *)newBandMatrix(nRows, nCols, 3, 40, err);
+}
+
+/** Structured classes: the triangles and wide bands are wide enough
+ *  to be multiplied by unpacking blocks, the others a row at a time.
+ */
+static const struct {
+  const char *desc;
+  NewFn new;
+  MatrixKlassId id;
+  int nRows, nCols;
+} structuredTests[] = {
+  { "upper(100)", newUpperTriangularMatrix, MATRIX_KLASS_TRIANGULAR,
+    100, 100 },
+  { "lower(100)", newLowerTriangularMatrix, MATRIX_KLASS_TRIANGULAR,
+    100, 100 },
+  { "diagonal(100)", newSquareDiagonalMatrix, MATRIX_KLASS_DIAGONAL,
+    100, 100 },
+  { "band(100x100,1,1)", newTridiagonalMatrix, MATRIX_KLASS_BAND,
+    100, 100 },
+  { "band(100x100,16,16)", newWideBandMatrix, MATRIX_KLASS_BAND,
+    100, 100 },
+  { "band(90x150,3,40)", newSkewBandMatrix, MATRIX_KLASS_BAND,
+    90, 150 },
+};
+
+/** Set the entries of matrix from data, zeroing the entries of data
+ *  which setElement() rejects as outside the structure, and return
+ *  the # of entries outside the structure.
+ */
+static int
+setStructuredEntries(Matrix *matrix, const TestData *data, const char *desc)
+{
+  int nOutside = 0;
+  for (int i = 0; i < data->nRows; i++) {
+    for (int j = 0; j < data->nCols; j++) {
+      int err = 0;
+      MatrixBaseType *entry = &data->data[i*data->nCols + j];
+      matrix->fns->setElement(matrix, i, j, *entry | 1, &err);
+      if (err == EDOM) {
+        err = 0;
+        nOutside++;
+        *entry = 0;
+        matrix->fns->setElement(matrix, i, j, 0, &err);
+      }
+      else if (!err) {
+        matrix->fns->setElement(matrix, i, j, *entry, &err);
+      }
+      if (err) {
+        error("%s: cannot set [%d][%d]: %s", desc, i, j, strerror(err));
+      }
+    }
+  }
+  return nOutside;
+}
+
+/** Check that setRow() rejects a row with a non-zero entry outside the
+ *  structure of matrix, given that data has the entries of matrix.
+ */
+static void
+testStructuredSetRow(Matrix *matrix, const TestData *data, const char *desc)
+{
+  int nRows = data->nRows, nCols = data->nCols;
+  MatrixBaseType row[nCols];
+  for (int i = 0; i < nRows; i++) {
+    int err = 0;
+    memcpy(row, &data->data[i*nCols], sizeof(row));
+    for (int j = 0; j < nCols; j++) {
+      if (matrix->fns->getElement(matrix, i, j, &err) != 0) continue;
+      matrix->fns->setElement(matrix, i, j, 1, &err);
+      if (err != EDOM) {
+        matrix->fns->setElement(matrix, i, j, 0, &err);
+        continue;
+      }
+      err = 0;
+      row[j] = 1;
+      matrix->fns->setRow(matrix, i, row, &err);
+      if (err != EDOM) {
+        error("%s: setRow() with [%d][%d] outside structure: %s", desc, i, j,
+              (err) ? strerror(err) : "no error");
+      }
+      return;
+    }
+  }
+}
+
+/** Test the structured matrix classes against equivalent dense
+ *  matrices: entries outside the structure, multiplication by and of
+ *  dense matrices and of each other, matrix-vector products and
+ *  transposes.
+ */
+static void
+doStructuredTests(void)
+{
+  enum { P = 37 };
+  for (int t = 0; t < sizeof(structuredTests)/sizeof(structuredTests[0]);
+       t++) {
+    const char *desc = structuredTests[t].desc;
+    const int nRows = structuredTests[t].nRows;
+    const int nCols = structuredTests[t].nCols;
+    RandSpec specA = { .desc = desc, .nRows = nRows, .nCols = nCols,
+                       .max = 100 };
+    RandSpec specB = { .desc = "denseB", .nRows = nCols, .nCols = P,
+                       .max = 100 };
+    RandSpec specC = { .desc = "denseC", .nRows = P, .nCols = nRows,
+                       .max = 100 };
+    TestData a = createRandomTestData(&specA);
+    TestData b = createRandomTestData(&specB);
+    TestData c = createRandomTestData(&specC);
+    int err = 0;
+    Matrix *m1 = structuredTests[t].new(nRows, nCols, &err);
+    if (err) fatal("cannot create %s: %s", desc, strerror(err));
+    const MatrixKlassId id = m1->fns->getKlassId(m1, &err);
+    if (id != structuredTests[t].id) {
+      error("%s: class id %d; expected %d", desc, id, structuredTests[t].id);
+    }
+    int stride;
+    if (m1->fns->getData(m1, &stride, &err)) {
+      error("%s: unexpected row-major storage", desc);
+    }
+    int nOutside = setStructuredEntries(m1, &a, desc);
+    size_t nEntries = getStructuredMatrixNEntries((StructuredMatrix *)m1);
+    if (nEntries != (size_t)nRows*nCols - nOutside) {
+      error("%s: %zu entries; expected %d", desc, nEntries,
+            nRows*nCols - nOutside);
+    }
+
+    //a copy made using setRow() must match
+    Matrix *m2 = createMatrix(&a, structuredTests[t].new, &err);
+    Matrix *denseB = createMatrix(&b, (NewFn)newDenseMatrix, &err);
+    Matrix *denseC = createMatrix(&c, (NewFn)newDenseMatrix, &err);
+    Matrix *product1 = (Matrix *)newDenseMatrix(nRows, P, &err);
+    Matrix *product2 = (Matrix *)newDenseMatrix(P, nCols, &err);
+    Matrix *transpose = (Matrix *)newDenseMatrix(nCols, nRows, &err);
+    if (err) fatal("cannot create %s test matrices: %s", desc, strerror(err));
+    int diffRowN, diffColN;
+    if (!compareMatrixToPlainMatrix(m2, desc, nRows, nCols,
+                                    (int (*)[nCols])a.data,
+                                    &diffRowN, &diffColN)) {
+      error("%s: copy differs at [%d][%d]", desc, diffRowN, diffColN);
+    }
+    testStructuredSetRow(m2, &a, desc);
+
+    m1->fns->mul(m1, denseB, product1, &err);
+    if (err) error("%s x %s: %s", desc, b.desc, strerror(err));
+    else doMulTestMatrix(m1, desc, denseB, b.desc, product1);
+    if (getMulKernel(denseC, m1, product2, &err) != mulByStructuredMatrix) {
+      error("%s x %s: structured mul kernel not registered", c.desc, desc);
+    }
+    denseC->fns->mul(denseC, m1, product2, &err);
+    if (err) error("%s x %s: %s", c.desc, desc, strerror(err));
+    else doMulTestMatrix(denseC, c.desc, m1, desc, product2);
+    if (nRows == nCols) {
+      m1->fns->mul(m1, m2, transpose, &err);
+      if (err) error("%s x %s: %s", desc, desc, strerror(err));
+      else doMulTestMatrix(m1, desc, m2, desc, transpose);
+    }
+    doMulVecTestMatrix(m1, desc);
+    m1->fns->transpose(m1, transpose, &err);
+    if (err) error("%s: transpose: %s", desc, strerror(err));
+    else testTranspose(m1, desc, transpose, nRows, nCols);
+
+    m1->fns->free(m1, &err);
+    m2->fns->free(m2, &err);
+    denseB->fns->free(denseB, &err);
+    denseC->fns->free(denseC, &err);
+    product1->fns->free(product1, &err);
+    product2->fns->free(product2, &err);
+    transpose->fns->free(transpose, &err);
+    freeRandomTestData(&a);
+    freeRandomTestData(&b);
+    freeRandomTestData(&c);
+  }
+}
+
+static Matrix *
+newSquareSymmetricMatrix(int nRows, int nCols, int *err)
+{
+  if (nRows != nCols) *err = EINVAL;
+  return (*err) ? NULL : (Matrix *)newSymmetricMatrix(nRows, err);
+}
+
+/** Test symmetric matrices: entries mirrored about the diagonal,
+ *  multiplication by and of dense matrices, matrix-vector products
+ *  and syrkMatrix() of dense and sparse operands with every supported
+ *  micro-kernel variant.
+ */
+static void
+doSymmetricTests(void)
+{
+  enum { N = 83, K = 150 };
+  int err = 0;
+  Matrix *m1 = (Matrix *)newSymmetricMatrix(N, &err);
+  if (err) fatal("cannot create symmetric matrix: %s", strerror(err));
+  if (m1->fns->getKlassId(m1, &err) != MATRIX_KLASS_SYMMETRIC) {
+    error("symmetric matrix: unexpected class id");
+  }
+  RandSpec spec = { .desc = "symmetric", .nRows = N, .nCols = N, .max = 100 };
+  TestData s = createRandomTestData(&spec);
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < i; j++) s.data[i*N + j] = s.data[j*N + i];
+  }
+  for (int i = N - 1; i >= 0; i--) {
+    for (int j = 0; j <= i; j++) {
+      m1->fns->setElement(m1, i, j, s.data[i*N + j], &err);
+    }
+  }
+  Matrix *m2 = createMatrix(&s, newSquareSymmetricMatrix, &err);
+  if (err) fatal("cannot set symmetric test matrices: %s", strerror(err));
+  int diffRowN, diffColN;
+  Matrix *copies[] = { m1, m2 };
+  for (int i = 0; i < 2; i++) {
+    if (!compareMatrixToPlainMatrix(copies[i], s.desc, N, N,
+                                    (int (*)[N])s.data,
+                                    &diffRowN, &diffColN)) {
+      error("symmetric copy %d differs at [%d][%d]", i, diffRowN, diffColN);
+    }
+  }
+
+  RandSpec specB = { .desc = "denseB", .nRows = N, .nCols = K, .max = 100 };
+  RandSpec specC = { .desc = "denseC", .nRows = K, .nCols = N, .max = 100 };
+  TestData b = createRandomTestData(&specB);
+  TestData c = createRandomTestData(&specC);
+  Matrix *denseB = createMatrix(&b, (NewFn)newDenseMatrix, &err);
+  Matrix *denseC = createMatrix(&c, (NewFn)newDenseMatrix, &err);
+  Matrix *sparseC = createMatrix(&c, (NewFn)newSparseCsrMatrix, &err);
+  Matrix *product1 = (Matrix *)newDenseMatrix(N, K, &err);
+  Matrix *product2 = (Matrix *)newDenseMatrix(K, N, &err);
+  Matrix *transpose = (Matrix *)newDenseMatrix(N, N, &err);
+  Matrix *gramB = (Matrix *)newSymmetricMatrix(N, &err);
+  Matrix *viewB = (Matrix *)newTransposeView(denseB, false, &err);
+  Matrix *viewC = (Matrix *)newTransposeView(denseC, false, &err);
+  if (err) fatal("cannot create symmetric test matrices: %s", strerror(err));
+
+  m1->fns->mul(m1, denseB, product1, &err);
+  if (err) error("symmetric x %s: %s", b.desc, strerror(err));
+  else doMulTestMatrix(m1, s.desc, denseB, b.desc, product1);
+  denseC->fns->mul(denseC, m1, product2, &err);
+  if (err) error("%s x symmetric: %s", c.desc, strerror(err));
+  else doMulTestMatrix(denseC, c.desc, m1, s.desc, product2);
+  doMulVecTestMatrix(m1, s.desc);
+  m1->fns->transpose(m1, transpose, &err);
+  if (err) error("symmetric transpose: %s", strerror(err));
+  else testTranspose(m1, s.desc, transpose, N, N);
+
+  GemmKernelId savedKernel = getGemmKernel();
+  for (GemmKernelId k = GEMM_KERNEL_SCALAR; k < N_GEMM_KERNELS; k++) {
+    if (!setGemmKernel(k)) continue;
+    syrkMatrix(denseB, false, (SymmetricMatrix *)gramB, &err);
+    if (err) error("syrk %s: %s", b.desc, strerror(err));
+    else doMulTestMatrix(denseB, b.desc, viewB, "transpose", gramB);
+    const Matrix *cs[] = { denseC, sparseC };
+    for (int i = 0; i < 2; i++) {
+      syrkMatrix(cs[i], true, (SymmetricMatrix *)m2, &err);
+      if (err) error("syrk transpose %s: %s", c.desc, strerror(err));
+      else doMulTestMatrix(viewC, "transpose", denseC, c.desc, m2);
+    }
+  }
+  setGemmKernel(savedKernel);
+  syrkMatrix(denseB, true, (SymmetricMatrix *)gramB, &err);
+  if (err != EDOM) {
+    error("syrk with mismatched product: %s",
+          (err) ? strerror(err) : "no error");
+  }
+  err = 0;
+
+  Matrix *matrices[] = {
+    m1, m2, denseB, denseC, sparseC, product1, product2, transpose, gramB,
+    viewB, viewC,
+  };
+  for (int i = 0; i < sizeof(matrices)/sizeof(matrices[0]); i++) {
+    matrices[i]->fns->free(matrices[i], &err);
+  }
+  freeRandomTestData(&s);
+  freeRandomTestData(&b);
+  freeRandomTestData(&c);
+}
+
+/** Test that smart and Strassen multiplications using an attached
+ *  workspace are correct and that repeating them does not allocate.
+ */
+static void
+doWorkspaceTests(void)
+{
+  enum { TEST_CROSSOVER = 4 };
+  int savedCrossover = getStrassenCrossover();
+  int err = 0;
+  setStrassenCrossover(TEST_CROSSOVER, &err);
+  RandSpec spec1 = { .desc = "wsA", .nRows = 19, .nCols = 23, .max = 100 };
+  RandSpec spec2 = { .desc = "wsB", .nRows = 23, .nCols = 17, .max = 100 };
+  TestData a = createRandomTestData(&spec1);
+  TestData b = createRandomTestData(&spec2);
+  //multiplicand and multiplier classes: the sparse multiplier has no
+  //storage to transpose directly; Strassen needs dense storage
+  const struct { NewFn new1, new2; } newFnsWs[] = {
+    { (NewFn)newSmartMulMatrix, (NewFn)newSparseCsrMatrix },
+    { (NewFn)newStrassenMatrix, (NewFn)newDenseMatrix },
+  };
+  Workspace *workspace = newWorkspace(&err);
+  if (err) fatal("cannot create workspace: %s", strerror(err));
+  for (int i = 0; i < sizeof(newFnsWs)/sizeof(newFnsWs[0]); i++) {
+    Matrix *m1 = createMatrix(&a, newFnsWs[i].new1, &err);
+    Matrix *m2 = createMatrix(&b, newFnsWs[i].new2, &err);
+    Matrix *product = (Matrix *)newDenseMatrix(a.nRows, b.nCols, &err);
+    if (err) fatal("cannot create workspace test matrices: %s", strerror(err));
+    setDenseMatrixWorkspace((DenseMatrix *)m1, workspace);
+    m1->fns->mul(m1, m2, product, &err);
+    long nAllocs = getWorkspaceAllocCount();
+    m1->fns->mul(m1, m2, product, &err);
+    if (err) {
+      error("workspace product %s x %s: %s", a.desc, b.desc, strerror(err));
+    }
+    else {
+      doMulTestMatrix(m1, a.desc, m2, b.desc, product);
+      if (getWorkspaceAllocCount() != nAllocs) {
+        error("repeated %s x %s allocated workspace memory", a.desc, b.desc);
+      }
+    }
+    m1->fns->free(m1, &err);
+    m2->fns->free(m2, &err);
+    product->fns->free(product, &err);
+  }
+  freeWorkspace(workspace);
+  freeRandomTestData(&a);
+  freeRandomTestData(&b);
+  setStrassenCrossover(savedCrossover, &err);
+}
+
+/** Memory budgets used for testing streaming multiplication: tiles
+ *  which do not divide the dimensions and a single tile.
+ */
+static const size_t streamTestBudgets[] = { 5*8*8*sizeof(MatrixBaseType),
+                                            1 << 20 };
+
+/** Create a new temporary file, setting path[] to its name */
+static void
+makeTempFile(char path[], size_t size)
+{
+  const char *dir = getenv("TMPDIR");
+  snprintf(path, size, "%s/prj1-XXXXXX", (dir) ? dir : "/tmp");
+  int fd = mkstemp(path);
+  if (fd < 0) fatal("cannot create temporary file %s:", path);
+  close(fd);
+}
+
+/** Test streaming multiplication of random matrices saved to
+ *  temporary files against goldMatrixMultiply().
+ */
+static void
+doStreamMulTests(void)
+{
+  RandSpec spec1 = { .desc = "streamA", .nRows = 37, .nCols = 53,
+                     .max = 100 };
+  RandSpec spec2 = { .desc = "streamB", .nRows = 53, .nCols = 29,
+                     .max = 100 };
+  TestData a = createRandomTestData(&spec1);
+  TestData b = createRandomTestData(&spec2);
+  char paths[3][256];
+  for (int i = 0; i < 3; i++) makeTempFile(paths[i], sizeof(paths[i]));
+  int err = 0;
+  Matrix *m1 = createMatrix(&a, (NewFn)newDenseMatrix, &err);
+  Matrix *m2 = createMatrix(&b, (NewFn)newDenseMatrix, &err);
+  if (!err) saveMatrixFile(m1, paths[0], &err);
+  if (!err) saveMatrixFile(m2, paths[1], &err);
+  if (err) fatal("cannot create streaming test files: %s", strerror(err));
+  int nBudgets = sizeof(streamTestBudgets)/sizeof(streamTestBudgets[0]);
+  for (int i = 0; i < nBudgets; i++) {
+    streamMulFiles(paths[0], paths[1], paths[2], streamTestBudgets[i], NULL,
+                   &err);
+    if (err) {
+      error("streaming %s x %s: %s", a.desc, b.desc, strerror(err));
+      err = 0;
+      continue;
+    }
+    Matrix *product = (Matrix *)newDenseMatrixFromFile(paths[2], false, &err);
+    if (err) {
+      error("cannot load streaming product: %s", strerror(err));
+      err = 0;
+      continue;
+    }
+    doMulTestMatrix(m1, a.desc, m2, b.desc, product);
+    product->fns->free(product, &err);
+  }
+  streamMulFiles(paths[1], paths[1], paths[2], 1 << 20, NULL, &err);
+  if (err != EDOM) {
+    error("streaming %s x %s: expected EDOM, got %s", b.desc, b.desc,
+          strerror(err));
+  }
+  m1->fns->free(m1, &err);
+  m2->fns->free(m2, &err);
+  for (int i = 0; i < 3; i++) unlink(paths[i]);
+  freeRandomTestData(&a);
+  freeRandomTestData(&b);
+}
+
+/** Test that matrix files whose headers describe sizes which overflow
+ *  or which lie beyond the end of the file are rejected.
+ */
+static void
+doBadMatrixFileTests(void)
+{
+  const MatrixFileHeader good = {
+    .magic = MATRIX_FILE_MAGIC,
+    .version = MATRIX_FILE_VERSION,
+    .byteOrder = MATRIX_FILE_BYTE_ORDER,
+    .elemType = MATRIX_FILE_INT32,
+    .elemSize = sizeof(MatrixBaseType),
+    .nRows = 3,
+    .nCols = 32,
+    .rowStride = 32,
+    .dataOffset = sizeof(MatrixFileHeader),
+  };
+  MatrixFileHeader bad[] = { good, good, good };
+  bad[0].dataOffset = UINT64_MAX - 255;  //wraps when added to data size
+  bad[1].nRows = bad[1].rowStride = INT32_MAX;  //data beyond end of file
+  bad[2].dataOffset = 1 << 20;                  //data beyond end of file
+  char path[256];
+  makeTempFile(path, sizeof(path));
+  for (int i = 0; i < sizeof(bad)/sizeof(bad[0]); i++) {
+    FILE *f = fopen(path, "wb");
+    if (!f) fatal("cannot open %s:", path);
+    fwrite(&bad[i], sizeof(bad[i]), 1, f);
+    for (int j = 0; j < good.nRows*good.nCols; j++) {
+      MatrixBaseType zero = 0;
+      fwrite(&zero, sizeof(zero), 1, f);
+    }
+    if (fclose(f) != 0) fatal("cannot write %s:", path);
+    int err = 0;
+    DenseMatrix *matrix = newDenseMatrixFromFile(path, false, &err);
+    if (err != EINVAL) {
+      error("bad matrix file header %d: expected EINVAL, got %s", i,
+            strerror(err));
+    }
+    if (matrix) ((Matrix *)matrix)->fns->free((Matrix *)matrix, &err);
+  }
+  unlink(path);
+}
+
+/*************************** Thread Pool Tests *************************/
+
+/** # of threads used by the thread pool tests, whatever the # of
+ *  processors, so that tasks really are stolen.
+ */
+enum { POOL_TEST_THREADS = 4 };
+
+/** Dimensions of the index space of the nested parallelFor() test */
+enum { OUTER_N = 37, OUTER_GRAIN = 3, INNER_N = 101, INNER_GRAIN = 7 };
+
+/** Counts of the # of times each index of a parallelFor() is
+ *  processed, and of the chunks larger than their grain.
+ */
+typedef struct {
+  atomic_int *counts;
+  atomic_int *nBadChunks;
+} IndexCounts;
+
+static void
+countInner(void *arg, int begin, int end)
+{
+  const IndexCounts *inner = arg;
+  if (end - begin > INNER_GRAIN) atomic_fetch_add(inner->nBadChunks, 1);
+  for (int j = begin; j < end; j++) atomic_fetch_add(&inner->counts[j], 1);
+}
+
+/** Count the indexes of an inner parallelFor() for each outer index;
+ *  the counts for outer index i start at counts[i*INNER_N].
+ */
+static void
+countOuter(void *arg, int begin, int end)
+{
+  const IndexCounts *outer = arg;
+  if (end - begin > OUTER_GRAIN) atomic_fetch_add(outer->nBadChunks, 1);
+  for (int i = begin; i < end; i++) {
+    IndexCounts inner = {
+      .counts = &outer->counts[i*INNER_N], .nBadChunks = outer->nBadChunks,
+    };
+    parallelFor(INNER_N, INNER_GRAIN, countInner, &inner);
+  }
+}
+
+/** A range to be summed by sumTask() using recursive fork/join */
+typedef struct {
+  long begin, end;
+  long sum;
+} SumRange;
+
+static void
+sumTask(void *arg)
+{
+  SumRange *range = arg;
+  if (range->end - range->begin <= 1000) {
+    range->sum = 0;
+    for (long i = range->begin; i < range->end; i++) range->sum += i;
+    return;
+  }
+  const long mid = range->begin + (range->end - range->begin)/2;
+  SumRange lower = { range->begin, mid }, upper = { mid, range->end };
+  TaskGroup group;
+  initTaskGroup(&group);
+  forkTask(&group, sumTask, &upper);
+  sumTask(&lower);
+  joinTasks(&group);
+  range->sum = lower.sum + upper.sum;
+}
+
+/** Operands for multiplying matrices within a parallelFor() */
+typedef struct {
+  const TestData *a, *b;
+  const int *gold;            //a x b
+  const int *goldTranspose;   //transpose(a)
+  atomic_int nErrors;
+} NestedMul;
+
+/** Multiply, transpose and multiply by a vector using parallel
+ *  multiplication matrices from within a task, so that the parallel
+ *  algorithms are nested within the parallelFor().
+ */
+static void
+nestedMul(void *arg, int begin, int end)
+{
+  NestedMul *nested = arg;
+  const int m = nested->a->nRows, n = nested->a->nCols,
+    p = nested->b->nCols;
+  for (int t = begin; t < end; t++) {
+    int err = 0;
+    NewFn newFn = (NewFn)newParallelMulMatrix;
+    Matrix *a = createMatrix(nested->a, newFn, &err);
+    Matrix *b = createMatrix(nested->b, newFn, &err);
+    Matrix *c = newFn(m, p, &err);
+    Matrix *tr = newFn(n, m, &err);
+    if (err) fatal("cannot create nested matrices: %s", strerror(err));
+    a->fns->mul(a, b, c, &err);
+    a->fns->transpose(a, tr, &err);
+    int *row = mallocChk(sizeof(MatrixBaseType)*m);
+    for (int i = 0; i < m && !err; i++) {
+      c->fns->getRow(c, i, row, &err);
+      if (memcmp(row, &nested->gold[i*p], p*sizeof(MatrixBaseType)) != 0) {
+        atomic_fetch_add(&nested->nErrors, 1);
+        break;
+      }
+    }
+    for (int i = 0; i < n && !err; i++) {
+      tr->fns->getRow(tr, i, row, &err);
+      if (memcmp(row, &nested->goldTranspose[i*m],
+                 m*sizeof(MatrixBaseType)) != 0) {
+        atomic_fetch_add(&nested->nErrors, 1);
+        break;
+      }
+    }
+    if (err) atomic_fetch_add(&nested->nErrors, 1);
+    free(row);
+    a->fns->free(a, &err);
+    b->fns->free(b, &err);
+    c->fns->free(c, &err);
+    tr->fns->free(tr, &err);
+  }
+}
+
+/** Test the thread pool with POOL_TEST_THREADS threads: nested
+ *  parallelFor()'s must process each index exactly once in chunks of
+ *  at most grain indexes, deeply recursive fork/join must complete,
+ *  and the parallel matrix algorithms must give the right results
+ *  when run from within tasks.
+ */
+static void
+doThreadPoolTests(void)
+{
+  const int savedSize = getThreadPoolSize();
+  setThreadPoolSize(POOL_TEST_THREADS);
+
+  static atomic_int counts[OUTER_N*INNER_N];
+  atomic_int nBadChunks = 0;
+  for (int i = 0; i < OUTER_N*INNER_N; i++) atomic_init(&counts[i], 0);
+  IndexCounts outer = { .counts = counts, .nBadChunks = &nBadChunks };
+  parallelFor(OUTER_N, OUTER_GRAIN, countOuter, &outer);
+  for (int i = 0; i < OUTER_N*INNER_N; i++) {
+    const int count = atomic_load(&counts[i]);
+    if (count != 1) {
+      error("nested parallelFor(): index [%d][%d] processed %d times",
+            i/INNER_N, i%INNER_N, count);
+      break;
+    }
+  }
+  if (atomic_load(&nBadChunks) > 0) {
+    error("nested parallelFor(): %d chunks larger than their grain",
+          atomic_load(&nBadChunks));
+  }
+
+  SumRange range = { 0, 1000000 };
+  sumTask(&range);
+  if (range.sum != range.end*(range.end - 1)/2) {
+    error("fork/join sum of [0, %ld): expected %ld, got %ld", range.end,
+          range.end*(range.end - 1)/2, range.sum);
+  }
+
+  enum { N_NESTED_MULS = 8 };
+  RandSpec specA = { .desc = "a", .nRows = 67, .nCols = 90, .max = 100 };
+  RandSpec specB = { .desc = "b", .nRows = 90, .nCols = 50, .max = 100 };
+  TestData a = createRandomTestData(&specA);
+  TestData b = createRandomTestData(&specB);
+  int *gold = mallocChk(sizeof(MatrixBaseType)*a.nRows*b.nCols);
+  int *goldTranspose = mallocChk(sizeof(MatrixBaseType)*a.nRows*a.nCols);
+  goldMatrixMultiply(a.nRows, a.nCols, b.nCols, (int (*)[a.nCols])a.data,
+                     (int (*)[b.nCols])b.data, (int (*)[b.nCols])gold);
+  for (int i = 0; i < a.nRows; i++) {
+    for (int j = 0; j < a.nCols; j++) {
+      goldTranspose[j*a.nRows + i] = a.data[i*a.nCols + j];
+    }
+  }
+  NestedMul mul = { .a = &a, .b = &b, .gold = gold,
+                    .goldTranspose = goldTranspose };
+  parallelFor(N_NESTED_MULS, 1, nestedMul, &mul);
+  if (atomic_load(&mul.nErrors) > 0) {
+    error("%d errors in parallel multiplications within tasks",
+          atomic_load(&mul.nErrors));
+  }
+  free(gold);
+  free(goldTranspose);
+  freeRandomTestData(&a);
+  freeRandomTestData(&b);
+
+  setThreadPoolSize(savedSize);
+}
+
+static void doRandomTests(FILE *out, _Bool doOutput) {
+  int nSpecs = sizeof(randSpecs)/sizeof(randSpecs[0]);
+  TestData data[nSpecs];
+  for (int i = 0; i < nSpecs; i++) {
+    data[i] = createRandomTestData(&randSpecs[i]);
+  }
+  doTests(out, doOutput, data, nSpecs);
+  for (int i = 0; i < nSpecs; i++) {
+    freeRandomTestData(&data[i]);
+  }
+  doVerifyTests();
+  doGemmKernelTests();
+  doDenseStorageTests();
+  doDenseAccessorTests();
+  doMulDispatchTests();
+  doMulVecKernelTests();
+  doTypedTests(&typedTestOps);
+  doTypedTests(&typedTestOpsI64);
+  doTypedTests(&typedTestOpsF32);
+  doTypedTests(&typedTestOpsF64);
+  doTransposeViewTests();
+  doSubMatrixViewTests();
+  doSmallMulTests();
+  doBatchMulTests();
+  doStrassenTests();
+  doSparseTests();
+  doStructuredTests();
+  doSymmetricTests();
+  doWorkspaceTests();
+  doThreadPoolTests();
+  doStreamMulTests();
+  doBadMatrixFileTests();
+}
+
+/***************************** File Test Data **************************/
+
+/** Test data from a matrix file */
+typedef struct {
+  TestData data;
+  Matrix *matrix;       //dense matrix mapped from the file
+  _Bool isCopy;         //true iff data.data is a copy of the entries
+} FileTestData;
+
+/** Return test data for the matrix file at path.  The entries are used
+ *  in place from a mapping of the file unless its rows are padded.
+ */
+static FileTestData
+createFileTestData(const char *path)
+{
+  int err = 0;
+  FileTestData file = { .data = { .desc = path, .path = path } };
+  file.matrix = (Matrix *)newDenseMatrixFromFile(path, false, &err);
+  if (err) fatal("cannot load matrix file %s: %s", path, strerror(err));
+  int ld;
+  file.data.nRows = file.matrix->fns->getNRows(file.matrix, &err);
+  file.data.nCols = file.matrix->fns->getNCols(file.matrix, &err);
+  file.data.data = file.matrix->fns->getData(file.matrix, &ld, &err);
+  if (ld != file.data.nCols) {
+    file.data.data = matrixToPlainMatrix(file.matrix, path, &file.data.nRows,
+                                         &file.data.nCols);
+    file.isCopy = true;
+  }
+  return file;
+}
+
+static void
+freeFileTestData(const FileTestData *file)
+{
+  if (file->isCopy) free(file->data.data);
+  int err = 0;
+  file->matrix->fns->free(file->matrix, &err);
+}
+
+/** Write a random nRows x nCols matrix to a new matrix file at path */
+static void
+genMatrixFile(int nRows, int nCols, const char *path)
+{
+  RandSpec spec = { .desc = path, .nRows = nRows, .nCols = nCols,
+                    .max = 100 };
+  TestData data = createRandomTestData(&spec);
+  int err = 0;
+  Matrix *matrix = createMatrix(&data, (NewFn)newDenseMatrix, &err);
+  if (!err) saveMatrixFile(matrix, path, &err);
+  if (err) error("cannot write matrix file %s: %s", path, strerror(err));
+  if (matrix) matrix->fns->free(matrix, &err);
+  freeRandomTestData(&data);
+}
+
+/** Test transpose of the matrix in file paths[0] and multiplication of
+ *  the matrices in files paths[0] x paths[1] for all newFns.
+ */
+static void
+doFileTests(FILE *out, _Bool doOutput, const char *paths[2])
+{
+  FileTestData a = createFileTestData(paths[0]);
+  FileTestData b = createFileTestData(paths[1]);
+  doTransposeTestData(out, doOutput, &a.data);
+  if (a.data.nCols != b.data.nRows) {
+    error("cannot multiply %s (%dx%d) by %s (%dx%d)", paths[0],
+          a.data.nRows, a.data.nCols, paths[1], b.data.nRows, b.data.nCols);
+  }
+  else {
+    doMulTestData(out, doOutput, &a.data, &b.data);
+  }
+  freeFileTestData(&a);
+  freeFileTestData(&b);
+}
+
+/*************************** Predefined Tests **************************/
+
+#include "test.data"
+
+static void
+doPredefinedTests(FILE *out, _Bool doOutput)
+{
+  doTests(out, doOutput, testData, sizeof(testData)/sizeof(testData[0]));
+}
+
+
+/************************** Performance Tests **************************/
+
+/** Parameters for performance tests */
+typedef struct {
+  int nWarmups;          //# of untimed runs before timed trials
+  int nTrials;           //# of timed trials
+  BenchReport *report;
+  PerfCounters *counters; //hardware counters; NULL if not collected
+} BenchParams;
+
+/** Return the # of threads used by operations on matrices created by
+ *  newFns[i]; a product uses the threads of its multiplicand.
+ */
+static int
+getBenchThreads(int i)
+{
+  return (newFns[i].isParallel) ? getThreadPoolSize() : 1;
+}
+
+/** Operation being benchmarked; return error code */
+typedef int (*BenchFn)(void *arg);
+
+/** Run fn(arg) params->nWarmups times and then time params->nTrials
+ *  runs, setting record->stats and record->nAllocs.  If
+ *  params->counters, then also set *counts to the mean hardware counts
+ *  per timed run.  Return error code of first failing run.
+ */
+static int
+benchmark(const BenchParams *params, BenchFn fn, void *arg,
+          BenchRecord *record, PerfCounts *counts)
+{
+  PerfCounters *counters = params->counters;
+  for (int i = 0; i < params->nWarmups; i++) {
+    int err = fn(arg);
+    if (err) return err;
+  }
+  if (counters) resetPerfCounters(counters);
+  long nAllocs = getWorkspaceAllocCount();
+  double secs[params->nTrials];
+  for (int i = 0; i < params->nTrials; i++) {
+    if (counters) enablePerfCounters(counters);
+    double start = getBenchTime();
+    int err = fn(arg);
+    secs[i] = getBenchTime() - start;
+    if (counters) disablePerfCounters(counters);
+    if (err) return err;
+  }
+  computeBenchStats(secs, params->nTrials, &record->stats);
+  record->nAllocs =
+    (double)(getWorkspaceAllocCount() - nAllocs)/params->nTrials;
+  if (counters) {
+    readPerfCounters(counters, counts);
+    for (int i = 0; i < N_PERF_COUNTERS; i++) {
+      counts->values[i] /= params->nTrials;
+    }
+  }
+  return 0;
+}
+
+/** Operands for a benchmarked operation */
+typedef struct {
+  const Matrix *multiplicand;
+  const Matrix *multiplier;
+  Matrix *result;
+} BenchOperands;
+
+static int
+benchMul(void *arg)
+{
+  BenchOperands *ops = arg;
+  int err = 0;
+  ops->multiplicand->fns->mul(ops->multiplicand, ops->multiplier,
+                              ops->result, &err);
+  return err;
+}
+
+static int
+benchTranspose(void *arg)
+{
+  BenchOperands *ops = arg;
+  int err = 0;
+  ops->multiplicand->fns->transpose(ops->multiplicand, ops->result, &err);
+  return err;
+}
+
+/** Operands for a benchmarked matrix-vector product */
+typedef struct {
+  const Matrix *matrix;
+  const MatrixBaseType *vec;
+  MatrixBaseType *result;
+} BenchVecOperands;
+
+static int
+benchMulVec(void *arg)
+{
+  BenchVecOperands *ops = arg;
+  int err = 0;
+  ops->matrix->fns->mulVec(ops->matrix, ops->vec, ops->result, &err);
+  return err;
+}
+
+static int
+benchVecMul(void *arg)
+{
+  BenchVecOperands *ops = arg;
+  int err = 0;
+  ops->matrix->fns->vecMul(ops->matrix, ops->vec, ops->result, &err);
+  return err;
+}
+
+/** Benchmark mulVec() and vecMul() of data for all newFns, reporting
+ *  throughput in GB/s (counting the bytes of the matrix and of both
+ *  vectors, each of which need only be accessed once).
+ */
+static void
+doMulVecPerfTests(const BenchParams *params, const TestData *data)
+{
+  const double nBytes = ((double)data->nRows*data->nCols +
+                         data->nRows + data->nCols)*sizeof(MatrixBaseType);
+  const int maxN = (data->nRows > data->nCols) ? data->nRows : data->nCols;
+  MatrixBaseType *vec = mallocChk(maxN*sizeof(MatrixBaseType));
+  MatrixBaseType *result = mallocChk(maxN*sizeof(MatrixBaseType));
+  for (int i = 0; i < maxN; i++) vec[i] = rand() % 100;
+  const struct { const char *op; BenchFn fn; } vecOps[] = {
+    { "mulVec", benchMulVec }, { "vecMul", benchVecMul },
+  };
+  int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  for (int i = 0; i < nNewFns; i++) {
+    int err = 0;
+    Matrix *matrix = createMatrix(data, newFns[i].new, &err);
+    if (err) {
+      fatal("cannot create matrix for %s matrix-vector product: %s",
+            newFns[i].desc, strerror(err));
+    }
+    BenchVecOperands ops = { matrix, vec, result };
+    for (int k = 0; k < 2; k++) {
+      PerfCounts counts;
+      BenchRecord record = {
+        .op = vecOps[k].op, .lhs = newFns[i].desc, .n = data->nRows,
+        .nThreads = getBenchThreads(i), .rateUnit = "GB/s",
+        .counts = (params->counters) ? &counts : NULL,
+      };
+      err = benchmark(params, vecOps[k].fn, &ops, &record, &counts);
+      if (err) {
+        error("%s %s: %s", newFns[i].desc, vecOps[k].op, strerror(err));
+      }
+      else {
+        record.rate = nBytes/record.stats.medianSecs/1e9;
+        outBenchRecord(params->report, &record);
+      }
+    }
+    matrix->fns->free(matrix, &err);
+  }
+  free(vec);
+  free(result);
+}
+
+/** Benchmark multiplication of data1 x data2 for all pairs of newFns,
+ *  reporting GOPS (2mnp operations per multiplication) and, when
+ *  counters are collected, misses per each of the mnp multiply-adds.
+ *  Each product is verified (outside the timed region) as specified
+ *  by verifyMode.
+ */
+static void
+doMulPerfTests(const BenchParams *params, const TestData *data1,
+               const TestData *data2)
+{
+  const int n = data1->nRows;
+  const double nOps = 2.0*data1->nRows*data1->nCols*data2->nCols;
+  int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  for (int i = 0; i < nNewFns; i++) {
+    for (int j = 0; j < nNewFns; j++) {
+      int err = 0;
+      Matrix *multiplicand = createMatrix(data1, newFns[i].new, &err);
+      Matrix *multiplier = createMatrix(data2, newFns[j].new, &err);
+      Matrix *product =
+        (Matrix *)newDenseMatrix(data1->nRows, data2->nCols, &err);
+      if (err) {
+        fatal("cannot create matrices for %s x %s: %s", newFns[i].desc,
+              newFns[j].desc, strerror(err));
+      }
+      BenchOperands ops = { multiplicand, multiplier, product };
+      PerfCounts counts;
+      BenchRecord record = {
+        .op = "mul", .lhs = newFns[i].desc, .rhs = newFns[j].desc,
+        .n = n, .nThreads = getBenchThreads(i), .rateUnit = "GOPS",
+        .counts = (params->counters) ? &counts : NULL, .nFmas = nOps/2,
+      };
+      err = benchmark(params, benchMul, &ops, &record, &counts);
+      if (err) {
+        error("%s x %s: %s", newFns[i].desc, newFns[j].desc, strerror(err));
+      }
+      else {
+        record.rate = nOps/record.stats.medianSecs/1e9;
+        outBenchRecord(params->report, &record);
+        doMulTestMatrix(multiplicand, newFns[i].desc, multiplier,
+                        newFns[j].desc, product);
+      }
+      multiplicand->fns->free(multiplicand, &err);
+      multiplier->fns->free(multiplier, &err);
+      product->fns->free(product, &err);
+    }
+  }
+}
+
+/** Benchmark transpose of data for all newFns, reporting throughput in
+ *  GB/s (counting both the bytes read and the bytes written).
+ */
+static void
+doTransposePerfTests(const BenchParams *params, const TestData *data)
+{
+  const double nBytes = 2.0*data->nRows*data->nCols*sizeof(MatrixBaseType);
+  int nNewFns = sizeof(newFns)/sizeof(newFns[0]);
+  for (int i = 0; i < nNewFns; i++) {
+    int err = 0;
+    Matrix *matrix = createMatrix(data, newFns[i].new, &err);
+    Matrix *transpose =
+      (Matrix *)newDenseMatrix(data->nCols, data->nRows, &err);
+    if (err) {
+      fatal("cannot create matrices for %s transpose: %s",
+            newFns[i].desc, strerror(err));
+    }
+    BenchOperands ops = { .multiplicand = matrix, .result = transpose };
+    PerfCounts counts;
+    BenchRecord record = {
+      .op = "transpose", .lhs = newFns[i].desc, .n = data->nRows,
+      .nThreads = getBenchThreads(i), .rateUnit = "GB/s",
+      .counts = (params->counters) ? &counts : NULL,
+    };
+    err = benchmark(params, benchTranspose, &ops, &record, &counts);
+    if (err) {
+      error("%s transpose: %s", newFns[i].desc, strerror(err));
+    }
+    else {
+      record.rate = nBytes/record.stats.medianSecs/1e9;
+      outBenchRecord(params->report, &record);
+    }
+    matrix->fns->free(matrix, &err);
+    transpose->fns->free(transpose, &err);
+  }
+}
+
+/** Report speedup of parallel multiplication of data x data using
+ *  nThreads threads against the single-threaded baseline.
+ */
+static void
+doSpeedupPerfTest(const BenchParams *params, const TestData *data,
+                  int nThreads)
+{
+  int err = 0;
+  NewFn newFn = (NewFn)newParallelMulMatrix;
+  Matrix *multiplicand = createMatrix(data, newFn, &err);
+  Matrix *multiplier = createMatrix(data, newFn, &err);
+  Matrix *product = newFn(data->nRows, data->nCols, &err);
+  if (err) {
+    fatal("cannot create matrices for speedup test: %s", strerror(err));
+  }
+  BenchOperands ops = { multiplicand, multiplier, product };
+  const int nThreadCounts[] = { 1, nThreads };
+  BenchRecord records[2];
+  PerfCounts counts;    //not reported
+  for (int i = 0; i < 2; i++) {
+    setThreadPoolSize(nThreadCounts[i]);
+    err = benchmark(params, benchMul, &ops, &records[i], &counts);
+    if (err) {
+      error("parallel multiplication failed: %s", strerror(err));
+      break;
+    }
+  }
+  if (!err) {
+    BenchRecord record = {
+      .op = "speedup", .lhs = "parallelMulMatrix", .rhs = "parallelMulMatrix",
+      .n = data->nRows, .nThreads = nThreads, .stats = records[1].stats,
+      .rate = records[0].stats.medianSecs/records[1].stats.medianSecs,
+      .rateUnit = "x", .nAllocs = records[1].nAllocs,
+    };
+    outBenchRecord(params->report, &record);
+  }
+  setThreadPoolSize(nThreads);
+  multiplicand->fns->free(multiplicand, &err);
+  multiplier->fns->free(multiplier, &err);
+  product->fns->free(product, &err);
+}
+
+/** Sizes n of the n x n matrices used for benchmarking padding: the
+ *  rows of the power-of-two sizes alias into the same cache sets when
+ *  not padded.
+ */
+static const int paddingBenchSizes[] = { 1024, 1025, 2048 };
+
+/** Benchmark blocked multiplication, smart multiplication (which
+ *  walks the columns of its multiplier to transpose it), transpose and
+ *  vecMul() of dense matrices created with and without padded rows.
+ *  The rhs of each record is "padded" or "unpadded".
+ */
+static void
+doPaddingPerfTests(const BenchParams *params)
+{
+  const char *descs[] = { "unpadded", "padded" };
+  int nSizes = sizeof(paddingBenchSizes)/sizeof(paddingBenchSizes[0]);
+  for (int i = 0; i < nSizes; i++) {
+    const int n = paddingBenchSizes[i];
+    RandSpec spec = { .desc = "padding", .nRows = n, .nCols = n, .max = 100 };
+    TestData data = createRandomTestData(&spec);
+    MatrixBaseType *vec = mallocChk(n*sizeof(MatrixBaseType));
+    MatrixBaseType *vecResult = mallocChk(n*sizeof(MatrixBaseType));
+    for (int k = 0; k < n; k++) vec[k] = data.data[k];
+    for (int isPadded = 0; isPadded < 2; isPadded++) {
+      setDenseMatrixPadding(isPadded);
+      int err = 0;
+      Matrix *blocked = createMatrix(&data, (NewFn)newBlockedMulMatrix, &err);
+      Matrix *smart = createMatrix(&data, (NewFn)newSmartMulMatrix, &err);
+      Matrix *result = (Matrix *)newDenseMatrix(n, n, &err);
+      if (err) {
+        fatal("cannot create %s matrices for padding test: %s",
+              descs[isPadded], strerror(err));
+      }
+      BenchOperands blockedOps = { blocked, blocked, result };
+      BenchOperands smartOps = { smart, smart, result };
+      BenchOperands transposeOps = {
+        .multiplicand = blocked, .result = result,
+      };
+      BenchVecOperands vecOps = { blocked, vec, vecResult };
+      const struct {
+        const char *op, *lhs;
+        BenchFn fn;
+        void *arg;
+        double nOps;
+        const char *rateUnit;
+      } benches[] = {
+        { "mul", "blockedMulMatrix", benchMul, &blockedOps,
+          2.0*n*n*n/1e9, "GOPS" },
+        { "mul", "smartMulMatrix", benchMul, &smartOps,
+          2.0*n*n*n/1e9, "GOPS" },
+        { "transpose", "blockedMulMatrix", benchTranspose, &transposeOps,
+          2.0*n*n*sizeof(MatrixBaseType)/1e9, "GB/s" },
+        { "vecMul", "blockedMulMatrix", benchVecMul, &vecOps,
+          ((double)n*n + 2*n)*sizeof(MatrixBaseType)/1e9, "GB/s" },
+      };
+      for (int b = 0; b < sizeof(benches)/sizeof(benches[0]); b++) {
+        PerfCounts counts;
+        BenchRecord record = {
+          .op = benches[b].op, .lhs = benches[b].lhs, .rhs = descs[isPadded],
+          .n = n, .nThreads = 1, .rateUnit = benches[b].rateUnit,
+          .counts = (params->counters) ? &counts : NULL,
+        };
+        err = benchmark(params, benches[b].fn, benches[b].arg, &record,
+                        &counts);
+        if (err) {
+          error("%s %s %s: %s", descs[isPadded], benches[b].lhs,
+                benches[b].op, strerror(err));
+        }
+        else {
+          record.rate = benches[b].nOps/record.stats.medianSecs;
+          outBenchRecord(params->report, &record);
+        }
+      }
+      blocked->fns->free(blocked, &err);
+      smart->fns->free(smart, &err);
+      result->fns->free(result, &err);
+    }
+    setDenseMatrixPadding(true);
+    free(vec);
+    free(vecResult);
+    freeRandomTestData(&data);
+  }
+}
+
+/** Sizes n of the n x n matrices used for benchmarking structured
+ *  multiplication.
+ */
+static const int structuredBenchSizes[] = { 512, 1024 };
+
+/** Structures benchmarked by doStructuredPerfTests() */
+static const struct {
+  const char *desc;
+  NewFn new;
+} structuredBenches[] = {
+  { "upperTriangular", newUpperTriangularMatrix },
+  { "lowerTriangular", newLowerTriangularMatrix },
+  { "diagonal", newSquareDiagonalMatrix },
+  { "tridiagonal", newTridiagonalMatrix },
+  { "wideBand", newWideBandMatrix },
+};
+
+/** Benchmark multiplying each structure by a dense matrix and a dense
+ *  matrix by each structure against the same dense x dense product.
+ *  Each "mul" record reports GOPS counting only the multiply-adds by
+ *  entries within the structure; each "speedup" record the dense
+ *  median time over the structured median time.  The "flopSaving" and
+ *  "byteSaving" records report the ratios of the multiply-adds and
+ *  the bytes of storage of the dense matrix to those of the
+ *  structure.  The products are verified after timing.
+ */
+static void
+doStructuredPerfTests(const BenchParams *params)
+{
+  int nSizes = sizeof(structuredBenchSizes)/sizeof(structuredBenchSizes[0]);
+  int nBenches = sizeof(structuredBenches)/sizeof(structuredBenches[0]);
+  for (int i = 0; i < nSizes; i++) {
+    const int n = structuredBenchSizes[i];
+    RandSpec spec = { .desc = "dense", .nRows = n, .nCols = n, .max = 100 };
+    TestData data = createRandomTestData(&spec);
+    int err = 0;
+    Matrix *dense = createMatrix(&data, (NewFn)newDenseMatrix, &err);
+    Matrix *product = (Matrix *)newDenseMatrix(n, n, &err);
+    if (err) fatal("cannot create dense structured bench matrices: %s",
+                   strerror(err));
+    PerfCounts counts;
+    BenchOperands denseOps = { dense, dense, product };
+    BenchRecord denseRecord = {
+      .op = "mul", .lhs = "denseMatrix", .rhs = "denseMatrix", .n = n,
+      .nThreads = 1, .rateUnit = "GOPS", .nFmas = (double)n*n*n,
+      .counts = (params->counters) ? &counts : NULL,
+    };
+    err = benchmark(params, benchMul, &denseOps, &denseRecord, &counts);
+    if (err) fatal("dense x dense benchmark: %s", strerror(err));
+    denseRecord.rate = 2.0*n*n*n/1e9/denseRecord.stats.medianSecs;
+    outBenchRecord(params->report, &denseRecord);
+
+    for (int b = 0; b < nBenches; b++) {
+      const char *desc = structuredBenches[b].desc;
+      Matrix *structured = structuredBenches[b].new(n, n, &err);
+      if (err) fatal("cannot create %s: %s", desc, strerror(err));
+      TestData entries = createRandomTestData(&spec);
+      setStructuredEntries(structured, &entries, desc);
+      freeRandomTestData(&entries);
+      const StructuredMatrix *s = (const StructuredMatrix *)structured;
+      const double nEntries = getStructuredMatrixNEntries(s);
+      const double storageSize = getStructuredMatrixStorageSize(s);
+      const struct { const Matrix *m1, *m2; const char *lhs, *rhs; } ops[] = {
+        { structured, dense, desc, "denseMatrix" },
+        { dense, structured, "denseMatrix", desc },
+      };
+      BenchRecord structuredRecord;
+      for (int k = 0; k < sizeof(ops)/sizeof(ops[0]); k++) {
+        BenchOperands mulOps = { ops[k].m1, ops[k].m2, product };
+        BenchRecord record = {
+          .op = "mul", .lhs = ops[k].lhs, .rhs = ops[k].rhs, .n = n,
+          .nThreads = 1, .rateUnit = "GOPS", .nFmas = nEntries*n,
+          .counts = (params->counters) ? &counts : NULL,
+        };
+        err = benchmark(params, benchMul, &mulOps, &record, &counts);
+        if (err) {
+          error("%s x %s: %s", ops[k].lhs, ops[k].rhs, strerror(err));
+          continue;
+        }
+        record.rate = 2.0*nEntries*n/1e9/record.stats.medianSecs;
+        outBenchRecord(params->report, &record);
+        BenchRecord speedup = {
+          .op = "speedup", .lhs = ops[k].lhs, .rhs = ops[k].rhs, .n = n,
+          .nThreads = 1, .stats = record.stats, .rateUnit = "x",
+          .rate = denseRecord.stats.medianSecs/record.stats.medianSecs,
+        };
+        outBenchRecord(params->report, &speedup);
+        doMulTestMatrix((Matrix *)ops[k].m1, ops[k].lhs,
+                        (Matrix *)ops[k].m2, ops[k].rhs, product);
+        structuredRecord = record;
+      }
+      if (!err) {
+        BenchRecord saving = {
+          .op = "flopSaving", .lhs = desc, .n = n, .nThreads = 1,
+          .stats = structuredRecord.stats, .rateUnit = "x",
+          .rate = (double)n*n/nEntries,
+        };
+        outBenchRecord(params->report, &saving);
+        saving.op = "byteSaving";
+        saving.rate = (double)n*n*sizeof(MatrixBaseType)/storageSize;
+        outBenchRecord(params->report, &saving);
+      }
+      structured->fns->free(structured, &err);
+    }
+    dense->fns->free(dense, &err);
+    product->fns->free(product, &err);
+    freeRandomTestData(&data);
+  }
+}
+
+/** Operands for a benchmarked A*transpose(A) */
+typedef struct {
+  const Matrix *a;
+  _Bool isTransA;
+  Matrix *transpose;    //for transpose followed by mul(); else NULL
+  Matrix *result;
+} BenchSyrkOperands;
+
+static int
+benchSyrk(void *arg)
+{
+  BenchSyrkOperands *ops = arg;
+  int err = 0;
+  if (ops->transpose) {
+    ops->a->fns->transpose(ops->a, ops->transpose, &err);
+    if (err) return err;
+    if (ops->isTransA) {
+      ops->transpose->fns->mul(ops->transpose, ops->a, ops->result, &err);
+    }
+    else {
+      ops->a->fns->mul(ops->a, ops->transpose, ops->result, &err);
+    }
+  }
+  else {
+    syrkMatrix(ops->a, ops->isTransA, (SymmetricMatrix *)ops->result, &err);
+  }
+  return err;
+}
+
+/** Benchmark syrkMatrix() of an n x n dense matrix, in both
+ *  orientations, against a transpose into a new dense matrix followed
+ *  by a dense multiplication.  Each "syrk" or "syrkTrans" record
+ *  reports GOPS over the multiply-adds actually performed, followed by
+ *  a "speedup" record over the transpose and multiplication; a
+ *  "byteSaving" record reports the ratio of dense to packed storage.
+ *  The products are verified after timing.
+ */
+static void
+doSymmetricPerfTests(const BenchParams *params)
+{
+  int nSizes = sizeof(structuredBenchSizes)/sizeof(structuredBenchSizes[0]);
+  for (int i = 0; i < nSizes; i++) {
+    const int n = structuredBenchSizes[i];
+    RandSpec spec = { .desc = "dense", .nRows = n, .nCols = n, .max = 100 };
+    TestData data = createRandomTestData(&spec);
+    int err = 0;
+    Matrix *a = createMatrix(&data, (NewFn)newDenseMatrix, &err);
+    Matrix *transpose = (Matrix *)newDenseMatrix(n, n, &err);
+    Matrix *product = (Matrix *)newDenseMatrix(n, n, &err);
+    Matrix *symmetric = (Matrix *)newSymmetricMatrix(n, &err);
+    Matrix *view = (Matrix *)newTransposeView(a, false, &err);
+    if (err) fatal("cannot create symmetric bench matrices: %s",
+                   strerror(err));
+    PerfCounts counts;
+    const char *ops[] = { "syrk", "syrkTrans" };
+    for (int isTransA = 0; isTransA < 2; isTransA++) {
+      BenchSyrkOperands denseOps = { a, isTransA, transpose, product };
+      BenchRecord denseRecord = {
+        .op = ops[isTransA], .lhs = "denseMatrix", .rhs = "denseMatrix",
+        .n = n, .nThreads = 1, .rateUnit = "GOPS", .nFmas = (double)n*n*n,
+        .counts = (params->counters) ? &counts : NULL,
+      };
+      err = benchmark(params, benchSyrk, &denseOps, &denseRecord, &counts);
+      if (err) fatal("transpose and mul benchmark: %s", strerror(err));
+      denseRecord.rate = 2.0*n*n*n/1e9/denseRecord.stats.medianSecs;
+      outBenchRecord(params->report, &denseRecord);
+
+      BenchSyrkOperands syrkOps = { a, isTransA, NULL, symmetric };
+      const double nFmas = (double)n*(n + 1)/2*n;
+      BenchRecord record = {
+        .op = ops[isTransA], .lhs = "denseMatrix", .rhs = "symmetricMatrix",
+        .n = n, .nThreads = 1, .rateUnit = "GOPS", .nFmas = nFmas,
+        .counts = (params->counters) ? &counts : NULL,
+      };
+      err = benchmark(params, benchSyrk, &syrkOps, &record, &counts);
+      if (err) fatal("syrk benchmark: %s", strerror(err));
+      record.rate = 2.0*nFmas/1e9/record.stats.medianSecs;
+      outBenchRecord(params->report, &record);
+      BenchRecord speedup = {
+        .op = "speedup", .lhs = ops[isTransA], .rhs = "symmetricMatrix",
+        .n = n, .nThreads = 1, .stats = record.stats, .rateUnit = "x",
+        .rate = denseRecord.stats.medianSecs/record.stats.medianSecs,
+      };
+      outBenchRecord(params->report, &speedup);
+      if (isTransA) doMulTestMatrix(view, "transpose", a, "dense", symmetric);
+      else doMulTestMatrix(a, "dense", view, "transpose", symmetric);
+      if (isTransA) {
+        BenchRecord saving = {
+          .op = "byteSaving", .lhs = "symmetricMatrix", .n = n,
+          .nThreads = 1, .stats = record.stats, .rateUnit = "x",
+          .rate = (double)n*n/((double)n*(n + 1)/2),
+        };
+        outBenchRecord(params->report, &saving);
+      }
+    }
+    Matrix *matrices[] = { view, a, transpose, product, symmetric };
+    for (int k = 0; k < sizeof(matrices)/sizeof(matrices[0]); k++) {
+      matrices[k]->fns->free(matrices[k], &err);
+    }
+    freeRandomTestData(&data);
+  }
+}
+
+/** Operands for a benchmarked batch of multiplications */
+typedef struct {
+  BatchLayout layout;
+  int count, n;
+  const MatrixBaseType *a, *b;
+  MatrixBaseType *c;
+  Matrix **matrices;    //for one matrix at a time: count a's and b's
+} BatchOperands;
+
+static int
+benchBatchMul(void *arg)
+{
+  BatchOperands *ops = arg;
+  int err = 0;
+  batchMul(ops->layout, ops->count, ops->n, ops->n, ops->n, ops->a, ops->b,
+           ops->c, &err);
+  return err;
+}
+
+/** Multiply the matrices in the batch one at a time, as callers
+ *  without the batch API do: each product is a new dense matrix.
+ */
+static int
+benchMatrixMuls(void *arg)
+{
+  BatchOperands *ops = arg;
+  int err = 0;
+  for (int t = 0; t < ops->count && !err; t++) {
+    const Matrix *a = ops->matrices[t], *b = ops->matrices[ops->count + t];
+    Matrix *product = (Matrix *)newDenseMatrix(ops->n, ops->n, &err);
+    if (err) break;
+    a->fns->mul(a, b, product, &err);
+    product->fns->free(product, &err);
+  }
+  return err;
+}
+
+/** Sizes n of the n x n matrices used for benchmarking batches */
+static const int batchBenchSizes[] = { 2, 3, 4, 5, 8 };
+
+/** Benchmark multiplying batches of count small square matrices, one
+ *  dense matrix at a time and using batchMul() in each layout,
+ *  reporting millions of products per second.
+ */
+static void
+doBatchPerfTests(const BenchParams *params, int count)
+{
+  const char *descs[] = { "denseMatrix", "aos", "soa" };
+  int nSizes = sizeof(batchBenchSizes)/sizeof(batchBenchSizes[0]);
+  for (int i = 0; i < nSizes; i++) {
+    const int n = batchBenchSizes[i];
+    RandSpec spec = { .desc = "batch", .nRows = 2*count*n, .nCols = n,
+                      .max = 100 };
+    TestData data = createRandomTestData(&spec);
+    const size_t size = (size_t)count*n*n;
+    int *soa = mallocChk(2*size*sizeof(MatrixBaseType));
+    int *c = mallocChk(size*sizeof(MatrixBaseType));
+    convertBatchLayout(count, n, n, BATCH_LAYOUT_AOS, data.data,
+                       BATCH_LAYOUT_SOA, soa);
+    convertBatchLayout(count, n, n, BATCH_LAYOUT_AOS, &data.data[size],
+                       BATCH_LAYOUT_SOA, &soa[size]);
+    Matrix **matrices = mallocChk(2*count*sizeof(Matrix *));
+    for (int t = 0; t < 2*count; t++) {
+      TestData tData = { .nRows = n, .nCols = n, .data = &data.data[t*n*n] };
+      int err = 0;
+      matrices[t] = createMatrix(&tData, (NewFn)newDenseMatrix, &err);
+      if (err) fatal("cannot create batch matrices: %s", strerror(err));
+    }
+    BatchOperands ops[] = {
+      { .count = count, .n = n, .matrices = matrices },
+      { .layout = BATCH_LAYOUT_AOS, .count = count, .n = n,
+        .a = data.data, .b = &data.data[size], .c = c },
+      { .layout = BATCH_LAYOUT_SOA, .count = count, .n = n,
+        .a = soa, .b = &soa[size], .c = c },
+    };
+    for (int j = 0; j < sizeof(ops)/sizeof(ops[0]); j++) {
+      PerfCounts counts;
+      BenchRecord record = {
+        .op = "batchMul", .lhs = descs[j], .n = n,
+        .nThreads = (j == 0) ? 1 : getThreadPoolSize(),
+        .rateUnit = "Mmat/s", .counts = (params->counters) ? &counts : NULL,
+        .nFmas = (double)count*n*n*n,
+      };
+      int err = benchmark(params, (j == 0) ? benchMatrixMuls : benchBatchMul,
+                          &ops[j], &record, &counts);
+      if (err) {
+        error("%s batch of %dx%d: %s", descs[j], n, n, strerror(err));
+      }
+      else {
+        record.rate = count/record.stats.medianSecs/1e6;
+        outBenchRecord(params->report, &record);
+      }
+    }
+    for (int t = 0; t < 2*count; t++) {
+      int err = 0;
+      matrices[t]->fns->free(matrices[t], &err);
+    }
+    free(matrices);
+    free(soa);
+    free(c);
+    freeRandomTestData(&data);
+  }
+}
+
+/** Run all performance tests for each of the nSizes sizes[] */
+static void
+doPerformanceTests(const BenchParams *params, const int sizes[], int nSizes)
+{
+  for (int i = 0; i < nSizes; i++) {
+    RandSpec randSpec = {
+      .desc = "randPerfMatrix", .nRows = sizes[i], .nCols = sizes[i],
+      .max = 100,
+    };
+    TestData data = createRandomTestData(&randSpec);
+    doMulPerfTests(params, &data, &data);
+    doTransposePerfTests(params, &data);
+    doMulVecPerfTests(params, &data);
+    int nThreads = getThreadPoolSize();
+    if (nThreads > 1) doSpeedupPerfTest(params, &data, nThreads);
+    freeRandomTestData(&data);
+  }
+}
+
+/** Run multiplication and transpose benchmarks on the matrices in files
+ *  paths[0] x paths[1].
+ */
+static void
+doFilePerfTests(const BenchParams *params, const char *paths[2])
+{
+  FileTestData a = createFileTestData(paths[0]);
+  FileTestData b = createFileTestData(paths[1]);
+  if (a.data.nCols != b.data.nRows) {
+    error("cannot multiply %s (%dx%d) by %s (%dx%d)", paths[0],
+          a.data.nRows, a.data.nCols, paths[1], b.data.nRows, b.data.nCols);
+  }
+  else {
+    doMulPerfTests(params, &a.data, &b.data);
+  }
+  doTransposePerfTests(params, &a.data);
+  freeFileTestData(&a);
+  freeFileTestData(&b);
+}
+
+/** Multiply the matrix files paths[0] x paths[1] into paths[2] out of
+ *  core using buffers of at most memoryBudget bytes.  The single run
+ *  is reported as several records, comparing the overall and compute
+ *  rates with the disk bandwidth achieved for reads and writes; the
+ *  rate of the final record is the fraction of the time that
+ *  computation waited for reads.
+ */
+static void
+doStreamMulPerfTest(const BenchParams *params, const char *paths[3],
+                    size_t memoryBudget)
+{
+  int err = 0;
+  StreamMulStats stats;
+  streamMulFiles(paths[0], paths[1], paths[2], memoryBudget, &stats, &err);
+  if (err) {
+    error("streaming multiplication %s x %s: %s", paths[0], paths[1],
+          strerror(err));
+    return;
+  }
+  FileTestData a = createFileTestData(paths[0]);
+  FileTestData b = createFileTestData(paths[1]);
+  const double nOps = 2.0*a.data.nRows*a.data.nCols*b.data.nCols;
+  #define PER_SEC(amount, secs) (((secs) > 0) ? (amount)/(secs) : 0)
+  const struct {
+    const char *op; double secs; double rate; const char *unit;
+  } parts[] = {
+    { "streamMul", stats.totalSecs, PER_SEC(nOps/1e9, stats.totalSecs),
+      "GOPS" },
+    { "streamCompute", stats.computeSecs,
+      PER_SEC(nOps/1e9, stats.computeSecs), "GOPS" },
+    { "streamRead", stats.readSecs,
+      PER_SEC(stats.bytesRead/1e9, stats.readSecs), "GB/s" },
+    { "streamWrite", stats.writeSecs,
+      PER_SEC(stats.bytesWritten/1e9, stats.writeSecs), "GB/s" },
+    { "streamWait", stats.waitSecs, PER_SEC(stats.waitSecs, stats.totalSecs),
+      "frac" },
+  };
+  #undef PER_SEC
+  for (int i = 0; i < sizeof(parts)/sizeof(parts[0]); i++) {
+    const double secs = parts[i].secs;
+    BenchRecord record = {
+      .op = parts[i].op, .lhs = paths[0], .rhs = paths[1],
+      .n = a.data.nRows, .nThreads = 1,
+      .stats = { .nTrials = 1, .minSecs = secs, .medianSecs = secs,
+                 .p95Secs = secs },
+      .rate = parts[i].rate, .rateUnit = parts[i].unit,
+    };
+    outBenchRecord(params->report, &record);
+  }
+  freeFileTestData(&a);
+  freeFileTestData(&b);
+}
+
+/***************************** Main Program ****************************/
+
+#define OUTPUT_LONG_OPT            "output"
+#define OUTPUT_SHORT_OPT           'o'
+#define PREDEF_TESTS_LONG_OPT      "predefined-tests"
+#define PREDEF_TESTS_SHORT_OPT     't'
+#define RAND_TESTS_LONG_OPT        "random-tests"
+#define RAND_TESTS_SHORT_OPT       'r'
+#define PERF_MATRIX_SIZE_LONG_OPT  "perf-matrix-size"
+#define PERF_MATRIX_SIZE_SHORT_OPT 's'
+#define THREADS_LONG_OPT           "threads"
+#define THREADS_SHORT_OPT          'j'
+#define GEMM_KERNEL_LONG_OPT       "gemm-kernel"
+#define GEMM_KERNEL_SHORT_OPT      'k'
+#define STRASSEN_CROSSOVER_LONG_OPT  "strassen-crossover"
+#define STRASSEN_CROSSOVER_SHORT_OPT 'x'
+#define BENCH_SIZES_LONG_OPT       "bench-sizes"
+#define BENCH_SIZES_SHORT_OPT      'b'
+#define BENCH_TRIALS_LONG_OPT      "bench-trials"
+#define BENCH_TRIALS_SHORT_OPT     'n'
+#define BENCH_WARMUPS_LONG_OPT     "bench-warmups"
+#define BENCH_WARMUPS_SHORT_OPT    'w'
+#define BENCH_FORMAT_LONG_OPT      "bench-format"
+#define BENCH_FORMAT_SHORT_OPT     'f'
+#define PERF_COUNTERS_LONG_OPT     "perf-counters"
+#define PERF_COUNTERS_SHORT_OPT    'p'
+#define TEST_FILES_LONG_OPT        "test-files"
+#define TEST_FILES_SHORT_OPT       'T'
+#define BENCH_FILES_LONG_OPT       "bench-files"
+#define BENCH_FILES_SHORT_OPT      'B'
+#define GEN_MATRIX_FILE_LONG_OPT   "gen-matrix-file"
+#define GEN_MATRIX_FILE_SHORT_OPT  'g'
+#define STREAM_MUL_LONG_OPT        "stream-mul"
+#define STREAM_MUL_SHORT_OPT       'S'
+#define STREAM_MEMORY_LONG_OPT     "stream-memory"
+#define STREAM_MEMORY_SHORT_OPT    'M'
+#define BENCH_BATCH_LONG_OPT       "bench-batch"
+#define BENCH_BATCH_SHORT_OPT      'c'
+#define BENCH_PADDING_LONG_OPT     "bench-padding"
+#define BENCH_PADDING_SHORT_OPT    'P'
+#define VERIFY_ROUNDS_LONG_OPT     "verify-rounds"
+#define VERIFY_ROUNDS_SHORT_OPT    'V'
+#define GOLD_CHECK_LONG_OPT        "gold-check"
+#define GOLD_CHECK_SHORT_OPT       'G'
+#define BENCH_STRUCTURED_LONG_OPT  "bench-structured"
+#define BENCH_STRUCTURED_SHORT_OPT 'Y'
+
+#define SHORT_OPTS {     \
+  PREDEF_TESTS_SHORT_OPT, \
+  RAND_TESTS_SHORT_OPT, \
+  OUTPUT_SHORT_OPT, \
+  PERF_MATRIX_SIZE_SHORT_OPT, ':', \
+  THREADS_SHORT_OPT, ':', \
+  GEMM_KERNEL_SHORT_OPT, ':', \
+  STRASSEN_CROSSOVER_SHORT_OPT, ':', \
+  BENCH_SIZES_SHORT_OPT, ':', \
+  BENCH_TRIALS_SHORT_OPT, ':', \
+  BENCH_WARMUPS_SHORT_OPT, ':', \
+  BENCH_FORMAT_SHORT_OPT, ':', \
+  PERF_COUNTERS_SHORT_OPT, \
+  TEST_FILES_SHORT_OPT, ':', \
+  BENCH_FILES_SHORT_OPT, ':', \
+  GEN_MATRIX_FILE_SHORT_OPT, ':', \
+  STREAM_MUL_SHORT_OPT, ':', \
+  STREAM_MEMORY_SHORT_OPT, ':', \
+  BENCH_BATCH_SHORT_OPT, ':', \
+  BENCH_PADDING_SHORT_OPT, \
+  VERIFY_ROUNDS_SHORT_OPT, ':', \
+  GOLD_CHECK_SHORT_OPT, \
+  BENCH_STRUCTURED_SHORT_OPT, \
+  '\0' \
+  }
+
+static struct option options[] = {
+  { .name = OUTPUT_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = OUTPUT_SHORT_OPT
+  },
+  { .name = PREDEF_TESTS_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = PREDEF_TESTS_SHORT_OPT
+  },
+  { .name = RAND_TESTS_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = RAND_TESTS_SHORT_OPT
+  },
+  { .name = PERF_MATRIX_SIZE_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = PERF_MATRIX_SIZE_SHORT_OPT
+  },
+  { .name = THREADS_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = THREADS_SHORT_OPT
+  },
+  { .name = GEMM_KERNEL_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = GEMM_KERNEL_SHORT_OPT
+  },
+  { .name = STRASSEN_CROSSOVER_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = STRASSEN_CROSSOVER_SHORT_OPT
+  },
+  { .name = BENCH_SIZES_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_SIZES_SHORT_OPT
+  },
+  { .name = BENCH_TRIALS_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_TRIALS_SHORT_OPT
+  },
+  { .name = BENCH_WARMUPS_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_WARMUPS_SHORT_OPT
+  },
+  { .name = BENCH_FORMAT_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_FORMAT_SHORT_OPT
+  },
+  { .name = PERF_COUNTERS_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = PERF_COUNTERS_SHORT_OPT
+  },
+  { .name = TEST_FILES_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = TEST_FILES_SHORT_OPT
+  },
+  { .name = BENCH_FILES_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_FILES_SHORT_OPT
+  },
+  { .name = GEN_MATRIX_FILE_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = GEN_MATRIX_FILE_SHORT_OPT
+  },
+  { .name = STREAM_MUL_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = STREAM_MUL_SHORT_OPT
+  },
+  { .name = STREAM_MEMORY_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = STREAM_MEMORY_SHORT_OPT
+  },
+  { .name = BENCH_BATCH_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = BENCH_BATCH_SHORT_OPT
+  },
+  { .name = BENCH_PADDING_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = BENCH_PADDING_SHORT_OPT
+  },
+  { .name = VERIFY_ROUNDS_LONG_OPT, .has_arg = 1, .flag = 0,
+    .val = VERIFY_ROUNDS_SHORT_OPT
+  },
+  { .name = GOLD_CHECK_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = GOLD_CHECK_SHORT_OPT
+  },
+  { .name = BENCH_STRUCTURED_LONG_OPT, .has_arg = 0, .flag = 0,
+    .val = BENCH_STRUCTURED_SHORT_OPT
+  },
+
+};
+
+enum { MAX_PERF_SIZES = 32, MAX_GEN_FILES = 8 };
+
+/** Specification of a random matrix file to be generated */
+typedef struct {
+  int nRows, nCols;
+  const char *path;
+} GenFileSpec;
+
+typedef struct {
+  _Bool isErr;
+  _Bool doOutput;
+  _Bool doPredefTests;
+  _Bool doRandomTests;
+  int perfSizes[MAX_PERF_SIZES];
+  int nPerfSizes;
+  int nTrials;
+  int nWarmups;
+  BenchFormat benchFormat;
+  _Bool doPerfCounters;
+  const char *testFiles[2];     //multiplicand and multiplier files
+  const char *benchFiles[2];
+  GenFileSpec genFiles[MAX_GEN_FILES];
+  int nGenFiles;
+  const char *streamFiles[3];   //multiplicand, multiplier and product
+  long streamMemoryMB;
+  int batchCount;               //# of matrices per benchmarked batch
+  _Bool doPaddingBench;
+  int nVerifyRounds;            //rounds of Freivalds' check per product
+  _Bool isGoldCheck;            //verify products against gold instead
+  _Bool doStructuredBench;
+  int nThreads;
+  GemmKernelId gemmKernel;
+  int strassenCrossover;
+} Opts;
+
+/** Return id of micro-kernel variant with name; N_GEMM_KERNELS if none. */
+static GemmKernelId
+getGemmKernelId(const char *name)
+{
+  for (GemmKernelId id = GEMM_KERNEL_AUTO; id < N_GEMM_KERNELS; id++) {
+    if (strcmp(name, getGemmKernelName(id)) == 0) return id;
+  }
+  return N_GEMM_KERNELS;
+}
+
+/** Add the comma-separated sizes in list to opts->perfSizes[]. */
+static void
+addPerfSizes(Opts *opts, const char *list)
+{
+  const char *p = list;
+  while (*p != '\0') {
+    char *end;
+    long size = strtol(p, &end, 10);
+    if (end == p || size <= 0 || opts->nPerfSizes >= MAX_PERF_SIZES ||
+        (*end != ',' && *end != '\0')) {
+      opts->isErr = true;
+      return;
+    }
+    opts->perfSizes[opts->nPerfSizes++] = size;
+    p = (*end == ',') ? end + 1 : end;
+  }
+}
+
+/** Set paths[] to the comma-separated files in list and return their
+ *  #; return -1 if there are more than maxPaths or any is empty.
+ */
+static int
+splitPaths(const char *list, const char *paths[], int maxPaths)
+{
+  char *copy = mallocChk(strlen(list) + 1);  //never freed: used by opts
+  strcpy(copy, list);
+  int nPaths = 0;
+  for (char *p = copy; ; p++) {
+    char *comma = strchr(p, ',');
+    if (comma) *comma = '\0';
+    if (*p == '\0' || nPaths == maxPaths) return -1;
+    paths[nPaths++] = p;
+    if (!comma) break;
+    p = comma;
+  }
+  return nPaths;
+}
+
+/** Set paths[] to the files in list, which is either "A,B" or "A"
+ *  (meaning "A,A"); return false if list is invalid.
+ */
+static _Bool
+getFilePair(const char *list, const char *paths[2])
+{
+  int nPaths = splitPaths(list, paths, 2);
+  if (nPaths == 1) paths[1] = paths[0];
+  return nPaths > 0;
+}
+
+/** Add the file specified by spec of the form RxC:PATH to
+ *  opts->genFiles[].
+ */
+static void
+addGenFile(Opts *opts, const char *spec)
+{
+  int nRows, nCols, nChars = 0;
+  if (opts->nGenFiles >= MAX_GEN_FILES ||
+      sscanf(spec, "%dx%d:%n", &nRows, &nCols, &nChars) != 2 ||
+      nChars == 0 || spec[nChars] == '\0' || nRows <= 0 || nCols <= 0) {
+    opts->isErr = true;
+    return;
+  }
+  opts->genFiles[opts->nGenFiles++] =
+    (GenFileSpec) { .nRows = nRows, .nCols = nCols, .path = &spec[nChars] };
+}
+
 static void
 usage(const char *prog)
 {
-  fatal("usage: %s ( (--%s | -%c) | (--%s | -%c) | (--%s | -%c) | "
-        "(--%s S | -%c S) )+", prog,
+  fatal("usage: %s OPTION+ where OPTION is one of:\n"
+        "  --%s | -%c\n"
+        "  --%s | -%c\n"
+        "  --%s | -%c\n"
+        "  --%s S | -%c S\n"
+        "  --%s S,... | -%c S,...\n"
+        "  --%s N | -%c N   (default 5)\n"
+        "  --%s N | -%c N  (default 1)\n"
+        "  --%s csv|json | -%c csv|json\n"
+        "  --%s | -%c\n"
+        "  --%s A[,B] | -%c A[,B]\n"
+        "  --%s A[,B] | -%c A[,B]\n"
+        "  --%s RxC:PATH | -%c RxC:PATH\n"
+        "  --%s A,B,C | -%c A,B,C\n"
+        "  --%s MB | -%c MB  (default 64)\n"
+        "  --%s N | -%c N\n"
+        "  --%s | -%c\n"
+        "  --%s N | -%c N  (default %d)\n"
+        "  --%s | -%c\n"
+        "  --%s | -%c\n"
+        "  --%s N | -%c N\n"
+        "  --%s K | -%c K   (K is auto, scalar, sse4.1, avx2 or avx512)\n"
+        "  --%s N | -%c N",
+        prog,
         OUTPUT_LONG_OPT, OUTPUT_SHORT_OPT,
         PREDEF_TESTS_LONG_OPT, PREDEF_TESTS_SHORT_OPT,
         RAND_TESTS_LONG_OPT, RAND_TESTS_SHORT_OPT,
-        PERF_MATRIX_SIZE_LONG_OPT, PERF_MATRIX_SIZE_SHORT_OPT);
+        PERF_MATRIX_SIZE_LONG_OPT, PERF_MATRIX_SIZE_SHORT_OPT,
+        BENCH_SIZES_LONG_OPT, BENCH_SIZES_SHORT_OPT,
+        BENCH_TRIALS_LONG_OPT, BENCH_TRIALS_SHORT_OPT,
+        BENCH_WARMUPS_LONG_OPT, BENCH_WARMUPS_SHORT_OPT,
+        BENCH_FORMAT_LONG_OPT, BENCH_FORMAT_SHORT_OPT,
+        PERF_COUNTERS_LONG_OPT, PERF_COUNTERS_SHORT_OPT,
+        TEST_FILES_LONG_OPT, TEST_FILES_SHORT_OPT,
+        BENCH_FILES_LONG_OPT, BENCH_FILES_SHORT_OPT,
+        GEN_MATRIX_FILE_LONG_OPT, GEN_MATRIX_FILE_SHORT_OPT,
+        STREAM_MUL_LONG_OPT, STREAM_MUL_SHORT_OPT,
+        STREAM_MEMORY_LONG_OPT, STREAM_MEMORY_SHORT_OPT,
+        BENCH_BATCH_LONG_OPT, BENCH_BATCH_SHORT_OPT,
+        BENCH_PADDING_LONG_OPT, BENCH_PADDING_SHORT_OPT,
+        VERIFY_ROUNDS_LONG_OPT, VERIFY_ROUNDS_SHORT_OPT, DEFAULT_VERIFY_ROUNDS,
+        GOLD_CHECK_LONG_OPT, GOLD_CHECK_SHORT_OPT,
+        BENCH_STRUCTURED_LONG_OPT, BENCH_STRUCTURED_SHORT_OPT,
+        THREADS_LONG_OPT, THREADS_SHORT_OPT,
+        GEMM_KERNEL_LONG_OPT, GEMM_KERNEL_SHORT_OPT,
+        STRASSEN_CROSSOVER_LONG_OPT, STRASSEN_CROSSOVER_SHORT_OPT);
 }
 
 static Opts
@@ -603,7 +3839,14 @@ getOpts(int argc, const char *argv[])
 {
   const char shortOpts[] = SHORT_OPTS;
   const char *prog = argv[0];
-  Opts opts = {};
+  Opts opts = {
+    .gemmKernel = GEMM_KERNEL_AUTO,
+    .nTrials = 5,
+    .nWarmups = 1,
+    .benchFormat = BENCH_CSV,
+    .streamMemoryMB = 64,
+    .nVerifyRounds = DEFAULT_VERIFY_ROUNDS,
+  };
   int c;
   while (true) {
     int optIndex = 0;
@@ -619,8 +3862,76 @@ getOpts(int argc, const char *argv[])
     case RAND_TESTS_SHORT_OPT:
       opts.doRandomTests = true;
       break;
-    case  PERF_MATRIX_SIZE_SHORT_OPT:
-      opts.perfMatrixSize = atoi(optarg);
+    case PERF_MATRIX_SIZE_SHORT_OPT:
+    case BENCH_SIZES_SHORT_OPT:
+      addPerfSizes(&opts, optarg);
+      break;
+    case BENCH_TRIALS_SHORT_OPT:
+      opts.nTrials = atoi(optarg);
+      if (opts.nTrials <= 0) opts.isErr = true;
+      break;
+    case BENCH_WARMUPS_SHORT_OPT:
+      opts.nWarmups = atoi(optarg);
+      if (opts.nWarmups < 0) opts.isErr = true;
+      break;
+    case BENCH_FORMAT_SHORT_OPT:
+      if (strcmp(optarg, "csv") == 0) {
+        opts.benchFormat = BENCH_CSV;
+      }
+      else if (strcmp(optarg, "json") == 0) {
+        opts.benchFormat = BENCH_JSON;
+      }
+      else {
+        opts.isErr = true;
+      }
+      break;
+    case PERF_COUNTERS_SHORT_OPT:
+      opts.doPerfCounters = true;
+      break;
+    case TEST_FILES_SHORT_OPT:
+      if (!getFilePair(optarg, opts.testFiles)) opts.isErr = true;
+      break;
+    case BENCH_FILES_SHORT_OPT:
+      if (!getFilePair(optarg, opts.benchFiles)) opts.isErr = true;
+      break;
+    case GEN_MATRIX_FILE_SHORT_OPT:
+      addGenFile(&opts, optarg);
+      break;
+    case STREAM_MUL_SHORT_OPT:
+      if (splitPaths(optarg, opts.streamFiles, 3) != 3) opts.isErr = true;
+      break;
+    case STREAM_MEMORY_SHORT_OPT:
+      opts.streamMemoryMB = atol(optarg);
+      if (opts.streamMemoryMB <= 0) opts.isErr = true;
+      break;
+    case BENCH_BATCH_SHORT_OPT:
+      opts.batchCount = atoi(optarg);
+      if (opts.batchCount <= 0) opts.isErr = true;
+      break;
+    case BENCH_PADDING_SHORT_OPT:
+      opts.doPaddingBench = true;
+      break;
+    case VERIFY_ROUNDS_SHORT_OPT:
+      opts.nVerifyRounds = atoi(optarg);
+      if (opts.nVerifyRounds <= 0) opts.isErr = true;
+      break;
+    case GOLD_CHECK_SHORT_OPT:
+      opts.isGoldCheck = true;
+      break;
+    case BENCH_STRUCTURED_SHORT_OPT:
+      opts.doStructuredBench = true;
+      break;
+    case THREADS_SHORT_OPT:
+      opts.nThreads = atoi(optarg);
+      if (opts.nThreads <= 0) opts.isErr = true;
+      break;
+    case GEMM_KERNEL_SHORT_OPT:
+      opts.gemmKernel = getGemmKernelId(optarg);
+      if (opts.gemmKernel == N_GEMM_KERNELS) opts.isErr = true;
+      break;
+    case STRASSEN_CROSSOVER_SHORT_OPT:
+      opts.strassenCrossover = atoi(optarg);
+      if (opts.strassenCrossover <= 0) opts.isErr = true;
       break;
     case '?':
       opts.isErr = true;
@@ -641,9 +3952,62 @@ main(int argc, const char *argv[])
     usage(argv[0]);
   }
   else {
+    if (opts.nThreads > 0) setThreadPoolSize(opts.nThreads);
+    verifyMode.nRounds = opts.nVerifyRounds;
+    verifyMode.isGold = opts.isGoldCheck;
+    if (!setGemmKernel(opts.gemmKernel)) {
+      fatal("%s kernel not supported on this processor",
+            getGemmKernelName(opts.gemmKernel));
+    }
+    if (opts.strassenCrossover > 0) {
+      int err = 0;
+      setStrassenCrossover(opts.strassenCrossover, &err);
+    }
+    for (int i = 0; i < opts.nGenFiles; i++) {
+      genMatrixFile(opts.genFiles[i].nRows, opts.genFiles[i].nCols,
+                    opts.genFiles[i].path);
+    }
     if (opts.doPredefTests) doPredefinedTests(stdout, opts.doOutput);
     if (opts.doRandomTests) doRandomTests(stdout, opts.doOutput);
-    if (opts.perfMatrixSize > 0) doPerformanceTests(opts.perfMatrixSize);
+    if (opts.testFiles[0]) {
+      doFileTests(stdout, opts.doOutput, opts.testFiles);
+    }
+    if (opts.nPerfSizes > 0 || opts.benchFiles[0] || opts.streamFiles[0] ||
+        opts.batchCount > 0 || opts.doPaddingBench ||
+        opts.doStructuredBench) {
+      PerfCounters *counters = NULL;
+      if (opts.doPerfCounters) {
+        int err = 0;
+        counters = newPerfCounters(&err);
+        if (err) {
+          fprintf(stderr, "hardware counters not available: %s; "
+                  "counter metrics will be empty\n", strerror(err));
+        }
+        //the counters only follow threads created after they are
+        //opened, so restart any pool workers started by the tests
+        setThreadPoolSize(getThreadPoolSize());
+      }
+      BenchReport report;
+      beginBenchReport(&report, stdout, opts.benchFormat, opts.doPerfCounters);
+      BenchParams params = {
+        .nWarmups = opts.nWarmups, .nTrials = opts.nTrials, .report = &report,
+        .counters = counters,
+      };
+      doPerformanceTests(&params, opts.perfSizes, opts.nPerfSizes);
+      if (opts.benchFiles[0]) doFilePerfTests(&params, opts.benchFiles);
+      if (opts.streamFiles[0]) {
+        doStreamMulPerfTest(&params, opts.streamFiles,
+                            (size_t)opts.streamMemoryMB << 20);
+      }
+      if (opts.batchCount > 0) doBatchPerfTests(&params, opts.batchCount);
+      if (opts.doPaddingBench) doPaddingPerfTests(&params);
+      if (opts.doStructuredBench) {
+        doStructuredPerfTests(&params);
+        doSymmetricPerfTests(&params);
+      }
+      endBenchReport(&report);
+      if (counters) freePerfCounters(counters);
+    }
   }
   exit(getErrorCount() > 0);
 }
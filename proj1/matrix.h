@@ -10,6 +10,29 @@
 /** The type of each matrix entry */
 typedef int MatrixBaseType;
 
+/** Numeric ids of the matrix classes, return'd by getKlassId().  Unlike
+ *  the names return'd by getKlass(), these can be compared cheaply and
+ *  used as indexes, allowing reflective code to dispatch on classes
+ *  without string comparisons.  Classes without an id of their own
+ *  (including abstract matrices) use MATRIX_KLASS_OTHER.
+ */
+typedef enum {
+  MATRIX_KLASS_OTHER,
+  MATRIX_KLASS_DENSE,
+  MATRIX_KLASS_SMART_MUL,
+  MATRIX_KLASS_BLOCKED_MUL,
+  MATRIX_KLASS_PARALLEL_MUL,
+  MATRIX_KLASS_STRASSEN,
+  MATRIX_KLASS_SPARSE_CSR,
+  MATRIX_KLASS_TRANSPOSE_VIEW,
+  MATRIX_KLASS_SUB_MATRIX_VIEW,
+  MATRIX_KLASS_TRIANGULAR,
+  MATRIX_KLASS_DIAGONAL,
+  MATRIX_KLASS_BAND,
+  MATRIX_KLASS_SYMMETRIC,
+  N_MATRIX_KLASSES
+} MatrixKlassId;
+
 //Forward declaration of incomplete struct
 typedef struct MatrixFns MatrixFns;
 
@@ -73,6 +96,12 @@ struct MatrixFns {
    */
   const char *(*getKlass)(const Matrix *this, int *err);
 
+  /** Return the numeric id of the implementing class; the id of each
+   *  class corresponds to the name return'd by getKlass().  Set *err
+   *  to EINVAL if this matrix is not in a valid state.
+   */
+  MatrixKlassId (*getKlassId)(const Matrix *this, int *err);
+
   /** Free all resources used by this. Set *err to EINVAL if this
    *  matrix is not in a valid state.
    */
@@ -103,6 +132,33 @@ struct MatrixFns {
   void (*setElement)(Matrix *this, int rowIndex, int colIndex,
                      MatrixBaseType element, int *err);
 
+  /** Copy the entries of row rowIndex of this matrix into row[], which
+   *  must have room for getNCols() entries.  Set *err to EINVAL if this
+   *  matrix not in valid state; EDOM if rowIndex not valid for this
+   *  matrix.
+   */
+  void (*getRow)(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                 int *err);
+
+  /** Set the entries of row rowIndex of this matrix from the
+   *  getNCols() entries in row[].  Set *err to EINVAL if this matrix
+   *  not in valid state; EDOM if rowIndex not valid for this matrix.
+   */
+  void (*setRow)(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                 int *err);
+
+  /** If all entries of this matrix are stored in row-major order in
+   *  memory, return a pointer to the entry at [0][0] and set
+   *  *rowStride to the distance (in entries) between the start of
+   *  consecutive rows.  Otherwise return NULL; the entries of this
+   *  matrix can then only be accessed using the other functions.  Set
+   *  *err to EINVAL if this matrix not in valid state.
+   *
+   *  This allows code to work directly on the storage of a matrix
+   *  without knowing its implementing class.
+   */
+  MatrixBaseType *(*getData)(const Matrix *this, int *rowStride, int *err);
+
   /** Set result matrix to transpose of this matrix.  Set *err to EINVAL
    *  if this or result matrix not in valid state; EDOM if dimensions
    *  of this and result are not compatible.
@@ -119,6 +175,22 @@ struct MatrixFns {
   void (*mul)(const Matrix *this, const Matrix *multiplier,
               Matrix *product, int *err);
 
+  /** Set result[] (getNRows() entries) to the product of this matrix
+   *  and the column vector vec[] (getNCols() entries).  result must
+   *  not overlap vec.  Set *err to EINVAL if this matrix not in valid
+   *  state.
+   */
+  void (*mulVec)(const Matrix *this, const MatrixBaseType vec[],
+                 MatrixBaseType result[], int *err);
+
+  /** Set result[] (getNCols() entries) to the product of the row
+   *  vector vec[] (getNRows() entries) and this matrix.  result must
+   *  not overlap vec.  Set *err to EINVAL if this matrix not in valid
+   *  state.
+   */
+  void (*vecMul)(const Matrix *this, const MatrixBaseType vec[],
+                 MatrixBaseType result[], int *err);
+
 };
 
 #endif //ifndef _MATRIX_H_
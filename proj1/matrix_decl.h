@@ -0,0 +1,168 @@
+/** Template for the abstract matrix interface for a single element
+ *  type; see typed_template.h.
+ */
+
+/** The type of each matrix entry */
+typedef TM_TYPE TM_NAME(MatrixBaseType);
+
+//Forward declaration of incomplete struct
+typedef struct TM_NAME(MatrixFns) TM_NAME(MatrixFns);
+
+/** There are different matrix implementations but all concrete matrix
+ *  implementation structs will contain an initial field which is a
+ *  pointer to a struct containing pointers to the different matrix
+ *  functions.
+ *
+ *  Hence a concrete matrix will be represented as a pointer to a
+ *  different struct, but this struct must have MatrixFns *fns as its
+ *  initial member.  The pointer to the concrete struct type can be
+ *  converted to the abstract struct Matrix pointer and back again
+ *  without problems as per section 6.3.2.3, #7 of the n1570 C
+ *  standard (pg. 56, of 4/12/2011 Committee Draft):
+ *
+ *      A pointer to an object type may be converted to a pointer to a
+ *      different object type.  If the resulting pointer is not
+ *      correctly aligned for the referenced type, the behavior is
+ *      undefined.  Otherwise, when converted back again, the result
+ *      shall compare equal to the original pointer.
+ *
+ *  Additionally, it should be possible to use the functions in fns
+ *  simply via the Matrix interface.  Specifically, section 6.7.2.1
+ *  #15 of the n1570 C standard (pg. 115, of 4/12/2011 Committee
+ *  Draft):
+ *
+ *      A pointer to a structure object, suitably converted, points to
+ *      its initial member (...), and vice versa.  There may be
+ *      unnamed padding within a structure object, but not at its
+ *      beginning
+ *
+ */
+typedef struct {
+  const TM_NAME(MatrixFns) *fns;
+} TM_NAME(Matrix);
+
+/** All matrix implementations will implement the interface represented
+ *  by struct MatrixFns: a struct of function pointers.
+ *
+ *  Note that the this matrix represents the receiver (in OOP
+ *  terminology).  The code for each matrix function will cast the
+ *  this pointer to the pointer corresponding to the concrete type.
+ *  However, non-reflective code will access any other or result
+ *  matrices only as abstract struct Matrix pointers (that is the code
+ *  will not assume any specific implementation for other or result
+ *  matrices).
+ *
+ *  A matrix is in an invalid state if its # of rows and cols are
+ *  not positive.
+ *
+ *  All matrix functions have an *err argument used to return an
+ *  error-code: 0 means no error.
+ *
+ */
+struct TM_NAME(MatrixFns) {
+
+  /** Return a string containing name of implementing class.
+   *  Set *err to EINVAL if this matrix is not in a valid state.  This
+   *  function allows the use of reflective code which can take
+   *  action based on the implementing class.
+   */
+  const char *(*getKlass)(const TM_NAME(Matrix) *this, int *err);
+
+  /** Return the numeric id of the implementing class; the id of each
+   *  class corresponds to the name return'd by getKlass().  Set *err
+   *  to EINVAL if this matrix is not in a valid state.
+   */
+  MatrixKlassId (*getKlassId)(const TM_NAME(Matrix) *this, int *err);
+
+  /** Free all resources used by this. Set *err to EINVAL if this
+   *  matrix is not in a valid state.
+   */
+  void (*free)(TM_NAME(Matrix) *this, int *err);
+
+  /** Return # of rows of this matrix.  Set *err to EINVAL if this matrix
+   *  not in valid state.
+   */
+  int (*getNRows)(const TM_NAME(Matrix) *this, int *err);
+
+  /** Return # of columns of matrix. Set *err to EINVAL if this matrix
+   *  not in valid state.
+   */
+  int (*getNCols)(const TM_NAME(Matrix) *this, int *err);
+
+  /** Return element of this matrix entry at row rowIndex, col colIndex.
+   *  Set *err to EINVAL if this matrix not in valid state; EDOM if rowIndex
+   *  or colIndex not valid for this matrix.
+   */
+  TM_TYPE (*getElement)(const TM_NAME(Matrix) *this,
+                        int rowIndex, int colIndex, int *err);
+
+  /** Set entry of this matrix entry at row rowIndex, col colIndex to
+   *  element. Set *err to EINVAL if this matrix not in valid state; EDOM
+   *  if rowIndex or colIndex not valid for this matrix.
+
+   */
+  void (*setElement)(TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                     TM_TYPE element, int *err);
+
+  /** Copy the entries of row rowIndex of this matrix into row[], which
+   *  must have room for getNCols() entries.  Set *err to EINVAL if this
+   *  matrix not in valid state; EDOM if rowIndex not valid for this
+   *  matrix.
+   */
+  void (*getRow)(const TM_NAME(Matrix) *this, int rowIndex, TM_TYPE row[],
+                 int *err);
+
+  /** Set the entries of row rowIndex of this matrix from the
+   *  getNCols() entries in row[].  Set *err to EINVAL if this matrix
+   *  not in valid state; EDOM if rowIndex not valid for this matrix.
+   */
+  void (*setRow)(TM_NAME(Matrix) *this, int rowIndex, const TM_TYPE row[],
+                 int *err);
+
+  /** If all entries of this matrix are stored in row-major order in
+   *  memory, return a pointer to the entry at [0][0] and set
+   *  *rowStride to the distance (in entries) between the start of
+   *  consecutive rows.  Otherwise return NULL; the entries of this
+   *  matrix can then only be accessed using the other functions.  Set
+   *  *err to EINVAL if this matrix not in valid state.
+   *
+   *  This allows code to work directly on the storage of a matrix
+   *  without knowing its implementing class.
+   */
+  TM_TYPE *(*getData)(const TM_NAME(Matrix) *this, int *rowStride,
+                      int *err);
+
+  /** Set result matrix to transpose of this matrix.  Set *err to EINVAL
+   *  if this or result matrix not in valid state; EDOM if dimensions
+   *  of this and result are not compatible.
+   */
+  void (*transpose)(const TM_NAME(Matrix) *this, TM_NAME(Matrix) *result,
+                    int *err);
+
+  /** Set product matrix to result of multiplying this matrix by
+   *  multiplier matrix.  Before ths call, product should be a valid
+   *  matrix; it's entries will be changed to contain the product
+   *  matrix.  Set *err to EINVAL if this, multiplier or product matrix
+   *  not in valid state; EDOM if dimensions of this, multiplier and product
+   *  not compatible.
+   */
+  void (*mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+              TM_NAME(Matrix) *product, int *err);
+
+  /** Set result[] (getNRows() entries) to the product of this matrix
+   *  and the column vector vec[] (getNCols() entries).  result must
+   *  not overlap vec.  Set *err to EINVAL if this matrix not in valid
+   *  state.
+   */
+  void (*mulVec)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                 TM_TYPE result[], int *err);
+
+  /** Set result[] (getNCols() entries) to the product of the row
+   *  vector vec[] (getNRows() entries) and this matrix.  result must
+   *  not overlap vec.  Set *err to EINVAL if this matrix not in valid
+   *  state.
+   */
+  void (*vecMul)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                 TM_TYPE result[], int *err);
+
+};
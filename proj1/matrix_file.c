@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "matrix_file.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(MatrixFileHeader) == MATRIX_FILE_ALIGN,
+               "matrix file header must fill one alignment unit");
+
+size_t
+getMatrixFileSize(const MatrixFileHeader *header, int *err)
+{
+  uint64_t nElements, size;
+  if (header->nRows == 0 ||
+      __builtin_mul_overflow(header->nRows - 1, header->rowStride,
+                             &nElements) ||
+      __builtin_add_overflow(nElements, header->nCols, &nElements) ||
+      __builtin_mul_overflow(nElements, header->elemSize, &size) ||
+      __builtin_add_overflow(size, header->dataOffset, &size) ||
+      size > SIZE_MAX || size > INT64_MAX) {
+    *err = EINVAL;
+    return 0;
+  }
+  return size;
+}
+
+void
+readMatrixFileHeader(int fd, MatrixFileHeader *header, int *err)
+{
+  ssize_t n = pread(fd, header, sizeof(MatrixFileHeader), 0);
+  if (n < 0) {
+    *err = errno;
+    return;
+  }
+  if (n != sizeof(MatrixFileHeader) ||
+      memcmp(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != MATRIX_FILE_VERSION ||
+      header->byteOrder != MATRIX_FILE_BYTE_ORDER ||
+      header->elemType != MATRIX_FILE_INT32 ||
+      header->elemSize != sizeof(MatrixBaseType) ||
+      header->nRows == 0 || header->nRows > INT32_MAX ||
+      header->nCols == 0 || header->nCols > INT32_MAX ||
+      header->rowStride < header->nCols || header->rowStride > INT32_MAX ||
+      header->dataOffset < sizeof(MatrixFileHeader) ||
+      header->dataOffset % MATRIX_FILE_ALIGN != 0) {
+    *err = EINVAL;
+    return;
+  }
+  struct stat stats;
+  if (fstat(fd, &stats) < 0) {
+    *err = errno;
+    return;
+  }
+  if ((uint64_t)stats.st_size < header->dataOffset) {
+    *err = EINVAL;
+    return;
+  }
+  size_t size = getMatrixFileSize(header, err);
+  if (*err == EINVAL) return;
+  if ((uint64_t)stats.st_size < size) *err = EINVAL;
+}
+
+void
+saveMatrixFile(const Matrix *matrix, const char *path, int *err)
+{
+  const int nRows = matrix->fns->getNRows(matrix, err);
+  if (*err == EINVAL) return;
+  const int nCols = matrix->fns->getNCols(matrix, err);
+  if (*err == EINVAL) return;
+  MatrixFileHeader header = {
+    .magic = MATRIX_FILE_MAGIC,
+    .version = MATRIX_FILE_VERSION,
+    .byteOrder = MATRIX_FILE_BYTE_ORDER,
+    .elemType = MATRIX_FILE_INT32,
+    .elemSize = sizeof(MatrixBaseType),
+    .nRows = nRows,
+    .nCols = nCols,
+    .rowStride = nCols,
+    .dataOffset = sizeof(MatrixFileHeader),
+  };
+
+  // Write rows directly from the matrix storage if possible; otherwise
+  // go through a buffer
+  int ld;
+  const MatrixBaseType *data = matrix->fns->getData(matrix, &ld, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *buf = NULL;
+  if (!data) {
+    buf = malloc(nCols*sizeof(MatrixBaseType));
+    if (!buf) {
+      *err = ENOMEM;
+      return;
+    }
+  }
+  FILE *out = fopen(path, "wb");
+  if (!out) {
+    *err = errno;
+    free(buf);
+    return;
+  }
+  _Bool isOk = fwrite(&header, sizeof(header), 1, out) == 1;
+  for (int r = 0; isOk && r < nRows; r++) {
+    const MatrixBaseType *row;
+    if (data) {
+      row = &data[(size_t)r*ld];
+    }
+    else {
+      matrix->fns->getRow(matrix, r, buf, err);
+      if (*err == EINVAL || *err == EDOM) break;
+      row = buf;
+    }
+    isOk = fwrite(row, sizeof(MatrixBaseType), nCols, out) == (size_t)nCols;
+  }
+  if (!isOk && !*err) *err = errno;
+  if (fclose(out) != 0 && !*err) *err = errno;
+  free(buf);
+}
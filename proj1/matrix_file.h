@@ -0,0 +1,60 @@
+#ifndef _MATRIX_FILE_H
+#define _MATRIX_FILE_H
+
+#include "matrix.h"
+
+#include <stdint.h>
+
+/** Binary matrix file format.  A file consists of a fixed-size header
+ *  followed, at offset dataOffset, by nRows rows of nCols entries in
+ *  row-major order with rowStride entries between the starts of
+ *  successive rows.  All header fields and entries are stored in the
+ *  byte order of the machine which wrote the file.  dataOffset is a
+ *  multiple of MATRIX_FILE_ALIGN, so the entries are suitably aligned
+ *  for SIMD loads when the file is mapped into memory.
+ */
+
+#define MATRIX_FILE_MAGIC "MATRIX\0\0"   //8 bytes including NULs
+#define MATRIX_FILE_VERSION 1
+#define MATRIX_FILE_BYTE_ORDER 0x01020304
+enum { MATRIX_FILE_ALIGN = 64 };
+
+/** Type of the entries in a matrix file */
+typedef enum {
+  MATRIX_FILE_INT32 = 1,
+} MatrixFileElemType;
+
+typedef struct {
+  char magic[8];                //MATRIX_FILE_MAGIC
+  uint32_t version;             //MATRIX_FILE_VERSION
+  uint32_t byteOrder;           //MATRIX_FILE_BYTE_ORDER as written
+  uint32_t elemType;            //a MatrixFileElemType
+  uint32_t elemSize;            //# of bytes in each entry
+  uint64_t nRows;
+  uint64_t nCols;
+  uint64_t rowStride;           //in entries; >= nCols
+  uint64_t dataOffset;          //in bytes from start of file
+  uint8_t reserved[8];          //0; pads header to MATRIX_FILE_ALIGN
+} MatrixFileHeader;
+
+/** Read and validate the header of the matrix file open on fd into
+ *  *header, and check that the file is large enough to contain all
+ *  the entries described by the header.  Set *err to EINVAL if the
+ *  file is not a valid matrix file or its entries are not of type
+ *  MatrixBaseType, else to errno if the file cannot be read.
+ */
+void readMatrixFileHeader(int fd, MatrixFileHeader *header, int *err);
+
+/** Return the total # of bytes in a matrix file with header.  Set *err
+ *  to EINVAL and return 0 if the size cannot be represented.
+ */
+size_t getMatrixFileSize(const MatrixFileHeader *header, int *err);
+
+/** Write matrix to a new matrix file at path, replacing any existing
+ *  file.  Rows are stored without padding.  Set *err to errno if the
+ *  file cannot be written, to ENOMEM if not enough memory, or to the
+ *  error from accessing matrix.
+ */
+void saveMatrixFile(const Matrix *matrix, const char *path, int *err);
+
+#endif //ifndef _MATRIX_FILE_H
@@ -0,0 +1,124 @@
+#include "mul_dispatch.h"
+#include "gemm_kernel.h"
+#include "structured_matrix.h"
+#include "symmetric_matrix.h"
+#include "transpose_view.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+/** Classes whose instances provide row-major storage (unless they are
+ *  views of matrices which do not)
+ */
+static const MatrixKlassId storageKlasses[] = {
+  MATRIX_KLASS_DENSE,
+  MATRIX_KLASS_SMART_MUL,
+  MATRIX_KLASS_BLOCKED_MUL,
+  MATRIX_KLASS_PARALLEL_MUL,
+  MATRIX_KLASS_STRASSEN,
+  MATRIX_KLASS_SUB_MATRIX_VIEW,
+};
+
+/** Classes which store only the entries within a structure */
+static const MatrixKlassId structuredKlasses[] = {
+  MATRIX_KLASS_TRIANGULAR,
+  MATRIX_KLASS_DIAGONAL,
+  MATRIX_KLASS_BAND,
+};
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+//indexed by the ids of the multiplicand, multiplier and product classes
+static MulKernelFn
+kernels[N_MATRIX_KLASSES][N_MATRIX_KLASSES][N_MATRIX_KLASSES];
+
+/** Multiply directly on the storage of all the matrices */
+static _Bool
+mulStorage(const Matrix *this, const Matrix *multiplier, Matrix *product,
+           int *err)
+{
+  int lda, ldb, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return false;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return false;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return false;
+  if (!a || !b || !c) return false;
+  const int m = this->fns->getNRows(this, err);
+  const int n = this->fns->getNCols(this, err);
+  const int p = multiplier->fns->getNCols(multiplier, err);
+  gemmBlocked(m, n, p, a, lda, b, ldb, c, ldc);
+  return true;
+}
+
+/** Multiply by a transpose view using the storage of its base, whose
+ *  rows are the columns of the multiplier.
+ */
+static _Bool
+mulStorageTransB(const Matrix *this, const Matrix *multiplier,
+                 Matrix *product, int *err)
+{
+  const Matrix *base = getTransposeViewBase(multiplier);
+  if (!base) return false;
+  int lda, ldb, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return false;
+  const MatrixBaseType *bt = base->fns->getData(base, &ldb, err);
+  if (*err == EINVAL) return false;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return false;
+  if (!a || !bt || !c) return false;
+  const int m = this->fns->getNRows(this, err);
+  const int n = this->fns->getNCols(this, err);
+  const int p = multiplier->fns->getNCols(multiplier, err);
+  gemmTransB(m, n, p, a, lda, bt, ldb, c, ldc);
+  return true;
+}
+
+/** Register the default kernels; run once, by the first call to
+ *  setMulKernel() or getMulKernel().
+ */
+static void
+initMulKernels(void)
+{
+  const int nKlasses = sizeof(storageKlasses)/sizeof(storageKlasses[0]);
+  const int nStructured =
+    sizeof(structuredKlasses)/sizeof(structuredKlasses[0]);
+  for (int i = 0; i < nKlasses; i++) {
+    for (int k = 0; k < nKlasses; k++) {
+      const MatrixKlassId a = storageKlasses[i], c = storageKlasses[k];
+      for (int j = 0; j < nKlasses; j++) {
+        kernels[a][storageKlasses[j]][c] = mulStorage;
+      }
+      kernels[a][MATRIX_KLASS_TRANSPOSE_VIEW][c] = mulStorageTransB;
+      for (int j = 0; j < nStructured; j++) {
+        kernels[a][structuredKlasses[j]][c] = mulByStructuredMatrix;
+      }
+      kernels[a][MATRIX_KLASS_SYMMETRIC][c] = mulBySymmetricMatrix;
+    }
+  }
+}
+
+void
+setMulKernel(MatrixKlassId thisId, MatrixKlassId multiplierId,
+             MatrixKlassId productId, MulKernelFn kernel)
+{
+  pthread_once(&initOnce, initMulKernels);
+  kernels[thisId][multiplierId][productId] = kernel;
+}
+
+MulKernelFn
+getMulKernel(const Matrix *this, const Matrix *multiplier,
+             const Matrix *product, int *err)
+{
+  pthread_once(&initOnce, initMulKernels);
+  const MatrixKlassId thisId = this->fns->getKlassId(this, err);
+  if (*err == EINVAL) return NULL;
+  const MatrixKlassId multiplierId =
+    multiplier->fns->getKlassId(multiplier, err);
+  if (*err == EINVAL) return NULL;
+  const MatrixKlassId productId = product->fns->getKlassId(product, err);
+  if (*err == EINVAL) return NULL;
+  return kernels[thisId][multiplierId][productId];
+}
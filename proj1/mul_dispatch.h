@@ -0,0 +1,48 @@
+#ifndef _MUL_DISPATCH_H
+#define _MUL_DISPATCH_H
+
+#include "matrix.h"
+
+/** Registry of multiplication kernels keyed by the classes (see
+ *  getKlassId() in matrix.h) of the multiplicand, multiplier and
+ *  product.  Multiplications which would otherwise fall back to the
+ *  generic algorithm in abstract_matrix.c look up the kernel for
+ *  their classes here first, so that operands of different concrete
+ *  classes can still be multiplied by a specialized kernel.
+ *
+ *  Initially, every combination of classes which provide row-major
+ *  storage (dense matrices and their sub-classes, and sub-matrix
+ *  views) is multiplied by the cache-blocked kernel directly on that
+ *  storage, as is any such multiplicand and product with a transpose
+ *  view multiplier.  Such a multiplicand and product with a
+ *  triangular, diagonal or band multiplier use
+ *  mulByStructuredMatrix(), which skips the structural zeros, and
+ *  with a symmetric multiplier, mulBySymmetricMatrix().
+ */
+
+/** Set product to this * multiplier, whose dimensions have already
+ *  been checked.  Return false without changing product if the
+ *  kernel does not apply to these particular matrices (for example,
+ *  because a view does not provide storage after all), in which case
+ *  the caller falls back to the generic algorithm.
+ */
+typedef _Bool (*MulKernelFn)(const Matrix *this, const Matrix *multiplier,
+                             Matrix *product, int *err);
+
+/** Register kernel for multiplying a thisId multiplicand by a
+ *  multiplierId multiplier into a productId product, replacing any
+ *  kernel previously registered for those classes.  If kernel is
+ *  NULL, then such multiplications use the generic algorithm.  Must
+ *  not be called while multiplications are running in other threads.
+ */
+void setMulKernel(MatrixKlassId thisId, MatrixKlassId multiplierId,
+                  MatrixKlassId productId, MulKernelFn kernel);
+
+/** Return the kernel registered for the classes of this, multiplier
+ *  and product; NULL if there is none.  Set *err to EINVAL if any of
+ *  the matrices is not in a valid state.
+ */
+MulKernelFn getMulKernel(const Matrix *this, const Matrix *multiplier,
+                         const Matrix *product, int *err);
+
+#endif //ifndef _MUL_DISPATCH_H
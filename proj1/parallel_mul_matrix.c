@@ -0,0 +1,265 @@
+#include "dense_matrix.h"
+#include "gemm_kernel.h"
+#include "parallel_mul_matrix.h"
+#include "thread_pool.h"
+#include "transpose_kernel.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+typedef struct {
+  DenseMatrix;
+} ParallelMulMatrixImpl;
+
+/** Arguments for multiplying a band of rows */
+typedef struct {
+  int n, p;
+  const MatrixBaseType *a;
+  int lda;
+  const MatrixBaseType *b;
+  int ldb;
+  MatrixBaseType *c;
+  int ldc;
+} MulBand;
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  return "parallelMulMatrix";
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  return MATRIX_KLASS_PARALLEL_MUL;
+}
+
+static void mulBand(void *arg, int begin, int end)
+{
+  const MulBand *band = arg;
+  gemmBlocked(end - begin, band->n, band->p,
+              &band->a[(size_t)begin*band->lda], band->lda,
+              band->b, band->ldb,
+              &band->c[(size_t)begin*band->ldc], band->ldc);
+}
+
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of all the matrices
+  MulBand band = { .n = this_n, .p = pr_p };
+  band.a = this->fns->getData(this, &band.lda, err);
+  if (*err == EINVAL) return;
+  band.b = multiplier->fns->getData(multiplier, &band.ldb, err);
+  if (*err == EINVAL) return;
+  band.c = product->fns->getData(product, &band.ldc, err);
+  if (*err == EINVAL) return;
+  if (!band.a || !band.b || !band.c) {
+    getDenseMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+
+  // Use a few bands per thread to even out the load
+  enum { MIN_BAND_ROWS = 8 };
+  int bandRows = pr_m/(4*getThreadPoolSize());
+  if (bandRows < MIN_BAND_ROWS) bandRows = MIN_BAND_ROWS;
+  parallelFor(pr_m, bandRows, mulBand, &band);
+}
+
+/** Arguments for a matrix-vector product over bands of rows or columns */
+typedef struct {
+  int m, n;
+  const MatrixBaseType *a;
+  int lda;
+  const MatrixBaseType *x;
+  MatrixBaseType *y;
+} VecBand;
+
+static void mulVecBand(void *arg, int begin, int end)
+{
+  const VecBand *band = arg;
+  gemv(end - begin, band->n, &band->a[(size_t)begin*band->lda], band->lda,
+       band->x, &band->y[begin]);
+}
+
+/** Each band of columns of the product is independent of the others,
+ *  so no reduction is needed across threads.
+ */
+static void vecMulBand(void *arg, int begin, int end)
+{
+  const VecBand *band = arg;
+  gemvTrans(band->m, end - begin, &band->a[begin], band->lda,
+            band->x, &band->y[begin]);
+}
+
+/** Return the grain for splitting n rows or columns of matrix-vector
+ *  product; the bands are large enough to amortize the dispatch since
+ *  each entry of the matrix is only used once.
+ */
+static int getVecBandSize(int n)
+{
+  enum { MIN_VEC_BAND = 64 };
+  int bandSize = n/(4*getThreadPoolSize());
+  return (bandSize < MIN_VEC_BAND) ? MIN_VEC_BAND : bandSize;
+}
+
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  VecBand band = { .x = vec, .y = result };
+  band.m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  band.n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  band.a = this->fns->getData(this, &band.lda, err);
+  if (*err == EINVAL) return;
+  if (!band.a) {
+    getDenseMatrixFns()->mulVec(this, vec, result, err);
+    return;
+  }
+  parallelFor(band.m, getVecBandSize(band.m), mulVecBand, &band);
+}
+
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  VecBand band = { .x = vec, .y = result };
+  band.m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  band.n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  band.a = this->fns->getData(this, &band.lda, err);
+  if (*err == EINVAL) return;
+  if (!band.a) {
+    getDenseMatrixFns()->vecMul(this, vec, result, err);
+    return;
+  }
+  parallelFor(band.n, getVecBandSize(band.n), vecMulBand, &band);
+}
+
+/** Arguments for transposing a band of rows */
+typedef struct {
+  int n;
+  const MatrixBaseType *a;
+  int lda;
+  MatrixBaseType *c;
+  int ldc;
+} TransposeBand;
+
+/** Rows [begin, end) of this become columns [begin, end) of result */
+static void transposeBand(void *arg, int begin, int end)
+{
+  const TransposeBand *band = arg;
+  transposeRecursive(end - begin, band->n, &band->a[(size_t)begin*band->lda],
+                     band->lda, &band->c[begin], band->ldc);
+}
+
+static void transpose(const Matrix *this, Matrix *result, int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == result_m && this_n == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited transpose unless we can get at the
+  // storage of both matrices
+  TransposeBand band = { .n = this_n };
+  band.a = this->fns->getData(this, &band.lda, err);
+  if (*err == EINVAL) return;
+  band.c = result->fns->getData(result, &band.ldc, err);
+  if (*err == EINVAL) return;
+  if (!band.a || !band.c) {
+    getDenseMatrixFns()->transpose(this, result, err);
+    return;
+  }
+
+  // Bands are a multiple of the tile size used by transposeRecursive()
+  enum { MIN_BAND_ROWS = 32 };
+  int bandRows = this_m/(4*getThreadPoolSize());
+  bandRows = (bandRows < MIN_BAND_ROWS) ? MIN_BAND_ROWS
+    : bandRows - bandRows % MIN_BAND_ROWS;
+  parallelFor(this_m, bandRows, transposeBand, &band);
+}
+
+static _Bool isInit = false;
+static ParallelMulMatrixFns parallelMulMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .transpose = transpose,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
+};
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a multi-threaded multiplication algorithm.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+ParallelMulMatrix *
+newParallelMulMatrix(int nRows, int nCols, int *err)
+{
+  ParallelMulMatrixImpl *matrix =
+    (ParallelMulMatrixImpl *)newDenseMatrix(nRows, nCols, err);
+  if (*err == EINVAL || *err == ENOMEM) return NULL;
+
+  matrix->fns = (MatrixFns *)getParallelMulMatrixFns();
+  return (ParallelMulMatrix *)matrix;
+}
+
+static void patchParallelMulMatrixFns(void)
+{
+  if (!isInit) {
+    const DenseMatrixFns *fns = getDenseMatrixFns();
+    parallelMulMatrixFns.free = fns->free;
+    parallelMulMatrixFns.getNRows = fns->getNRows;
+    parallelMulMatrixFns.getNCols = fns->getNCols;
+    parallelMulMatrixFns.getElement = fns->getElement;
+    parallelMulMatrixFns.setElement = fns->setElement;
+    parallelMulMatrixFns.getRow = fns->getRow;
+    parallelMulMatrixFns.setRow = fns->setRow;
+    parallelMulMatrixFns.getData = fns->getData;
+    isInit = true;
+  }
+}
+
+/** Return implementation of functions for a parallel multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const ParallelMulMatrixFns *
+getParallelMulMatrixFns(void)
+{
+  patchParallelMulMatrixFns();
+  return &parallelMulMatrixFns;
+}
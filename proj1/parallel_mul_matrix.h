@@ -0,0 +1,34 @@
+#ifndef _PARALLEL_MUL_MATRIX_H
+#define _PARALLEL_MUL_MATRIX_H
+
+#include "matrix.h"
+
+typedef struct ParallelMulMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} ParallelMulMatrixFns;
+
+typedef struct ParallelMulMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} ParallelMulMatrix;
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a multi-threaded multiplication algorithm: the rows of the
+ *  product are split into bands which are computed in parallel
+ *  using the cache-blocked kernel on the threads of the thread pool
+ *  (see thread_pool.h for setting the # of threads).  Transposes and
+ *  matrix-vector products are split into bands in the same way.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+ParallelMulMatrix *newParallelMulMatrix(int nRows, int nCols, int *err);
+
+/** Return implementation of functions for a parallel multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const ParallelMulMatrixFns *getParallelMulMatrixFns(void);
+
+#endif //ifndef _PARALLEL_MUL_MATRIX_H
@@ -0,0 +1,184 @@
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct PerfCounters {
+  int fds[N_PERF_COUNTERS];     //-1 if counter could not be opened
+};
+
+static const char *counterNames[] = {
+  [PERF_CYCLES] = "cycles",
+  [PERF_INSTRUCTIONS] = "instructions",
+  [PERF_L1D_MISSES] = "l1d-misses",
+  [PERF_LLC_MISSES] = "llc-misses",
+  [PERF_DTLB_MISSES] = "dtlb-misses",
+  [PERF_BRANCH_MISSES] = "branch-misses",
+};
+
+const char *
+getPerfCounterName(PerfCounterId id)
+{
+  return (0 <= id && id < N_PERF_COUNTERS) ? counterNames[id] : "unknown";
+}
+
+#ifdef __linux__
+
+/** Return config for a PERF_TYPE_HW_CACHE read miss event for cache. */
+#define CACHE_READ_MISS(cache) \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct { unsigned type; unsigned long long config; }
+counterEvents[] = {
+  [PERF_CYCLES] =
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  [PERF_INSTRUCTIONS] =
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  [PERF_L1D_MISSES] =
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+  [PERF_LLC_MISSES] =
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+  [PERF_DTLB_MISSES] =
+    { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+  [PERF_BRANCH_MISSES] =
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+/** Open counter id for the calling thread and the threads it creates
+ *  from now on, on any cpu; return fd or -1 with errno set.
+ */
+static int
+openCounter(PerfCounterId id)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = counterEvents[id].type;
+  attr.config = counterEvents[id].config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;      //allowed with perf_event_paranoid <= 2
+  attr.exclude_hv = 1;
+  //count the threads created later (such as pool workers) too; the
+  //kernel adds their counts into those read from the returned fd and
+  //applies the ioctls to them
+  attr.inherit = 1;
+  //the counters are not grouped, so the kernel multiplexes them if
+  //there are too few hardware counters; the enabled and running
+  //times are used to scale the counts.
+  attr.read_format =
+    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters *
+newPerfCounters(int *err)
+{
+  PerfCounters *counters = malloc(sizeof(PerfCounters));
+  if (!counters) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  int firstErr = 0;
+  _Bool isAnyOpen = false;
+  for (int i = 0; i < N_PERF_COUNTERS; i++) {
+    counters->fds[i] = openCounter(i);
+    if (counters->fds[i] >= 0) {
+      isAnyOpen = true;
+    }
+    else if (firstErr == 0) {
+      firstErr = errno;
+    }
+  }
+  if (!isAnyOpen) {
+    free(counters);
+    *err = firstErr;
+    return NULL;
+  }
+  return counters;
+}
+
+void
+freePerfCounters(PerfCounters *counters)
+{
+  for (int i = 0; i < N_PERF_COUNTERS; i++) {
+    if (counters->fds[i] >= 0) close(counters->fds[i]);
+  }
+  free(counters);
+}
+
+/** Apply perf ioctl request to all open counters. */
+static void
+ioctlAll(PerfCounters *counters, unsigned long request)
+{
+  for (int i = 0; i < N_PERF_COUNTERS; i++) {
+    if (counters->fds[i] >= 0) ioctl(counters->fds[i], request, 0);
+  }
+}
+
+void
+resetPerfCounters(PerfCounters *counters)
+{
+  ioctlAll(counters, PERF_EVENT_IOC_RESET);
+}
+
+void
+enablePerfCounters(PerfCounters *counters)
+{
+  ioctlAll(counters, PERF_EVENT_IOC_ENABLE);
+}
+
+void
+disablePerfCounters(PerfCounters *counters)
+{
+  ioctlAll(counters, PERF_EVENT_IOC_DISABLE);
+}
+
+void
+readPerfCounters(const PerfCounters *counters, PerfCounts *counts)
+{
+  for (int i = 0; i < N_PERF_COUNTERS; i++) {
+    counts->isValid[i] = false;
+    counts->values[i] = 0;
+    if (counters->fds[i] < 0) continue;
+    struct { unsigned long long value, timeEnabled, timeRunning; } data;
+    if (read(counters->fds[i], &data, sizeof(data)) != sizeof(data)) continue;
+    if (data.timeRunning == 0) continue;  //never scheduled on the pmu
+    counts->isValid[i] = true;
+    counts->values[i] =
+      (double)data.value * data.timeEnabled / data.timeRunning;
+  }
+}
+
+#else //ifdef __linux__
+
+PerfCounters *
+newPerfCounters(int *err)
+{
+  *err = ENOSYS;
+  return NULL;
+}
+
+void freePerfCounters(PerfCounters *counters) { free(counters); }
+void resetPerfCounters(PerfCounters *counters) { }
+void enablePerfCounters(PerfCounters *counters) { }
+void disablePerfCounters(PerfCounters *counters) { }
+
+void
+readPerfCounters(const PerfCounters *counters, PerfCounts *counts)
+{
+  memset(counts, 0, sizeof(PerfCounts));
+}
+
+#endif //ifdef __linux__
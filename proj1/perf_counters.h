@@ -0,0 +1,59 @@
+#ifndef _PERF_COUNTERS_H
+#define _PERF_COUNTERS_H
+
+/** Hardware performance counters for the calling thread and all the
+ *  threads it creates after the counters are opened, read using the
+ *  Linux perf_event_open() interface.  Only user-space events are
+ *  counted.  Thread pool workers are only counted if they are started
+ *  after the counters are opened (see setThreadPoolSize()).
+ */
+
+typedef enum {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  PERF_DTLB_MISSES,
+  PERF_BRANCH_MISSES,
+  N_PERF_COUNTERS
+} PerfCounterId;
+
+/** Counter values read by readPerfCounters() */
+typedef struct {
+  _Bool isValid[N_PERF_COUNTERS];  //false if counter not available
+  double values[N_PERF_COUNTERS];  //scaled if counters were multiplexed
+} PerfCounts;
+
+typedef struct PerfCounters PerfCounters;
+
+/** Return a short name for counter id, e.g. "cycles". */
+const char *getPerfCounterName(PerfCounterId id);
+
+/** Return a newly allocated set of all the counters which can be
+ *  opened on this system; the counters are initially disabled.  Set
+ *  *err to ENOSYS if perf_event_open() is not supported, else to the
+ *  error from opening the cycles counter if no counter could be
+ *  opened (EACCES or EPERM when forbidden by perf_event_paranoid,
+ *  ENOENT when there is no hardware PMU), to ENOMEM if not enough
+ *  memory.
+ */
+PerfCounters *newPerfCounters(int *err);
+
+/** Free all resources used by counters. */
+void freePerfCounters(PerfCounters *counters);
+
+/** Reset all counters to zero. */
+void resetPerfCounters(PerfCounters *counters);
+
+/** Start counting; counts accumulate over successive
+ *  enablePerfCounters() / disablePerfCounters() intervals.
+ */
+void enablePerfCounters(PerfCounters *counters);
+
+/** Stop counting. */
+void disablePerfCounters(PerfCounters *counters);
+
+/** Set *counts to the values accumulated since the last reset. */
+void readPerfCounters(const PerfCounters *counters, PerfCounts *counts);
+
+#endif //ifndef _PERF_COUNTERS_H
@@ -0,0 +1,117 @@
+#include "small_mul_kernel.h"
+
+/** Set c[m][p] to a[m][n] * b[n][p].  This is only called with
+ *  constant m, n and p, and is inlined into each kernel: all the loops
+ *  are then completely unrolled, so that every index is a constant
+ *  and the compiler keeps each entry of acc[][] in a register.
+ */
+static inline __attribute__((always_inline)) void
+mulFixed(int m, int n, int p,
+         const MatrixBaseType *restrict a, int lda,
+         const MatrixBaseType *restrict b, int ldb,
+         MatrixBaseType *restrict c, int ldc)
+{
+  MatrixBaseType acc[SMALL_MUL_MAX][SMALL_MUL_MAX];
+#pragma GCC unroll 8
+  for (int i = 0; i < m; i++) {
+#pragma GCC unroll 8
+    for (int j = 0; j < p; j++) acc[i][j] = 0;
+  }
+#pragma GCC unroll 8
+  for (int k = 0; k < n; k++) {
+#pragma GCC unroll 8
+    for (int i = 0; i < m; i++) {
+      const MatrixBaseType aik = a[i*lda + k];
+#pragma GCC unroll 8
+      for (int j = 0; j < p; j++) acc[i][j] += aik*b[k*ldb + j];
+    }
+  }
+#pragma GCC unroll 8
+  for (int i = 0; i < m; i++) {
+#pragma GCC unroll 8
+    for (int j = 0; j < p; j++) c[i*ldc + j] = acc[i][j];
+  }
+}
+
+/** Set c[m][p] to a[m][n] * b[n][p] a row at a time.  This is only
+ *  called with constant p, and is inlined into each kernel: only the
+ *  loops over p are unrolled, so that the compiler keeps each entry
+ *  of acc[] in a register, while those over m and n are not.
+ */
+static inline __attribute__((always_inline)) void
+mulFixedP(int m, int n, int p,
+          const MatrixBaseType *restrict a, int lda,
+          const MatrixBaseType *restrict b, int ldb,
+          MatrixBaseType *restrict c, int ldc)
+{
+  for (int i = 0; i < m; i++) {
+    MatrixBaseType acc[SMALL_MUL_MAX];
+#pragma GCC unroll 8
+    for (int j = 0; j < p; j++) acc[j] = 0;
+    for (int k = 0; k < n; k++) {
+      const MatrixBaseType aik = a[i*lda + k];
+#pragma GCC unroll 8
+      for (int j = 0; j < p; j++) acc[j] += aik*b[k*ldb + j];
+    }
+#pragma GCC unroll 8
+    for (int j = 0; j < p; j++) c[i*ldc + j] = acc[j];
+  }
+}
+
+/* X-macro which applies X(n) to every dimension in
+ * [SMALL_MUL_MIN, SMALL_MUL_MAX], in increasing order.
+ */
+#define SMALL_SIZES(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8)
+
+#define DEFINE_SMALL_MUL_SQUARE(d)                                      \
+  static void                                                           \
+  smallMul##d##x##d##x##d(int m, int n,                                 \
+                          const MatrixBaseType *a, int lda,             \
+                          const MatrixBaseType *b, int ldb,             \
+                          MatrixBaseType *c, int ldc)                   \
+  {                                                                     \
+    (void)m; (void)n;  /*always d*/                                     \
+    mulFixed(d, d, d, a, lda, b, ldb, c, ldc);                          \
+  }
+
+#define DEFINE_SMALL_MUL_P(p)                                           \
+  static void                                                           \
+  smallMulP##p(int m, int n,                                            \
+               const MatrixBaseType *a, int lda,                        \
+               const MatrixBaseType *b, int ldb,                        \
+               MatrixBaseType *c, int ldc)                              \
+  {                                                                     \
+    mulFixedP(m, n, p, a, lda, b, ldb, c, ldc);                         \
+  }
+
+SMALL_SIZES(DEFINE_SMALL_MUL_SQUARE)
+SMALL_SIZES(DEFINE_SMALL_MUL_P)
+
+enum { N_SMALL_SIZES = SMALL_MUL_MAX - SMALL_MUL_MIN + 1 };
+
+#define SMALL_MUL_SQUARE_ENTRY(d) smallMul##d##x##d##x##d,
+#define SMALL_MUL_P_ENTRY(p) smallMulP##p,
+
+//indexed by the dimension, from SMALL_MUL_MIN
+static const SmallMulFn smallMulSquares[N_SMALL_SIZES] = {
+  SMALL_SIZES(SMALL_MUL_SQUARE_ENTRY)
+};
+static const SmallMulFn smallMulPs[N_SMALL_SIZES] = {
+  SMALL_SIZES(SMALL_MUL_P_ENTRY)
+};
+
+/** Return true iff n is a dimension for which there are kernels */
+static inline _Bool
+isSmallSize(int n)
+{
+  return n >= SMALL_MUL_MIN && n <= SMALL_MUL_MAX;
+}
+
+SmallMulFn
+getSmallMulKernel(int m, int n, int p)
+{
+  if (!isSmallSize(m) || !isSmallSize(n) || !isSmallSize(p)) return NULL;
+  return (m == n && n == p)
+    ? smallMulSquares[n - SMALL_MUL_MIN]
+    : smallMulPs[p - SMALL_MUL_MIN];
+}
@@ -0,0 +1,35 @@
+#ifndef _SMALL_MUL_KERNEL_H
+#define _SMALL_MUL_KERNEL_H
+
+#include "matrix.h"
+
+/** Raw-memory multiplication kernels specialized for the shapes of
+ *  small matrices.  Like the kernels in gemm_kernel.h, matrices are
+ *  described by a pointer to their first element and a leading
+ *  dimension and no error checking is done.
+ *
+ *  There is a kernel for each m x n x p with all of m, n and p in
+ *  [SMALL_MUL_MIN, SMALL_MUL_MAX].  The kernels for square shapes are
+ *  fully unrolled with the whole product held in registers; the others
+ *  are specialized on p only, with each row of the product held in
+ *  registers.  Either way, they have little of the loop overhead which
+ *  dominates the generic algorithms at these sizes.
+ */
+
+enum { SMALL_MUL_MIN = 2, SMALL_MUL_MAX = 8 };
+
+/** Set c[m][p] to a[m][n] * b[n][p] for the m and n passed and the
+ *  p (and, for square kernels, the m and n) fixed by the kernel.  c
+ *  must not overlap a or b.
+ */
+typedef void (*SmallMulFn)(int m, int n,
+                           const MatrixBaseType *a, int lda,
+                           const MatrixBaseType *b, int ldb,
+                           MatrixBaseType *c, int ldc);
+
+/** Return the kernel for multiplying m x n by n x p matrices; NULL if
+ *  there is none for that shape.
+ */
+SmallMulFn getSmallMulKernel(int m, int n, int p);
+
+#endif //ifndef _SMALL_MUL_KERNEL_H
@@ -1,8 +1,14 @@
 #include "dense_matrix.h"
+#include "gemm_kernel.h"
 #include "smart_mul_matrix.h"
+#include "transpose_kernel.h"
+#include "transpose_view.h"
+#include "typed_matrix.h"
+#include "workspace.h"
 
 #include <errno.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 typedef struct {
   DenseMatrix;
@@ -13,6 +19,11 @@ static const char *getKlass(const Matrix *this, int *err)
   return "smartMulMatrix";
 }
 
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  return MATRIX_KLASS_SMART_MUL;
+}
+
 static void mul(const Matrix *this, const Matrix *multiplier,
 		Matrix *product, int *err)
 {
@@ -35,41 +46,85 @@ static void mul(const Matrix *this, const Matrix *multiplier,
     return;
   }
 
-  // Transpose multiplier, so columns are more likely to end up in the cache
-  // NxP -> PxN
-  Matrix *tr_multiplier = (Matrix *)newSmartMulMatrix(mul_p, mul_n, err);
-  if (*err == EINVAL || *err == ENOMEM) return;
-  multiplier->fns->transpose(multiplier, tr_multiplier, err);
-  if (*err == EINVAL || *err == EDOM) {
-    tr_multiplier->fns->free(tr_multiplier, err);
-    return;
+  Workspace *workspace =
+    getDenseMatrixWorkspace((const DenseMatrix *)this, err);
+  if (!workspace) return;
+  MatrixBaseType *buf =
+    getWorkspaceBuffer(workspace, WORKSPACE_ROWS,
+                       (this_n + pr_p)*sizeof(MatrixBaseType), err);
+  if (!buf) return;
+
+  // If the multiplier is a transpose view of a matrix with row-major
+  // storage, then that storage is already the transposed multiplier
+  const MatrixBaseType *trData = NULL;
+  int trLd;
+  const Matrix *viewBase = getTransposeViewBase(multiplier);
+  if (viewBase) {
+    trData = viewBase->fns->getData(viewBase, &trLd, err);
+    if (*err == EINVAL) return;
+  }
+
+  // Otherwise transpose multiplier into scratch memory, so that its
+  // columns become rows which stream through the cache: NxP -> PxN
+  if (!trData) {
+    MatrixBaseType *tr =
+      getWorkspaceBuffer(workspace, WORKSPACE_TRANSPOSE,
+                         (size_t)mul_p*mul_n*sizeof(MatrixBaseType), err);
+    if (!tr) return;
+    trLd = mul_n;
+    int mulLd;
+    const MatrixBaseType *mulData =
+      multiplier->fns->getData(multiplier, &mulLd, err);
+    if (*err == EINVAL) return;
+    if (mulData) {
+      transposeRecursive(mul_n, mul_p, mulData, mulLd, tr, trLd);
+    }
+    else {
+      for (int r = 0; r < mul_n; r++) {
+        multiplier->fns->getRow(multiplier, r, buf, err);
+        if (*err == EINVAL || *err == EDOM) return;
+        for (int c = 0; c < mul_p; c++) tr[(size_t)c*trLd + r] = buf[c];
+      }
+    }
+    trData = tr;
   }
 
+  // Use the rows of this and the product directly if possible;
+  // otherwise go through the row buffer
+  int thisLd, prLd;
+  const MatrixBaseType *thisData = this->fns->getData(this, &thisLd, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *prData = product->fns->getData(product, &prLd, err);
+  if (*err == EINVAL) return;
+
   // Do the multiplication
   for (int pr_r = 0; pr_r < pr_m; pr_r++) {
+    const MatrixBaseType *thisRow;
+    if (thisData) {
+      thisRow = &thisData[(size_t)pr_r*thisLd];
+    }
+    else {
+      this->fns->getRow(this, pr_r, buf, err);
+      if (*err == EINVAL || *err == EDOM) break;
+      thisRow = buf;
+    }
+    MatrixBaseType *prRow = (prData) ? &prData[(size_t)pr_r*prLd] : &buf[this_n];
     for (int pr_c = 0; pr_c < pr_p; pr_c++) {
       // Pr[r][c] <- Sum_i This[r][i]*tr_That[c][i]
-      MatrixBaseType res = 0;
-      for (int i = 0; i < this_n; i++) {
-	MatrixBaseType a = this->fns->getElement(this, pr_r, i, err);
-	if (*err == EINVAL || *err == EDOM) return;
-	MatrixBaseType b = tr_multiplier->fns->getElement(tr_multiplier, pr_c, i, err);
-	if (*err == EINVAL || *err == EDOM) return;
-	res += a*b;
-      }
-      product->fns->setElement(product, pr_r, pr_c, res, err);
-      if (*err == EINVAL || *err == EDOM) return;
+      prRow[pr_c] = dotProduct(this_n, thisRow, &trData[(size_t)pr_c*trLd]);
+    }
+    if (!prData) {
+      product->fns->setRow(product, pr_r, prRow, err);
+      if (*err == EINVAL || *err == EDOM) break;
     }
   }
-
-  // Clean up
-  tr_multiplier->fns->free(tr_multiplier, err);
 }
 
 //TODO: Add types, data and functions as required.
 static _Bool isInit = false;
 static SmartMulMatrixFns smartMulMatrixFns = {
   .getKlass = getKlass,
+  .getKlassId = getKlassId,
   .mul = mul,
 };
 
@@ -78,7 +133,13 @@ static SmartMulMatrixFns smartMulMatrixFns = {
  *  created matrix are initialized to 0.  The return'd matrix uses
  *  a smart multiplication algorithm to avoid caching issues;
  *  specifically, transpose the multiplier and use a modified
- *  multiplication algorithm with the transposed multiplier.
+ *  multiplication algorithm with the transposed multiplier.  The
+ *  transposed multiplier is held in the matrix's workspace (see
+ *  setDenseMatrixWorkspace()), so repeated multiplications with
+ *  multipliers of the same shape do not allocate memory.  If the
+ *  multiplier is a transpose view (see transpose_view.h) of a matrix
+ *  with row-major storage, then that storage is used directly and no
+ *  transpose is done at all.
  *
  *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
  *  memory.
@@ -101,7 +162,12 @@ static void patchSmartMulMatrixFns(void)
     smartMulMatrixFns.getNCols = fns->getNCols;
     smartMulMatrixFns.getElement = fns->getElement;
     smartMulMatrixFns.setElement = fns->setElement;
+    smartMulMatrixFns.getRow = fns->getRow;
+    smartMulMatrixFns.setRow = fns->setRow;
+    smartMulMatrixFns.getData = fns->getData;
     smartMulMatrixFns.transpose = fns->transpose;
+    smartMulMatrixFns.mulVec = fns->mulVec;
+    smartMulMatrixFns.vecMul = fns->vecMul;
     isInit = true;
   }
 }
@@ -116,3 +182,6 @@ getSmartMulMatrixFns(void)
   patchSmartMulMatrixFns();
   return &smartMulMatrixFns;
 }
+
+#define TM_TEMPLATE "smart_mul_matrix_template.h"
+#include "typed_matrix_instances.h"
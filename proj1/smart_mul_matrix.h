@@ -16,7 +16,13 @@ typedef struct SmartMulMatrix {
  *  created matrix are initialized to 0.  The return'd matrix uses
  *  a smart multiplication algorithm to avoid caching issues;
  *  specifically, transpose the multiplier and use a modified
- *  multiplication algorithm with the transposed multiplier.
+ *  multiplication algorithm with the transposed multiplier.  The
+ *  transposed multiplier is held in the matrix's workspace (see
+ *  setDenseMatrixWorkspace()), so repeated multiplications with
+ *  multipliers of the same shape do not allocate memory.  If the
+ *  multiplier is a transpose view (see transpose_view.h) of a matrix
+ *  with row-major storage, then that storage is used directly and no
+ *  transpose is done at all.
  *
  *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
  *  memory.
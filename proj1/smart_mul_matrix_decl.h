@@ -0,0 +1,36 @@
+/** Template for the smart multiplication matrix class for a single
+ *  element type; see typed_template.h.
+ */
+
+typedef struct TM_NAME(SmartMulMatrixFns) {
+  TM_NAME(MatrixFns); //-fms-extensions inserts MatrixFns fields into struct
+} TM_NAME(SmartMulMatrixFns);
+
+typedef struct TM_NAME(SmartMulMatrix) {
+  TM_NAME(Matrix);    //-fms-extensions inserts Matrix fields into struct
+} TM_NAME(SmartMulMatrix);
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a smart multiplication algorithm to avoid caching issues;
+ *  specifically, transpose the multiplier and use a modified
+ *  multiplication algorithm with the transposed multiplier.  The
+ *  transposed multiplier is held in the matrix's workspace (see
+ *  setDenseMatrixWorkspace()), so repeated multiplications with
+ *  multipliers of the same shape do not allocate memory.  If the
+ *  multiplier is a transpose view (see transpose_view.h) of a matrix
+ *  with row-major storage, then that storage is used directly and no
+ *  transpose is done at all.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+TM_NAME(SmartMulMatrix) *TM_NAME(newSmartMulMatrix)(int nRows, int nCols,
+                                                    int *err);
+
+/** Return implementation of functions for a smart multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const TM_NAME(SmartMulMatrixFns) *TM_NAME(getSmartMulMatrixFns)(void);
@@ -0,0 +1,183 @@
+/** Template for the implementation of the smart multiplication matrix
+ *  class for a single element type; see typed_template.h.
+ */
+
+typedef struct {
+  TM_NAME(DenseMatrix);
+} TM_NAME(SmartMulMatrixImpl);
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  return "smartMulMatrix" TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  return MATRIX_KLASS_SMART_MUL;
+}
+
+static void
+TM_NAME(mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+             TM_NAME(Matrix) *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  Workspace *workspace =
+    TM_NAME(getDenseMatrixWorkspace)((const TM_NAME(DenseMatrix) *)this, err);
+  if (!workspace) return;
+  TM_TYPE *buf =
+    getWorkspaceBuffer(workspace, WORKSPACE_ROWS,
+                       (this_n + pr_p)*sizeof(TM_TYPE), err);
+  if (!buf) return;
+
+  // If the multiplier is a transpose view of a matrix with row-major
+  // storage, then that storage is already the transposed multiplier
+  const TM_TYPE *trData = NULL;
+  int trLd;
+  const TM_NAME(Matrix) *viewBase = TM_NAME(getTransposeViewBase)(multiplier);
+  if (viewBase) {
+    trData = viewBase->fns->getData(viewBase, &trLd, err);
+    if (*err == EINVAL) return;
+  }
+
+  // Otherwise transpose multiplier into scratch memory, so that its
+  // columns become rows which stream through the cache: NxP -> PxN
+  if (!trData) {
+    TM_TYPE *tr =
+      getWorkspaceBuffer(workspace, WORKSPACE_TRANSPOSE,
+                         (size_t)mul_p*mul_n*sizeof(TM_TYPE), err);
+    if (!tr) return;
+    trLd = mul_n;
+    int mulLd;
+    const TM_TYPE *mulData =
+      multiplier->fns->getData(multiplier, &mulLd, err);
+    if (*err == EINVAL) return;
+    if (mulData) {
+      TM_NAME(transposeRecursive)(mul_n, mul_p, mulData, mulLd, tr, trLd);
+    }
+    else {
+      for (int r = 0; r < mul_n; r++) {
+        multiplier->fns->getRow(multiplier, r, buf, err);
+        if (*err == EINVAL || *err == EDOM) return;
+        for (int c = 0; c < mul_p; c++) tr[(size_t)c*trLd + r] = buf[c];
+      }
+    }
+    trData = tr;
+  }
+
+  // Use the rows of this and the product directly if possible;
+  // otherwise go through the row buffer
+  int thisLd, prLd;
+  const TM_TYPE *thisData = this->fns->getData(this, &thisLd, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *prData = product->fns->getData(product, &prLd, err);
+  if (*err == EINVAL) return;
+
+  // Do the multiplication
+  for (int pr_r = 0; pr_r < pr_m; pr_r++) {
+    const TM_TYPE *thisRow;
+    if (thisData) {
+      thisRow = &thisData[(size_t)pr_r*thisLd];
+    }
+    else {
+      this->fns->getRow(this, pr_r, buf, err);
+      if (*err == EINVAL || *err == EDOM) break;
+      thisRow = buf;
+    }
+    TM_TYPE *prRow = (prData) ? &prData[(size_t)pr_r*prLd] : &buf[this_n];
+    for (int pr_c = 0; pr_c < pr_p; pr_c++) {
+      // Pr[r][c] <- Sum_i This[r][i]*tr_That[c][i]
+      prRow[pr_c] =
+        TM_NAME(dotProduct)(this_n, thisRow, &trData[(size_t)pr_c*trLd]);
+    }
+    if (!prData) {
+      product->fns->setRow(product, pr_r, prRow, err);
+      if (*err == EINVAL || *err == EDOM) break;
+    }
+  }
+}
+
+//TODO: Add types, data and functions as required.
+static _Bool TM_NAME(isInit) = false;
+static TM_NAME(SmartMulMatrixFns) TM_NAME(smartMulMatrixFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .mul = TM_NAME(mul),
+};
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  a smart multiplication algorithm to avoid caching issues;
+ *  specifically, transpose the multiplier and use a modified
+ *  multiplication algorithm with the transposed multiplier.  The
+ *  transposed multiplier is held in the matrix's workspace (see
+ *  setDenseMatrixWorkspace()), so repeated multiplications with
+ *  multipliers of the same shape do not allocate memory.  If the
+ *  multiplier is a transpose view (see transpose_view.h) of a matrix
+ *  with row-major storage, then that storage is used directly and no
+ *  transpose is done at all.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+TM_NAME(SmartMulMatrix) *
+TM_NAME(newSmartMulMatrix)(int nRows, int nCols, int *err)
+{
+  TM_NAME(SmartMulMatrixImpl) *matrix =
+    (TM_NAME(SmartMulMatrixImpl) *)TM_NAME(newDenseMatrix)(nRows, nCols, err);
+  if (*err == EINVAL || *err == EDOM) return NULL;
+
+  matrix->fns = (TM_NAME(MatrixFns) *)TM_NAME(getSmartMulMatrixFns)();
+  return (TM_NAME(SmartMulMatrix) *)matrix;
+}
+
+static void
+TM_NAME(patchSmartMulMatrixFns)(void)
+{
+  if (!TM_NAME(isInit)) {
+    const TM_NAME(DenseMatrixFns) *fns = TM_NAME(getDenseMatrixFns)();
+    TM_NAME(smartMulMatrixFns).free = fns->free;
+    TM_NAME(smartMulMatrixFns).getNRows = fns->getNRows;
+    TM_NAME(smartMulMatrixFns).getNCols = fns->getNCols;
+    TM_NAME(smartMulMatrixFns).getElement = fns->getElement;
+    TM_NAME(smartMulMatrixFns).setElement = fns->setElement;
+    TM_NAME(smartMulMatrixFns).getRow = fns->getRow;
+    TM_NAME(smartMulMatrixFns).setRow = fns->setRow;
+    TM_NAME(smartMulMatrixFns).getData = fns->getData;
+    TM_NAME(smartMulMatrixFns).transpose = fns->transpose;
+    TM_NAME(smartMulMatrixFns).mulVec = fns->mulVec;
+    TM_NAME(smartMulMatrixFns).vecMul = fns->vecMul;
+    TM_NAME(isInit) = true;
+  }
+}
+
+/** Return implementation of functions for a smart multiplication
+ *  matrix; these functions can be used by sub-classes to inherit
+ *  behavior from this class.
+ */
+const TM_NAME(SmartMulMatrixFns) *
+TM_NAME(getSmartMulMatrixFns)(void)
+{
+  TM_NAME(patchSmartMulMatrixFns)();
+  return &TM_NAME(smartMulMatrixFns);
+}
@@ -0,0 +1,724 @@
+#include "abstract_matrix.h"
+#include "sparse_csr_matrix.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** An entry set while building the matrix */
+typedef struct {
+  int row, col;
+  MatrixBaseType value;
+} Triple;
+
+typedef struct {
+  SparseCsrMatrix;
+  int nRows;
+  int nCols;
+  _Bool isFrozen;
+
+  //build form: entries in the order they were set; later entries
+  //override earlier entries for the same position.  If non-NULL,
+  //triples for row r at indexes below rowClearedAt[r] were dropped by
+  //setRow()
+  Triple *triples;
+  int nTriples;
+  int maxTriples;
+  int *rowClearedAt;
+
+  //frozen form: the column indexes (in increasing order) and values
+  //of the entries of row r are at [rowStarts[r], rowStarts[r + 1])
+  int *rowStarts;
+  int *colIndexes;
+  MatrixBaseType *values;
+} SparseCsrMatrixImpl;
+
+#define KLASS "sparseCsrMatrix"
+
+/** Examines the matrix as a SparseCsrMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifySparseCsrMatrix(const Matrix *this, int *err)
+{
+  const SparseCsrMatrixImpl *matrix = (const SparseCsrMatrixImpl *)this;
+  if (matrix->nRows <= 0 || matrix->nCols <= 0) {
+    *err = EINVAL;
+  }
+}
+
+/** Return true iff matrix is a sparse CSR matrix. */
+static _Bool isSparseCsrMatrix(const Matrix *matrix)
+{
+  int err = 0;
+  const MatrixKlassId id = matrix->fns->getKlassId(matrix, &err);
+  return !err && id == MATRIX_KLASS_SPARSE_CSR;
+}
+
+/************************* Build and Freeze ****************************/
+
+/** Stably sort the n triples in src[] into dst[] by row (if byRow)
+ *  or by column; nKeys is the # of rows or columns.
+ */
+static void
+countingSort(const Triple src[], int n, Triple dst[], int nKeys,
+             _Bool byRow, int counts[])
+{
+  memset(counts, 0, (nKeys + 1)*sizeof(int));
+  for (int i = 0; i < n; i++) counts[(byRow ? src[i].row : src[i].col) + 1]++;
+  for (int k = 0; k < nKeys; k++) counts[k + 1] += counts[k];
+  for (int i = 0; i < n; i++) dst[counts[byRow ? src[i].row : src[i].col]++] = src[i];
+}
+
+/** Replace the frozen form of matrix by the given arrays, discarding
+ *  any build form.
+ */
+static void
+setCsr(SparseCsrMatrixImpl *matrix, int *rowStarts, int *colIndexes,
+       MatrixBaseType *values)
+{
+  free(matrix->triples);
+  free(matrix->rowClearedAt);
+  matrix->triples = NULL;
+  matrix->rowClearedAt = NULL;
+  matrix->nTriples = matrix->maxTriples = 0;
+  free(matrix->rowStarts);
+  free(matrix->colIndexes);
+  free(matrix->values);
+  matrix->rowStarts = rowStarts;
+  matrix->colIndexes = colIndexes;
+  matrix->values = values;
+  matrix->isFrozen = true;
+}
+
+/** Convert the build form of matrix into its frozen form: drop the
+ *  triples cleared by setRow(), sort the rest by row and column
+ *  (preserving the order in which entries for the same position were
+ *  set), keep only the last entry for each position and drop zero
+ *  entries.
+ */
+static void
+freeze(SparseCsrMatrixImpl *matrix, int *err)
+{
+  if (matrix->isFrozen) return;
+  if (matrix->rowClearedAt) {
+    int n = 0;
+    for (int i = 0; i < matrix->nTriples; i++) {
+      if (i >= matrix->rowClearedAt[matrix->triples[i].row]) {
+        matrix->triples[n++] = matrix->triples[i];
+      }
+    }
+    matrix->nTriples = n;
+    free(matrix->rowClearedAt);
+    matrix->rowClearedAt = NULL;
+  }
+  const int n = matrix->nTriples;
+  const int nKeys = (matrix->nRows > matrix->nCols) ? matrix->nRows : matrix->nCols;
+  Triple *sorted = malloc(n*sizeof(Triple));
+  int *counts = malloc((nKeys + 1)*sizeof(int));
+  int *rowStarts = calloc(matrix->nRows + 1, sizeof(int));
+  int *colIndexes = malloc((n > 0 ? n : 1)*sizeof(int));
+  MatrixBaseType *values = malloc((n > 0 ? n : 1)*sizeof(MatrixBaseType));
+  if ((n > 0 && !sorted) || !counts || !rowStarts || !colIndexes || !values) {
+    free(sorted); free(counts); free(rowStarts); free(colIndexes); free(values);
+    *err = ENOMEM;
+    return;
+  }
+
+  //radix sort: by column, then stably by row
+  countingSort(matrix->triples, n, sorted, matrix->nCols, false, counts);
+  countingSort(sorted, n, matrix->triples, matrix->nRows, true, counts);
+  free(sorted);
+  free(counts);
+
+  int nnz = 0;
+  const Triple *t = matrix->triples;
+  for (int i = 0; i < n; i++) {
+    if (i + 1 < n && t[i + 1].row == t[i].row && t[i + 1].col == t[i].col) {
+      continue;  //overridden by a later entry
+    }
+    if (t[i].value == 0) continue;
+    colIndexes[nnz] = t[i].col;
+    values[nnz] = t[i].value;
+    nnz++;
+    rowStarts[t[i].row + 1]++;
+  }
+  for (int r = 0; r < matrix->nRows; r++) rowStarts[r + 1] += rowStarts[r];
+
+  setCsr(matrix, rowStarts, colIndexes, values);
+}
+
+/** Freeze this if necessary; this is logically const since freezing
+ *  does not change any entries.
+ */
+static SparseCsrMatrixImpl *
+getFrozen(const Matrix *this, int *err)
+{
+  SparseCsrMatrixImpl *matrix = (SparseCsrMatrixImpl *)this;
+  verifySparseCsrMatrix(this, err);
+  if (*err == EINVAL) return NULL;
+  freeze(matrix, err);
+  if (*err == ENOMEM) return NULL;
+  return matrix;
+}
+
+/** Ensure matrix has room for nMore additional triples */
+static void
+reserveTriples(SparseCsrMatrixImpl *matrix, int nMore, int *err)
+{
+  if (matrix->nTriples + nMore <= matrix->maxTriples) return;
+  int max = 2*matrix->maxTriples;
+  if (max < matrix->nTriples + nMore) max = matrix->nTriples + nMore;
+  if (max < 16) max = 16;
+  Triple *triples = realloc(matrix->triples, max*sizeof(Triple));
+  if (!triples) {
+    *err = ENOMEM;
+    return;
+  }
+  matrix->triples = triples;
+  matrix->maxTriples = max;
+}
+
+/** Convert the frozen form of matrix back into build form */
+static void
+thaw(SparseCsrMatrixImpl *matrix, int *err)
+{
+  if (!matrix->isFrozen) return;
+  const int nnz = matrix->rowStarts[matrix->nRows];
+  reserveTriples(matrix, nnz, err);
+  if (*err == ENOMEM) return;
+  for (int r = 0; r < matrix->nRows; r++) {
+    for (int k = matrix->rowStarts[r]; k < matrix->rowStarts[r + 1]; k++) {
+      matrix->triples[matrix->nTriples++] = (Triple) {
+        .row = r, .col = matrix->colIndexes[k], .value = matrix->values[k]
+      };
+    }
+  }
+  free(matrix->rowStarts);
+  free(matrix->colIndexes);
+  free(matrix->values);
+  matrix->rowStarts = NULL;
+  matrix->colIndexes = NULL;
+  matrix->values = NULL;
+  matrix->isFrozen = false;
+}
+
+/** Return index of entry [rowIndex][colIndex] in frozen matrix; -1 if
+ *  not stored.
+ */
+static int
+findEntry(const SparseCsrMatrixImpl *matrix, int rowIndex, int colIndex)
+{
+  int lo = matrix->rowStarts[rowIndex];
+  int hi = matrix->rowStarts[rowIndex + 1];
+  while (lo < hi) {
+    int mid = lo + (hi - lo)/2;
+    if (matrix->colIndexes[mid] < colIndex) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return (lo < matrix->rowStarts[rowIndex + 1] &&
+          matrix->colIndexes[lo] == colIndex) ? lo : -1;
+}
+
+/** Growable arrays used for building the frozen form of a product */
+typedef struct {
+  int nnz;
+  int max;
+  int *colIndexes;
+  MatrixBaseType *values;
+} CsrBuilder;
+
+static void
+appendEntry(CsrBuilder *builder, int col, MatrixBaseType value, int *err)
+{
+  if (builder->nnz == builder->max) {
+    int max = (builder->max > 0) ? 2*builder->max : 16;
+    int *colIndexes = realloc(builder->colIndexes, max*sizeof(int));
+    if (colIndexes) builder->colIndexes = colIndexes;
+    MatrixBaseType *values =
+      realloc(builder->values, max*sizeof(MatrixBaseType));
+    if (values) builder->values = values;
+    if (!colIndexes || !values) {
+      *err = ENOMEM;
+      return;
+    }
+    builder->max = max;
+  }
+  builder->colIndexes[builder->nnz] = col;
+  builder->values[builder->nnz] = value;
+  builder->nnz++;
+}
+
+/*************************** Matrix Functions **************************/
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifySparseCsrMatrix(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifySparseCsrMatrix(this, err);
+  return MATRIX_KLASS_SPARSE_CSR;
+}
+
+static void freeSparseCsrMatrix(Matrix *this, int *err)
+{
+  verifySparseCsrMatrix(this, err);
+  SparseCsrMatrixImpl *matrix = (SparseCsrMatrixImpl *)this;
+  free(matrix->triples);
+  free(matrix->rowClearedAt);
+  free(matrix->rowStarts);
+  free(matrix->colIndexes);
+  free(matrix->values);
+  free(matrix);
+}
+
+static int getNRows(const Matrix *this, int *err)
+{
+  verifySparseCsrMatrix(this, err);
+  const SparseCsrMatrixImpl *matrix = (const SparseCsrMatrixImpl *)this;
+  return matrix->nRows;
+}
+
+static int getNCols(const Matrix *this, int *err)
+{
+  verifySparseCsrMatrix(this, err);
+  const SparseCsrMatrixImpl *matrix = (const SparseCsrMatrixImpl *)this;
+  return matrix->nCols;
+}
+
+static MatrixBaseType getElement(const Matrix *this,
+                                 int rowIndex, int colIndex, int *err)
+{
+  SparseCsrMatrixImpl *matrix = getFrozen(this, err);
+  if (!matrix) return 0;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows ||
+      colIndex < 0 || colIndex >= matrix->nCols) {
+    *err = EDOM;
+    return 0;
+  }
+  int k = findEntry(matrix, rowIndex, colIndex);
+  return (k < 0) ? 0 : matrix->values[k];
+}
+
+static void setElement(Matrix *this, int rowIndex, int colIndex,
+                       MatrixBaseType element, int *err)
+{
+  SparseCsrMatrixImpl *matrix = (SparseCsrMatrixImpl *)this;
+  verifySparseCsrMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows ||
+      colIndex < 0 || colIndex >= matrix->nCols) {
+    *err = EDOM;
+    return;
+  }
+  if (matrix->isFrozen) {
+    int k = findEntry(matrix, rowIndex, colIndex);
+    if (k >= 0) {
+      matrix->values[k] = element;
+      return;
+    }
+    if (element == 0) return;
+    thaw(matrix, err);
+    if (*err == ENOMEM) return;
+  }
+  reserveTriples(matrix, 1, err);
+  if (*err == ENOMEM) return;
+  matrix->triples[matrix->nTriples++] = (Triple) {
+    .row = rowIndex, .col = colIndex, .value = element
+  };
+}
+
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  SparseCsrMatrixImpl *matrix = getFrozen(this, err);
+  if (!matrix) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  memset(row, 0, matrix->nCols*sizeof(MatrixBaseType));
+  for (int k = matrix->rowStarts[rowIndex];
+       k < matrix->rowStarts[rowIndex + 1]; k++) {
+    row[matrix->colIndexes[k]] = matrix->values[k];
+  }
+}
+
+/** Setting a row is done in place if all its non-zero entries are
+ *  already stored; otherwise the row is marked as cleared and its
+ *  non-zero entries are appended to the build form, so that setting
+ *  every row costs O(nnz) overall.
+ */
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  SparseCsrMatrixImpl *matrix = (SparseCsrMatrixImpl *)this;
+  verifySparseCsrMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  if (matrix->isFrozen) {
+    int k = matrix->rowStarts[rowIndex];
+    const int end = matrix->rowStarts[rowIndex + 1];
+    _Bool inPlace = true;
+    for (int c = 0; c < matrix->nCols && inPlace; c++) {
+      if (k < end && matrix->colIndexes[k] == c) {
+        k++;
+      }
+      else if (row[c] != 0) {
+        inPlace = false;
+      }
+    }
+    if (inPlace) {
+      for (k = matrix->rowStarts[rowIndex]; k < end; k++) {
+        matrix->values[k] = row[matrix->colIndexes[k]];
+      }
+      return;
+    }
+    thaw(matrix, err);
+    if (*err == ENOMEM) return;
+  }
+
+  //drop previous entries for row when freezing, then add its non-zero
+  //entries
+  if (!matrix->rowClearedAt) {
+    matrix->rowClearedAt = calloc(matrix->nRows, sizeof(int));
+    if (!matrix->rowClearedAt) {
+      *err = ENOMEM;
+      return;
+    }
+  }
+  int nNonZero = 0;
+  for (int c = 0; c < matrix->nCols; c++) nNonZero += (row[c] != 0);
+  reserveTriples(matrix, nNonZero, err);
+  if (*err == ENOMEM) return;
+  matrix->rowClearedAt[rowIndex] = matrix->nTriples;
+  for (int c = 0; c < matrix->nCols; c++) {
+    if (row[c] == 0) continue;
+    matrix->triples[matrix->nTriples++] = (Triple) {
+      .row = rowIndex, .col = c, .value = row[c]
+    };
+  }
+}
+
+static void transpose(const Matrix *this, Matrix *result, int *err)
+{
+  // Check dimensions: MxN -> NxM
+  SparseCsrMatrixImpl *matrix = getFrozen(this, err);
+  if (!matrix) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(matrix->nRows == result_m && matrix->nCols == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  const int nnz = matrix->rowStarts[matrix->nRows];
+  int resultLd;
+  MatrixBaseType *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (res) {
+    // Scatter entries into the result storage
+    for (int r = 0; r < result_n; r++) {
+      memset(&res[(size_t)r*resultLd], 0, result_m*sizeof(MatrixBaseType));
+    }
+    for (int r = 0; r < matrix->nRows; r++) {
+      for (int k = matrix->rowStarts[r]; k < matrix->rowStarts[r + 1]; k++) {
+        res[(size_t)matrix->colIndexes[k]*resultLd + r] = matrix->values[k];
+      }
+    }
+  }
+  else if (isSparseCsrMatrix(result)) {
+    // Build the frozen form of the result directly; scanning the rows
+    // of this in order leaves the columns of each result row sorted
+    SparseCsrMatrixImpl *tr = (SparseCsrMatrixImpl *)result;
+    int *rowStarts = calloc(result_n + 1, sizeof(int));
+    int *next = malloc((result_n + 1)*sizeof(int));
+    int *colIndexes = malloc((nnz > 0 ? nnz : 1)*sizeof(int));
+    MatrixBaseType *values = malloc((nnz > 0 ? nnz : 1)*sizeof(MatrixBaseType));
+    if (!rowStarts || !next || !colIndexes || !values) {
+      free(rowStarts); free(next); free(colIndexes); free(values);
+      *err = ENOMEM;
+      return;
+    }
+    for (int k = 0; k < nnz; k++) rowStarts[matrix->colIndexes[k] + 1]++;
+    for (int r = 0; r < result_n; r++) rowStarts[r + 1] += rowStarts[r];
+    memcpy(next, rowStarts, (result_n + 1)*sizeof(int));
+    for (int r = 0; r < matrix->nRows; r++) {
+      for (int k = matrix->rowStarts[r]; k < matrix->rowStarts[r + 1]; k++) {
+        int dst = next[matrix->colIndexes[k]]++;
+        colIndexes[dst] = r;
+        values[dst] = matrix->values[k];
+      }
+    }
+    free(next);
+    setCsr(tr, rowStarts, colIndexes, values);
+  }
+  else {
+    getAbstractMatrixFns()->transpose(this, result, err);
+  }
+}
+
+/** Output row rowIndex of a product from the dense accumulator acc[p]
+ *  whose non-zero entries are at the nTouched (sorted) column indexes
+ *  in touched[]; if touched is NULL, then all of acc[] is scanned.
+ *  The row is added to builder if non-NULL, stored directly at prRow
+ *  if non-NULL, else set using setRow().  acc[] is left zeroed.
+ */
+static void
+outputProductRow(Matrix *product, int rowIndex, MatrixBaseType acc[], int p,
+                 const int touched[], int nTouched,
+                 CsrBuilder *builder, MatrixBaseType *prRow, int *err)
+{
+  if (builder) {
+    if (touched) {
+      for (int t = 0; t < nTouched; t++) {
+        int c = touched[t];
+        if (acc[c] != 0) appendEntry(builder, c, acc[c], err);
+        acc[c] = 0;
+      }
+    }
+    else {
+      for (int c = 0; c < p; c++) {
+        if (acc[c] != 0) appendEntry(builder, c, acc[c], err);
+        acc[c] = 0;
+      }
+    }
+  }
+  else if (prRow) {
+    memcpy(prRow, acc, p*sizeof(MatrixBaseType));
+    memset(acc, 0, p*sizeof(MatrixBaseType));
+  }
+  else {
+    product->fns->setRow(product, rowIndex, acc, err);
+    memset(acc, 0, p*sizeof(MatrixBaseType));
+  }
+}
+
+static int compareInts(const void *p1, const void *p2)
+{
+  int i1 = *(const int *)p1, i2 = *(const int *)p2;
+  return (i1 > i2) - (i1 < i2);
+}
+
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  SparseCsrMatrixImpl *a = getFrozen(this, err);
+  if (!a) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(a->nRows == pr_m && a->nCols == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Specialize on the multiplier: either sparse or with dense storage
+  SparseCsrMatrixImpl *b = NULL;
+  int ldb;
+  const MatrixBaseType *bData = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  if (!bData) {
+    if (!isSparseCsrMatrix(multiplier)) {
+      getAbstractMatrixFns()->mul(this, multiplier, product, err);
+      return;
+    }
+    b = getFrozen(multiplier, err);
+    if (!b) return;
+  }
+
+  // The product is built directly if sparse, else written a row at a time
+  int prLd;
+  MatrixBaseType *prData = product->fns->getData(product, &prLd, err);
+  if (*err == EINVAL) return;
+  _Bool isSparseProduct = !prData && isSparseCsrMatrix(product);
+  CsrBuilder builder = { };
+  int *rowStarts = NULL;
+  if (isSparseProduct) {
+    rowStarts = malloc((pr_m + 1)*sizeof(int));
+    if (!rowStarts) {
+      *err = ENOMEM;
+      return;
+    }
+    rowStarts[0] = 0;
+  }
+  MatrixBaseType *acc = calloc(pr_p, sizeof(MatrixBaseType));
+  int *touched = (b) ? malloc(pr_p*sizeof(int)) : NULL;
+  _Bool *isTouched = (b) ? calloc(pr_p, sizeof(_Bool)) : NULL;
+  if (!acc || (b && (!touched || !isTouched))) {
+    *err = ENOMEM;
+  }
+
+  for (int r = 0; r < pr_m && !*err; r++) {
+    int nTouched = 0;
+    for (int k = a->rowStarts[r]; k < a->rowStarts[r + 1]; k++) {
+      const MatrixBaseType v = a->values[k];
+      const int i = a->colIndexes[k];
+      if (b) {
+        // Gustavson: accumulate v * (row i of sparse multiplier)
+        for (int kb = b->rowStarts[i]; kb < b->rowStarts[i + 1]; kb++) {
+          const int c = b->colIndexes[kb];
+          if (!isTouched[c]) {
+            isTouched[c] = true;
+            touched[nTouched++] = c;
+          }
+          acc[c] += v*b->values[kb];
+        }
+      }
+      else {
+        // accumulate v * (row i of dense multiplier)
+        const MatrixBaseType *bRow = &bData[(size_t)i*ldb];
+        for (int c = 0; c < pr_p; c++) acc[c] += v*bRow[c];
+      }
+    }
+    if (b) {
+      for (int t = 0; t < nTouched; t++) isTouched[touched[t]] = false;
+      if (isSparseProduct) qsort(touched, nTouched, sizeof(int), compareInts);
+    }
+    outputProductRow(product, r, acc, pr_p, touched, nTouched,
+                     (isSparseProduct) ? &builder : NULL,
+                     (prData) ? &prData[(size_t)r*prLd] : NULL, err);
+    if (isSparseProduct) rowStarts[r + 1] = builder.nnz;
+  }
+
+  if (isSparseProduct && !*err) {
+    SparseCsrMatrixImpl *c = (SparseCsrMatrixImpl *)product;
+    setCsr(c, rowStarts, builder.colIndexes, builder.values);
+  }
+  else {
+    free(rowStarts);
+    free(builder.colIndexes);
+    free(builder.values);
+  }
+  free(acc);
+  free(touched);
+  free(isTouched);
+}
+
+/** Only the stored entries contribute: the cost is O(nnz) */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const SparseCsrMatrixImpl *a = getFrozen(this, err);
+  if (!a) return;
+  for (int r = 0; r < a->nRows; r++) {
+    MatrixBaseType res = 0;
+    for (int k = a->rowStarts[r]; k < a->rowStarts[r + 1]; k++) {
+      res += a->values[k]*vec[a->colIndexes[k]];
+    }
+    result[r] = res;
+  }
+}
+
+/** Scatter each stored entry of row r, scaled by vec[r], into result */
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const SparseCsrMatrixImpl *a = getFrozen(this, err);
+  if (!a) return;
+  memset(result, 0, a->nCols*sizeof(MatrixBaseType));
+  for (int r = 0; r < a->nRows; r++) {
+    const MatrixBaseType v = vec[r];
+    for (int k = a->rowStarts[r]; k < a->rowStarts[r + 1]; k++) {
+      result[a->colIndexes[k]] += v*a->values[k];
+    }
+  }
+}
+
+static _Bool isInit = false;
+static SparseCsrMatrixFns sparseCsrMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .free = freeSparseCsrMatrix,
+  .getNRows = getNRows,
+  .getNCols = getNCols,
+  .getElement = getElement,
+  .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .transpose = transpose,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
+};
+
+static void patchSparseCsrMatrixFns(void)
+{
+  if (!isInit) {
+    const MatrixFns *fns = getAbstractMatrixFns();
+    sparseCsrMatrixFns.getData = fns->getData;
+    isInit = true;
+  }
+}
+
+/** Return a newly allocated sparse matrix with all entries 0.  Set
+ *  *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+SparseCsrMatrix *
+newSparseCsrMatrix(int nRows, int nCols, int *err)
+{
+  // Check if dimensions make sense
+  if (nRows <= 0 || nCols <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+
+  // Start out as a frozen matrix with no entries
+  SparseCsrMatrixImpl *matrix = calloc(1, sizeof(SparseCsrMatrixImpl));
+  int *rowStarts = calloc(nRows + 1, sizeof(int));
+  if (!matrix || !rowStarts) {
+    free(matrix);
+    free(rowStarts);
+    *err = ENOMEM;
+    return NULL;
+  }
+  matrix->nRows = nRows;
+  matrix->nCols = nCols;
+  matrix->rowStarts = rowStarts;
+  matrix->isFrozen = true;
+  matrix->fns = (MatrixFns *)getSparseCsrMatrixFns();
+  return (SparseCsrMatrix *)matrix;
+}
+
+void
+freezeSparseCsrMatrix(SparseCsrMatrix *this, int *err)
+{
+  getFrozen((Matrix *)this, err);
+}
+
+int
+getSparseCsrMatrixNnz(SparseCsrMatrix *this, int *err)
+{
+  SparseCsrMatrixImpl *matrix = getFrozen((Matrix *)this, err);
+  return (matrix) ? matrix->rowStarts[matrix->nRows] : 0;
+}
+
+/** Return implementation of functions for a sparse CSR matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const SparseCsrMatrixFns *
+getSparseCsrMatrixFns(void)
+{
+  patchSparseCsrMatrixFns();
+  return &sparseCsrMatrixFns;
+}
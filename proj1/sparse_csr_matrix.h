@@ -0,0 +1,55 @@
+#ifndef _SPARSE_CSR_MATRIX_H
+#define _SPARSE_CSR_MATRIX_H
+
+#include "matrix.h"
+
+typedef struct SparseCsrMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} SparseCsrMatrixFns;
+
+typedef struct SparseCsrMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} SparseCsrMatrix;
+
+/** Return a newly allocated sparse matrix with all entries 0.  Only
+ *  the non-zero entries are stored, so memory and time for all
+ *  operations scale with the # of non-zero entries (nnz) rather
+ *  than with nRows*nCols.
+ *
+ *  The matrix is used in a build-then-freeze manner: entries set
+ *  using setElement()/setRow() are accumulated cheaply in build
+ *  form; the matrix is frozen into compressed sparse row (CSR) form
+ *  when it is next read (or explicitly using freezeSparseCsrMatrix()).
+ *  Setting an entry which is already stored in a frozen matrix is
+ *  done in place; setting any other entry to a non-zero value
+ *  returns the matrix to build form, which costs O(nnz).
+ *
+ *  Multiplication uses specialized sparse x dense and sparse x sparse
+ *  algorithms when the multiplier provides row-major storage or is
+ *  itself a sparse CSR matrix; a sparse CSR product is built
+ *  directly.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+SparseCsrMatrix *newSparseCsrMatrix(int nRows, int nCols, int *err);
+
+/** Freeze this matrix into compressed sparse row form.  Set *err to
+ *  EINVAL if this matrix not in valid state, ENOMEM if not enough
+ *  memory.
+ */
+void freezeSparseCsrMatrix(SparseCsrMatrix *this, int *err);
+
+/** Return # of stored entries of this matrix after freezing it.  Set
+ *  *err to EINVAL if this matrix not in valid state, ENOMEM if not
+ *  enough memory to freeze it.
+ */
+int getSparseCsrMatrixNnz(SparseCsrMatrix *this, int *err);
+
+/** Return implementation of functions for a sparse CSR matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const SparseCsrMatrixFns *getSparseCsrMatrixFns(void);
+
+#endif //ifndef _SPARSE_CSR_MATRIX_H
@@ -0,0 +1,327 @@
+#include "dense_matrix.h"
+#include "gemm_kernel.h"
+#include "strassen_matrix.h"
+#include "workspace.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  DenseMatrix;
+} StrassenMatrixImpl;
+
+enum { DEFAULT_CROSSOVER = 128 };
+
+static int crossover = DEFAULT_CROSSOVER;
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  return "strassenMatrix";
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  return MATRIX_KLASS_STRASSEN;
+}
+
+/************************ Raw Matrix Operations ************************/
+
+/** z[m][n] = x[m][n] + y[m][n] */
+static void
+add(int m, int n, const MatrixBaseType *x, int ldx,
+    const MatrixBaseType *y, int ldy, MatrixBaseType *z, int ldz)
+{
+  for (int i = 0; i < m; i++) {
+    const MatrixBaseType *xRow = &x[(size_t)i*ldx], *yRow = &y[(size_t)i*ldy];
+    MatrixBaseType *zRow = &z[(size_t)i*ldz];
+    for (int j = 0; j < n; j++) zRow[j] = xRow[j] + yRow[j];
+  }
+}
+
+/** z[m][n] = x[m][n] - y[m][n] */
+static void
+sub(int m, int n, const MatrixBaseType *x, int ldx,
+    const MatrixBaseType *y, int ldy, MatrixBaseType *z, int ldz)
+{
+  for (int i = 0; i < m; i++) {
+    const MatrixBaseType *xRow = &x[(size_t)i*ldx], *yRow = &y[(size_t)i*ldy];
+    MatrixBaseType *zRow = &z[(size_t)i*ldz];
+    for (int j = 0; j < n; j++) zRow[j] = xRow[j] - yRow[j];
+  }
+}
+
+/** z[m][n] = sign*x[m][n] if !accumulate, else z[m][n] += sign*x[m][n] */
+static void
+update(int m, int n, const MatrixBaseType *x, int ldx,
+       MatrixBaseType *z, int ldz, int sign, _Bool accumulate)
+{
+  for (int i = 0; i < m; i++) {
+    const MatrixBaseType *xRow = &x[(size_t)i*ldx];
+    MatrixBaseType *zRow = &z[(size_t)i*ldz];
+    for (int j = 0; j < n; j++) {
+      MatrixBaseType v = (sign < 0) ? -xRow[j] : xRow[j];
+      zRow[j] = (accumulate) ? zRow[j] + v : v;
+    }
+  }
+}
+
+/** Copy x[m][n] to z[m][n] padded with zeros to z[pm][pn] */
+static void
+copyPadded(int m, int n, const MatrixBaseType *x, int ldx,
+           int pm, int pn, MatrixBaseType *z)
+{
+  for (int i = 0; i < m; i++) {
+    memcpy(&z[(size_t)i*pn], &x[(size_t)i*ldx], n*sizeof(MatrixBaseType));
+    memset(&z[(size_t)i*pn + n], 0, (pn - n)*sizeof(MatrixBaseType));
+  }
+  memset(&z[(size_t)m*pn], 0, (size_t)(pm - m)*pn*sizeof(MatrixBaseType));
+}
+
+/************************** Strassen Recursion *************************/
+
+/** Return # of entries of workspace needed for nLevels levels of
+ *  recursion on a m x n by n x p multiplication; each level needs
+ *  temporaries for a sum of a quadrants, a sum of b quadrants and
+ *  a quadrant product.
+ */
+static size_t
+workspaceSize(int nLevels, int m, int n, int p)
+{
+  size_t size = 0;
+  for (int level = 0; level < nLevels; level++) {
+    m /= 2; n /= 2; p /= 2;
+    size += (size_t)m*n + (size_t)n*p + (size_t)m*p;
+  }
+  return size;
+}
+
+/** Set c[m][p] = a[m][n] * b[n][p] using nLevels levels of Strassen
+ *  recursion; all dimensions must be divisible by 2^nLevels.  ws
+ *  points to at least workspaceSize(nLevels, m, n, p) entries.
+ */
+static void
+strassen(int nLevels, int m, int n, int p,
+         const MatrixBaseType *a, int lda,
+         const MatrixBaseType *b, int ldb,
+         MatrixBaseType *c, int ldc, MatrixBaseType *ws)
+{
+  if (nLevels == 0) {
+    gemmBlocked(m, n, p, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  const int hm = m/2, hn = n/2, hp = p/2;
+  const MatrixBaseType *a11 = a, *a12 = &a[hn],
+    *a21 = &a[(size_t)hm*lda], *a22 = &a[(size_t)hm*lda + hn];
+  const MatrixBaseType *b11 = b, *b12 = &b[hp],
+    *b21 = &b[(size_t)hn*ldb], *b22 = &b[(size_t)hn*ldb + hp];
+  MatrixBaseType *c11 = c, *c12 = &c[hp],
+    *c21 = &c[(size_t)hm*ldc], *c22 = &c[(size_t)hm*ldc + hp];
+  MatrixBaseType *ta = ws;                   //hm x hn
+  MatrixBaseType *tb = &ta[(size_t)hm*hn];   //hn x hp
+  MatrixBaseType *tm = &tb[(size_t)hn*hp];   //hm x hp
+  MatrixBaseType *next = &tm[(size_t)hm*hp];
+  const int nl = nLevels - 1;
+
+  //M1 = (A11 + A22)(B11 + B22); C11 = M1; C22 = M1
+  add(hm, hn, a11, lda, a22, lda, ta, hn);
+  add(hn, hp, b11, ldb, b22, ldb, tb, hp);
+  strassen(nl, hm, hn, hp, ta, hn, tb, hp, tm, hp, next);
+  update(hm, hp, tm, hp, c11, ldc, 1, false);
+  update(hm, hp, tm, hp, c22, ldc, 1, false);
+
+  //M2 = (A21 + A22)B11; C21 = M2; C22 -= M2
+  add(hm, hn, a21, lda, a22, lda, ta, hn);
+  strassen(nl, hm, hn, hp, ta, hn, b11, ldb, tm, hp, next);
+  update(hm, hp, tm, hp, c21, ldc, 1, false);
+  update(hm, hp, tm, hp, c22, ldc, -1, true);
+
+  //M3 = A11(B12 - B22); C12 = M3; C22 += M3
+  sub(hn, hp, b12, ldb, b22, ldb, tb, hp);
+  strassen(nl, hm, hn, hp, a11, lda, tb, hp, tm, hp, next);
+  update(hm, hp, tm, hp, c12, ldc, 1, false);
+  update(hm, hp, tm, hp, c22, ldc, 1, true);
+
+  //M4 = A22(B21 - B11); C11 += M4; C21 += M4
+  sub(hn, hp, b21, ldb, b11, ldb, tb, hp);
+  strassen(nl, hm, hn, hp, a22, lda, tb, hp, tm, hp, next);
+  update(hm, hp, tm, hp, c11, ldc, 1, true);
+  update(hm, hp, tm, hp, c21, ldc, 1, true);
+
+  //M5 = (A11 + A12)B22; C11 -= M5; C12 += M5
+  add(hm, hn, a11, lda, a12, lda, ta, hn);
+  strassen(nl, hm, hn, hp, ta, hn, b22, ldb, tm, hp, next);
+  update(hm, hp, tm, hp, c11, ldc, -1, true);
+  update(hm, hp, tm, hp, c12, ldc, 1, true);
+
+  //M6 = (A21 - A11)(B11 + B12); C22 += M6
+  sub(hm, hn, a21, lda, a11, lda, ta, hn);
+  add(hn, hp, b11, ldb, b12, ldb, tb, hp);
+  strassen(nl, hm, hn, hp, ta, hn, tb, hp, tm, hp, next);
+  update(hm, hp, tm, hp, c22, ldc, 1, true);
+
+  //M7 = (A12 - A22)(B21 + B22); C11 += M7
+  sub(hm, hn, a12, lda, a22, lda, ta, hn);
+  add(hn, hp, b21, ldb, b22, ldb, tb, hp);
+  strassen(nl, hm, hn, hp, ta, hn, tb, hp, tm, hp, next);
+  update(hm, hp, tm, hp, c11, ldc, 1, true);
+}
+
+/** Return dim rounded up to a multiple of 2^nLevels */
+static int
+padDim(int dim, int nLevels)
+{
+  const int mask = (1 << nLevels) - 1;
+  return (dim + mask) & ~mask;
+}
+
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = this->fns->getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = this->fns->getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of all the matrices
+  int lda, ldb, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (!a || !b || !c) {
+    getDenseMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+
+  // Recurse until the smallest dimension is within the crossover
+  int nLevels = 0;
+  int minDim = this_m;
+  if (this_n < minDim) minDim = this_n;
+  if (pr_p < minDim) minDim = pr_p;
+  for (int dim = minDim; dim > crossover; dim = (dim + 1)/2) nLevels++;
+  if (nLevels == 0) {
+    gemmBlocked(pr_m, this_n, pr_p, a, lda, b, ldb, c, ldc);
+    return;
+  }
+
+  // Get all scratch space up front from the workspace, including space
+  // for padded copies of the operands if their dimensions cannot be
+  // halved evenly at every level
+  const int m = padDim(this_m, nLevels);
+  const int n = padDim(this_n, nLevels);
+  const int p = padDim(pr_p, nLevels);
+  const _Bool isPadded = (m != this_m || n != this_n || p != pr_p);
+  size_t size = workspaceSize(nLevels, m, n, p);
+  if (isPadded) size += (size_t)m*n + (size_t)n*p + (size_t)m*p;
+  Workspace *workspace =
+    getDenseMatrixWorkspace((const DenseMatrix *)this, err);
+  if (!workspace) return;
+  MatrixBaseType *ws = getWorkspaceBuffer(workspace, WORKSPACE_STRASSEN,
+                                          size*sizeof(MatrixBaseType), err);
+  if (!ws) return;
+  if (isPadded) {
+    MatrixBaseType *pa = ws;
+    MatrixBaseType *pb = &pa[(size_t)m*n];
+    MatrixBaseType *pc = &pb[(size_t)n*p];
+    copyPadded(this_m, this_n, a, lda, m, n, pa);
+    copyPadded(mul_n, mul_p, b, ldb, n, p, pb);
+    strassen(nLevels, m, n, p, pa, n, pb, p, pc, p, &pc[(size_t)m*p]);
+    for (int i = 0; i < pr_m; i++) {
+      memcpy(&c[(size_t)i*ldc], &pc[(size_t)i*p], pr_p*sizeof(MatrixBaseType));
+    }
+  }
+  else {
+    strassen(nLevels, m, n, p, a, lda, b, ldb, c, ldc, ws);
+  }
+}
+
+static _Bool isInit = false;
+static StrassenMatrixFns strassenMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .mul = mul,
+};
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  Strassen's algorithm for multiplication.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+StrassenMatrix *
+newStrassenMatrix(int nRows, int nCols, int *err)
+{
+  StrassenMatrixImpl *matrix =
+    (StrassenMatrixImpl *)newDenseMatrix(nRows, nCols, err);
+  if (*err == EINVAL || *err == ENOMEM) return NULL;
+
+  matrix->fns = (MatrixFns *)getStrassenMatrixFns();
+  return (StrassenMatrix *)matrix;
+}
+
+void
+setStrassenCrossover(int n, int *err)
+{
+  if (n <= 0) {
+    *err = EINVAL;
+    return;
+  }
+  crossover = n;
+}
+
+int
+getStrassenCrossover(void)
+{
+  return crossover;
+}
+
+static void patchStrassenMatrixFns(void)
+{
+  if (!isInit) {
+    const DenseMatrixFns *fns = getDenseMatrixFns();
+    strassenMatrixFns.free = fns->free;
+    strassenMatrixFns.getNRows = fns->getNRows;
+    strassenMatrixFns.getNCols = fns->getNCols;
+    strassenMatrixFns.getElement = fns->getElement;
+    strassenMatrixFns.setElement = fns->setElement;
+    strassenMatrixFns.getRow = fns->getRow;
+    strassenMatrixFns.setRow = fns->setRow;
+    strassenMatrixFns.getData = fns->getData;
+    strassenMatrixFns.transpose = fns->transpose;
+    strassenMatrixFns.mulVec = fns->mulVec;
+    strassenMatrixFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+/** Return implementation of functions for a Strassen matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const StrassenMatrixFns *
+getStrassenMatrixFns(void)
+{
+  patchStrassenMatrixFns();
+  return &strassenMatrixFns;
+}
@@ -0,0 +1,43 @@
+#ifndef _STRASSEN_MATRIX_H
+#define _STRASSEN_MATRIX_H
+
+#include "matrix.h"
+
+typedef struct StrassenMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} StrassenMatrixFns;
+
+typedef struct StrassenMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} StrassenMatrix;
+
+/** Return a newly allocated matrix with all entries in consecutive
+ *  memory locations (row-major layout).  All entries in the newly
+ *  created matrix are initialized to 0.  The return'd matrix uses
+ *  Strassen's algorithm for multiplication: the operands are split
+ *  into quadrants and the product computed using 7 (rather than 8)
+ *  recursive multiplications, until the smallest dimension is at
+ *  most the crossover size, at which point the cache-blocked kernel
+ *  is used.  Dimensions which cannot be halved evenly are handled by
+ *  zero-padding the operands.
+ *
+ *  Set *err to EINVAL if nRows or nCols <= 0, to ENOMEM if not enough
+ *  memory.
+ */
+StrassenMatrix *newStrassenMatrix(int nRows, int nCols, int *err);
+
+/** Set the crossover size used by all Strassen matrices to crossover.
+ *  Set *err to EINVAL if crossover <= 0.
+ */
+void setStrassenCrossover(int crossover, int *err);
+
+/** Return the crossover size used by all Strassen matrices. */
+int getStrassenCrossover(void);
+
+/** Return implementation of functions for a Strassen matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const StrassenMatrixFns *getStrassenMatrixFns(void);
+
+#endif //ifndef _STRASSEN_MATRIX_H
@@ -0,0 +1,352 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stream_mul.h"
+
+#include "bench.h"
+#include "gemm_kernel.h"
+#include "matrix_file.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+enum {
+  N_SLOTS = 2,          //double buffering
+  N_TILE_BUFFERS = 2*N_SLOTS + 1, //operand tiles in all slots + product
+  TILE_ALIGN = 16,      //round large tiles down to a multiple of this
+};
+
+/** Buffers for one pair of operand tiles */
+typedef struct {
+  MatrixBaseType *a;
+  MatrixBaseType *b;
+  long step;            //step whose tiles are loaded; -1 if empty
+} Slot;
+
+/** State of a streaming multiplication c[m][p] = a[m][n] * b[n][p].
+ *  The product tiles are processed in row-major order and, for each
+ *  product tile, the operand tiles along the shared dimension; each
+ *  pair of operand tiles is a step.
+ */
+typedef struct {
+  int fdA, fdB;
+  MatrixFileHeader headerA, headerB;
+  int m, n, p;
+  int tile;                     //tile size for all dimensions
+  int nTilesM, nTilesN, nTilesP;
+  long nSteps;
+
+  //protected by lock
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  Slot slots[N_SLOTS];
+  int ioErr;                    //first error from I/O thread
+  _Bool isCancelled;            //set by compute thread on error
+  double readSecs;
+  size_t bytesRead;
+} Stream;
+
+static inline int min(int a, int b) { return (a < b) ? a : b; }
+
+/** Set (*i, *j, *k) to the tile indexes for step in stream */
+static void
+getStepTiles(const Stream *stream, long step, int *i, int *j, int *k)
+{
+  *k = step % stream->nTilesN;
+  long ij = step / stream->nTilesN;
+  *j = ij % stream->nTilesP;
+  *i = ij / stream->nTilesP;
+}
+
+/** Read exactly size bytes at offset in fd into buf; return 0 or
+ *  error code.
+ */
+static int
+preadFully(int fd, void *buf, size_t size, off_t offset)
+{
+  while (size > 0) {
+    ssize_t n = pread(fd, buf, size, offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) return errno;
+    if (n == 0) return EIO;     //file shorter than its header claims
+    buf = (char *)buf + n; size -= n; offset += n;
+  }
+  return 0;
+}
+
+/** Write exactly size bytes from buf at offset in fd; return 0 or
+ *  error code.
+ */
+static int
+pwriteFully(int fd, const void *buf, size_t size, off_t offset)
+{
+  while (size > 0) {
+    ssize_t n = pwrite(fd, buf, size, offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) return errno;
+    buf = (const char *)buf + n; size -= n; offset += n;
+  }
+  return 0;
+}
+
+/** Return the offset of entry [r][c] in the file with header */
+static off_t
+entryOffset(const MatrixFileHeader *header, int r, int c)
+{
+  return header->dataOffset +
+    ((off_t)r*header->rowStride + c)*header->elemSize;
+}
+
+/** Read the nr x nc tile starting at [r0][c0] from the matrix file
+ *  open on fd into tile[nr][nc]; return 0 or error code.
+ */
+static int
+readTile(int fd, const MatrixFileHeader *header, int r0, int c0,
+         int nr, int nc, MatrixBaseType *tile)
+{
+  for (int r = 0; r < nr; r++) {
+    int err = preadFully(fd, &tile[(size_t)r*nc], nc*sizeof(MatrixBaseType),
+                         entryOffset(header, r0 + r, c0));
+    if (err) return err;
+  }
+  return 0;
+}
+
+/** I/O thread: read the operand tiles for each step into the next
+ *  slot as soon as it is free.
+ */
+static void *
+readTiles(void *arg)
+{
+  Stream *stream = arg;
+  const int t = stream->tile;
+  for (long step = 0; step < stream->nSteps; step++) {
+    Slot *slot = &stream->slots[step % N_SLOTS];
+    pthread_mutex_lock(&stream->lock);
+    while (slot->step >= 0 && !stream->isCancelled) {
+      pthread_cond_wait(&stream->cond, &stream->lock);
+    }
+    _Bool isCancelled = stream->isCancelled;
+    pthread_mutex_unlock(&stream->lock);
+    if (isCancelled) break;
+
+    int i, j, k;
+    getStepTiles(stream, step, &i, &j, &k);
+    const int mm = min(t, stream->m - i*t);
+    const int nn = min(t, stream->n - k*t);
+    const int pp = min(t, stream->p - j*t);
+    double start = getBenchTime();
+    int err = readTile(stream->fdA, &stream->headerA, i*t, k*t, mm, nn,
+                       slot->a);
+    if (!err) {
+      err = readTile(stream->fdB, &stream->headerB, k*t, j*t, nn, pp,
+                     slot->b);
+    }
+    double secs = getBenchTime() - start;
+
+    pthread_mutex_lock(&stream->lock);
+    stream->readSecs += secs;
+    stream->bytesRead +=
+      ((size_t)mm*nn + (size_t)nn*pp)*sizeof(MatrixBaseType);
+    if (err) {
+      stream->ioErr = err;
+    }
+    else {
+      slot->step = step;
+    }
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    if (err) break;
+  }
+  return NULL;
+}
+
+/** Open the matrix file at path for reading into *fd and *header;
+ *  return 0 or error code.
+ */
+static int
+openOperand(const char *path, int *fd, MatrixFileHeader *header)
+{
+  *fd = open(path, O_RDONLY);
+  if (*fd < 0) return errno;
+  int err = 0;
+  readMatrixFileHeader(*fd, header, &err);
+  return err;
+}
+
+/** Return the largest tile size t such that all the tile buffers for
+ *  t x t tiles fit in memoryBudget bytes; 0 if none.
+ */
+static int
+getTileSize(size_t memoryBudget, int m, int n, int p)
+{
+  double t = floor(sqrt((double)memoryBudget /
+                        (N_TILE_BUFFERS*sizeof(MatrixBaseType))));
+  int maxDim = m;
+  if (n > maxDim) maxDim = n;
+  if (p > maxDim) maxDim = p;
+  if (t >= maxDim) return maxDim;
+  int tile = (int)t;
+  return (tile > TILE_ALIGN) ? tile - tile % TILE_ALIGN : tile;
+}
+
+/** Multiply all the steps of stream, writing each product tile to the
+ *  file open on fdC with header; return 0 or error code.
+ */
+static int
+computeTiles(Stream *stream, int fdC, const MatrixFileHeader *headerC,
+             MatrixBaseType *c, StreamMulStats *stats)
+{
+  const int t = stream->tile;
+  for (long step = 0; step < stream->nSteps; step++) {
+    Slot *slot = &stream->slots[step % N_SLOTS];
+    double waitStart = getBenchTime();
+    pthread_mutex_lock(&stream->lock);
+    while (slot->step != step && !stream->ioErr) {
+      pthread_cond_wait(&stream->cond, &stream->lock);
+    }
+    int err = stream->ioErr;
+    pthread_mutex_unlock(&stream->lock);
+    stats->waitSecs += getBenchTime() - waitStart;
+    if (err) return err;
+
+    int i, j, k;
+    getStepTiles(stream, step, &i, &j, &k);
+    const int mm = min(t, stream->m - i*t);
+    const int nn = min(t, stream->n - k*t);
+    const int pp = min(t, stream->p - j*t);
+    double start = getBenchTime();
+    if (k == 0) {
+      gemmBlocked(mm, nn, pp, slot->a, nn, slot->b, pp, c, pp);
+    }
+    else {
+      gemmBlockedAdd(mm, nn, pp, slot->a, nn, slot->b, pp, c, pp);
+    }
+    stats->computeSecs += getBenchTime() - start;
+
+    // Release the slot to the I/O thread before writing
+    pthread_mutex_lock(&stream->lock);
+    slot->step = -1;
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+
+    if (k == stream->nTilesN - 1) {
+      start = getBenchTime();
+      for (int r = 0; r < mm; r++) {
+        err = pwriteFully(fdC, &c[(size_t)r*pp], pp*sizeof(MatrixBaseType),
+                          entryOffset(headerC, i*t + r, j*t));
+        if (err) return err;
+      }
+      stats->writeSecs += getBenchTime() - start;
+      stats->bytesWritten += (size_t)mm*pp*sizeof(MatrixBaseType);
+    }
+  }
+  return 0;
+}
+
+void
+streamMulFiles(const char *aPath, const char *bPath, const char *cPath,
+               size_t memoryBudget, StreamMulStats *stats, int *err)
+{
+  double start = getBenchTime();
+  StreamMulStats localStats;
+  if (!stats) stats = &localStats;
+  memset(stats, 0, sizeof(StreamMulStats));
+  Stream stream = { .fdA = -1, .fdB = -1 };
+  int fdC = -1;
+  MatrixBaseType *buffers = NULL;
+
+  // Open the operands and check that they can be multiplied
+  *err = openOperand(aPath, &stream.fdA, &stream.headerA);
+  if (!*err) *err = openOperand(bPath, &stream.fdB, &stream.headerB);
+  if (*err) goto done;
+  stream.m = stream.headerA.nRows;
+  stream.n = stream.headerA.nCols;
+  stream.p = stream.headerB.nCols;
+  if (stream.headerB.nRows != stream.headerA.nCols) {
+    *err = EDOM;
+    goto done;
+  }
+  stream.tile = getTileSize(memoryBudget, stream.m, stream.n, stream.p);
+  if (stream.tile == 0) {
+    *err = EINVAL;
+    goto done;
+  }
+  const int t = stream.tile;
+  stream.nTilesM = (stream.m + t - 1)/t;
+  stream.nTilesN = (stream.n + t - 1)/t;
+  stream.nTilesP = (stream.p + t - 1)/t;
+  stream.nSteps = (long)stream.nTilesM*stream.nTilesN*stream.nTilesP;
+
+  // Allocate all the tile buffers at once
+  const size_t tileEntries = (size_t)t*t;
+  buffers = malloc(N_TILE_BUFFERS*tileEntries*sizeof(MatrixBaseType));
+  if (!buffers) {
+    *err = ENOMEM;
+    goto done;
+  }
+  for (int s = 0; s < N_SLOTS; s++) {
+    stream.slots[s].a = &buffers[(2*s)*tileEntries];
+    stream.slots[s].b = &buffers[(2*s + 1)*tileEntries];
+    stream.slots[s].step = -1;
+  }
+  MatrixBaseType *c = &buffers[2*N_SLOTS*tileEntries];
+
+  // Create the product file with its full size, so that tiles can be
+  // written in any order
+  MatrixFileHeader headerC = {
+    .magic = MATRIX_FILE_MAGIC,
+    .version = MATRIX_FILE_VERSION,
+    .byteOrder = MATRIX_FILE_BYTE_ORDER,
+    .elemType = MATRIX_FILE_INT32,
+    .elemSize = sizeof(MatrixBaseType),
+    .nRows = stream.m,
+    .nCols = stream.p,
+    .rowStride = stream.p,
+    .dataOffset = sizeof(MatrixFileHeader),
+  };
+  const size_t sizeC = getMatrixFileSize(&headerC, err);
+  if (*err) goto done;
+  fdC = open(cPath, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fdC < 0 || ftruncate(fdC, sizeC) < 0) {
+    *err = errno;
+    goto done;
+  }
+  *err = pwriteFully(fdC, &headerC, sizeof(headerC), 0);
+  if (*err) goto done;
+
+  // Multiply, with the I/O thread reading ahead
+  pthread_mutex_init(&stream.lock, NULL);
+  pthread_cond_init(&stream.cond, NULL);
+  pthread_t ioThread;
+  *err = pthread_create(&ioThread, NULL, readTiles, &stream);
+  if (!*err) {
+    *err = computeTiles(&stream, fdC, &headerC, c, stats);
+    pthread_mutex_lock(&stream.lock);
+    stream.isCancelled = true;
+    pthread_cond_broadcast(&stream.cond);
+    pthread_mutex_unlock(&stream.lock);
+    pthread_join(ioThread, NULL);
+  }
+  pthread_cond_destroy(&stream.cond);
+  pthread_mutex_destroy(&stream.lock);
+
+  stats->tileSize = t;
+  stats->nSteps = stream.nSteps;
+  stats->bufferBytes = N_TILE_BUFFERS*tileEntries*sizeof(MatrixBaseType);
+  stats->bytesRead = stream.bytesRead;
+  stats->readSecs = stream.readSecs;
+
+ done:
+  if (fdC >= 0 && close(fdC) < 0 && !*err) *err = errno;
+  if (stream.fdA >= 0) close(stream.fdA);
+  if (stream.fdB >= 0) close(stream.fdB);
+  free(buffers);
+  stats->totalSecs = getBenchTime() - start;
+}
@@ -0,0 +1,44 @@
+#ifndef _STREAM_MUL_H
+#define _STREAM_MUL_H
+
+#include <stddef.h>
+
+/** Out-of-core multiplication of matrices stored in matrix files (see
+ *  matrix_file.h), for matrices which are too large to be held in
+ *  memory.  The product is computed a tile at a time: for each tile of
+ *  the product, the corresponding tiles of the operands are read from
+ *  their files panel by panel and multiplied into the product tile,
+ *  which is then written to the product file.  Operand tiles are
+ *  double-buffered: a separate I/O thread reads the next pair of tiles
+ *  while the current pair is being multiplied.
+ */
+
+/** Statistics for a streaming multiplication */
+typedef struct {
+  int tileSize;         //maximum tile dimension used
+  long nSteps;          //# of operand tile pairs multiplied
+  size_t bufferBytes;   //total size of all tile buffers
+  size_t bytesRead;     //from operand files
+  size_t bytesWritten;  //to product file
+  double readSecs;      //time spent reading by the I/O thread
+  double writeSecs;     //time spent writing product tiles
+  double computeSecs;   //time spent multiplying tiles
+  double waitSecs;      //time computation waited for reads
+  double totalSecs;     //elapsed time
+} StreamMulStats;
+
+/** Multiply the matrix in file aPath by the matrix in file bPath,
+ *  writing the product to a new matrix file at cPath (replacing any
+ *  existing file).  The tiles are chosen so that the tile buffers use
+ *  at most memoryBudget bytes.  If stats is not NULL, then set *stats
+ *  to statistics for the multiplication.
+ *
+ *  Set *err to EINVAL if either file is not a valid matrix file or
+ *  memoryBudget is too small for even 1x1 tiles, to EDOM if the
+ *  matrices cannot be multiplied, to ENOMEM if not enough memory, or
+ *  to errno if a file cannot be opened, read or written.
+ */
+void streamMulFiles(const char *aPath, const char *bPath, const char *cPath,
+                    size_t memoryBudget, StreamMulStats *stats, int *err);
+
+#endif //ifndef _STREAM_MUL_H
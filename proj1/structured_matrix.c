@@ -0,0 +1,458 @@
+#include "abstract_matrix.h"
+#include "gemm_kernel.h"
+#include "structured_matrix.h"
+#include "structured_matrix_impl.h"
+#include "workspace.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** # of rows (or columns) of each block unpacked for multiplication */
+enum { UNPACK_BLOCK = 64 };
+
+/** Rows with at most this many stored entries are multiplied a row at
+ *  a time rather than by unpacking blocks, since a block would then be
+ *  mostly structural zeros.
+ */
+enum { MAX_NARROW_ENTRIES = 16 };
+
+/** Examines the matrix as a StructuredMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifyStructuredMatrix(const Matrix *this, int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  if (matrix->nRows <= 0 || matrix->nCols <= 0) {
+    *err = EINVAL;
+  }
+}
+
+static MatrixBaseType *
+getRowEntries(const Matrix *this, int rowIndex, int *begin, int *end)
+{
+  const StructuredMatrixFns *fns = (const StructuredMatrixFns *)this->fns;
+  return fns->getRowEntries(this, rowIndex, begin, end);
+}
+
+/** Return the greatest # of entries stored in any row of this */
+static int
+getMaxRowEntries(const StructuredMatrixImpl *matrix)
+{
+  int maxEntries = 0;
+  for (int i = 0; i < matrix->nRows; i++) {
+    int begin, end;
+    getRowEntries((const Matrix *)matrix, i, &begin, &end);
+    if (end - begin > maxEntries) maxEntries = end - begin;
+  }
+  return maxEntries;
+}
+
+/** Copy rows [r0, r1) x columns [c0, c1) of matrix, including the
+ *  structural zeros, into block with rows ld entries apart.
+ */
+static void
+unpackBlock(const StructuredMatrixImpl *matrix, int r0, int r1, int c0, int c1,
+            MatrixBaseType *block, int ld)
+{
+  for (int i = r0; i < r1; i++) {
+    MatrixBaseType *row = &block[(size_t)(i - r0)*ld];
+    memset(row, 0, (c1 - c0)*sizeof(MatrixBaseType));
+    int begin, end;
+    const MatrixBaseType *entries =
+      getRowEntries((const Matrix *)matrix, i, &begin, &end);
+    const int j0 = (begin > c0) ? begin : c0;
+    const int j1 = (end < c1) ? end : c1;
+    if (j0 < j1) {
+      memcpy(&row[j0 - c0], &entries[j0 - begin],
+             (j1 - j0)*sizeof(MatrixBaseType));
+    }
+  }
+}
+
+/************************** Matrix Functions ***************************/
+
+static void freeStructuredMatrix(Matrix *this, int *err)
+{
+  verifyStructuredMatrix(this, err);
+  free(this);
+}
+
+static int getNRows(const Matrix *this, int *err)
+{
+  verifyStructuredMatrix(this, err);
+  return ((const StructuredMatrixImpl *)this)->nRows;
+}
+
+static int getNCols(const Matrix *this, int *err)
+{
+  verifyStructuredMatrix(this, err);
+  return ((const StructuredMatrixImpl *)this)->nCols;
+}
+
+static MatrixBaseType getElement(const Matrix *this,
+                                 int rowIndex, int colIndex, int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return 0;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows ||
+      colIndex < 0 || colIndex >= matrix->nCols) {
+    *err = EDOM;
+    return 0;
+  }
+  int begin, end;
+  const MatrixBaseType *entries = getRowEntries(this, rowIndex, &begin, &end);
+  return (begin <= colIndex && colIndex < end) ? entries[colIndex - begin] : 0;
+}
+
+/** Entries outside the structure can only be set to 0 */
+static void setElement(Matrix *this, int rowIndex, int colIndex,
+                       MatrixBaseType element, int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows ||
+      colIndex < 0 || colIndex >= matrix->nCols) {
+    *err = EDOM;
+    return;
+  }
+  int begin, end;
+  MatrixBaseType *entries = getRowEntries(this, rowIndex, &begin, &end);
+  if (begin <= colIndex && colIndex < end) {
+    entries[colIndex - begin] = element;
+  }
+  else if (element != 0) {
+    *err = EDOM;
+  }
+}
+
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  unpackBlock(matrix, rowIndex, rowIndex + 1, 0, matrix->nCols, row,
+              matrix->nCols);
+}
+
+/** The row is left unchanged if it has a non-zero entry outside the
+ *  structure.
+ */
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->nRows) {
+    *err = EDOM;
+    return;
+  }
+  int begin, end;
+  MatrixBaseType *entries = getRowEntries(this, rowIndex, &begin, &end);
+  for (int j = 0; j < matrix->nCols; j++) {
+    if ((j < begin || j >= end) && row[j] != 0) {
+      *err = EDOM;
+      return;
+    }
+  }
+  if (begin < end) {
+    memcpy(entries, &row[begin], (end - begin)*sizeof(MatrixBaseType));
+  }
+}
+
+/** Multiply a row of this at a time, accumulating each product row
+ *  from the multiplier rows selected by the stored entries.
+ */
+static void
+mulNarrow(const StructuredMatrixImpl *matrix, int p,
+          const MatrixBaseType *b, int ldb, MatrixBaseType *c, int ldc)
+{
+  for (int i = 0; i < matrix->nRows; i++) {
+    int begin, end;
+    const MatrixBaseType *entries =
+      getRowEntries((const Matrix *)matrix, i, &begin, &end);
+    gemvTrans(end - begin, p, &b[(size_t)begin*ldb], ldb, entries,
+              &c[(size_t)i*ldc]);
+  }
+}
+
+/** Multiply a block of rows of this at a time, unpacked over the
+ *  columns which may be non-zero in them: for triangular and banded
+ *  structures, these are the columns which meet the structure.
+ */
+static void
+mulBlocks(const StructuredMatrixImpl *matrix, int p,
+          const MatrixBaseType *b, int ldb, MatrixBaseType *c, int ldc,
+          int *err)
+{
+  Workspace *workspace = getThreadWorkspace(err);
+  if (!workspace) return;
+  MatrixBaseType *block =
+    getWorkspaceBuffer(workspace, WORKSPACE_UNPACKED,
+                       (size_t)UNPACK_BLOCK*matrix->nCols
+                       *sizeof(MatrixBaseType), err);
+  if (!block) return;
+  for (int i0 = 0; i0 < matrix->nRows; i0 += UNPACK_BLOCK) {
+    const int i1 = (i0 + UNPACK_BLOCK < matrix->nRows)
+      ? i0 + UNPACK_BLOCK : matrix->nRows;
+    int c0 = matrix->nCols, c1 = 0;
+    for (int i = i0; i < i1; i++) {
+      int begin, end;
+      getRowEntries((const Matrix *)matrix, i, &begin, &end);
+      if (begin < end && begin < c0) c0 = begin;
+      if (begin < end && end > c1) c1 = end;
+    }
+    if (c0 >= c1) {
+      for (int i = i0; i < i1; i++) {
+        memset(&c[(size_t)i*ldc], 0, p*sizeof(MatrixBaseType));
+      }
+      continue;
+    }
+    unpackBlock(matrix, i0, i1, c0, c1, block, c1 - c0);
+    gemmBlocked(i1 - i0, c1 - c0, p, block, c1 - c0,
+                &b[(size_t)c0*ldb], ldb, &c[(size_t)i0*ldc], ldc);
+  }
+}
+
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(matrix->nRows == pr_m && matrix->nCols == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic multiplication unless we can get at the
+  // storage of the multiplier and product
+  int ldb, ldc;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (!b || !c) {
+    getAbstractMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+  if (getMaxRowEntries(matrix) <= MAX_NARROW_ENTRIES) {
+    mulNarrow(matrix, pr_p, b, ldb, c, ldc);
+  }
+  else {
+    mulBlocks(matrix, pr_p, b, ldb, c, ldc, err);
+  }
+}
+
+/** Only the stored entries contribute */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  for (int i = 0; i < matrix->nRows; i++) {
+    int begin, end;
+    const MatrixBaseType *entries = getRowEntries(this, i, &begin, &end);
+    result[i] = (begin < end) ? dotProduct(end - begin, entries, &vec[begin])
+                              : 0;
+  }
+}
+
+/** Accumulate the stored entries of each row r, scaled by vec[r] */
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  verifyStructuredMatrix(this, err);
+  if (*err == EINVAL) return;
+  memset(result, 0, matrix->nCols*sizeof(MatrixBaseType));
+  for (int i = 0; i < matrix->nRows; i++) {
+    int begin, end;
+    const MatrixBaseType *entries = getRowEntries(this, i, &begin, &end);
+    if (begin < end) {
+      axpyVector(end - begin, vec[i], entries, &result[begin]);
+    }
+  }
+}
+
+/** Multiply a block of rows of this at a time by the structured
+ *  multiplier, scaling each row of the multiplier into the
+ *  corresponding product rows of the block; the rows are too short to
+ *  be worth a call to the vector kernels, and the block keeps the
+ *  product rows resident in cache while the multiplier is swept.
+ */
+static void
+mulByNarrow(int m, const MatrixBaseType *a, int lda,
+            const StructuredMatrixImpl *multiplier,
+            MatrixBaseType *c, int ldc)
+{
+  enum { MUL_BY_ROWS = 32 };
+  const int n = multiplier->nRows, p = multiplier->nCols;
+  for (int i0 = 0; i0 < m; i0 += MUL_BY_ROWS) {
+    const int i1 = (i0 + MUL_BY_ROWS < m) ? i0 + MUL_BY_ROWS : m;
+    for (int i = i0; i < i1; i++) {
+      memset(&c[(size_t)i*ldc], 0, p*sizeof(MatrixBaseType));
+    }
+    for (int k = 0; k < n; k++) {
+      int begin, end;
+      const MatrixBaseType *entries =
+        getRowEntries((const Matrix *)multiplier, k, &begin, &end);
+      for (int i = i0; i < i1; i++) {
+        const MatrixBaseType aik = a[(size_t)i*lda + k];
+        MatrixBaseType *cRow = &c[(size_t)i*ldc + begin];
+        for (int j = 0; j < end - begin; j++) cRow[j] += aik*entries[j];
+      }
+    }
+  }
+}
+
+/** Multiply by a block of columns of multiplier at a time, unpacked
+ *  over the rows which may be non-zero in them.
+ */
+static void
+mulByBlocks(int m, const MatrixBaseType *a, int lda,
+            const StructuredMatrixImpl *multiplier,
+            MatrixBaseType *c, int ldc, int *err)
+{
+  const int n = multiplier->nRows, p = multiplier->nCols;
+  Workspace *workspace = getThreadWorkspace(err);
+  if (!workspace) return;
+  MatrixBaseType *block =
+    getWorkspaceBuffer(workspace, WORKSPACE_UNPACKED,
+                       (size_t)n*UNPACK_BLOCK*sizeof(MatrixBaseType), err);
+  if (!block) return;
+  for (int j0 = 0; j0 < p; j0 += UNPACK_BLOCK) {
+    const int j1 = (j0 + UNPACK_BLOCK < p) ? j0 + UNPACK_BLOCK : p;
+    int r0 = n, r1 = 0;
+    for (int k = 0; k < n; k++) {
+      int begin, end;
+      getRowEntries((const Matrix *)multiplier, k, &begin, &end);
+      if (begin < j1 && end > j0) {
+        if (k < r0) r0 = k;
+        r1 = k + 1;
+      }
+    }
+    if (r0 >= r1) {
+      for (int i = 0; i < m; i++) {
+        memset(&c[(size_t)i*ldc + j0], 0, (j1 - j0)*sizeof(MatrixBaseType));
+      }
+      continue;
+    }
+    unpackBlock(multiplier, r0, r1, j0, j1, block, j1 - j0);
+    gemmBlocked(m, r1 - r0, j1 - j0, &a[r0], lda, block, j1 - j0,
+                &c[j0], ldc);
+  }
+}
+
+_Bool
+mulByStructuredMatrix(const Matrix *this, const Matrix *multiplier,
+                      Matrix *product, int *err)
+{
+  const StructuredMatrixImpl *b = (const StructuredMatrixImpl *)multiplier;
+  int lda, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return false;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return false;
+  if (!a || !c) return false;
+  const int m = this->fns->getNRows(this, err);
+  if (getMaxRowEntries(b) <= MAX_NARROW_ENTRIES) {
+    mulByNarrow(m, a, lda, b, c, ldc);
+  }
+  else {
+    mulByBlocks(m, a, lda, b, c, ldc, err);
+  }
+  return true;
+}
+
+size_t
+getStructuredMatrixNEntries(const StructuredMatrix *this)
+{
+  const StructuredMatrixImpl *matrix = (const StructuredMatrixImpl *)this;
+  size_t nEntries = 0;
+  for (int i = 0; i < matrix->nRows; i++) {
+    int begin, end;
+    getRowEntries((const Matrix *)this, i, &begin, &end);
+    nEntries += end - begin;
+  }
+  return nEntries;
+}
+
+size_t
+getStructuredMatrixStorageSize(const StructuredMatrix *this)
+{
+  return ((const StructuredMatrixImpl *)this)->nStored*sizeof(MatrixBaseType);
+}
+
+StructuredMatrixImpl *
+newStructuredMatrix(size_t implSize, int nRows, int nCols, size_t nStored,
+                    const StructuredMatrixFns *fns, int *err)
+{
+  if (nStored > (SIZE_MAX - implSize)/sizeof(MatrixBaseType)) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  StructuredMatrixImpl *matrix =
+    calloc(1, implSize + nStored*sizeof(MatrixBaseType));
+  if (!matrix) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  matrix->nRows = nRows;
+  matrix->nCols = nCols;
+  matrix->entries = (MatrixBaseType *)((char *)matrix + implSize);
+  matrix->nStored = nStored;
+  matrix->fns = (const MatrixFns *)fns;
+  return matrix;
+}
+
+static _Bool isInit = false;
+static StructuredMatrixFns structuredMatrixFns = {
+  .free = freeStructuredMatrix,
+  .getNRows = getNRows,
+  .getNCols = getNCols,
+  .getElement = getElement,
+  .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
+};
+
+static void patchStructuredMatrixFns(void)
+{
+  if (!isInit) {
+    const MatrixFns *fns = getAbstractMatrixFns();
+    structuredMatrixFns.getData = fns->getData;
+    structuredMatrixFns.transpose = fns->transpose;
+    isInit = true;
+  }
+}
+
+const StructuredMatrixFns *
+getStructuredMatrixFns(void)
+{
+  patchStructuredMatrixFns();
+  return &structuredMatrixFns;
+}
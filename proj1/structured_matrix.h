@@ -0,0 +1,72 @@
+#ifndef _STRUCTURED_MATRIX_H
+#define _STRUCTURED_MATRIX_H
+
+#include "matrix.h"
+
+#include <stddef.h>
+
+/** Abstract base class for matrices whose entries outside a known
+ *  structure (a triangle, the diagonal or a band) are always 0.  Only
+ *  the entries within the structure are stored, packed a row at a
+ *  time, so that the entries which may be non-zero in each row are
+ *  contiguous.
+ *
+ *  Entries outside the structure can only be set to 0; setting them
+ *  to anything else sets *err to EDOM.  No row-major storage is
+ *  provided (getData() returns NULL).
+ *
+ *  Multiplication skips the structural zeros: when the multiplier
+ *  and product provide row-major storage, each block of rows is
+ *  unpacked over just the columns which may be non-zero in it and
+ *  multiplied using the cache-blocked kernel; when no row has more
+ *  than a few stored entries, each row of the product is instead
+ *  accumulated from the rows of the multiplier selected by those
+ *  entries.  mulByStructuredMatrix() does the same when a structured
+ *  matrix is the multiplier.  mulVec() and vecMul() only touch the
+ *  stored entries.
+ */
+
+typedef struct StructuredMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+
+  /** Return a pointer to the stored entries of row rowIndex and set
+   *  [*begin, *end) to the range of columns they hold, so that entry
+   *  [rowIndex][j] is at offset j - *begin for *begin <= j < *end;
+   *  all other entries of the row are 0.  The range may be empty.  No
+   *  error checking is done: this must be valid and rowIndex in
+   *  range.
+   */
+  MatrixBaseType *(*getRowEntries)(const Matrix *this, int rowIndex,
+                                   int *begin, int *end);
+} StructuredMatrixFns;
+
+typedef struct StructuredMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} StructuredMatrix;
+
+/** Return the # of entries of this which may be non-zero; the # of
+ *  multiply-adds needed to multiply this by a matrix with p columns,
+ *  or a matrix with p rows by this, is p times this.
+ */
+size_t getStructuredMatrixNEntries(const StructuredMatrix *this);
+
+/** Return the # of bytes used to store the entries of this. */
+size_t getStructuredMatrixStorageSize(const StructuredMatrix *this);
+
+/** The kernel registered in mul_dispatch.h for a multiplicand and
+ *  product with row-major storage and a structured multiplier: set
+ *  product to this * multiplier, unpacking blocks of columns of the
+ *  multiplier over just the rows which may be non-zero in them.
+ *  Return false if this or product does not provide storage.
+ */
+_Bool mulByStructuredMatrix(const Matrix *this, const Matrix *multiplier,
+                            Matrix *product, int *err);
+
+/** Return implementation of functions for a structured matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.  Sub-classes must provide getKlass(), getKlassId() and
+ *  getRowEntries().
+ */
+const StructuredMatrixFns *getStructuredMatrixFns(void);
+
+#endif //ifndef _STRUCTURED_MATRIX_H
@@ -0,0 +1,31 @@
+#ifndef _STRUCTURED_MATRIX_IMPL_H
+#define _STRUCTURED_MATRIX_IMPL_H
+
+#include "structured_matrix.h"
+
+#include <stddef.h>
+
+/** Layout of a structured matrix.  This is private to the structured
+ *  matrix family of classes; sub-classes extend it with the
+ *  parameters of their structure.
+ */
+typedef struct {
+  StructuredMatrix;
+  int nRows;
+  int nCols;
+  MatrixBaseType *entries;  //nStored packed entries allocated after
+                            //the sub-class struct
+  size_t nStored;
+} StructuredMatrixImpl;
+
+/** Return a newly allocated structured matrix of implSize bytes (the
+ *  size of the sub-class struct, which starts with a
+ *  StructuredMatrixImpl) with nStored entries all initialized to 0,
+ *  using fns.  Set *err to ENOMEM if not enough memory.  The caller
+ *  must have checked nRows and nCols.
+ */
+StructuredMatrixImpl *
+newStructuredMatrix(size_t implSize, int nRows, int nCols, size_t nStored,
+                    const StructuredMatrixFns *fns, int *err);
+
+#endif //ifndef _STRUCTURED_MATRIX_IMPL_H
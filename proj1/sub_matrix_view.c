@@ -0,0 +1,253 @@
+#include "abstract_matrix.h"
+#include "blocked_mul_matrix.h"
+#include "sub_matrix_view.h"
+#include "transpose_kernel.h"
+#include "typed_matrix.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  SubMatrixView;
+  Matrix *parent;
+  int rowOffset;
+  int colOffset;
+  int nRows;
+  int nCols;
+  _Bool ownsParent;
+} SubMatrixViewImpl;
+
+/** Examines the matrix as a SubMatrixView, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifySubMatrixView(const Matrix *this, int *err)
+{
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  if (!view->parent || view->nRows <= 0 || view->nCols <= 0) {
+    *err = EINVAL;
+  }
+}
+
+/** Return true iff [rowIndex][colIndex] is within view, setting *err
+ *  to EDOM if not.
+ */
+static _Bool
+checkIndexes(const SubMatrixViewImpl *view, int rowIndex, int colIndex,
+             int *err)
+{
+  if (rowIndex < 0 || rowIndex >= view->nRows ||
+      colIndex < 0 || colIndex >= view->nCols) {
+    *err = EDOM;
+    return false;
+  }
+  return true;
+}
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifySubMatrixView(this, err);
+  return "subMatrixView";
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifySubMatrixView(this, err);
+  return MATRIX_KLASS_SUB_MATRIX_VIEW;
+}
+
+static void freeSubMatrixView(Matrix *this, int *err)
+{
+  verifySubMatrixView(this, err);
+  SubMatrixViewImpl *view = (SubMatrixViewImpl *)this;
+  if (view->ownsParent) view->parent->fns->free(view->parent, err);
+  free(view);
+}
+
+static int getNRows(const Matrix *this, int *err)
+{
+  verifySubMatrixView(this, err);
+  return ((const SubMatrixViewImpl *)this)->nRows;
+}
+
+static int getNCols(const Matrix *this, int *err)
+{
+  verifySubMatrixView(this, err);
+  return ((const SubMatrixViewImpl *)this)->nCols;
+}
+
+static MatrixBaseType getElement(const Matrix *this,
+                                 int rowIndex, int colIndex, int *err)
+{
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL || !checkIndexes(view, rowIndex, colIndex, err)) {
+    return 0;
+  }
+  const Matrix *parent = view->parent;
+  return parent->fns->getElement(parent, view->rowOffset + rowIndex,
+                                 view->colOffset + colIndex, err);
+}
+
+static void setElement(Matrix *this, int rowIndex, int colIndex,
+                       MatrixBaseType element, int *err)
+{
+  SubMatrixViewImpl *view = (SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL || !checkIndexes(view, rowIndex, colIndex, err)) {
+    return;
+  }
+  Matrix *parent = view->parent;
+  parent->fns->setElement(parent, view->rowOffset + rowIndex,
+                          view->colOffset + colIndex, element, err);
+}
+
+/** The storage of this starts at its [0][0] entry within the storage
+ *  of the parent and has the same row stride.
+ */
+static MatrixBaseType *getData(const Matrix *this, int *rowStride, int *err)
+{
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL) return NULL;
+  const Matrix *parent = view->parent;
+  MatrixBaseType *data = parent->fns->getData(parent, rowStride, err);
+  if (!data) return NULL;
+  return &data[(size_t)view->rowOffset*(*rowStride) + view->colOffset];
+}
+
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL || !checkIndexes(view, rowIndex, 0, err)) return;
+  int ld;
+  const MatrixBaseType *data = getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    getAbstractMatrixFns()->getRow(this, rowIndex, row, err);
+    return;
+  }
+  memcpy(row, &data[(size_t)rowIndex*ld], view->nCols*sizeof(MatrixBaseType));
+}
+
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL || !checkIndexes(view, rowIndex, 0, err)) return;
+  int ld;
+  MatrixBaseType *data = getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    getAbstractMatrixFns()->setRow(this, rowIndex, row, err);
+    return;
+  }
+  memcpy(&data[(size_t)rowIndex*ld], row, view->nCols*sizeof(MatrixBaseType));
+}
+
+static void transpose(const Matrix *this, Matrix *result, int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const SubMatrixViewImpl *view = (const SubMatrixViewImpl *)this;
+  verifySubMatrixView(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(view->nRows == result_m && view->nCols == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic transpose unless we can get at the
+  // storage of both this and the result
+  int ld, resultLd;
+  const MatrixBaseType *data = getData(this, &ld, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!data || !res) {
+    getAbstractMatrixFns()->transpose(this, result, err);
+    return;
+  }
+  transposeRecursive(view->nRows, view->nCols, data, ld, res, resultLd);
+}
+
+static _Bool isInit = false;
+static SubMatrixViewFns subMatrixViewFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .free = freeSubMatrixView,
+  .getNRows = getNRows,
+  .getNCols = getNCols,
+  .getElement = getElement,
+  .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .getData = getData,
+  .transpose = transpose,
+};
+
+SubMatrixView *
+newSubMatrixView(Matrix *parent, int rowOffset, int colOffset,
+                 int nRows, int nCols, _Bool ownsParent, int *err)
+{
+  if (!parent || nRows <= 0 || nCols <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+  const int parentNRows = parent->fns->getNRows(parent, err);
+  if (*err == EINVAL) return NULL;
+  const int parentNCols = parent->fns->getNCols(parent, err);
+  if (*err == EINVAL) return NULL;
+  if (rowOffset < 0 || colOffset < 0 ||
+      rowOffset + nRows > parentNRows || colOffset + nCols > parentNCols) {
+    *err = EDOM;
+    return NULL;
+  }
+  SubMatrixViewImpl *view = malloc(sizeof(SubMatrixViewImpl));
+  if (!view) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  view->fns = (MatrixFns *)getSubMatrixViewFns();
+  view->parent = parent;
+  view->rowOffset = rowOffset;
+  view->colOffset = colOffset;
+  view->nRows = nRows;
+  view->nCols = nCols;
+  view->ownsParent = ownsParent;
+  return (SubMatrixView *)view;
+}
+
+static void patchSubMatrixViewFns(void)
+{
+  if (!isInit) {
+    //blocked multiplication (and the matrix-vector products it
+    //inherits) works on any operands with storage and falls back to
+    //the generic algorithms otherwise
+    const BlockedMulMatrixFns *fns = getBlockedMulMatrixFns();
+    subMatrixViewFns.mul = fns->mul;
+    subMatrixViewFns.mulVec = fns->mulVec;
+    subMatrixViewFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+/** Return implementation of functions for a sub-matrix view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const SubMatrixViewFns *
+getSubMatrixViewFns(void)
+{
+  patchSubMatrixViewFns();
+  return &subMatrixViewFns;
+}
+
+#define TM_TEMPLATE "sub_matrix_view_template.h"
+#include "typed_matrix_instances.h"
@@ -0,0 +1,40 @@
+#ifndef _SUB_MATRIX_VIEW_H
+#define _SUB_MATRIX_VIEW_H
+
+#include "matrix.h"
+
+typedef struct SubMatrixViewFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} SubMatrixViewFns;
+
+typedef struct SubMatrixView {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} SubMatrixView;
+
+/** Return a newly allocated view of the nRows x nCols block of parent
+ *  whose [0][0] entry is entry [rowOffset][colOffset] of parent.  No
+ *  entries are copied; reading or writing the view reads or writes
+ *  parent, so parent must remain valid while the view is in use.  If
+ *  ownsParent, then parent is freed when the view is freed.
+ *
+ *  If parent provides row-major storage (see getData() in matrix.h),
+ *  then so does the view: its storage starts within that of the
+ *  parent and has the same row stride.  Hence all the kernels which
+ *  work directly on storage work in place on the block; in
+ *  particular, multiplying a view uses the cache-blocked algorithm.
+ *
+ *  Set *err to EINVAL if parent is NULL or not in valid state or if
+ *  nRows or nCols <= 0, to EDOM if the block is not within parent, to
+ *  ENOMEM if not enough memory.
+ */
+SubMatrixView *newSubMatrixView(Matrix *parent, int rowOffset, int colOffset,
+                                int nRows, int nCols, _Bool ownsParent,
+                                int *err);
+
+/** Return implementation of functions for a sub-matrix view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const SubMatrixViewFns *getSubMatrixViewFns(void);
+
+#endif //ifndef _SUB_MATRIX_VIEW_H
@@ -0,0 +1,264 @@
+/** Template for the implementation of the sub-matrix view class for
+ *  a single element type; see typed_template.h.
+ */
+
+typedef struct {
+  TM_NAME(SubMatrixView);
+  TM_NAME(Matrix) *parent;
+  int rowOffset;
+  int colOffset;
+  int nRows;
+  int nCols;
+  _Bool ownsParent;
+} TM_NAME(SubMatrixViewImpl);
+
+/** Examines the matrix as a SubMatrixView, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void
+TM_NAME(verifySubMatrixView)(const TM_NAME(Matrix) *this, int *err)
+{
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  if (!view->parent || view->nRows <= 0 || view->nCols <= 0) {
+    *err = EINVAL;
+  }
+}
+
+/** Return true iff [rowIndex][colIndex] is within view, setting *err
+ *  to EDOM if not.
+ */
+static _Bool
+TM_NAME(checkIndexes)(const TM_NAME(SubMatrixViewImpl) *view, int rowIndex,
+                      int colIndex, int *err)
+{
+  if (rowIndex < 0 || rowIndex >= view->nRows ||
+      colIndex < 0 || colIndex >= view->nCols) {
+    *err = EDOM;
+    return false;
+  }
+  return true;
+}
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifySubMatrixView)(this, err);
+  return "subMatrixView" TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifySubMatrixView)(this, err);
+  return MATRIX_KLASS_SUB_MATRIX_VIEW;
+}
+
+static void
+TM_NAME(freeSubMatrixView)(TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifySubMatrixView)(this, err);
+  TM_NAME(SubMatrixViewImpl) *view = (TM_NAME(SubMatrixViewImpl) *)this;
+  if (view->ownsParent) view->parent->fns->free(view->parent, err);
+  free(view);
+}
+
+static int
+TM_NAME(getNRows)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifySubMatrixView)(this, err);
+  return ((const TM_NAME(SubMatrixViewImpl) *)this)->nRows;
+}
+
+static int
+TM_NAME(getNCols)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifySubMatrixView)(this, err);
+  return ((const TM_NAME(SubMatrixViewImpl) *)this)->nCols;
+}
+
+static TM_TYPE
+TM_NAME(getElement)(const TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    int *err)
+{
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL || !TM_NAME(checkIndexes)(view, rowIndex, colIndex, err)) {
+    return 0;
+  }
+  const TM_NAME(Matrix) *parent = view->parent;
+  return parent->fns->getElement(parent, view->rowOffset + rowIndex,
+                                 view->colOffset + colIndex, err);
+}
+
+static void
+TM_NAME(setElement)(TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    TM_TYPE element, int *err)
+{
+  TM_NAME(SubMatrixViewImpl) *view = (TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL || !TM_NAME(checkIndexes)(view, rowIndex, colIndex, err)) {
+    return;
+  }
+  TM_NAME(Matrix) *parent = view->parent;
+  parent->fns->setElement(parent, view->rowOffset + rowIndex,
+                          view->colOffset + colIndex, element, err);
+}
+
+/** The storage of this starts at its [0][0] entry within the storage
+ *  of the parent and has the same row stride.
+ */
+static TM_TYPE *
+TM_NAME(getData)(const TM_NAME(Matrix) *this, int *rowStride, int *err)
+{
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL) return NULL;
+  const TM_NAME(Matrix) *parent = view->parent;
+  TM_TYPE *data = parent->fns->getData(parent, rowStride, err);
+  if (!data) return NULL;
+  return &data[(size_t)view->rowOffset*(*rowStride) + view->colOffset];
+}
+
+static void
+TM_NAME(getRow)(const TM_NAME(Matrix) *this, int rowIndex, TM_TYPE row[],
+                int *err)
+{
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL || !TM_NAME(checkIndexes)(view, rowIndex, 0, err)) return;
+  int ld;
+  const TM_TYPE *data = TM_NAME(getData)(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    TM_NAME(getAbstractMatrixFns)()->getRow(this, rowIndex, row, err);
+    return;
+  }
+  memcpy(row, &data[(size_t)rowIndex*ld], view->nCols*sizeof(TM_TYPE));
+}
+
+static void
+TM_NAME(setRow)(TM_NAME(Matrix) *this, int rowIndex, const TM_TYPE row[],
+                int *err)
+{
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL || !TM_NAME(checkIndexes)(view, rowIndex, 0, err)) return;
+  int ld;
+  TM_TYPE *data = TM_NAME(getData)(this, &ld, err);
+  if (*err == EINVAL) return;
+  if (!data) {
+    TM_NAME(getAbstractMatrixFns)()->setRow(this, rowIndex, row, err);
+    return;
+  }
+  memcpy(&data[(size_t)rowIndex*ld], row, view->nCols*sizeof(TM_TYPE));
+}
+
+static void
+TM_NAME(transpose)(const TM_NAME(Matrix) *this, TM_NAME(Matrix) *result,
+                   int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const TM_NAME(SubMatrixViewImpl) *view =
+    (const TM_NAME(SubMatrixViewImpl) *)this;
+  TM_NAME(verifySubMatrixView)(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(view->nRows == result_m && view->nCols == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic transpose unless we can get at the
+  // storage of both this and the result
+  int ld, resultLd;
+  const TM_TYPE *data = TM_NAME(getData)(this, &ld, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!data || !res) {
+    TM_NAME(getAbstractMatrixFns)()->transpose(this, result, err);
+    return;
+  }
+  TM_NAME(transposeRecursive)(view->nRows, view->nCols, data, ld,
+                             res, resultLd);
+}
+
+static _Bool TM_NAME(isInit) = false;
+static TM_NAME(SubMatrixViewFns) TM_NAME(subMatrixViewFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .free = TM_NAME(freeSubMatrixView),
+  .getNRows = TM_NAME(getNRows),
+  .getNCols = TM_NAME(getNCols),
+  .getElement = TM_NAME(getElement),
+  .setElement = TM_NAME(setElement),
+  .getRow = TM_NAME(getRow),
+  .setRow = TM_NAME(setRow),
+  .getData = TM_NAME(getData),
+  .transpose = TM_NAME(transpose),
+};
+
+TM_NAME(SubMatrixView) *
+TM_NAME(newSubMatrixView)(TM_NAME(Matrix) *parent, int rowOffset, int colOffset,
+                 int nRows, int nCols, _Bool ownsParent, int *err)
+{
+  if (!parent || nRows <= 0 || nCols <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+  const int parentNRows = parent->fns->getNRows(parent, err);
+  if (*err == EINVAL) return NULL;
+  const int parentNCols = parent->fns->getNCols(parent, err);
+  if (*err == EINVAL) return NULL;
+  if (rowOffset < 0 || colOffset < 0 ||
+      rowOffset + nRows > parentNRows || colOffset + nCols > parentNCols) {
+    *err = EDOM;
+    return NULL;
+  }
+  TM_NAME(SubMatrixViewImpl) *view = malloc(sizeof(TM_NAME(SubMatrixViewImpl)));
+  if (!view) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  view->fns = (TM_NAME(MatrixFns) *)TM_NAME(getSubMatrixViewFns)();
+  view->parent = parent;
+  view->rowOffset = rowOffset;
+  view->colOffset = colOffset;
+  view->nRows = nRows;
+  view->nCols = nCols;
+  view->ownsParent = ownsParent;
+  return (TM_NAME(SubMatrixView) *)view;
+}
+
+static void
+TM_NAME(patchSubMatrixViewFns)(void)
+{
+  if (!TM_NAME(isInit)) {
+    //blocked multiplication (and the matrix-vector products it
+    //inherits) works on any operands with storage and falls back to
+    //the generic algorithms otherwise
+    const TM_NAME(BlockedMulMatrixFns) *fns = TM_NAME(getBlockedMulMatrixFns)();
+    TM_NAME(subMatrixViewFns).mul = fns->mul;
+    TM_NAME(subMatrixViewFns).mulVec = fns->mulVec;
+    TM_NAME(subMatrixViewFns).vecMul = fns->vecMul;
+    TM_NAME(isInit) = true;
+  }
+}
+
+/** Return implementation of functions for a sub-matrix view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TM_NAME(SubMatrixViewFns) *
+TM_NAME(getSubMatrixViewFns)(void)
+{
+  TM_NAME(patchSubMatrixViewFns)();
+  return &TM_NAME(subMatrixViewFns);
+}
@@ -0,0 +1,353 @@
+#include "abstract_matrix.h"
+#include "gemm_kernel.h"
+#include "symmetric_matrix.h"
+#include "workspace.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  SymmetricMatrix;
+  int n;
+  MatrixBaseType *entries;  //n*(n + 1)/2 packed entries of the upper
+                            //triangle allocated after the struct
+} SymmetricMatrixImpl;
+
+#define KLASS "symmetricMatrix"
+
+/** # of rows (or columns) of each block unpacked for multiplication */
+enum { UNPACK_BLOCK = 64 };
+
+/** Examines the matrix as a SymmetricMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifySymmetricMatrix(const Matrix *this, int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  if (matrix->n <= 0 || !matrix->entries) *err = EINVAL;
+}
+
+/** Return packed row i of matrix, adjusted so that entry [i][j] is at
+ *  index j for j >= i.
+ */
+static inline MatrixBaseType *
+getPackedRow(const SymmetricMatrixImpl *matrix, int i)
+{
+  const size_t n = matrix->n;
+  return &matrix->entries[i*n - (size_t)i*(i + 1)/2];
+}
+
+/** Copy rows [r0, r1) x columns [c0, c1) of matrix into block with
+ *  rows ld entries apart: the entries below the diagonal are read
+ *  from the corresponding columns of the rows above.
+ */
+static void
+unpackBlock(const SymmetricMatrixImpl *matrix, int r0, int r1, int c0, int c1,
+            MatrixBaseType *block, int ld)
+{
+  for (int i = r0; i < r1; i++) {
+    MatrixBaseType *row = &block[(size_t)(i - r0)*ld];
+    const int jDiag = (i < c0) ? c0 : (i > c1) ? c1 : i;
+    for (int j = c0; j < jDiag; j++) row[j - c0] = getPackedRow(matrix, j)[i];
+    if (jDiag < c1) {
+      memcpy(&row[jDiag - c0], &getPackedRow(matrix, i)[jDiag],
+             (c1 - jDiag)*sizeof(MatrixBaseType));
+    }
+  }
+}
+
+/************************** Matrix Functions ***************************/
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifySymmetricMatrix(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifySymmetricMatrix(this, err);
+  return MATRIX_KLASS_SYMMETRIC;
+}
+
+static void freeSymmetricMatrix(Matrix *this, int *err)
+{
+  verifySymmetricMatrix(this, err);
+  free(this);
+}
+
+static int getNRows(const Matrix *this, int *err)
+{
+  verifySymmetricMatrix(this, err);
+  return ((const SymmetricMatrixImpl *)this)->n;
+}
+
+static int getNCols(const Matrix *this, int *err)
+{
+  verifySymmetricMatrix(this, err);
+  return ((const SymmetricMatrixImpl *)this)->n;
+}
+
+static MatrixBaseType getElement(const Matrix *this,
+                                 int rowIndex, int colIndex, int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return 0;
+  if (rowIndex < 0 || rowIndex >= matrix->n ||
+      colIndex < 0 || colIndex >= matrix->n) {
+    *err = EDOM;
+    return 0;
+  }
+  return (rowIndex <= colIndex)
+    ? getPackedRow(matrix, rowIndex)[colIndex]
+    : getPackedRow(matrix, colIndex)[rowIndex];
+}
+
+/** Also sets entry [colIndex][rowIndex] */
+static void setElement(Matrix *this, int rowIndex, int colIndex,
+                       MatrixBaseType element, int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->n ||
+      colIndex < 0 || colIndex >= matrix->n) {
+    *err = EDOM;
+    return;
+  }
+  if (rowIndex <= colIndex) {
+    getPackedRow(matrix, rowIndex)[colIndex] = element;
+  }
+  else {
+    getPackedRow(matrix, colIndex)[rowIndex] = element;
+  }
+}
+
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->n) {
+    *err = EDOM;
+    return;
+  }
+  unpackBlock(matrix, rowIndex, rowIndex + 1, 0, matrix->n, row, matrix->n);
+}
+
+/** Also sets column rowIndex */
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= matrix->n) {
+    *err = EDOM;
+    return;
+  }
+  for (int j = 0; j < rowIndex; j++) {
+    getPackedRow(matrix, j)[rowIndex] = row[j];
+  }
+  memcpy(&getPackedRow(matrix, rowIndex)[rowIndex], &row[rowIndex],
+         (matrix->n - rowIndex)*sizeof(MatrixBaseType));
+}
+
+/** Multiply a block of rows of this at a time, unpacked into the
+ *  calling thread's workspace.
+ */
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // NxN * NxP = NxP
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  const int n = matrix->n;
+  if (!(n == pr_m && n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the generic multiplication unless we can get at the
+  // storage of the multiplier and product
+  int ldb, ldc;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (!b || !c) {
+    getAbstractMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+  Workspace *workspace = getThreadWorkspace(err);
+  if (!workspace) return;
+  MatrixBaseType *block =
+    getWorkspaceBuffer(workspace, WORKSPACE_UNPACKED,
+                       (size_t)UNPACK_BLOCK*n*sizeof(MatrixBaseType), err);
+  if (!block) return;
+  for (int i0 = 0; i0 < n; i0 += UNPACK_BLOCK) {
+    const int i1 = (i0 + UNPACK_BLOCK < n) ? i0 + UNPACK_BLOCK : n;
+    unpackBlock(matrix, i0, i1, 0, n, block, n);
+    gemmBlocked(i1 - i0, n, pr_p, block, n, b, ldb, &c[(size_t)i0*ldc], ldc);
+  }
+}
+
+/** Each stored entry [i][j] contributes to both result[i] and
+ *  result[j]; since this is symmetric, this is also vecMul().
+ */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  const SymmetricMatrixImpl *matrix = (const SymmetricMatrixImpl *)this;
+  verifySymmetricMatrix(this, err);
+  if (*err == EINVAL) return;
+  const int n = matrix->n;
+  memset(result, 0, n*sizeof(MatrixBaseType));
+  for (int i = 0; i < n; i++) {
+    const MatrixBaseType *row = getPackedRow(matrix, i);
+    result[i] += dotProduct(n - i, &row[i], &vec[i]);
+    if (i + 1 < n) axpyVector(n - i - 1, vec[i], &row[i + 1], &result[i + 1]);
+  }
+}
+
+_Bool
+mulBySymmetricMatrix(const Matrix *this, const Matrix *multiplier,
+                     Matrix *product, int *err)
+{
+  const SymmetricMatrixImpl *s = (const SymmetricMatrixImpl *)multiplier;
+  int lda, ldc;
+  const MatrixBaseType *a = this->fns->getData(this, &lda, err);
+  if (*err == EINVAL) return false;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return false;
+  if (!a || !c) return false;
+  const int m = this->fns->getNRows(this, err);
+  const int n = s->n;
+  Workspace *workspace = getThreadWorkspace(err);
+  if (!workspace) return true;
+  MatrixBaseType *block =
+    getWorkspaceBuffer(workspace, WORKSPACE_UNPACKED,
+                       (size_t)n*UNPACK_BLOCK*sizeof(MatrixBaseType), err);
+  if (!block) return true;
+  for (int j0 = 0; j0 < n; j0 += UNPACK_BLOCK) {
+    const int j1 = (j0 + UNPACK_BLOCK < n) ? j0 + UNPACK_BLOCK : n;
+    unpackBlock(s, 0, n, j0, j1, block, j1 - j0);
+    gemmBlocked(m, n, j1 - j0, a, lda, block, j1 - j0, &c[j0], ldc);
+  }
+  return true;
+}
+
+void
+syrkMatrix(const Matrix *a, _Bool isTransA, SymmetricMatrix *product,
+           int *err)
+{
+  SymmetricMatrixImpl *matrix = (SymmetricMatrixImpl *)product;
+  verifySymmetricMatrix((const Matrix *)product, err);
+  if (*err == EINVAL) return;
+  const int nRows = a->fns->getNRows(a, err);
+  if (*err == EINVAL) return;
+  const int nCols = a->fns->getNCols(a, err);
+  if (*err == EINVAL) return;
+  const int n = (isTransA) ? nCols : nRows;
+  const int k = (isTransA) ? nRows : nCols;
+  if (n != matrix->n) {
+    *err = EDOM;
+    return;
+  }
+  int lda;
+  const MatrixBaseType *data = a->fns->getData(a, &lda, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *copy = NULL;
+  if (!data) {
+    copy = malloc((size_t)nRows*nCols*sizeof(MatrixBaseType));
+    if (!copy) {
+      *err = ENOMEM;
+      return;
+    }
+    for (int i = 0; i < nRows; i++) {
+      a->fns->getRow(a, i, &copy[(size_t)i*nCols], err);
+    }
+    data = copy;
+    lda = nCols;
+  }
+  if (isTransA) {
+    syrkTransPacked(n, k, data, lda, matrix->entries);
+  }
+  else {
+    syrkPacked(n, k, data, lda, matrix->entries);
+  }
+  free(copy);
+}
+
+static _Bool isInit = false;
+static SymmetricMatrixFns symmetricMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .free = freeSymmetricMatrix,
+  .getNRows = getNRows,
+  .getNCols = getNCols,
+  .getElement = getElement,
+  .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = mulVec,
+};
+
+static void patchSymmetricMatrixFns(void)
+{
+  if (!isInit) {
+    //the entries are never in row-major order
+    const MatrixFns *fns = getAbstractMatrixFns();
+    symmetricMatrixFns.getData = fns->getData;
+    symmetricMatrixFns.transpose = fns->transpose;
+    isInit = true;
+  }
+}
+
+SymmetricMatrix *
+newSymmetricMatrix(int n, int *err)
+{
+  if (n <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+  const size_t nStored = (size_t)n*(n + 1)/2;
+  if (nStored > (SIZE_MAX - sizeof(SymmetricMatrixImpl))
+                /sizeof(MatrixBaseType)) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  SymmetricMatrixImpl *matrix =
+    calloc(1, sizeof(SymmetricMatrixImpl) + nStored*sizeof(MatrixBaseType));
+  if (!matrix) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  matrix->n = n;
+  matrix->entries = (MatrixBaseType *)&matrix[1];
+  matrix->fns = (const MatrixFns *)getSymmetricMatrixFns();
+  return (SymmetricMatrix *)matrix;
+}
+
+const SymmetricMatrixFns *
+getSymmetricMatrixFns(void)
+{
+  patchSymmetricMatrixFns();
+  return &symmetricMatrixFns;
+}
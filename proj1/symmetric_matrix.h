@@ -0,0 +1,60 @@
+#ifndef _SYMMETRIC_MATRIX_H
+#define _SYMMETRIC_MATRIX_H
+
+#include "matrix.h"
+
+/** A symmetric matrix: entry [i][j] is always entry [j][i], so only
+ *  the upper triangle is stored, packed a row at a time (row i holds
+ *  columns [i, n)), in about half the space of a dense matrix.
+ *
+ *  Setting entry [i][j] also sets entry [j][i]; setting row i also
+ *  sets column i.  No row-major storage is provided (getData()
+ *  returns NULL).  Multiplication by or of a matrix with row-major
+ *  storage unpacks blocks of rows (or of columns) and uses the
+ *  cache-blocked kernel; mulVec() and vecMul() read each stored entry
+ *  once.
+ */
+
+typedef struct SymmetricMatrixFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} SymmetricMatrixFns;
+
+typedef struct SymmetricMatrix {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} SymmetricMatrix;
+
+/** Return a newly allocated n x n symmetric matrix with all entries
+ *  initialized to 0.  Set *err to EINVAL if n <= 0, to ENOMEM if not
+ *  enough memory.
+ */
+SymmetricMatrix *newSymmetricMatrix(int n, int *err);
+
+/** Set product to a * transpose(a) if !isTransA, otherwise to
+ *  transpose(a) * a, without forming the transpose: only the upper
+ *  triangle of product is computed, directly into its packed storage,
+ *  reading a a row at a time.  If a does not provide row-major
+ *  storage, its rows are first copied into a temporary buffer.
+ *
+ *  Set *err to EDOM if product is not n x n where n is the # of rows
+ *  (or if isTransA, the # of columns) of a, to EINVAL if either is not
+ *  in a valid state, to ENOMEM if not enough memory.
+ */
+void syrkMatrix(const Matrix *a, _Bool isTransA, SymmetricMatrix *product,
+                int *err);
+
+/** The kernel registered in mul_dispatch.h for a multiplicand and
+ *  product with row-major storage and a symmetric multiplier: set
+ *  product to this * multiplier, unpacking blocks of columns of the
+ *  multiplier.  Return false if this or product does not provide
+ *  storage.
+ */
+_Bool mulBySymmetricMatrix(const Matrix *this, const Matrix *multiplier,
+                           Matrix *product, int *err);
+
+/** Return implementation of functions for a symmetric matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const SymmetricMatrixFns *getSymmetricMatrixFns(void);
+
+#endif //ifndef _SYMMETRIC_MATRIX_H
@@ -0,0 +1,298 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** # of tasks each deque can hold; a power of 2.  Recursive splitting
+ *  only leaves O(log n) tasks per level of nesting in a deque, so this
+ *  is rarely approached; when it is, tasks are run immediately.
+ */
+enum { DEQUE_SIZE = 1024 };
+
+typedef struct {
+  TaskFn fn;
+  void *arg;
+  TaskGroup *group;
+} Task;
+
+/** A deque of tasks.  Tasks are at indexes [top, bottom) modulo
+ *  DEQUE_SIZE: the owner pushes and pops at the bottom and thieves
+ *  steal from the top.  Each deque is only touched briefly, so a lock
+ *  per deque suffices; it does not serialize the running of tasks.
+ */
+typedef struct {
+  pthread_mutex_t lock;
+  unsigned top;
+  unsigned bottom;
+  Task tasks[DEQUE_SIZE];
+} Deque;
+
+static int poolSize = 0;            //0 until initialized
+static int nWorkers = 0;            //# of running worker threads
+static pthread_t *workers = NULL;
+
+//deques[0] is shared by threads outside the pool; deques[i] belongs
+//to worker i for i > 0
+static Deque *deques = NULL;
+static int nDeques = 0;
+static _Thread_local int myDeque = 0;
+
+//set once the workers (if any) have been started
+static atomic_bool isStarted = false;
+static pthread_mutex_t startLock = PTHREAD_MUTEX_INITIALIZER;
+
+//idle workers sleep on idleCond until a task is pushed; nQueued and
+//nIdle are atomic so that pushing only takes idleLock when some worker
+//is actually asleep
+static pthread_mutex_t idleLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idleCond = PTHREAD_COND_INITIALIZER;
+static atomic_int nQueued = 0;      //# of tasks in all deques
+static atomic_int nIdle = 0;        //# of workers about to sleep
+static _Bool isShutdown = false;    //protected by idleLock
+
+/** Push task onto the calling thread's deque; return false if full. */
+static _Bool
+pushTask(const Task *task)
+{
+  Deque *deque = &deques[myDeque];
+  pthread_mutex_lock(&deque->lock);
+  const _Bool isFull = deque->bottom - deque->top == DEQUE_SIZE;
+  if (!isFull) deque->tasks[deque->bottom++ % DEQUE_SIZE] = *task;
+  pthread_mutex_unlock(&deque->lock);
+  if (isFull) return false;
+  atomic_fetch_add(&nQueued, 1);
+  if (atomic_load(&nIdle) > 0) {
+    pthread_mutex_lock(&idleLock);
+    pthread_cond_signal(&idleCond);
+    pthread_mutex_unlock(&idleLock);
+  }
+  return true;
+}
+
+/** Remove a task from deque into *task, the newest if isOwner, else
+ *  the oldest.  Return false if deque is empty.
+ */
+static _Bool
+takeTask(Deque *deque, _Bool isOwner, Task *task)
+{
+  pthread_mutex_lock(&deque->lock);
+  const _Bool isEmpty = deque->bottom == deque->top;
+  if (!isEmpty) {
+    *task = (isOwner)
+      ? deque->tasks[--deque->bottom % DEQUE_SIZE]
+      : deque->tasks[deque->top++ % DEQUE_SIZE];
+  }
+  pthread_mutex_unlock(&deque->lock);
+  if (isEmpty) return false;
+  atomic_fetch_sub(&nQueued, 1);
+  return true;
+}
+
+/** Set *task to a task taken from the calling thread's deque or else
+ *  stolen from another deque; return false if there are none.
+ */
+static _Bool
+findTask(Task *task)
+{
+  if (atomic_load_explicit(&nQueued, memory_order_relaxed) == 0) return false;
+  if (takeTask(&deques[myDeque], true, task)) return true;
+  for (int i = 1; i < nDeques; i++) {
+    if (takeTask(&deques[(myDeque + i) % nDeques], false, task)) return true;
+  }
+  return false;
+}
+
+static void
+runTask(const Task *task)
+{
+  task->fn(task->arg);
+  atomic_fetch_sub_explicit(&task->group->nPending, 1, memory_order_release);
+}
+
+static void *
+workerMain(void *index)
+{
+  myDeque = (intptr_t)index;
+  while (true) {
+    Task task;
+    if (findTask(&task)) {
+      runTask(&task);
+      continue;
+    }
+    // Announce that we are going to sleep before checking for tasks
+    // for the last time; pushTask() increments nQueued before checking
+    // nIdle, so one of us always sees the other
+    pthread_mutex_lock(&idleLock);
+    atomic_fetch_add(&nIdle, 1);
+    while (!isShutdown && atomic_load(&nQueued) == 0) {
+      pthread_cond_wait(&idleCond, &idleLock);
+    }
+    atomic_fetch_sub(&nIdle, 1);
+    const _Bool isDone = isShutdown;
+    pthread_mutex_unlock(&idleLock);
+    if (isDone) break;
+  }
+  return NULL;
+}
+
+static void
+stopWorkers(void)
+{
+  pthread_mutex_lock(&idleLock);
+  isShutdown = true;
+  pthread_cond_broadcast(&idleCond);
+  pthread_mutex_unlock(&idleLock);
+  for (int i = 0; i < nWorkers; i++) pthread_join(workers[i], NULL);
+  for (int i = 0; i < nDeques; i++) pthread_mutex_destroy(&deques[i].lock);
+  free(workers);
+  free(deques);
+  workers = NULL;
+  deques = NULL;
+  nWorkers = nDeques = 0;
+  isShutdown = false;
+}
+
+/** Start the worker threads if not already done.  If threads cannot
+ *  be created, simply run with fewer threads.
+ */
+static void
+startWorkers(void)
+{
+  if (atomic_load_explicit(&isStarted, memory_order_acquire)) return;
+  pthread_mutex_lock(&startLock);
+  if (!atomic_load(&isStarted)) {
+    if (poolSize == 0) setThreadPoolSize(0);
+    if (poolSize > 1) {
+      workers = malloc((poolSize - 1)*sizeof(pthread_t));
+      deques = malloc(poolSize*sizeof(Deque));
+      if (workers && deques) {
+        nDeques = poolSize;
+        for (int i = 0; i < nDeques; i++) {
+          pthread_mutex_init(&deques[i].lock, NULL);
+          deques[i].top = deques[i].bottom = 0;
+        }
+        for (int i = 0; i < poolSize - 1; i++) {
+          if (pthread_create(&workers[i], NULL, workerMain,
+                             (void *)(intptr_t)(i + 1)) != 0) {
+            break;
+          }
+          nWorkers++;
+        }
+        //the deques of threads which could not be created stay empty
+      }
+      if (nWorkers == 0) {
+        free(workers);
+        free(deques);
+        workers = NULL;
+        deques = NULL;
+        nDeques = 0;
+      }
+    }
+    atomic_store_explicit(&isStarted, true, memory_order_release);
+  }
+  pthread_mutex_unlock(&startLock);
+}
+
+void
+setThreadPoolSize(int nThreads)
+{
+  if (nThreads <= 0) {
+    long nProcs = sysconf(_SC_NPROCESSORS_ONLN);
+    nThreads = (nProcs > 0) ? nProcs : 1;
+  }
+  if (nWorkers > 0) stopWorkers();
+  poolSize = nThreads;
+  atomic_store(&isStarted, false);
+}
+
+int
+getThreadPoolSize(void)
+{
+  if (poolSize == 0) setThreadPoolSize(0);
+  return poolSize;
+}
+
+void
+initTaskGroup(TaskGroup *group)
+{
+  atomic_init(&group->nPending, 0);
+}
+
+void
+forkTask(TaskGroup *group, TaskFn fn, void *arg)
+{
+  startWorkers();
+  if (nWorkers > 0) {
+    Task task = { .fn = fn, .arg = arg, .group = group };
+    atomic_fetch_add_explicit(&group->nPending, 1, memory_order_relaxed);
+    if (pushTask(&task)) return;
+    atomic_fetch_sub_explicit(&group->nPending, 1, memory_order_relaxed);
+  }
+  fn(arg);
+}
+
+void
+joinTasks(TaskGroup *group)
+{
+  while (atomic_load_explicit(&group->nPending, memory_order_acquire) > 0) {
+    Task task;
+    if (findTask(&task)) {
+      runTask(&task);
+    }
+    else {
+      sched_yield();
+    }
+  }
+}
+
+/** A range of indexes of a parallelFor() */
+typedef struct {
+  ParallelForFn fn;
+  void *arg;
+  int grain;
+  int begin, end;
+} Range;
+
+/** Process range, forking the upper half and recursing on the lower
+ *  half while it has more than one chunk.  Ranges are split on chunk
+ *  boundaries, so the chunks are the same however the work is split.
+ */
+static void
+runRange(void *arg)
+{
+  const Range *range = arg;
+  const int grain = range->grain;
+  const int nChunks = (range->end - range->begin + grain - 1)/grain;
+  if (nChunks <= 1) {
+    range->fn(range->arg, range->begin, range->end);
+    return;
+  }
+  const int mid = range->begin + (nChunks/2)*grain;
+  Range lower = *range, upper = *range;
+  lower.end = upper.begin = mid;
+  TaskGroup group;
+  initTaskGroup(&group);
+  forkTask(&group, runRange, &upper);
+  runRange(&lower);
+  joinTasks(&group);
+}
+
+void
+parallelFor(int n, int grain, ParallelForFn fn, void *arg)
+{
+  if (grain < 1) grain = 1;
+  startWorkers();
+  if (nWorkers == 0 || n <= grain) {
+    fn(arg, 0, n);
+    return;
+  }
+  Range range = { .fn = fn, .arg = arg, .grain = grain, .begin = 0, .end = n };
+  runRange(&range);
+}
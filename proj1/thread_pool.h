@@ -0,0 +1,69 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+/** A pool of worker threads shared by all matrix classes which do
+ *  their work in parallel.  The pool is created lazily on first use.
+ *
+ *  Work is scheduled by work stealing: each worker has a deque of
+ *  tasks, pushing and popping tasks it forks at one end while idle
+ *  workers steal the oldest (and hence usually largest) tasks from the
+ *  other end.  Threads outside the pool share a single deque.  A thread
+ *  waiting in joinTasks() runs queued tasks rather than blocking, so
+ *  tasks may fork and join further tasks to any depth, and nested
+ *  parallelism never uses more than the fixed number of threads.
+ */
+
+/** Function called by parallelFor() to process the indexes in
+ *  [begin, end); arg is the argument passed to parallelFor().
+ */
+typedef void (*ParallelForFn)(void *arg, int begin, int end);
+
+/** Function run by a task; arg is the argument passed to forkTask(). */
+typedef void (*TaskFn)(void *arg);
+
+/** A group of tasks forked by forkTask() which are waited for together
+ *  by joinTasks().  Initialize using initTaskGroup() before use;
+ *  otherwise opaque.
+ */
+typedef struct {
+  _Atomic int nPending;         //# of forked tasks not yet completed
+} TaskGroup;
+
+/** Set the total # of threads (including the calling thread) used by
+ *  parallelFor() and forkTask() to nThreads.  If nThreads <= 0, then
+ *  use the # of online processors.  Must not be called while any task
+ *  is in progress.
+ */
+void setThreadPoolSize(int nThreads);
+
+/** Return the total # of threads used by parallelFor(). */
+int getThreadPoolSize(void);
+
+/** Initialize group to contain no tasks. */
+void initTaskGroup(TaskGroup *group);
+
+/** Add a task which calls fn(arg) to group.  The task may be run by
+ *  any thread at any time until joinTasks(group) returns, so arg must
+ *  remain valid until then.  If the pool has no workers or the
+ *  calling thread's deque is full, then fn(arg) is simply called
+ *  before returning.
+ */
+void forkTask(TaskGroup *group, TaskFn fn, void *arg);
+
+/** Return only after all the tasks in group have completed, running
+ *  queued tasks (from group or elsewhere) while waiting.
+ */
+void joinTasks(TaskGroup *group);
+
+/** Call fn(arg, begin, end) for disjoint chunks [begin, end) of
+ *  indexes covering [0, n), where each chunk has at most grain
+ *  indexes.  The range is split in half recursively, forking one half
+ *  as a task, so that the chunks are processed in parallel by the
+ *  calling thread and the pool workers; return only after all chunks
+ *  have been processed.  Nested calls (from within fn) are split in
+ *  the same way and share the same threads.  If the pool has no
+ *  workers, then fn(arg, 0, n) is called directly.
+ */
+void parallelFor(int n, int grain, ParallelForFn fn, void *arg);
+
+#endif //ifndef _THREAD_POOL_H
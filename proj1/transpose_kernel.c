@@ -0,0 +1,36 @@
+#include "transpose_kernel.h"
+#include "typed_matrix.h"
+
+/* Tiles with at most TILE x TILE entries are transposed directly;
+ * two 16 x 16 int tiles use only 2K of cache and a source row segment
+ * is a full 64-byte cache line.
+ */
+enum { TILE = 16 };
+
+void
+transposeRecursive(int m, int n, const MatrixBaseType *src, int lds,
+                   MatrixBaseType *dst, int ldd)
+{
+  if (m <= TILE && n <= TILE) {
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        dst[(size_t)j*ldd + i] = src[(size_t)i*lds + j];
+      }
+    }
+  }
+  else if (m >= n) {
+    const int half = m/2;
+    transposeRecursive(half, n, src, lds, dst, ldd);
+    transposeRecursive(m - half, n, &src[(size_t)half*lds], lds,
+                       &dst[half], ldd);
+  }
+  else {
+    const int half = n/2;
+    transposeRecursive(m, half, src, lds, dst, ldd);
+    transposeRecursive(m, n - half, &src[half], lds,
+                       &dst[(size_t)half*ldd], ldd);
+  }
+}
+
+#define TM_TEMPLATE "transpose_kernel_template.h"
+#include "typed_matrix_instances.h"
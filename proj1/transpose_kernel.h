@@ -0,0 +1,19 @@
+#ifndef _TRANSPOSE_KERNEL_H
+#define _TRANSPOSE_KERNEL_H
+
+#include "matrix.h"
+
+/** Raw-memory transpose kernel.  Like the kernels in gemm_kernel.h,
+ *  matrices are described by a pointer to their first element and a
+ *  leading dimension and no error checking is done.
+ */
+
+/** Set dst[n][m] to the transpose of src[m][n].  Uses cache-oblivious
+ *  recursive subdivision: the larger dimension is halved until the
+ *  tiles are small enough that both the source and destination tile
+ *  fit in the L1 cache, whatever its size.  dst must not overlap src.
+ */
+void transposeRecursive(int m, int n, const MatrixBaseType *src, int lds,
+                        MatrixBaseType *dst, int ldd);
+
+#endif //ifndef _TRANSPOSE_KERNEL_H
@@ -0,0 +1,11 @@
+/** Template for the transpose kernel for a single element type; see
+ *  typed_template.h.
+ */
+
+/** Set dst[n][m] to the transpose of src[m][n].  Uses cache-oblivious
+ *  recursive subdivision: the larger dimension is halved until the
+ *  tiles are small enough that both the source and destination tile
+ *  fit in the L1 cache, whatever its size.  dst must not overlap src.
+ */
+void TM_NAME(transposeRecursive)(int m, int n, const TM_TYPE *src, int lds,
+                                 TM_TYPE *dst, int ldd);
@@ -0,0 +1,28 @@
+/** Template for the implementation of the transpose kernel for a
+ *  single element type; see typed_template.h.
+ */
+
+void
+TM_NAME(transposeRecursive)(int m, int n, const TM_TYPE *src, int lds,
+                            TM_TYPE *dst, int ldd)
+{
+  if (m <= TILE && n <= TILE) {
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        dst[(size_t)j*ldd + i] = src[(size_t)i*lds + j];
+      }
+    }
+  }
+  else if (m >= n) {
+    const int half = m/2;
+    TM_NAME(transposeRecursive)(half, n, src, lds, dst, ldd);
+    TM_NAME(transposeRecursive)(m - half, n, &src[(size_t)half*lds], lds,
+                                &dst[half], ldd);
+  }
+  else {
+    const int half = n/2;
+    TM_NAME(transposeRecursive)(m, half, src, lds, dst, ldd);
+    TM_NAME(transposeRecursive)(m, n - half, &src[half], lds,
+                                &dst[(size_t)half*ldd], ldd);
+  }
+}
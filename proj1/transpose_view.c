@@ -0,0 +1,327 @@
+#include "abstract_matrix.h"
+#include "transpose_view.h"
+#include "typed_matrix.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  TransposeView;
+  Matrix *base;
+  _Bool ownsBase;
+} TransposeViewImpl;
+
+#define KLASS "transposeView"
+
+/** # of rows of the product updated together by mul(); chosen so
+ *  that the product rows stay resident in the L2 cache while the rows
+ *  of the base and multiplier stream past them.
+ */
+enum { MUL_ROWS = 16 };
+
+/** Examines the matrix as a TransposeView, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifyTransposeView(const Matrix *this, int *err)
+{
+  const TransposeViewImpl *view = (const TransposeViewImpl *)this;
+  if (!view->base) *err = EINVAL;
+}
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifyTransposeView(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifyTransposeView(this, err);
+  return MATRIX_KLASS_TRANSPOSE_VIEW;
+}
+
+static void freeTransposeView(Matrix *this, int *err)
+{
+  verifyTransposeView(this, err);
+  TransposeViewImpl *view = (TransposeViewImpl *)this;
+  if (view->ownsBase) view->base->fns->free(view->base, err);
+  free(view);
+}
+
+static int getNRows(const Matrix *this, int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return 0;
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  return base->fns->getNCols(base, err);
+}
+
+static int getNCols(const Matrix *this, int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return 0;
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  return base->fns->getNRows(base, err);
+}
+
+static MatrixBaseType getElement(const Matrix *this,
+                                 int rowIndex, int colIndex, int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return 0;
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  return base->fns->getElement(base, colIndex, rowIndex, err);
+}
+
+static void setElement(Matrix *this, int rowIndex, int colIndex,
+                       MatrixBaseType element, int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return;
+  Matrix *base = ((TransposeViewImpl *)this)->base;
+  base->fns->setElement(base, colIndex, rowIndex, element, err);
+}
+
+/** Row rowIndex of this is column rowIndex of the base: gather it
+ *  directly from the storage of the base if possible.
+ */
+static void getRow(const Matrix *this, int rowIndex, MatrixBaseType row[],
+                   int *err)
+{
+  const int nRows = getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = getNCols(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= nRows) {
+    *err = EDOM;
+    return;
+  }
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  int baseLd;
+  const MatrixBaseType *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData) {
+    getAbstractMatrixFns()->getRow(this, rowIndex, row, err);
+    return;
+  }
+  for (int c = 0; c < nCols; c++) {
+    row[c] = baseData[(size_t)c*baseLd + rowIndex];
+  }
+}
+
+static void setRow(Matrix *this, int rowIndex, const MatrixBaseType row[],
+                   int *err)
+{
+  const int nRows = getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = getNCols(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= nRows) {
+    *err = EDOM;
+    return;
+  }
+  Matrix *base = ((TransposeViewImpl *)this)->base;
+  int baseLd;
+  MatrixBaseType *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData) {
+    getAbstractMatrixFns()->setRow(this, rowIndex, row, err);
+    return;
+  }
+  for (int c = 0; c < nCols; c++) {
+    baseData[(size_t)c*baseLd + rowIndex] = row[c];
+  }
+}
+
+/** The transpose of this is simply a copy of the base */
+static void transpose(const Matrix *this, Matrix *result, int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const int this_m = getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == result_m && this_n == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  int baseLd, resultLd;
+  const MatrixBaseType *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData || !res) {
+    getAbstractMatrixFns()->transpose(this, result, err);
+    return;
+  }
+  for (int r = 0; r < result_n; r++) {
+    memcpy(&res[(size_t)r*resultLd], &baseData[(size_t)r*baseLd],
+           result_m*sizeof(MatrixBaseType));
+  }
+}
+
+/** c[m][p] += transpose(a[n][m]) * b[n][p] as a sum of n rank-1
+ *  updates, one for each row of a and b; all of a, b and c are
+ *  accessed a row at a time.
+ */
+static void
+mulRank1(int m, int n, int p,
+         const MatrixBaseType *a, int lda,
+         const MatrixBaseType *restrict b, int ldb,
+         MatrixBaseType *restrict c, int ldc)
+{
+  for (int k = 0; k < n; k++) {
+    const MatrixBaseType *aRow = &a[(size_t)k*lda];
+    const MatrixBaseType *restrict bRow = &b[(size_t)k*ldb];
+    for (int i = 0; i < m; i++) {
+      const MatrixBaseType aki = aRow[i];
+      MatrixBaseType *restrict cRow = &c[(size_t)i*ldc];
+      for (int j = 0; j < p; j++) cRow[j] += aki*bRow[j];
+    }
+  }
+}
+
+/** Multiply without transposing the base: product row i is the sum
+ *  over k of base[k][i] * multiplier row k.
+ */
+static void mul(const Matrix *this, const Matrix *multiplier,
+                Matrix *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = getNRows(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = getNCols(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of the base, multiplier and product
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  int lda, ldb, ldc;
+  const MatrixBaseType *a = base->fns->getData(base, &lda, err);
+  if (*err == EINVAL) return;
+  const MatrixBaseType *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  MatrixBaseType *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (!a || !b || !c) {
+    getAbstractMatrixFns()->mul(this, multiplier, product, err);
+    return;
+  }
+  for (int i0 = 0; i0 < pr_m; i0 += MUL_ROWS) {
+    const int m = (pr_m - i0 < MUL_ROWS) ? pr_m - i0 : MUL_ROWS;
+    for (int i = i0; i < i0 + m; i++) {
+      memset(&c[(size_t)i*ldc], 0, pr_p*sizeof(MatrixBaseType));
+    }
+    mulRank1(m, this_n, pr_p, &a[i0], lda, b, ldb, &c[(size_t)i0*ldc], ldc);
+  }
+}
+
+/** A column vector times this is the row vector times the base */
+static void mulVec(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return;
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  base->fns->vecMul(base, vec, result, err);
+}
+
+/** A row vector times this is the base times the column vector */
+static void vecMul(const Matrix *this, const MatrixBaseType vec[],
+                   MatrixBaseType result[], int *err)
+{
+  verifyTransposeView(this, err);
+  if (*err == EINVAL) return;
+  const Matrix *base = ((const TransposeViewImpl *)this)->base;
+  base->fns->mulVec(base, vec, result, err);
+}
+
+static _Bool isInit = false;
+static TransposeViewFns transposeViewFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .free = freeTransposeView,
+  .getNRows = getNRows,
+  .getNCols = getNCols,
+  .getElement = getElement,
+  .setElement = setElement,
+  .getRow = getRow,
+  .setRow = setRow,
+  .transpose = transpose,
+  .mul = mul,
+  .mulVec = mulVec,
+  .vecMul = vecMul,
+};
+
+TransposeView *
+newTransposeView(Matrix *base, _Bool ownsBase, int *err)
+{
+  if (!base) {
+    *err = EINVAL;
+    return NULL;
+  }
+  base->fns->getNRows(base, err);
+  if (*err == EINVAL) return NULL;
+  TransposeViewImpl *view = malloc(sizeof(TransposeViewImpl));
+  if (!view) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  view->fns = (MatrixFns *)getTransposeViewFns();
+  view->base = base;
+  view->ownsBase = ownsBase;
+  return (TransposeView *)view;
+}
+
+const Matrix *
+getTransposeViewBase(const Matrix *matrix)
+{
+  int err = 0;
+  const MatrixKlassId id = matrix->fns->getKlassId(matrix, &err);
+  if (err || id != MATRIX_KLASS_TRANSPOSE_VIEW) return NULL;
+  return ((const TransposeViewImpl *)matrix)->base;
+}
+
+static void patchTransposeViewFns(void)
+{
+  if (!isInit) {
+    //the entries of a view are never in row-major order
+    const MatrixFns *fns = getAbstractMatrixFns();
+    transposeViewFns.getData = fns->getData;
+    isInit = true;
+  }
+}
+
+/** Return implementation of functions for a transpose view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TransposeViewFns *
+getTransposeViewFns(void)
+{
+  patchTransposeViewFns();
+  return &transposeViewFns;
+}
+
+#define TM_TEMPLATE "transpose_view_template.h"
+#include "typed_matrix_instances.h"
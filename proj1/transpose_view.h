@@ -0,0 +1,42 @@
+#ifndef _TRANSPOSE_VIEW_H
+#define _TRANSPOSE_VIEW_H
+
+#include "matrix.h"
+
+typedef struct TransposeViewFns {
+  MatrixFns;    //-fms-extensions inserts MatrixFns fields into struct
+} TransposeViewFns;
+
+typedef struct TransposeView {
+  Matrix;       //-fms-extensions inserts Matrix fields into struct
+} TransposeView;
+
+/** Return a newly allocated view of the transpose of base: entry
+ *  [i][j] of the view is entry [j][i] of base.  No entries are
+ *  copied; reading or writing the view reads or writes base, so base
+ *  must remain valid while the view is in use.  If ownsBase, then
+ *  base is freed when the view is freed.
+ *
+ *  Multiplying by a view is done without transposing: the smart and
+ *  blocked multiplication matrices compute a * transpose(b) as dot
+ *  products of rows of a and rows of b when b has row-major storage,
+ *  and a view multiplied by a matrix uses rank-1 updates over the
+ *  rows of its base.
+ *
+ *  Set *err to EINVAL if base is NULL or not in valid state, to
+ *  ENOMEM if not enough memory.
+ */
+TransposeView *newTransposeView(Matrix *base, _Bool ownsBase, int *err);
+
+/** If matrix is a transpose view, return the matrix it is a view of;
+ *  otherwise return NULL.
+ */
+const Matrix *getTransposeViewBase(const Matrix *matrix);
+
+/** Return implementation of functions for a transpose view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TransposeViewFns *getTransposeViewFns(void);
+
+#endif //ifndef _TRANSPOSE_VIEW_H
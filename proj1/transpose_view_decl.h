@@ -0,0 +1,41 @@
+/** Template for the transpose view class for a single element type;
+ *  see typed_template.h.
+ */
+
+typedef struct TM_NAME(TransposeViewFns) {
+  TM_NAME(MatrixFns); //-fms-extensions inserts MatrixFns fields into struct
+} TM_NAME(TransposeViewFns);
+
+typedef struct TM_NAME(TransposeView) {
+  TM_NAME(Matrix);    //-fms-extensions inserts Matrix fields into struct
+} TM_NAME(TransposeView);
+
+/** Return a newly allocated view of the transpose of base: entry
+ *  [i][j] of the view is entry [j][i] of base.  No entries are
+ *  copied; reading or writing the view reads or writes base, so base
+ *  must remain valid while the view is in use.  If ownsBase, then
+ *  base is freed when the view is freed.
+ *
+ *  Multiplying by a view is done without transposing: the smart and
+ *  blocked multiplication matrices compute a * transpose(b) as dot
+ *  products of rows of a and rows of b when b has row-major storage,
+ *  and a view multiplied by a matrix uses rank-1 updates over the
+ *  rows of its base.
+ *
+ *  Set *err to EINVAL if base is NULL or not in valid state, to
+ *  ENOMEM if not enough memory.
+ */
+TM_NAME(TransposeView) *TM_NAME(newTransposeView)(TM_NAME(Matrix) *base,
+                                                  _Bool ownsBase, int *err);
+
+/** If matrix is a transpose view, return the matrix it is a view of;
+ *  otherwise return NULL.
+ */
+const TM_NAME(Matrix) *
+TM_NAME(getTransposeViewBase)(const TM_NAME(Matrix) *matrix);
+
+/** Return implementation of functions for a transpose view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TM_NAME(TransposeViewFns) *TM_NAME(getTransposeViewFns)(void);
@@ -0,0 +1,336 @@
+/** Template for the implementation of the transpose view class for a
+ *  single element type; see typed_template.h.
+ */
+
+typedef struct {
+  TM_NAME(TransposeView);
+  TM_NAME(Matrix) *base;
+  _Bool ownsBase;
+} TM_NAME(TransposeViewImpl);
+
+/** Examines the matrix as a TransposeView, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void
+TM_NAME(verifyTransposeView)(const TM_NAME(Matrix) *this, int *err)
+{
+  const TM_NAME(TransposeViewImpl) *view =
+    (const TM_NAME(TransposeViewImpl) *)this;
+  if (!view->base) *err = EINVAL;
+}
+
+static const char *
+TM_NAME(getKlass)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  return KLASS TM_STR(TM_SUFFIX);
+}
+
+static MatrixKlassId
+TM_NAME(getKlassId)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  return MATRIX_KLASS_TRANSPOSE_VIEW;
+}
+
+static void
+TM_NAME(freeTransposeView)(TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  TM_NAME(TransposeViewImpl) *view = (TM_NAME(TransposeViewImpl) *)this;
+  if (view->ownsBase) view->base->fns->free(view->base, err);
+  free(view);
+}
+
+static int
+TM_NAME(getNRows)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return 0;
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  return base->fns->getNCols(base, err);
+}
+
+static int
+TM_NAME(getNCols)(const TM_NAME(Matrix) *this, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return 0;
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  return base->fns->getNRows(base, err);
+}
+
+static TM_TYPE
+TM_NAME(getElement)(const TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return 0;
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  return base->fns->getElement(base, colIndex, rowIndex, err);
+}
+
+static void
+TM_NAME(setElement)(TM_NAME(Matrix) *this, int rowIndex, int colIndex,
+                    TM_TYPE element, int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return;
+  TM_NAME(Matrix) *base = ((TM_NAME(TransposeViewImpl) *)this)->base;
+  base->fns->setElement(base, colIndex, rowIndex, element, err);
+}
+
+/** Row rowIndex of this is column rowIndex of the base: gather it
+ *  directly from the storage of the base if possible.
+ */
+static void
+TM_NAME(getRow)(const TM_NAME(Matrix) *this, int rowIndex, TM_TYPE row[],
+                int *err)
+{
+  const int nRows = TM_NAME(getNRows)(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = TM_NAME(getNCols)(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= nRows) {
+    *err = EDOM;
+    return;
+  }
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  int baseLd;
+  const TM_TYPE *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData) {
+    TM_NAME(getAbstractMatrixFns)()->getRow(this, rowIndex, row, err);
+    return;
+  }
+  for (int c = 0; c < nCols; c++) {
+    row[c] = baseData[(size_t)c*baseLd + rowIndex];
+  }
+}
+
+static void
+TM_NAME(setRow)(TM_NAME(Matrix) *this, int rowIndex, const TM_TYPE row[],
+                int *err)
+{
+  const int nRows = TM_NAME(getNRows)(this, err);
+  if (*err == EINVAL) return;
+  const int nCols = TM_NAME(getNCols)(this, err);
+  if (*err == EINVAL) return;
+  if (rowIndex < 0 || rowIndex >= nRows) {
+    *err = EDOM;
+    return;
+  }
+  TM_NAME(Matrix) *base = ((TM_NAME(TransposeViewImpl) *)this)->base;
+  int baseLd;
+  TM_TYPE *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData) {
+    TM_NAME(getAbstractMatrixFns)()->setRow(this, rowIndex, row, err);
+    return;
+  }
+  for (int c = 0; c < nCols; c++) {
+    baseData[(size_t)c*baseLd + rowIndex] = row[c];
+  }
+}
+
+/** The transpose of this is simply a copy of the base */
+static void
+TM_NAME(transpose)(const TM_NAME(Matrix) *this, TM_NAME(Matrix) *result,
+                   int *err)
+{
+  // Check dimensions: MxN -> NxM
+  const int this_m = TM_NAME(getNRows)(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = TM_NAME(getNCols)(this, err);
+  if (*err == EINVAL) return;
+  const int result_n = result->fns->getNRows(result, err);
+  if (*err == EINVAL) return;
+  const int result_m = result->fns->getNCols(result, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == result_m && this_n == result_n)) {
+    *err = EDOM;
+    return;
+  }
+
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  int baseLd, resultLd;
+  const TM_TYPE *baseData = base->fns->getData(base, &baseLd, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *res = result->fns->getData(result, &resultLd, err);
+  if (*err == EINVAL) return;
+  if (!baseData || !res) {
+    TM_NAME(getAbstractMatrixFns)()->transpose(this, result, err);
+    return;
+  }
+  for (int r = 0; r < result_n; r++) {
+    memcpy(&res[(size_t)r*resultLd], &baseData[(size_t)r*baseLd],
+           result_m*sizeof(TM_TYPE));
+  }
+}
+
+/** c[m][p] += transpose(a[n][m]) * b[n][p] as a sum of n rank-1
+ *  updates, one for each row of a and b; all of a, b and c are
+ *  accessed a row at a time.
+ */
+static void
+TM_NAME(mulRank1)(int m, int n, int p, const TM_TYPE *a, int lda,
+                  const TM_TYPE *restrict b, int ldb, TM_TYPE *restrict c,
+                  int ldc)
+{
+  for (int k = 0; k < n; k++) {
+    const TM_TYPE *aRow = &a[(size_t)k*lda];
+    const TM_TYPE *restrict bRow = &b[(size_t)k*ldb];
+    for (int i = 0; i < m; i++) {
+      const TM_TYPE aki = aRow[i];
+      TM_TYPE *restrict cRow = &c[(size_t)i*ldc];
+      for (int j = 0; j < p; j++) cRow[j] += aki*bRow[j];
+    }
+  }
+}
+
+/** Multiply without transposing the base: product row i is the sum
+ *  over k of base[k][i] * multiplier row k.
+ */
+static void
+TM_NAME(mul)(const TM_NAME(Matrix) *this, const TM_NAME(Matrix) *multiplier,
+             TM_NAME(Matrix) *product, int *err)
+{
+  // Check if the dimensions are correct:
+  // MxN * NxP = MxP
+  const int this_m = TM_NAME(getNRows)(this, err);
+  if (*err == EINVAL) return;
+  const int this_n = TM_NAME(getNCols)(this, err);
+  if (*err == EINVAL) return;
+  const int mul_n = multiplier->fns->getNRows(multiplier, err);
+  if (*err == EINVAL) return;
+  const int mul_p = multiplier->fns->getNCols(multiplier, err);
+  if (*err == EINVAL) return;
+  const int pr_m = product->fns->getNRows(product, err);
+  if (*err == EINVAL) return;
+  const int pr_p = product->fns->getNCols(product, err);
+  if (*err == EINVAL) return;
+  if (!(this_m == pr_m && this_n == mul_n && mul_p == pr_p)) {
+    *err = EDOM;
+    return;
+  }
+
+  // Fall back to the inherited multiplication unless we can get at
+  // the storage of the base, multiplier and product
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  int lda, ldb, ldc;
+  const TM_TYPE *a = base->fns->getData(base, &lda, err);
+  if (*err == EINVAL) return;
+  const TM_TYPE *b = multiplier->fns->getData(multiplier, &ldb, err);
+  if (*err == EINVAL) return;
+  TM_TYPE *c = product->fns->getData(product, &ldc, err);
+  if (*err == EINVAL) return;
+  if (!a || !b || !c) {
+    TM_NAME(getAbstractMatrixFns)()->mul(this, multiplier, product, err);
+    return;
+  }
+  for (int i0 = 0; i0 < pr_m; i0 += MUL_ROWS) {
+    const int m = (pr_m - i0 < MUL_ROWS) ? pr_m - i0 : MUL_ROWS;
+    for (int i = i0; i < i0 + m; i++) {
+      memset(&c[(size_t)i*ldc], 0, pr_p*sizeof(TM_TYPE));
+    }
+    TM_NAME(mulRank1)(m, this_n, pr_p, &a[i0], lda, b, ldb,
+                      &c[(size_t)i0*ldc], ldc);
+  }
+}
+
+/** A column vector times this is the row vector times the base */
+static void
+TM_NAME(mulVec)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return;
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  base->fns->vecMul(base, vec, result, err);
+}
+
+/** A row vector times this is the base times the column vector */
+static void
+TM_NAME(vecMul)(const TM_NAME(Matrix) *this, const TM_TYPE vec[],
+                TM_TYPE result[], int *err)
+{
+  TM_NAME(verifyTransposeView)(this, err);
+  if (*err == EINVAL) return;
+  const TM_NAME(Matrix) *base =
+    ((const TM_NAME(TransposeViewImpl) *)this)->base;
+  base->fns->mulVec(base, vec, result, err);
+}
+
+static _Bool TM_NAME(isInit) = false;
+static TM_NAME(TransposeViewFns) TM_NAME(transposeViewFns) = {
+  .getKlass = TM_NAME(getKlass),
+  .getKlassId = TM_NAME(getKlassId),
+  .free = TM_NAME(freeTransposeView),
+  .getNRows = TM_NAME(getNRows),
+  .getNCols = TM_NAME(getNCols),
+  .getElement = TM_NAME(getElement),
+  .setElement = TM_NAME(setElement),
+  .getRow = TM_NAME(getRow),
+  .setRow = TM_NAME(setRow),
+  .transpose = TM_NAME(transpose),
+  .mul = TM_NAME(mul),
+  .mulVec = TM_NAME(mulVec),
+  .vecMul = TM_NAME(vecMul),
+};
+
+TM_NAME(TransposeView) *
+TM_NAME(newTransposeView)(TM_NAME(Matrix) *base, _Bool ownsBase, int *err)
+{
+  if (!base) {
+    *err = EINVAL;
+    return NULL;
+  }
+  base->fns->getNRows(base, err);
+  if (*err == EINVAL) return NULL;
+  TM_NAME(TransposeViewImpl) *view = malloc(sizeof(TM_NAME(TransposeViewImpl)));
+  if (!view) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  view->fns = (TM_NAME(MatrixFns) *)TM_NAME(getTransposeViewFns)();
+  view->base = base;
+  view->ownsBase = ownsBase;
+  return (TM_NAME(TransposeView) *)view;
+}
+
+const TM_NAME(Matrix) *
+TM_NAME(getTransposeViewBase)(const TM_NAME(Matrix) *matrix)
+{
+  int err = 0;
+  const MatrixKlassId id = matrix->fns->getKlassId(matrix, &err);
+  if (err || id != MATRIX_KLASS_TRANSPOSE_VIEW) return NULL;
+  return ((const TM_NAME(TransposeViewImpl) *)matrix)->base;
+}
+
+static void
+TM_NAME(patchTransposeViewFns)(void)
+{
+  if (!TM_NAME(isInit)) {
+    //the entries of a view are never in row-major order
+    const TM_NAME(MatrixFns) *fns = TM_NAME(getAbstractMatrixFns)();
+    TM_NAME(transposeViewFns).getData = fns->getData;
+    TM_NAME(isInit) = true;
+  }
+}
+
+/** Return implementation of functions for a transpose view; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TM_NAME(TransposeViewFns) *
+TM_NAME(getTransposeViewFns)(void)
+{
+  TM_NAME(patchTransposeViewFns)();
+  return &TM_NAME(transposeViewFns);
+}
@@ -0,0 +1,105 @@
+#include "structured_matrix_impl.h"
+#include "triangular_matrix.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+typedef struct {
+  StructuredMatrixImpl;
+  _Bool isUpper;
+} TriangularMatrixImpl;
+
+#define KLASS "triangularMatrix"
+
+/** Examines the matrix as a TriangularMatrix, and verifies that it is
+    in a valid state, otherwise, set *err to EINVAL. */
+static void verifyTriangularMatrix(const Matrix *this, int *err)
+{
+  const TriangularMatrixImpl *matrix = (const TriangularMatrixImpl *)this;
+  if (matrix->nRows <= 0 || matrix->nRows != matrix->nCols) *err = EINVAL;
+}
+
+static const char *getKlass(const Matrix *this, int *err)
+{
+  verifyTriangularMatrix(this, err);
+  return KLASS;
+}
+
+static MatrixKlassId getKlassId(const Matrix *this, int *err)
+{
+  verifyTriangularMatrix(this, err);
+  return MATRIX_KLASS_TRIANGULAR;
+}
+
+/** Row i of an upper triangle holds columns [i, n) and is preceded by
+ *  rows of n, n - 1, ..., n - i + 1 entries; row i of a lower triangle
+ *  holds columns [0, i] and is preceded by rows of 1, 2, ..., i
+ *  entries.
+ */
+static MatrixBaseType *
+getRowEntries(const Matrix *this, int rowIndex, int *begin, int *end)
+{
+  const TriangularMatrixImpl *matrix = (const TriangularMatrixImpl *)this;
+  const size_t i = rowIndex, n = matrix->nRows;
+  if (matrix->isUpper) {
+    *begin = rowIndex;
+    *end = matrix->nCols;
+    return &matrix->entries[i*n - i*(i - 1)/2];
+  }
+  else {
+    *begin = 0;
+    *end = rowIndex + 1;
+    return &matrix->entries[i*(i + 1)/2];
+  }
+}
+
+static _Bool isInit = false;
+static TriangularMatrixFns triangularMatrixFns = {
+  .getKlass = getKlass,
+  .getKlassId = getKlassId,
+  .getRowEntries = getRowEntries,
+};
+
+static void patchTriangularMatrixFns(void)
+{
+  if (!isInit) {
+    const StructuredMatrixFns *fns = getStructuredMatrixFns();
+    triangularMatrixFns.free = fns->free;
+    triangularMatrixFns.getNRows = fns->getNRows;
+    triangularMatrixFns.getNCols = fns->getNCols;
+    triangularMatrixFns.getElement = fns->getElement;
+    triangularMatrixFns.setElement = fns->setElement;
+    triangularMatrixFns.getRow = fns->getRow;
+    triangularMatrixFns.setRow = fns->setRow;
+    triangularMatrixFns.getData = fns->getData;
+    triangularMatrixFns.transpose = fns->transpose;
+    triangularMatrixFns.mul = fns->mul;
+    triangularMatrixFns.mulVec = fns->mulVec;
+    triangularMatrixFns.vecMul = fns->vecMul;
+    isInit = true;
+  }
+}
+
+TriangularMatrix *
+newTriangularMatrix(int n, _Bool isUpper, int *err)
+{
+  if (n <= 0) {
+    *err = EINVAL;
+    return NULL;
+  }
+  TriangularMatrixImpl *matrix = (TriangularMatrixImpl *)
+    newStructuredMatrix(sizeof(TriangularMatrixImpl), n, n,
+                        (size_t)n*(n + 1)/2,
+                        (const StructuredMatrixFns *)getTriangularMatrixFns(),
+                        err);
+  if (!matrix) return NULL;
+  matrix->isUpper = isUpper;
+  return (TriangularMatrix *)matrix;
+}
+
+const TriangularMatrixFns *
+getTriangularMatrixFns(void)
+{
+  patchTriangularMatrixFns();
+  return &triangularMatrixFns;
+}
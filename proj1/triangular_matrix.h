@@ -0,0 +1,30 @@
+#ifndef _TRIANGULAR_MATRIX_H
+#define _TRIANGULAR_MATRIX_H
+
+#include "structured_matrix.h"
+
+typedef struct TriangularMatrixFns {
+  StructuredMatrixFns; //-fms-extensions inserts StructuredMatrixFns fields
+} TriangularMatrixFns;
+
+typedef struct TriangularMatrix {
+  StructuredMatrix; //-fms-extensions inserts StructuredMatrix fields
+} TriangularMatrix;
+
+/** Return a newly allocated n x n upper triangular matrix if isUpper
+ *  (entry [i][j] is 0 for j < i), otherwise lower triangular (entry
+ *  [i][j] is 0 for j > i), with all entries initialized to 0.  Only
+ *  the n*(n + 1)/2 entries of the triangle are stored, packed a row
+ *  at a time.
+ *
+ *  Set *err to EINVAL if n <= 0, to ENOMEM if not enough memory.
+ */
+TriangularMatrix *newTriangularMatrix(int n, _Bool isUpper, int *err);
+
+/** Return implementation of functions for a triangular matrix; these
+ *  functions can be used by sub-classes to inherit behavior from this
+ *  class.
+ */
+const TriangularMatrixFns *getTriangularMatrixFns(void);
+
+#endif //ifndef _TRIANGULAR_MATRIX_H
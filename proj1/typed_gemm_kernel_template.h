@@ -0,0 +1,57 @@
+/** Template for the micro-kernel variants for a single element type
+ *  other than MatrixBaseType (whose variants are hand-written in
+ *  gemm_kernel.c and gemm_kernel_x86.c); see typed_template.h.  Each
+ *  variant is generated from typed_kernel_template.h and the variants
+ *  are collected in TM_NAME(gemmKernels), indexed by GemmKernelId, for
+ *  use by the driver in gemm_kernel_template.h.
+ */
+
+#include "gemm_kernel_impl_decl.h"
+
+#define TK_VARIANT Scalar
+#define TK_ID GEMM_KERNEL_SCALAR
+#define TK_VEC_BYTES sizeof(TM_TYPE)
+#define TK_TARGET
+#include "typed_kernel_template.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define TK_VARIANT Sse41
+#define TK_ID GEMM_KERNEL_SSE41
+#define TK_VEC_BYTES 16
+#define TK_TARGET __attribute__((target("sse4.1")))
+#include "typed_kernel_template.h"
+
+#define TK_VARIANT Avx2
+#define TK_ID GEMM_KERNEL_AVX2
+#define TK_VEC_BYTES 32
+#define TK_TARGET __attribute__((target("avx2,fma")))
+#include "typed_kernel_template.h"
+
+#define TK_VARIANT Avx512
+#define TK_ID GEMM_KERNEL_AVX512
+#define TK_VEC_BYTES 64
+#define TK_TARGET __attribute__((target("avx512f")))
+#include "typed_kernel_template.h"
+
+//indexed by GemmKernelId
+static const TM_NAME(GemmKernelImpl) *const
+TM_NAME(gemmKernels)[N_GEMM_KERNELS] = {
+  &TM_NAME(gemmKernelScalar),
+  &TM_NAME(gemmKernelSse41),
+  &TM_NAME(gemmKernelAvx2),
+  &TM_NAME(gemmKernelAvx512),
+};
+
+#else
+
+//only the scalar variant is ever selected when not on x86
+static const TM_NAME(GemmKernelImpl) *const
+TM_NAME(gemmKernels)[N_GEMM_KERNELS] = {
+  &TM_NAME(gemmKernelScalar),
+  &TM_NAME(gemmKernelScalar),
+  &TM_NAME(gemmKernelScalar),
+  &TM_NAME(gemmKernelScalar),
+};
+
+#endif
@@ -0,0 +1,111 @@
+/** Template for one micro-kernel variant for a single element type;
+ *  included by typed_gemm_kernel_template.h once for each variant.
+ *  Before each inclusion, define:
+ *
+ *    TK_VARIANT    suffix appended to all names for the variant
+ *    TK_ID         GemmKernelId of the variant
+ *    TK_VEC_BYTES  # of bytes in each vector register
+ *    TK_TARGET     function attribute selecting the instruction set,
+ *                  or empty for the baseline instruction set
+ *
+ *  in addition to TM_TYPE and TM_SUFFIX.  The variant is defined as a
+ *  GemmKernelImpl for the element type named gemmKernel<TK_VARIANT>
+ *  followed by the suffix for the element type.
+ *
+ *  Like the variants in gemm_kernel_x86.c, the micro-kernel keeps a
+ *  GEMM_MR x 2-vector block of c in registers while streaming through
+ *  k, broadcasting an element of each a row and multiplying it into
+ *  two vectors loaded from a b row.  Vectors are loaded and stored
+ *  using memcpy() (which compiles to an unaligned vector move) so that
+ *  operands need not be aligned.
+ */
+
+#define TK_NAME(name) TM_NAME(TM_CAT(name, TK_VARIANT))
+#define TK_VL ((int)(TK_VEC_BYTES/sizeof(TM_TYPE)))
+
+typedef TM_TYPE TK_NAME(Vec) __attribute__((vector_size(TK_VEC_BYTES)));
+
+static _Bool
+TK_NAME(isSupported)(void)
+{
+  return isGemmKernelSupported(TK_ID);
+}
+
+TK_TARGET
+static void
+TK_NAME(microKernel)(int k, const TM_TYPE *a, int lda,
+                     const TM_TYPE *b, int ldb, TM_TYPE *c, int ldc)
+{
+  TK_NAME(Vec) acc[GEMM_MR][2];
+  for (int i = 0; i < GEMM_MR; i++) {
+    memcpy(&acc[i][0], &c[(size_t)i*ldc], TK_VEC_BYTES);
+    memcpy(&acc[i][1], &c[(size_t)i*ldc + TK_VL], TK_VEC_BYTES);
+  }
+  for (int kk = 0; kk < k; kk++) {
+    TK_NAME(Vec) b0, b1;
+    memcpy(&b0, &b[(size_t)kk*ldb], TK_VEC_BYTES);
+    memcpy(&b1, &b[(size_t)kk*ldb + TK_VL], TK_VEC_BYTES);
+    for (int i = 0; i < GEMM_MR; i++) {
+      const TM_TYPE aik = a[(size_t)i*lda + kk];
+      acc[i][0] += aik*b0;
+      acc[i][1] += aik*b1;
+    }
+  }
+  for (int i = 0; i < GEMM_MR; i++) {
+    memcpy(&c[(size_t)i*ldc], &acc[i][0], TK_VEC_BYTES);
+    memcpy(&c[(size_t)i*ldc + TK_VL], &acc[i][1], TK_VEC_BYTES);
+  }
+}
+
+TK_TARGET
+static TM_TYPE
+TK_NAME(dot)(int n, const TM_TYPE *a, const TM_TYPE *b)
+{
+  TK_NAME(Vec) acc0 = { 0 }, acc1 = { 0 };
+  int i = 0;
+  for (; i + 2*TK_VL <= n; i += 2*TK_VL) {
+    TK_NAME(Vec) x0, x1, y0, y1;
+    memcpy(&x0, &a[i], TK_VEC_BYTES);
+    memcpy(&x1, &a[i + TK_VL], TK_VEC_BYTES);
+    memcpy(&y0, &b[i], TK_VEC_BYTES);
+    memcpy(&y1, &b[i + TK_VL], TK_VEC_BYTES);
+    acc0 += x0*y0;
+    acc1 += x1*y1;
+  }
+  acc0 += acc1;
+  TM_TYPE sum = 0;
+  for (int j = 0; j < TK_VL; j++) sum += acc0[j];
+  for (; i < n; i++) sum += a[i]*b[i];
+  return sum;
+}
+
+TK_TARGET
+static void
+TK_NAME(axpy)(int n, TM_TYPE alpha, const TM_TYPE *x, TM_TYPE *y)
+{
+  int i = 0;
+  for (; i + TK_VL <= n; i += TK_VL) {
+    TK_NAME(Vec) xi, yi;
+    memcpy(&xi, &x[i], TK_VEC_BYTES);
+    memcpy(&yi, &y[i], TK_VEC_BYTES);
+    yi += alpha*xi;
+    memcpy(&y[i], &yi, TK_VEC_BYTES);
+  }
+  for (; i < n; i++) y[i] += alpha*x[i];
+}
+
+static const TM_NAME(GemmKernelImpl) TK_NAME(gemmKernel) = {
+  .name = TM_STR(TK_VARIANT),
+  .nr = 2*TK_VL,
+  .microKernel = TK_NAME(microKernel),
+  .dot = TK_NAME(dot),
+  .axpy = TK_NAME(axpy),
+  .isSupported = TK_NAME(isSupported),
+};
+
+#undef TK_VL
+#undef TK_NAME
+#undef TK_VARIANT
+#undef TK_ID
+#undef TK_VEC_BYTES
+#undef TK_TARGET
@@ -0,0 +1,46 @@
+#ifndef _TYPED_MATRIX_H
+#define _TYPED_MATRIX_H
+
+#include "dense_matrix.h"
+#include "gemm_kernel.h"
+#include "matrix.h"
+#include "typed_template.h"
+#include "workspace.h"
+
+#include <stdint.h>
+
+/** Matrices with entries of types other than MatrixBaseType.
+ *
+ *  The abstract matrix, dense, smart multiplication and blocked
+ *  multiplication matrices, transpose and sub-matrix views and the
+ *  raw-memory kernels in gemm_kernel.h and transpose_kernel.h are
+ *  generated for each of these types from templates (see
+ *  typed_template.h) which follow the MatrixBaseType code.  The names
+ *  for each type have the suffix for the type appended: for example,
+ *  a MatrixF32 has functions MatrixF32Fns (the same functions as
+ *  MatrixFns in matrix.h but with float entries), newDenseMatrixF32()
+ *  returns a DenseMatrixF32 and gemmBlockedF32() multiplies float
+ *  storage.  The types are:
+ *
+ *    int64_t          I64
+ *    float            F32
+ *    double           F64
+ *
+ *  All the code for each type is specialized at compile time: there
+ *  is no switching on the element type at run time.  The micro-kernels
+ *  are written using GCC vector extensions and are compiled for each
+ *  of the instruction sets in gemm_kernel.h; the variant used is the
+ *  one selected for the MatrixBaseType kernels by setGemmKernel().
+ *  Dense storage is aligned and padded as set by
+ *  setDenseMatrixPadding(), and dense multiplication uses
+ *  gemmBlocked() on operands with storage rather than the small
+ *  kernels and registry of the MatrixBaseType classes.
+ *
+ *  A matrix of one type may only be used with matrices of the same
+ *  type.
+ */
+
+#define TM_TEMPLATE "typed_matrix_decl.h"
+#include "typed_matrix_instances.h"
+
+#endif //ifndef _TYPED_MATRIX_H
@@ -0,0 +1,14 @@
+/** Template for the declarations of all the matrix classes and
+ *  kernels for a single element type, in dependency order; see
+ *  typed_template.h.
+ */
+
+#include "matrix_decl.h"
+#include "abstract_matrix_decl.h"
+#include "dense_matrix_decl.h"
+#include "smart_mul_matrix_decl.h"
+#include "blocked_mul_matrix_decl.h"
+#include "transpose_view_decl.h"
+#include "sub_matrix_view_decl.h"
+#include "gemm_kernel_decl.h"
+#include "transpose_kernel_decl.h"
@@ -0,0 +1,29 @@
+/** Include the template named by TM_TEMPLATE once for each of the
+ *  element types in typed_matrix.h other than MatrixBaseType, with
+ *  TM_TYPE and TM_SUFFIX defined for the type; TM_TEMPLATE is
+ *  undefined at the end.  Hence each template is instantiated for all
+ *  the types by:
+ *
+ *    #define TM_TEMPLATE "xxx_template.h"
+ *    #include "typed_matrix_instances.h"
+ */
+
+#define TM_TYPE int64_t
+#define TM_SUFFIX I64
+#include TM_TEMPLATE
+#undef TM_TYPE
+#undef TM_SUFFIX
+
+#define TM_TYPE float
+#define TM_SUFFIX F32
+#include TM_TEMPLATE
+#undef TM_TYPE
+#undef TM_SUFFIX
+
+#define TM_TYPE double
+#define TM_SUFFIX F64
+#include TM_TEMPLATE
+#undef TM_TYPE
+#undef TM_SUFFIX
+
+#undef TM_TEMPLATE
@@ -0,0 +1,23 @@
+#ifndef _TYPED_TEMPLATE_H
+#define _TYPED_TEMPLATE_H
+
+/** Macros used by the templates from which the matrix classes and
+ *  kernels are generated for each element type in typed_matrix.h.
+ *
+ *  Before including a template, define TM_TYPE as the element type
+ *  and TM_SUFFIX as the suffix appended to every name generated for
+ *  that type.  The includer undefines both afterwards, so templates
+ *  have no include guards.
+ */
+
+#define TM_CAT_(a, b) a##b
+#define TM_CAT(a, b) TM_CAT_(a, b)
+
+/** name followed by the suffix for the current element type */
+#define TM_NAME(name) TM_CAT(name, TM_SUFFIX)
+
+#define TM_STR_(a) #a
+/** String literal for the expansion of a */
+#define TM_STR(a) TM_STR_(a)
+
+#endif //ifndef _TYPED_TEMPLATE_H
@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "workspace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct {
+  void *data;
+  size_t size;          //# of bytes allocated for data
+} Buffer;
+
+struct Workspace {
+  Buffer buffers[N_WORKSPACE_SLOTS];
+};
+
+static atomic_long allocCount = 0;
+
+Workspace *
+newWorkspace(int *err)
+{
+  Workspace *workspace = calloc(1, sizeof(Workspace));
+  if (!workspace) {
+    *err = ENOMEM;
+    return NULL;
+  }
+  return workspace;
+}
+
+void
+freeWorkspace(Workspace *workspace)
+{
+  for (int i = 0; i < N_WORKSPACE_SLOTS; i++) {
+    free(workspace->buffers[i].data);
+  }
+  free(workspace);
+}
+
+void *
+getWorkspaceBuffer(Workspace *workspace, WorkspaceSlot slot, size_t size,
+                   int *err)
+{
+  Buffer *buffer = &workspace->buffers[slot];
+  if (size > buffer->size || !buffer->data) {
+    // Contents need not be preserved, so avoid the copy in realloc()
+    free(buffer->data);
+    buffer->data = malloc((size > 0) ? size : 1);
+    buffer->size = (buffer->data) ? size : 0;
+    if (!buffer->data) {
+      *err = ENOMEM;
+      return NULL;
+    }
+    atomic_fetch_add(&allocCount, 1);
+  }
+  return buffer->data;
+}
+
+static pthread_key_t threadWorkspaceKey;
+static pthread_once_t threadWorkspaceOnce = PTHREAD_ONCE_INIT;
+
+static void
+freeThreadWorkspace(void *workspace)
+{
+  freeWorkspace(workspace);
+}
+
+static void
+createThreadWorkspaceKey(void)
+{
+  pthread_key_create(&threadWorkspaceKey, freeThreadWorkspace);
+}
+
+Workspace *
+getThreadWorkspace(int *err)
+{
+  pthread_once(&threadWorkspaceOnce, createThreadWorkspaceKey);
+  Workspace *workspace = pthread_getspecific(threadWorkspaceKey);
+  if (!workspace) {
+    workspace = newWorkspace(err);
+    if (!workspace) return NULL;
+    pthread_setspecific(threadWorkspaceKey, workspace);
+  }
+  return workspace;
+}
+
+long
+getWorkspaceAllocCount(void)
+{
+  return atomic_load(&allocCount);
+}
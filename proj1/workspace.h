@@ -0,0 +1,58 @@
+#ifndef _WORKSPACE_H
+#define _WORKSPACE_H
+
+#include <stddef.h>
+
+/** A workspace holds scratch buffers which are reused across matrix
+ *  operations, so that repeated operations on matrices of the same
+ *  shape do not allocate memory.  Each buffer is identified by a slot
+ *  and is only reallocated when an operation needs it to be larger
+ *  than it already is.  A workspace must not be used by more than one
+ *  thread at a time.
+ */
+
+/** Buffers held by a workspace.  An operation may use several slots
+ *  at the same time, but must not call another operation which uses
+ *  the same slot while the buffer is in use.
+ */
+typedef enum {
+  WORKSPACE_TRANSPOSE,      //transposed operand
+  WORKSPACE_ROWS,           //row buffers for matrices without storage
+  WORKSPACE_STRASSEN,       //Strassen temporaries and padded operands
+  WORKSPACE_UNPACKED,       //unpacked blocks of structured matrices
+  N_WORKSPACE_SLOTS
+} WorkspaceSlot;
+
+typedef struct Workspace Workspace;
+
+/** Return a newly allocated workspace with all buffers empty.  Set
+ *  *err to ENOMEM if not enough memory.
+ */
+Workspace *newWorkspace(int *err);
+
+/** Free workspace and all its buffers. */
+void freeWorkspace(Workspace *workspace);
+
+/** Return the buffer for slot in workspace, growing it if necessary
+ *  so that it has at least size bytes; the buffer is aligned for any
+ *  type and its previous contents are not preserved when it grows.
+ *  The buffer remains valid until the next call for the same slot.
+ *  Set *err to ENOMEM if not enough memory.
+ */
+void *getWorkspaceBuffer(Workspace *workspace, WorkspaceSlot slot,
+                         size_t size, int *err);
+
+/** Return the calling thread's default workspace, creating it on first
+ *  use; it is freed when the thread exits.  Set *err to ENOMEM if not
+ *  enough memory.
+ */
+Workspace *getThreadWorkspace(int *err);
+
+/** Return the total # of times any workspace has allocated a buffer
+ *  since the program started.  The count does not change while
+ *  operations are repeated on matrices whose shapes have been seen
+ *  before.
+ */
+long getWorkspaceAllocCount(void);
+
+#endif //ifndef _WORKSPACE_H